@@ -15,6 +15,7 @@ var worker_threads_1 = require("worker_threads");
 var path_1 = require("path");
 var net_1 = require("net");
 var child_process_1 = require("child_process");
+var string_decoder_1 = require("string_decoder");
 var __default = {
     path: 'PaddleOCR-json.exe',
     args: [],
@@ -45,19 +46,102 @@ function cargs(obj) {
     return obj;
 }
 function cout(data) {
-    return {
+    var out = {
         code: data.code,
         message: data.code - 100 ? data.data : '',
         data: data.code - 100 ? null : data.data,
     };
+    if (data.index !== undefined)
+        out.index = data.index; // 多页文档的页码、批量任务的序号
+    return out;
+}
+// 二进制帧：跳过 base64 与 JSON，直接传输图片文件字节或像素。帧头格式见 cpp/include/task.h
+var FRAME_MAGIC = [0x89, 0x4f, 0x43, 0x52];
+var FRAME_FORMAT = { 3: 1, 4: 2, 1: 3 };
+function cframe(obj) {
+    var format = 0, width = 0, height = 0, stride = 0, data;
+    if ('image_bytes' in obj && obj.image_bytes) {
+        data = obj.image_bytes;
+    }
+    else if ('image_pixels' in obj && obj.image_pixels) {
+        var pixels = obj.image_pixels;
+        format = FRAME_FORMAT[pixels.channels || 3];
+        width = pixels.width;
+        height = pixels.height;
+        stride = pixels.stride || 0;
+        data = pixels.data;
+    }
+    else
+        return null;
+    var header = Buffer.alloc(24);
+    header.set(FRAME_MAGIC, 0);
+    header[4] = 1;
+    header[5] = format;
+    header.writeUInt32LE(width, 8);
+    header.writeUInt32LE(height, 12);
+    header.writeUInt32LE(stride, 16);
+    header.writeUInt32LE(data.byteLength, 20);
+    return [header, Buffer.from(data.buffer, data.byteOffset, data.byteLength)];
+}
+// 按行切分输出。回复可能分多次到达，也可能一次到达多行；按字节解码，避免多字节字符被截断
+function lines(stream, online) {
+    var decoder = new string_decoder_1.StringDecoder('utf8');
+    var rest = '';
+    stream.on('data', function (chunk) {
+        var parts = (rest + decoder.write(chunk)).split('\n');
+        rest = parts.pop();
+        for (var _i = 0, parts_1 = parts; _i < parts_1.length; _i++) {
+            var line = parts_1[_i];
+            if (line.trim())
+                online(line);
+        }
+    });
 }
-var end = 'at' in String ? function (str) { return str.at(-1); } : function (str) { return str[str.length - 1]; };
 if (!worker_threads_1.isMainThread) {
     var _a = worker_threads_1.workerData, _b = _a.path, path = _b === void 0 ? __default.path : _b, _c = _a.args, args = _c === void 0 ? [] : _c, options = _a.options, debug_1 = _a.debug;
     var mode_1 = 0;
     var proc_1 = (0, child_process_1.spawn)(path, args.concat(__default.args), __assign(__assign({}, options), __default.options));
     process.once('exit', proc_1.kill.bind(proc_1));
     proc_1.once('exit', process.exit);
+    // 请求可以连续发出，不等待回复（流水线）。每条请求后附一条带id的空指令作为结束标记（二进制帧不能带id），
+    // 读到标记的回复时，此前收到的各行即为该请求的回复：单图一行，多页文档、批量任务每页/每项一行
+    var markers_1 = new Map(); // 结束标记的id -> 请求编号
+    var replies_1 = [];
+    var backlog_1 = [];
+    var write_1 = null;
+    function send(_a) {
+        var id = _a.id, arg = _a.arg;
+        var chunks;
+        try {
+            chunks = cframe(arg) || ["".concat(JSON.stringify(cargs(arg)), "\n")];
+        }
+        catch (e) { // 参数错误，不发给引擎
+            return worker_threads_1.parentPort.postMessage({ id: id, code: -1, message: String(e && e.message || e), data: null });
+        }
+        if (!write_1)
+            return backlog_1.push({ id: id, arg: arg });
+        var marker = "#ppocr-".concat(id);
+        markers_1.set(marker, id);
+        write_1(chunks.concat("{\"id\":\"".concat(marker, "\"}\n")));
+    }
+    function reply(line) {
+        var data;
+        try {
+            data = JSON.parse(line);
+        }
+        catch (e) {
+            data = { code: -1, data: "识别器输出值反序列化JSON失败。原始内容：[".concat(line, "]") };
+        }
+        if (data && 'stage' in data)
+            return; // 流式中间结果
+        var id = data && typeof data.id === 'string' ? markers_1.get(data.id) : undefined;
+        if (id === undefined)
+            return void replies_1.push(cout(data));
+        markers_1.delete(data.id);
+        var done = replies_1.splice(0);
+        worker_threads_1.parentPort.postMessage(done.length === 1 ? __assign({ id: id }, done[0]) : { id: id, replies: done });
+    }
+    worker_threads_1.parentPort.on('message', send);
     new Promise(function (res) { return proc_1.stdout.on('data', function stdout(chunk) {
         var data = chunk.toString();
         if (!mode_1) {
@@ -90,30 +174,39 @@ if (!worker_threads_1.isMainThread) {
             proc_1.stderr.destroy();
         }
         if (socket) {
-            var client_1 = new net_1.Socket();
+            // 持久连接，所有请求复用同一个TCP连接。连接断开时，未回复的请求以错误结束，之后的请求重新连接
             var addr_1 = socket[0], port_1 = socket[1];
-            worker_threads_1.parentPort.on('message', function (data) {
-                client_1.connect(port_1, addr_1, function () {
-                    client_1.end("".concat(JSON.stringify(cargs(data)), "\n"));
-                });
-            });
-            client_1.on('data', function (chunk) {
-                worker_threads_1.parentPort.postMessage(cout(JSON.parse(String(chunk))));
-            });
+            var client_1 = null;
+            write_1 = function (chunks) {
+                if (!client_1) {
+                    var conn_1 = client_1 = new net_1.Socket();
+                    conn_1.setNoDelay(true);
+                    conn_1.connect(port_1, addr_1);
+                    lines(conn_1, reply);
+                    conn_1.on('error', function () { return null; });
+                    conn_1.once('close', function () {
+                        if (client_1 === conn_1)
+                            client_1 = null;
+                        markers_1.forEach(function (id) { return worker_threads_1.parentPort.postMessage({ id: id, code: -1, message: '与识别器的连接已断开。', data: null }); });
+                        markers_1.clear();
+                        replies_1 = [];
+                    });
+                }
+                for (var _i = 0, chunks_1 = chunks; _i < chunks_1.length; _i++) {
+                    var chunk = chunks_1[_i];
+                    client_1.write(chunk);
+                }
+            };
         }
         else {
-            worker_threads_1.parentPort.on('message', function (data) {
-                proc_1.stdin.write("".concat(JSON.stringify(cargs(data)), "\n"));
-            });
-            var cache_1 = [];
-            proc_1.stdout.on('data', function (chunk) {
-                var str = String(chunk);
-                cache_1.push(str);
-                if (end(str) !== '\n')
-                    return;
-                worker_threads_1.parentPort.postMessage(cout(JSON.parse(cache_1.join(''))));
-                cache_1.length = 0;
-            });
+            lines(proc_1.stdout, reply);
+            write_1 = function (chunks) {
+                for (var _i = 0, chunks_2 = chunks; _i < chunks_2.length; _i++) {
+                    var chunk = chunks_2[_i];
+                    proc_1.stdin.write(chunk);
+                }
+            };
         }
+        backlog_1.splice(0).forEach(send); // 初始化完成前收到的请求
     });
 }
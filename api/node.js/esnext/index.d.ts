@@ -6,10 +6,21 @@ declare class OCR extends Worker {
     port: number | undefined;
     exitCode: number | null;
     constructor(path?: string, args?: string[], options?: OCR.Options, debug?: boolean);
+    /** 已发出、尚未回复的请求数 */
+    get pending(): number;
     postMessage(obj: OCR.Arg): void;
-    flush(obj: OCR.Arg): Promise<OCR.coutReturnType>;
+    /** 发出一个请求。可以连续调用而不等待，多个请求同时在途。多页文档与批量任务每页/每项一个结果，返回数组 */
+    flush(obj: OCR.Arg): Promise<OCR.coutReturnType | OCR.coutReturnType[]>;
 }
 declare namespace OCR {
+    /** 多个引擎进程组成的池，每个请求交给未回复请求最少的进程 */
+    export class Pool {
+        readonly workers: OCR[];
+        constructor(size: number, path?: string, args?: string[], options?: Options, debug?: boolean);
+        get pending(): number;
+        flush(obj: Arg): Promise<coutReturnType | coutReturnType[]>;
+        terminate(): Promise<number[]>;
+    }
     interface BaseArg {
         limit_side_len?: number;
         limit_type?: string;
@@ -22,10 +33,26 @@ declare namespace OCR {
     interface Arg_Base64 extends BaseArg {
         image_base64?: string;
     }
-    export type Arg = Arg_Base64 | Arg_Path;
+    /** 以二进制帧发送图片文件字节（jpg/png等），省去 base64 编码 */
+    interface Arg_Bytes extends BaseArg {
+        image_bytes?: Uint8Array;
+    }
+    /** 以二进制帧发送未编码的 BGR/BGRA/灰度 像素 */
+    interface Arg_Pixels extends BaseArg {
+        image_pixels?: {
+            data: Uint8Array;
+            width: number;
+            height: number;
+            channels?: 1 | 3 | 4;
+            stride?: number;
+        };
+    }
+    export type Arg = Arg_Base64 | Arg_Path | Arg_Bytes | Arg_Pixels;
     export interface coutReturnType {
         code: number;
         message: string;
+        /** 多页文档的页码、批量任务（images）的序号，从0起 */
+        index?: number;
         data: {
             box: [[number, number], [number, number], [number, number], [number, number]];
             score: number;
@@ -1,11 +1,8 @@
 "use strict";
 const worker_threads_1 = require("worker_threads");
 const path_1 = require("path");
-async function* Queue(value) {
-    while (true)
-        value = await new Promise(yield value);
-}
-const quqeMap = new WeakMap();
+const taskMap = new WeakMap();
+let nextId = 0;
 class OCR extends worker_threads_1.Worker {
     pid;
     addr;
@@ -16,32 +13,66 @@ class OCR extends worker_threads_1.Worker {
             workerData: { path, args, options, debug },
             stdout: true,
         });
-        const quqe = Queue();
-        quqeMap.set(this, quqe);
-        quqe.next();
-        quqe.next((res) => {
-            this.stdout.once('data', (data) => {
-                const [, pid, socket, addr, port] = String(data).match(/^pid=(\d+)(, a=(\d+\.\d+\.\d+\.\d+:\d+))?/);
-                this.pid = Number(pid);
-                if (socket) {
-                    this.addr = addr;
-                    this.port = Number(port);
-                }
-                super.emit('init', this.pid, this.addr, this.port);
-                res();
-            });
+        const tasks = new Map();
+        taskMap.set(this, tasks);
+        this.stdout.once('data', (data) => {
+            const [, pid, socket, addr, port] = String(data).match(/^pid=(\d+)(, addr=(\d+\.\d+\.\d+\.\d+), port=(\d+))?/);
+            this.pid = Number(pid);
+            if (socket) {
+                this.addr = addr;
+                this.port = Number(port);
+            }
+            super.emit('init', this.pid, this.addr, this.port);
+        });
+        // 回复带有请求编号，交给对应的 flush；之后的 message 监听器收到的仍是 { code, message, data }，
+        // 多行回复为 { replies }
+        super.on('message', (data) => {
+            const id = data.id;
+            delete data.id;
+            const task = tasks.get(id);
+            if (!task)
+                return;
+            tasks.delete(id);
+            task.resolve(data.replies || data);
         });
         super.once('exit', (code) => {
             this.exitCode = code;
-            quqeMap.get(this).return(null);
+            tasks.forEach((task) => task.reject(new Error(`OCR exited with code ${code}.`)));
+            tasks.clear();
         });
     }
-    postMessage(obj) { OCR.prototype.flush.call(this, obj); }
-    async flush(obj) {
-        return (await quqeMap.get(this).next((res) => {
-            super.once('message', res);
-            super.postMessage(obj);
-        })).value;
+    /** 已发出、尚未回复的请求数 */
+    get pending() { return taskMap.get(this).size; }
+    postMessage(obj) { OCR.prototype.flush.call(this, obj).catch(() => null); }
+    /** 发出一个请求。可以连续调用而不等待，多个请求同时在途。多页文档与批量任务每页/每项一个结果，返回数组 */
+    flush(obj) {
+        if (this.exitCode !== null)
+            return Promise.reject(new Error(`OCR exited with code ${this.exitCode}.`));
+        const tasks = taskMap.get(this);
+        const id = nextId++;
+        return new Promise((resolve, reject) => {
+            tasks.set(id, { resolve, reject });
+            super.postMessage({ id, arg: obj });
+        });
     }
 }
+(function (OCR) {
+    /** 多个引擎进程组成的池，每个请求交给未回复请求最少的进程 */
+    class Pool {
+        workers = [];
+        constructor(size, path, args, options, debug) {
+            for (let i = 0; i < Math.max(1, size); i++)
+                this.workers.push(new OCR(path, args, options, debug));
+        }
+        get pending() { return this.workers.reduce((sum, worker) => sum + worker.pending, 0); }
+        flush(obj) {
+            const alive = this.workers.filter((worker) => worker.exitCode === null);
+            if (!alive.length)
+                return Promise.reject(new Error('No OCR process is running.'));
+            return alive.reduce((a, b) => (b.pending < a.pending ? b : a)).flush(obj);
+        }
+        terminate() { return Promise.all(this.workers.map((worker) => worker.terminate())); }
+    }
+    OCR.Pool = Pool;
+})(OCR || (OCR = {}));
 module.exports = OCR;
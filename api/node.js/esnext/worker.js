@@ -4,6 +4,7 @@ const worker_threads_1 = require("worker_threads");
 const path_1 = require("path");
 const net_1 = require("net");
 const child_process_1 = require("child_process");
+const string_decoder_1 = require("string_decoder");
 const __default = {
     path: 'PaddleOCR-json.exe',
     args: [],
@@ -34,13 +35,55 @@ function cargs(obj) {
     return obj;
 }
 function cout(data) {
-    return {
+    const out = {
         code: data.code,
         message: data.code - 100 ? data.data : '',
         data: data.code - 100 ? null : data.data,
     };
+    if (data.index !== undefined)
+        out.index = data.index; // 多页文档的页码、批量任务的序号
+    return out;
+}
+// 二进制帧：跳过 base64 与 JSON，直接传输图片文件字节或像素。帧头格式见 cpp/include/task.h
+const FRAME_MAGIC = [0x89, 0x4f, 0x43, 0x52];
+const FRAME_FORMAT = { 3: 1, 4: 2, 1: 3 };
+function cframe(obj) {
+    let format = 0, width = 0, height = 0, stride = 0, data;
+    if ('image_bytes' in obj && obj.image_bytes) {
+        data = obj.image_bytes;
+    }
+    else if ('image_pixels' in obj && obj.image_pixels) {
+        const pixels = obj.image_pixels;
+        format = FRAME_FORMAT[pixels.channels || 3];
+        width = pixels.width;
+        height = pixels.height;
+        stride = pixels.stride || 0;
+        data = pixels.data;
+    }
+    else
+        return null;
+    const header = Buffer.alloc(24);
+    header.set(FRAME_MAGIC, 0);
+    header[4] = 1;
+    header[5] = format;
+    header.writeUInt32LE(width, 8);
+    header.writeUInt32LE(height, 12);
+    header.writeUInt32LE(stride, 16);
+    header.writeUInt32LE(data.byteLength, 20);
+    return [header, Buffer.from(data.buffer, data.byteOffset, data.byteLength)];
+}
+// 按行切分输出。回复可能分多次到达，也可能一次到达多行；按字节解码，避免多字节字符被截断
+function lines(stream, online) {
+    const decoder = new string_decoder_1.StringDecoder('utf8');
+    let rest = '';
+    stream.on('data', (chunk) => {
+        const parts = (rest + decoder.write(chunk)).split('\n');
+        rest = parts.pop();
+        for (const line of parts)
+            if (line.trim())
+                online(line);
+    });
 }
-const end = 'at' in String ? (str) => str.at(-1) : (str) => str[str.length - 1];
 if (!worker_threads_1.isMainThread) {
     const { path = __default.path, args = [], options, debug, } = worker_threads_1.workerData;
     let mode = 0;
@@ -50,6 +93,44 @@ if (!worker_threads_1.isMainThread) {
     });
     process.once('exit', proc.kill.bind(proc));
     proc.once('exit', process.exit);
+    // 请求可以连续发出，不等待回复（流水线）。每条请求后附一条带id的空指令作为结束标记（二进制帧不能带id），
+    // 读到标记的回复时，此前收到的各行即为该请求的回复：单图一行，多页文档、批量任务每页/每项一行
+    const markers = new Map(); // 结束标记的id -> 请求编号
+    let replies = [];
+    const backlog = [];
+    let write = null;
+    function send({ id, arg }) {
+        let chunks;
+        try {
+            chunks = cframe(arg) || [`${JSON.stringify(cargs(arg))}\n`];
+        }
+        catch (e) { // 参数错误，不发给引擎
+            return worker_threads_1.parentPort.postMessage({ id, code: -1, message: String(e && e.message || e), data: null });
+        }
+        if (!write)
+            return backlog.push({ id, arg });
+        const marker = `#ppocr-${id}`;
+        markers.set(marker, id);
+        write(chunks.concat(`{"id":"${marker}"}\n`));
+    }
+    function reply(line) {
+        let data;
+        try {
+            data = JSON.parse(line);
+        }
+        catch (e) {
+            data = { code: -1, data: `识别器输出值反序列化JSON失败。原始内容：[${line}]` };
+        }
+        if (data && 'stage' in data)
+            return; // 流式中间结果
+        const id = data && typeof data.id === 'string' ? markers.get(data.id) : undefined;
+        if (id === undefined)
+            return void replies.push(cout(data));
+        markers.delete(data.id);
+        const done = replies.splice(0);
+        worker_threads_1.parentPort.postMessage(done.length === 1 ? { id, ...done[0] } : { id, replies: done });
+    }
+    worker_threads_1.parentPort.on('message', send);
     new Promise((res) => proc.stdout.on('data', function stdout(chunk) {
         const data = chunk.toString();
         if (!mode) {
@@ -82,30 +163,35 @@ if (!worker_threads_1.isMainThread) {
             proc.stderr.destroy();
         }
         if (socket) {
-            const client = new net_1.Socket();
+            // 持久连接，所有请求复用同一个TCP连接。连接断开时，未回复的请求以错误结束，之后的请求重新连接
             const [addr, port] = socket;
-            worker_threads_1.parentPort.on('message', (data) => {
-                client.connect(port, addr, () => {
-                    client.end(`${JSON.stringify(cargs(data))}\n`);
-                });
-            });
-            client.on('data', (chunk) => {
-                worker_threads_1.parentPort.postMessage(cout(JSON.parse(String(chunk))));
-            });
+            let client = null;
+            write = (chunks) => {
+                if (!client) {
+                    const conn = client = new net_1.Socket();
+                    conn.setNoDelay(true);
+                    conn.connect(port, addr);
+                    lines(conn, reply);
+                    conn.on('error', () => null);
+                    conn.once('close', () => {
+                        if (client === conn)
+                            client = null;
+                        markers.forEach((id) => worker_threads_1.parentPort.postMessage({ id, code: -1, message: '与识别器的连接已断开。', data: null }));
+                        markers.clear();
+                        replies = [];
+                    });
+                }
+                for (const chunk of chunks)
+                    client.write(chunk);
+            };
         }
         else {
-            worker_threads_1.parentPort.on('message', (data) => {
-                proc.stdin.write(`${JSON.stringify(cargs(data))}\n`);
-            });
-            const cache = [];
-            proc.stdout.on('data', (chunk) => {
-                const str = String(chunk);
-                cache.push(str);
-                if (end(str) !== '\n')
-                    return;
-                worker_threads_1.parentPort.postMessage(cout(JSON.parse(cache.join(''))));
-                cache.length = 0;
-            });
+            lines(proc.stdout, reply);
+            write = (chunks) => {
+                for (const chunk of chunks)
+                    proc.stdin.write(chunk);
+            };
         }
+        backlog.splice(0).forEach(send); // 初始化完成前收到的请求
     });
 }
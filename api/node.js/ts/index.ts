@@ -1,11 +1,12 @@
 import { Worker } from 'worker_threads';
 import { resolve as path_resolve } from 'path';
 
-interface Queue<T> extends AsyncGenerator<T, null, (resolve: (value?: T) => void, reject: (reason?: any) => void) => void> { }
-async function* Queue<T>(value?: T): Queue<T> {
-    while (true) value = await new Promise(yield value);
+interface Task {
+    resolve: (value: OCR.coutReturnType | OCR.coutReturnType[]) => void;
+    reject: (reason?: any) => void;
 }
-const quqeMap = new WeakMap<OCR, Queue<OCR.coutReturnType>>();
+const taskMap = new WeakMap<OCR, Map<number, Task>>();
+let nextId = 0;
 
 class OCR extends Worker {
     pid: number;
@@ -17,37 +18,68 @@ class OCR extends Worker {
             workerData: { path, args, options, debug },
             stdout: true,
         });
-        const quqe = Queue<OCR.coutReturnType>();
-        quqeMap.set(this, quqe);
-        quqe.next();
-        quqe.next((res) => {
-            this.stdout.once('data', (data) => {
-                const [, pid, socket, addr, port] = String(data).match(/^pid=(\d+)(, a=(\d+\.\d+\.\d+\.\d+:\d+))?/);
-                this.pid = Number(pid);
-                if (socket) {
-                    this.addr = addr;
-                    this.port = Number(port);
-                }
-                super.emit('init', this.pid, this.addr, this.port);
-                res();
-            });
+        const tasks = new Map<number, Task>();
+        taskMap.set(this, tasks);
+        this.stdout.once('data', (data) => {
+            const [, pid, socket, addr, port] = String(data).match(/^pid=(\d+)(, addr=(\d+\.\d+\.\d+\.\d+), port=(\d+))?/);
+            this.pid = Number(pid);
+            if (socket) {
+                this.addr = addr;
+                this.port = Number(port);
+            }
+            super.emit('init', this.pid, this.addr, this.port);
+        });
+        // 回复带有请求编号，交给对应的 flush；之后的 message 监听器收到的仍是 { code, message, data }，
+        // 多行回复为 { replies }
+        super.on('message', (data: OCR.coutReturnType & { id?: number; replies?: OCR.coutReturnType[]; }) => {
+            const id = data.id;
+            delete data.id;
+            const task = tasks.get(id);
+            if (!task) return;
+            tasks.delete(id);
+            task.resolve(data.replies || data);
         });
         super.once('exit', (code) => {
             this.exitCode = code;
-            quqeMap.get(this).return(null);
+            tasks.forEach((task) => task.reject(new Error(`OCR exited with code ${code}.`)));
+            tasks.clear();
         });
     }
-    postMessage(obj: OCR.Arg) { OCR.prototype.flush.call(this, obj); }
-    async flush(obj: OCR.Arg) {
-        return (await quqeMap.get(this).next((res) => {
-            super.once('message', res);
-            super.postMessage(obj);
-        })).value;
+    /** 已发出、尚未回复的请求数 */
+    get pending() { return taskMap.get(this).size; }
+    postMessage(obj: OCR.Arg) { OCR.prototype.flush.call(this, obj).catch(() => null); }
+    /** 发出一个请求。可以连续调用而不等待，多个请求同时在途。多页文档与批量任务每页/每项一个结果，返回数组 */
+    flush(obj: OCR.Arg): Promise<OCR.coutReturnType | OCR.coutReturnType[]> {
+        if (this.exitCode !== null)
+            return Promise.reject(new Error(`OCR exited with code ${this.exitCode}.`));
+        const tasks = taskMap.get(this);
+        const id = nextId++;
+        return new Promise((resolve, reject) => {
+            tasks.set(id, { resolve, reject });
+            super.postMessage({ id, arg: obj });
+        });
     }
 }
 
 namespace OCR {
 
+    /** 多个引擎进程组成的池，每个请求交给未回复请求最少的进程 */
+    export class Pool {
+        readonly workers: OCR[] = [];
+        constructor(size: number, path?: string, args?: string[], options?: Options, debug?: boolean) {
+            for (let i = 0; i < Math.max(1, size); i++)
+                this.workers.push(new OCR(path, args, options, debug));
+        }
+        get pending() { return this.workers.reduce((sum, worker) => sum + worker.pending, 0); }
+        flush(obj: Arg): Promise<coutReturnType | coutReturnType[]> {
+            const alive = this.workers.filter((worker) => worker.exitCode === null);
+            if (!alive.length)
+                return Promise.reject(new Error('No OCR process is running.'));
+            return alive.reduce((a, b) => (b.pending < a.pending ? b : a)).flush(obj);
+        }
+        terminate() { return Promise.all(this.workers.map((worker) => worker.terminate())); }
+    }
+
     interface BaseArg {
         limit_side_len?: number;
         limit_type?: string;
@@ -62,12 +94,28 @@ namespace OCR {
     interface Arg_Base64 extends BaseArg {
         image_base64?: string;
     }
+    /** 以二进制帧发送图片文件字节（jpg/png等），省去 base64 编码 */
+    interface Arg_Bytes extends BaseArg {
+        image_bytes?: Uint8Array;
+    }
+    /** 以二进制帧发送未编码的 BGR/BGRA/灰度 像素 */
+    interface Arg_Pixels extends BaseArg {
+        image_pixels?: {
+            data: Uint8Array,
+            width: number,
+            height: number,
+            channels?: 1 | 3 | 4,
+            stride?: number,
+        };
+    }
 
-    export type Arg = Arg_Base64 | Arg_Path;
+    export type Arg = Arg_Base64 | Arg_Path | Arg_Bytes | Arg_Pixels;
 
     export interface coutReturnType {
         code: number;
         message: string;
+        /** 多页文档的页码、批量任务（images）的序号，从0起 */
+        index?: number;
         data: {
             box: [[number, number], [number, number], [number, number], [number, number]],
             score: number,
@@ -9,7 +9,85 @@ import subprocess  # 进程，管道
 import re  # regex
 from json import loads as jsonLoads, dumps as jsonDumps
 from sys import platform as sysPlatform  # popen静默模式
-from base64 import b64encode  # base64 编码
+import struct  # 二进制帧
+import asyncio  # 异步接口
+
+# 二进制帧：跳过 base64 与 json 解析，直接传输图片文件字节或像素
+FRAME_MAGIC = b"\x89OCR"
+FRAME_VERSION = 1
+FRAME_FORMATS = {"encoded": 0, "bgr": 1, "bgra": 2, "gray": 3}  # 负载格式
+FRAME_OPT_OVERRIDE, FRAME_OPT_DET, FRAME_OPT_CLS, FRAME_OPT_REC = 0x01, 0x02, 0x04, 0x08
+
+
+def packFrameHeader(
+    length: int,
+    format: str = "encoded",
+    width: int = 0,
+    height: int = 0,
+    stride: int = 0,
+    det: bool = None,
+    cls: bool = None,
+    rec: bool = None,
+) -> bytes:
+    """生成二进制帧的24字节帧头。\n
+    `length`: 负载字节数。\n
+    `format`: 负载格式，`encoded` 图片文件字节，`bgr`/`bgra`/`gray` 像素。\n
+    `width`/`height`/`stride`: 像素格式的宽、高、每行字节数（0表示紧密排列）。\n
+    `det`/`cls`/`rec`: 本次任务的开关，全部为None时使用引擎启动参数。\n
+    """
+    options = 0
+    if det is not None or cls is not None or rec is not None:
+        options = FRAME_OPT_OVERRIDE
+        options |= FRAME_OPT_DET if (det is None or det) else 0
+        options |= FRAME_OPT_CLS if cls else 0
+        options |= FRAME_OPT_REC if (rec is None or rec) else 0
+    return struct.pack(
+        "<4sBBBxIIII",
+        FRAME_MAGIC,
+        FRAME_VERSION,
+        FRAME_FORMATS[format],
+        options,
+        width,
+        height,
+        stride,
+        length,
+    )
+
+
+def buildCmds(exePath: str, modelsPath: str = None, argument: dict = None):
+    """生成启动引擎进程的命令行。
+
+    `return`: (命令行列表, 工作目录, Windows静默模式的startupinfo)
+"""
+    exePath = os.path.abspath(exePath)
+    cwd = os.path.abspath(os.path.join(exePath, os.pardir))  # 获取exe父文件夹
+    cmds = [exePath]
+    # 处理启动参数
+    if modelsPath is not None:
+        if os.path.exists(modelsPath) and os.path.isdir(modelsPath):
+            cmds += ["--models_path", os.path.abspath(modelsPath)]
+        else:
+            raise Exception(
+                f"Input modelsPath doesn't exits or isn't a directory. modelsPath: [{modelsPath}]"
+            )
+    if isinstance(argument, dict):
+        for key, value in argument.items():
+            # Popen() 要求输入list里所有的元素都是 str 或 bytes
+            if isinstance(value, bool):
+                cmds += [f"--{key}={value}"]  # 布尔参数必须键和值连在一起
+            elif isinstance(value, str):
+                cmds += [f"--{key}", value]
+            else:
+                cmds += [f"--{key}", str(value)]
+    # 设置子进程启用静默模式，不显示控制台窗口
+    startupinfo = None
+    if "win32" in str(sysPlatform).lower():
+        startupinfo = subprocess.STARTUPINFO()
+        startupinfo.dwFlags = (
+            subprocess.CREATE_NEW_CONSOLE | subprocess.STARTF_USESHOWWINDOW
+        )
+        startupinfo.wShowWindow = subprocess.SW_HIDE
+    return cmds, cwd, startupinfo
 
 
 class PPOCR_pipe:  # 调用OCR（管道模式）
@@ -22,35 +100,8 @@ class PPOCR_pipe:  # 调用OCR（管道模式）
         # 私有成员变量
         self.__ENABLE_CLIPBOARD = False
 
-        exePath = os.path.abspath(exePath)
-        cwd = os.path.abspath(os.path.join(exePath, os.pardir))  # 获取exe父文件夹
-        cmds = [exePath]
-        # 处理启动参数
-        if modelsPath is not None:
-            if os.path.exists(modelsPath) and os.path.isdir(modelsPath):
-                cmds += ["--models_path", os.path.abspath(modelsPath)]
-            else:
-                raise Exception(
-                    f"Input modelsPath doesn't exits or isn't a directory. modelsPath: [{modelsPath}]"
-                )
-        if isinstance(argument, dict):
-            for key, value in argument.items():
-                # Popen() 要求输入list里所有的元素都是 str 或 bytes
-                if isinstance(value, bool):
-                    cmds += [f"--{key}={value}"]  # 布尔参数必须键和值连在一起
-                elif isinstance(value, str):
-                    cmds += [f"--{key}", value]
-                else:
-                    cmds += [f"--{key}", str(value)]
-        # 设置子进程启用静默模式，不显示控制台窗口
+        cmds, cwd, startupinfo = buildCmds(exePath, modelsPath, argument)
         self.ret = None
-        startupinfo = None
-        if "win32" in str(sysPlatform).lower():
-            startupinfo = subprocess.STARTUPINFO()
-            startupinfo.dwFlags = (
-                subprocess.CREATE_NEW_CONSOLE | subprocess.STARTF_USESHOWWINDOW
-            )
-            startupinfo.wShowWindow = subprocess.SW_HIDE
         self.ret = subprocess.Popen(  # 打开管道
             cmds,
             cwd=cwd,
@@ -81,15 +132,21 @@ class PPOCR_pipe:  # 调用OCR（管道模式）
         """传入指令字典，发送给引擎进程。\n
         `writeDict`: 指令字典。\n
         `return`:  {"code": 识别码, "data": 内容列表或错误信息字符串}\n"""
+        writeStr = jsonDumps(writeDict, ensure_ascii=True, indent=None) + "\n"
+        return self._runRaw(writeStr.encode("utf-8"))
+
+    def _runRaw(self, *writeBytes):
+        """将一条完整指令（json行或二进制帧的各个分段）写入引擎进程，读取一行结果。\n
+        `return`:  {"code": 识别码, "data": 内容列表或错误信息字符串}\n"""
         # 检查子进程
         if not self.ret:
             return {"code": 901, "data": f"引擎实例不存在。"}
         if not self.ret.poll() == None:
             return {"code": 902, "data": f"子进程已崩溃。"}
         # 输入信息
-        writeStr = jsonDumps(writeDict, ensure_ascii=True, indent=None) + "\n"
         try:
-            self.ret.stdin.write(writeStr.encode("utf-8"))
+            for b in writeBytes:
+                self.ret.stdin.write(b)
             self.ret.stdin.flush()
         except Exception as e:
             return {
@@ -132,11 +189,43 @@ class PPOCR_pipe:  # 调用OCR（管道模式）
         return self.runDict(writeDict)
 
     def runBytes(self, imageBytes):
-        """对一张图片的字节流信息进行文字识别。\n
+        """对一张图片的字节流信息进行文字识别。以二进制帧发送原始字节，不做base64编码。\n
         `imageBytes`: 图片字节流。\n
         `return`:  {"code": 识别码, "data": 内容列表或错误信息字符串}\n"""
-        imageBase64 = b64encode(imageBytes).decode("utf-8")
-        return self.runBase64(imageBase64)
+        return self.runFrame(imageBytes)
+
+    def runFrame(self, imageBytes, **options):
+        """以二进制帧发送一张图片文件的字节流进行文字识别，省去base64编码。\n
+        `imageBytes`: 图片字节流（jpg/png等）。\n
+        `options`: 可选 `det`/`cls`/`rec` 开关。\n
+        `return`:  {"code": 识别码, "data": 内容列表或错误信息字符串}\n"""
+        data = memoryview(imageBytes).cast("B")
+        header = packFrameHeader(len(data), "encoded", **options)
+        return self._runRaw(header, data)
+
+    def runPixels(self, pixels, width: int, height: int, channels: int = 3, stride: int = 0, **options):
+        """以二进制帧发送未编码的像素进行文字识别，省去编解码。\n
+        `pixels`: 像素缓冲区（bytes、bytearray、numpy数组等），BGR/BGRA/灰度排列。\n
+        `width`/`height`: 图像宽高。`channels`: 通道数，3/4/1。\n
+        `stride`: 每行字节数，0表示紧密排列。\n
+        `options`: 可选 `det`/`cls`/`rec` 开关。\n
+        `return`:  {"code": 识别码, "data": 内容列表或错误信息字符串}\n"""
+        format = {3: "bgr", 4: "bgra", 1: "gray"}[channels]
+        data = memoryview(pixels).cast("B")
+        header = packFrameHeader(len(data), format, width, height, stride, **options)
+        return self._runRaw(header, data)
+
+    def runShm(self, shm, width: int, height: int, channels: int = 3, stride: int = 0, offset: int = 0):
+        """从命名共享内存读取像素进行文字识别，只传输共享内存名称，不传输像素。仅限引擎与调用方在同一台机器。\n
+        `shm`: `multiprocessing.shared_memory.SharedMemory` 对象，或共享内存名称字符串。\n
+        `width`/`height`: 图像宽高。`channels`: 通道数，3/4/1，即BGR/BGRA/灰度。\n
+        `stride`: 每行字节数，0表示紧密排列。`offset`: 图像在共享内存中的起始偏移。\n
+        返回之前，不要改写共享内存中的这块图像。\n
+        `return`:  {"code": 识别码, "data": 内容列表或错误信息字符串}\n"""
+        name = shm if isinstance(shm, str) else shm.name
+        format = {3: "BGR", 4: "BGRA", 1: "GRAY"}[channels]
+        writeDict = {"shm_name": name, "offset": offset, "w": width, "h": height, "stride": stride, "format": format}
+        return self.runDict(writeDict)
 
     def exit(self):
         """关闭引擎子进程"""
@@ -183,6 +272,9 @@ class PPOCR_socket(PPOCR_pipe):
         `modelsPath`: 识别库`models`文件夹的路径。若为None则默认识别库与识别器在同一目录下。\n
         `argument`: 启动参数，字典`{"键":值}`。参数说明见 https://github.com/hiroi-sora/PaddleOCR-json
         """
+        # 持久连接，多次调用复用同一个TCP连接
+        self.__sock = None
+        self.__recvBuf = b""
         # 处理参数
         if not argument:
             argument = {}
@@ -234,39 +326,41 @@ class PPOCR_socket(PPOCR_pipe):
         """传入指令字典，发送给引擎进程。\n
         `writeDict`: 指令字典。\n
         `return`:  {"code": 识别码, "data": 内容列表或错误信息字符串}\n"""
+        writeStr = jsonDumps(writeDict, ensure_ascii=True, indent=None) + "\n"
+        return self._runRaw(writeStr.encode())
 
+    def _runRaw(self, *writeBytes):
+        """将一条完整指令（json行或二进制帧的各个分段）发送给服务器，读取一行结果。\n
+        `return`:  {"code": 识别码, "data": 内容列表或错误信息字符串}\n"""
         # 仅在本地模式下检查引擎进程
         if self.__runningMode == "local":
-            # 检查子进程
             if not self.ret.poll() == None:
                 return {"code": 901, "data": f"子进程已崩溃。"}
 
         # 通信
-        writeStr = jsonDumps(writeDict, ensure_ascii=True, indent=None) + "\n"
-        try:
-            # 创建TCP连接
-            clientSocket = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
-            clientSocket.connect((self.ip, self.port))
-            # 发送数据
-            clientSocket.sendall(writeStr.encode())
-            # 发送完所有数据，关闭我方套接字，之后只能从服务器读取数据
-            clientSocket.shutdown(socket.SHUT_WR)
-            # 接收数据
-            resData = b""
-            while True:
-                chunk = clientSocket.recv(1024)
-                if not chunk:
-                    break
-                resData += chunk
-            getStr = resData.decode()
-        except ConnectionRefusedError:
-            return {"code": 902, "data": "连接被拒绝"}
-        except TimeoutError:
-            return {"code": 903, "data": "连接超时"}
-        except Exception as e:
-            return {"code": 904, "data": f"网络错误：{e}"}
-        finally:
-            clientSocket.close()  # 关闭连接
+        getStr = None
+        # 复用已有连接。连接可能已被服务器关闭，此时重新连接并重试一次
+        for retry in range(2):
+            try:
+                if self.__sock is None:
+                    self.__sock = socket.create_connection((self.ip, self.port))
+                    self.__recvBuf = b""
+                # 发送请求
+                for b in writeBytes:
+                    self.__sock.sendall(b)
+                # 接收一行回复。旧版服务器回复后关闭连接、不带换行符，同样兼容
+                getStr = self.__recvLine()
+                break
+            except ConnectionRefusedError:
+                self.__closeSocket()
+                return {"code": 902, "data": "连接被拒绝"}
+            except TimeoutError:
+                self.__closeSocket()
+                return {"code": 903, "data": "连接超时"}
+            except Exception as e:
+                self.__closeSocket()
+                if retry == 1:
+                    return {"code": 904, "data": f"网络错误：{e}"}
         # 反序列输出信息
         try:
             return jsonLoads(getStr)
@@ -276,6 +370,30 @@ class PPOCR_socket(PPOCR_pipe):
                 "data": f"识别器输出值反序列化JSON失败。异常信息：[{e}]。原始内容：[{getStr}]",
             }
 
+    def __recvLine(self) -> str:
+        """从持久连接中读取一行回复（不含换行符）。连接被关闭时返回已收到的内容。"""
+        while b"\n" not in self.__recvBuf:
+            chunk = self.__sock.recv(65536)
+            if not chunk:  # 服务器关闭连接
+                if not self.__recvBuf:
+                    raise ConnectionError("连接被服务器关闭")
+                line, self.__recvBuf = self.__recvBuf, b""
+                self.__closeSocket()
+                return line.decode()
+            self.__recvBuf += chunk
+        line, self.__recvBuf = self.__recvBuf.split(b"\n", 1)
+        return line.decode()
+
+    def __closeSocket(self):
+        """关闭持久连接"""
+        if self.__sock is not None:
+            try:
+                self.__sock.close()
+            except Exception:
+                pass
+        self.__sock = None
+        self.__recvBuf = b""
+
     def exit(self):
         """关闭引擎子进程"""
         # 仅在本地模式下关闭引擎进程
@@ -289,6 +407,7 @@ class PPOCR_socket(PPOCR_pipe):
                     print(f"[Error] ret.kill() {e}")
             self.ret = None
 
+        self.__closeSocket()
         self.ip = None
         self.port = None
         atexit.unregister(self.exit)  # 移除退出处理
@@ -318,6 +437,332 @@ class PPOCR_socket(PPOCR_pipe):
             return None
 
 
+class PPOCR_async:
+    """调用OCR（异步，asyncio）。一个实例对应一个引擎进程（管道）或一条套接字连接。\n
+    多个请求可以同时发出，不必等待上一个回复（流水线）。每条请求后附一条带id的空指令作为结束标记，
+    引擎按顺序处理，读到标记的回复时，此前收到的各行即为该请求的回复。用 `await PPOCR_async.create(...)` 创建。\n
+    多页文档（PDF、多页TIFF）与批量任务（`images`）每页/每项回复一行，合为列表返回，各项带有 `index`。
+    """
+
+    READ_LIMIT = 64 * 1024 * 1024  # 单行回复的最大字节数
+
+    def __init__(self):
+        self.proc = None  # 本地引擎进程
+        self.ip = None
+        self.port = None
+        self.__ENABLE_CLIPBOARD = False
+        self.__runningMode = None
+        self.__reader = None
+        self.__writer = None
+        self.__pending = {}  # 已发送、等待回复的 Future，键为请求所附结束标记的id
+        self.__replies = []  # 正在接收的请求已收到的回复行
+        self.__seq = 0  # 结束标记的序号
+        self.__writeLock = asyncio.Lock()  # 一条请求的各个分段连续写出
+        self.__tasks = []  # 接收回复、丢弃输出的后台任务
+        self.__closed = False
+
+    @classmethod
+    async def create(
+        cls,
+        exePath: str,
+        modelsPath: str = None,
+        argument: dict = None,
+        ipcMode: str = "pipe",
+    ):
+        """启动引擎进程，或连接远程服务器。\n
+        `exePath`: 识别器`PaddleOCR_json.exe`的路径。套接字模式下也可以是 `remote://ip:port`，直接连接已运行的服务器。\n
+        `modelsPath`: 识别库`models`文件夹的路径。若为None则默认识别库与识别器在同一目录下。\n
+        `argument`: 启动参数，字典`{"键":值}`。\n
+        `ipcMode`: 进程通信模式，管道模式`pipe` 或 套接字模式`socket`。\n
+        """
+        self = cls()
+        try:
+            await self.__start(exePath, modelsPath, argument, ipcMode)
+        except BaseException:
+            await self.close()
+            raise
+        return self
+
+    async def __start(self, exePath, modelsPath, argument, ipcMode):
+        match = re.search(r"remote://(.*):(\d+)", exePath)
+        if ipcMode == "socket" and match:  # 远程模式：直接连接
+            self.__runningMode = "remote"
+            self.ip, self.port = match.group(1), int(match.group(2))
+            if self.ip == "any":
+                self.ip = "0.0.0.0"
+            elif self.ip == "loopback":
+                self.ip = "127.0.0.1"
+            await self.__connect()
+            return
+        if ipcMode not in ("pipe", "socket"):
+            raise Exception(
+                f'ipcMode可选值为 套接字模式"socket" 或 管道模式"pipe" ，不允许{ipcMode}。'
+            )
+        self.__runningMode = "local"
+        argument = dict(argument) if argument else {}
+        if ipcMode == "socket":
+            argument.setdefault("port", 0)  # 随机端口号
+            argument.setdefault("addr", "loopback")  # 本地环回地址
+        cmds, cwd, startupinfo = buildCmds(exePath, modelsPath, argument)
+        self.proc = await asyncio.create_subprocess_exec(
+            *cmds,
+            cwd=cwd,
+            stdin=subprocess.PIPE,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.DEVNULL,  # 丢弃stderr的内容
+            startupinfo=startupinfo,  # 开启静默模式
+            limit=self.READ_LIMIT,
+        )
+        while True:
+            initStr = (await self.proc.stdout.readline()).decode("utf-8", errors="ignore")
+            if not initStr:  # 子进程已退出，初始化失败
+                raise Exception(f"OCR init fail.")
+            if "OCR init completed." in initStr:  # 初始化成功
+                break
+            elif "OCR clipboard enbaled." in initStr:  # 检测到剪贴板已启用
+                self.__ENABLE_CLIPBOARD = True
+        if ipcMode == "pipe":
+            self.__reader, self.__writer = self.proc.stdout, self.proc.stdin
+            self.__tasks.append(asyncio.ensure_future(self.__recvLoop()))
+            return
+        initStr = (await self.proc.stdout.readline()).decode("utf-8", errors="ignore")
+        if "Socket init completed. " not in initStr:
+            raise Exception(f"Socket init fail.")
+        splits = initStr.split("Socket init completed. ")[1].split(":")
+        self.ip, self.port = splits[0], int(splits[1])
+        # 持续读出并丢弃引擎的其余输出，防止缓冲区填满导致堵塞
+        self.__tasks.append(asyncio.ensure_future(self.__discard(self.proc.stdout)))
+        await self.__connect()
+
+    async def __connect(self):
+        self.__reader, self.__writer = await asyncio.open_connection(
+            self.ip, self.port, limit=self.READ_LIMIT
+        )
+        self.__tasks.append(asyncio.ensure_future(self.__recvLoop()))
+
+    @staticmethod
+    async def __discard(stream):
+        while await stream.read(65536):
+            pass
+
+    async def __recvLoop(self):
+        """逐行读取回复，读到结束标记时交给它所属的请求。流式中间结果（带 stage 键）不是回复，跳过。"""
+        try:
+            while True:
+                line = await self.__reader.readline()
+                if not line:  # 子进程退出或连接关闭
+                    break
+                try:
+                    res = jsonLoads(line.decode("utf-8", errors="ignore"))
+                except Exception as e:
+                    res = {
+                        "code": 904,
+                        "data": f"识别器输出值反序列化JSON失败。异常信息：[{e}]。原始内容：[{line}]",
+                    }
+                if isinstance(res, dict) and "stage" in res:
+                    continue
+                marker = res.get("id") if isinstance(res, dict) else None
+                fut = self.__pending.pop(marker, None) if isinstance(marker, str) else None
+                if fut is None:  # 请求的回复行
+                    self.__replies.append(res)
+                    continue
+                replies, self.__replies = self.__replies, []
+                if not fut.done():
+                    fut.set_result(replies[0] if len(replies) == 1 else replies)
+        except Exception as e:
+            reason = f"读取识别器输出值失败。异常信息：[{e}]"
+        else:
+            reason = "子进程已退出或连接已关闭。"
+        self.__fail({"code": 902, "data": reason})
+
+    def __fail(self, res: dict):
+        """结束所有未回复的请求"""
+        self.__closed = True
+        pending, self.__pending = self.__pending, {}
+        self.__replies = []
+        for fut in pending.values():
+            if not fut.done():
+                fut.set_result(dict(res))
+
+    def isClipboardEnabled(self) -> bool:
+        return self.__ENABLE_CLIPBOARD
+
+    def getRunningMode(self) -> str:
+        return self.__runningMode
+
+    @property
+    def pending(self) -> int:
+        """已发送、尚未回复的请求数"""
+        return len(self.__pending)
+
+    async def _runRaw(self, *writeBytes):
+        """发送一条完整指令（json行或二进制帧的各个分段），等待它的回复。\n
+        `return`:  {"code": 识别码, "data": 内容列表或错误信息字符串}，多行回复时为其列表\n"""
+        if self.__closed or self.__writer is None:
+            return {"code": 901, "data": f"引擎实例不存在或已关闭。"}
+        fut = asyncio.get_running_loop().create_future()
+        self.__seq += 1
+        marker = f"#ppocr-{self.__seq}"
+        try:
+            async with self.__writeLock:
+                self.__pending[marker] = fut
+                for b in writeBytes:
+                    self.__writer.write(b)
+                # 二进制帧不能带id，以紧随其后的空指令标记回复的结束。引擎回复它一行带id的错误码403
+                self.__writer.write(b'{"id":"' + marker.encode() + b'"}\n')
+                await self.__writer.drain()
+        except Exception as e:
+            self.__fail({"code": 902, "data": f"向识别器传入指令失败。{e}"})
+        return await fut
+
+    async def runDict(self, writeDict: dict):
+        """传入指令字典，发送给引擎。\n
+        `return`:  {"code": 识别码, "data": 内容列表或错误信息字符串}\n"""
+        writeStr = jsonDumps(writeDict, ensure_ascii=True, indent=None) + "\n"
+        return await self._runRaw(writeStr.encode("utf-8"))
+
+    async def run(self, imgPath: str):
+        """对一张本地图片进行文字识别。"""
+        return await self.runDict({"image_path": imgPath})
+
+    async def runClipboard(self):
+        """立刻对剪贴板第一位的图片进行文字识别。"""
+        if self.__ENABLE_CLIPBOARD:
+            return await self.run("clipboard")
+        else:
+            raise Exception("剪贴板功能不存在或已禁用。")
+
+    async def runBase64(self, imageBase64: str):
+        """对一张编码为base64字符串的图片进行文字识别。"""
+        return await self.runDict({"image_base64": imageBase64})
+
+    async def runBytes(self, imageBytes, **options):
+        """以二进制帧发送一张图片文件的原始字节进行文字识别。\n
+        `options`: 可选 `det`/`cls`/`rec` 开关。返回之前不要改写 imageBytes。\n"""
+        data = memoryview(imageBytes).cast("B")
+        header = packFrameHeader(len(data), "encoded", **options)
+        return await self._runRaw(header, data)
+
+    runFrame = runBytes
+
+    async def runPixels(self, pixels, width: int, height: int, channels: int = 3, stride: int = 0, **options):
+        """以二进制帧发送未编码的 BGR/BGRA/灰度 像素进行文字识别。参数同 PPOCR_pipe.runPixels。"""
+        format = {3: "bgr", 4: "bgra", 1: "gray"}[channels]
+        data = memoryview(pixels).cast("B")
+        header = packFrameHeader(len(data), format, width, height, stride, **options)
+        return await self._runRaw(header, data)
+
+    async def runShm(self, shm, width: int, height: int, channels: int = 3, stride: int = 0, offset: int = 0):
+        """从命名共享内存读取像素进行文字识别。参数同 PPOCR_pipe.runShm。"""
+        name = shm if isinstance(shm, str) else shm.name
+        format = {3: "BGR", 4: "BGRA", 1: "GRAY"}[channels]
+        writeDict = {"shm_name": name, "offset": offset, "w": width, "h": height, "stride": stride, "format": format}
+        return await self.runDict(writeDict)
+
+    async def close(self):
+        """关闭连接与引擎子进程。未回复的请求返回错误码902。"""
+        if self.__writer is not None:
+            try:
+                self.__writer.close()
+            except Exception:
+                pass
+            self.__writer = None
+        if self.proc is not None and self.proc.returncode is None:
+            try:
+                self.proc.kill()  # 关闭子进程
+                await self.proc.wait()
+            except Exception as e:
+                print(f"[Error] proc.kill() {e}")
+        self.proc = None
+        for task in self.__tasks:
+            task.cancel()
+        self.__tasks = []
+        self.__fail({"code": 902, "data": "引擎已关闭。"})
+
+    async def __aenter__(self):
+        return self
+
+    async def __aexit__(self, *exc):
+        await self.close()
+
+
+class PPOCR_pool:
+    """多个 PPOCR_async 组成的池（异步）。每个请求交给未回复请求最少的引擎，各引擎内部再流水线。\n
+    本地模式下每个成员是一个引擎进程；`remote://ip:port` 时每个成员是到同一服务器的一条连接。\n
+    用 `await PPOCR_pool.create(...)` 创建。
+    """
+
+    def __init__(self, members: list):
+        self.members = members
+
+    @classmethod
+    async def create(
+        cls,
+        exePath: str,
+        modelsPath: str = None,
+        argument: dict = None,
+        ipcMode: str = "pipe",
+        size: int = 2,
+    ):
+        """参数同 PPOCR_async.create。`size`: 引擎进程数（或连接数）。"""
+        results = await asyncio.gather(
+            *[PPOCR_async.create(exePath, modelsPath, argument, ipcMode) for _ in range(max(1, size))],
+            return_exceptions=True,
+        )
+        members = [r for r in results if isinstance(r, PPOCR_async)]
+        errors = [r for r in results if not isinstance(r, PPOCR_async)]
+        if errors:  # 任一成员启动失败时，关闭其余成员
+            await asyncio.gather(*[m.close() for m in members])
+            raise errors[0]
+        return cls(members)
+
+    def pick(self) -> PPOCR_async:
+        """未回复请求最少的成员"""
+        return min(self.members, key=lambda m: m.pending)
+
+    @property
+    def pending(self) -> int:
+        return sum(m.pending for m in self.members)
+
+    def isClipboardEnabled(self) -> bool:
+        return self.members[0].isClipboardEnabled()
+
+    def getRunningMode(self) -> str:
+        return self.members[0].getRunningMode()
+
+    async def runDict(self, writeDict: dict):
+        return await self.pick().runDict(writeDict)
+
+    async def run(self, imgPath: str):
+        return await self.pick().run(imgPath)
+
+    async def runClipboard(self):
+        return await self.pick().runClipboard()
+
+    async def runBase64(self, imageBase64: str):
+        return await self.pick().runBase64(imageBase64)
+
+    async def runBytes(self, imageBytes, **options):
+        return await self.pick().runBytes(imageBytes, **options)
+
+    runFrame = runBytes
+
+    async def runPixels(self, pixels, width: int, height: int, channels: int = 3, stride: int = 0, **options):
+        return await self.pick().runPixels(pixels, width, height, channels, stride, **options)
+
+    async def runShm(self, shm, width: int, height: int, channels: int = 3, stride: int = 0, offset: int = 0):
+        return await self.pick().runShm(shm, width, height, channels, stride, offset)
+
+    async def close(self):
+        await asyncio.gather(*[m.close() for m in self.members])
+
+    async def __aenter__(self):
+        return self
+
+    async def __aexit__(self, *exc):
+        await self.close()
+
+
 def GetOcrApi(
     exePath: str, modelsPath: str = None, argument: dict = None, ipcMode: str = "pipe"
 ):
@@ -335,3 +780,18 @@ def GetOcrApi(
         raise Exception(
             f'ipcMode可选值为 套接字模式"socket" 或 管道模式"pipe" ，不允许{ipcMode}。'
         )
+
+
+async def GetOcrApiAsync(
+    exePath: str,
+    modelsPath: str = None,
+    argument: dict = None,
+    ipcMode: str = "pipe",
+    size: int = 1,
+):
+    """获取异步识别器API对象，参数同 GetOcrApi。\n
+    `size`: 大于1时返回 PPOCR_pool，同时运行多个引擎进程（或多条连接）；否则返回 PPOCR_async。
+    """
+    if size > 1:
+        return await PPOCR_pool.create(exePath, modelsPath, argument, ipcMode, size)
+    return await PPOCR_async.create(exePath, modelsPath, argument, ipcMode)
@@ -0,0 +1,476 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+// ==================== 性能测试工具 ppocr_bench ====================
+// 读取一个目录下的全部图片，按指定的并发数、批大小与引擎池大小反复识别，
+// 统计端到端与各阶段耗时的分位数、吞吐量、内存峰值与内存分配次数，以json输出，
+// 便于在版本之间对比性能回退。OCR相关参数（模型、线程数、det/cls/rec等）与主程序相同。
+// 启用 bench_drift 时，另以全fp32的引擎为基准逐张比较识别文本，报告低精度（fp16/bf16/int8）带来的精度漂移。
+//
+// 示例：ppocr_bench --bench_dir=imgs --bench_concurrency=4 --bench_output=bench.json
+//       ppocr_bench --bench_dir=imgs --rec_precision=int8 --rec_model_dir=rec_quant --bench_drift
+
+// 版本信息
+#define PROJECT_VER "v1.4.1 dev.1"
+
+#include "opencv2/core.hpp"
+#include "opencv2/imgcodecs.hpp"
+
+#include "include/args.h"
+#include "include/engine_pool.h"
+#include "include/metrics.h"
+#include "include/nlohmann/json.hpp"
+#include "include/utility.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+DEFINE_string(bench_dir, "", "Directory of images to benchmark.");                        // 测试图片目录
+DEFINE_int32(bench_concurrency, 1, "Number of client threads sending requests.");        // 并发请求数
+DEFINE_int32(bench_batch, 1, "Images per request, >1 runs multi-image OCR.");            // 每个请求的图片数
+DEFINE_int32(bench_engines, 0, "Engine pool size, 0 for the same as bench_concurrency."); // 引擎池大小
+DEFINE_int32(bench_warmup, 5, "Warmup requests before measuring.");                      // 预热请求数，不计入统计
+DEFINE_int32(bench_rounds, 1, "How many times to go through the image directory.");     // 遍历图片目录的轮数
+DEFINE_string(bench_output, "", "Write the JSON report to this file, empty for stdout."); // 报告输出路径
+DEFINE_bool(bench_drift, false, "Compare recognized text against an FP32 engine.");        // true时以fp32引擎为基准，报告字符错误率等精度漂移
+DEFINE_string(bench_drift_models, "", "Reference det,cls,rec model dirs for drift, comma separated, empty to reuse."); // 基准引擎的 det,cls,rec 模型目录（逗号分隔，某项为空时沿用），用于量化模型与原模型对比
+
+// ==================== 内存分配计数 ====================
+// 替换全局 operator new，统计整个进程的分配次数与字节数
+
+static std::atomic<uint64_t> g_alloc_count(0);
+static std::atomic<uint64_t> g_alloc_bytes(0);
+
+static void *counted_alloc(size_t size)
+{
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    g_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    return malloc(size ? size : 1);
+}
+
+void *operator new(size_t size)
+{
+    void *p = counted_alloc(size);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *operator new[](size_t size)
+{
+    void *p = counted_alloc(size);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept { return counted_alloc(size); }
+void *operator new[](size_t size, const std::nothrow_t &) noexcept { return counted_alloc(size); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { free(p); }
+
+using namespace PaddleOCR;
+
+// 进程内存峰值，单位MB。失败时返回-1
+static double peak_rss_mb()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+    {
+        return pmc.PeakWorkingSetSize / (1024.0 * 1024.0);
+    }
+    return -1;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+        return usage.ru_maxrss / 1024.0; // Linux下单位为KB
+    }
+    return -1;
+#endif
+}
+
+// 样本的分位数统计（毫秒），取最近秩
+static nlohmann::json latency_json(std::vector<double> samples)
+{
+    nlohmann::json j;
+    j["count"] = samples.size();
+    if (samples.empty())
+    {
+        return j;
+    }
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        sum += samples[i];
+    }
+    const double qs[] = {0.5, 0.95, 0.99};
+    const char *names[] = {"p50", "p95", "p99"};
+    for (int k = 0; k < 3; k++)
+    {
+        size_t rank = size_t(std::ceil(qs[k] * samples.size()));
+        j[names[k]] = samples[rank > 0 ? rank - 1 : 0];
+    }
+    j["mean"] = sum / samples.size();
+    j["max"] = samples.back();
+    return j;
+}
+
+// 识别结果json中各文本行以换行连接，转为unicode码点。无文字或失败时为空
+static std::vector<uint32_t> reply_text(const std::string &reply, int &lines)
+{
+    std::vector<uint32_t> cps;
+    lines = 0;
+    nlohmann::json j = nlohmann::json::parse(reply, nullptr, false);
+    if (j.is_discarded() || !j.contains("code") || j["code"] != CODE_OK || !j["data"].is_array())
+    {
+        return cps;
+    }
+    for (size_t i = 0; i < j["data"].size(); i++)
+    {
+        if (i > 0)
+        {
+            cps.push_back('\n');
+        }
+        const std::string text = j["data"][i].value("text", std::string());
+        for (size_t k = 0; k < text.size();)
+        {
+            unsigned char c = text[k];
+            int len = c < 0x80 ? 1 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+            uint32_t cp = len == 1 ? c : c & (0x3F >> (len - 1));
+            for (int m = 1; m < len && k + m < text.size(); m++)
+            {
+                cp = (cp << 6) | (text[k + m] & 0x3F);
+            }
+            cps.push_back(cp);
+            k += len;
+        }
+    }
+    lines = int(j["data"].size());
+    return cps;
+}
+
+// 编辑距离
+static size_t edit_distance(const std::vector<uint32_t> &a, const std::vector<uint32_t> &b)
+{
+    std::vector<size_t> row(b.size() + 1);
+    for (size_t k = 0; k <= b.size(); k++)
+    {
+        row[k] = k;
+    }
+    for (size_t i = 1; i <= a.size(); i++)
+    {
+        size_t diag = row[0];
+        row[0] = i;
+        for (size_t k = 1; k <= b.size(); k++)
+        {
+            size_t up = row[k];
+            row[k] = std::min(std::min(row[k] + 1, row[k - 1] + 1), diag + (a[i - 1] == b[k - 1] ? 0 : 1));
+            diag = up;
+        }
+    }
+    return row[b.size()];
+}
+
+// 精度漂移：以全fp32的引擎为基准，逐张比较 pool 的识别文本
+static nlohmann::json drift_json(EnginePool &pool, const std::vector<cv::Mat> &images)
+{
+    std::vector<std::string> replies;
+    {
+        EnginePool::Lease engine = pool.acquire();
+        for (size_t i = 0; i < images.size(); i++)
+        {
+            replies.push_back(engine->run_ocr_mat(images[i]));
+        }
+    }
+    // 临时改为fp32（及基准模型）创建基准引擎，完成后恢复
+    std::string saved[] = {FLAGS_precision, FLAGS_det_precision, FLAGS_cls_precision, FLAGS_rec_precision,
+                           FLAGS_det_model_dir, FLAGS_cls_model_dir, FLAGS_rec_model_dir};
+    FLAGS_precision = "fp32";
+    FLAGS_det_precision = FLAGS_cls_precision = FLAGS_rec_precision = "";
+    std::string *model_dirs[] = {&FLAGS_det_model_dir, &FLAGS_cls_model_dir, &FLAGS_rec_model_dir};
+    std::stringstream ss(FLAGS_bench_drift_models);
+    std::string dir;
+    for (int k = 0; k < 3 && std::getline(ss, dir, ','); k++)
+    {
+        if (!dir.empty())
+        {
+            *model_dirs[k] = dir;
+        }
+    }
+    size_t errors = 0, ref_chars = 0;
+    int identical = 0, line_delta = 0;
+    {
+        EnginePool reference(1);
+        EnginePool::Lease engine = reference.acquire();
+        for (size_t i = 0; i < images.size(); i++)
+        {
+            int lines, ref_lines;
+            std::vector<uint32_t> text = reply_text(replies[i], lines);
+            std::vector<uint32_t> ref = reply_text(engine->run_ocr_mat(images[i]), ref_lines);
+            size_t dist = edit_distance(text, ref);
+            errors += dist;
+            ref_chars += ref.size();
+            identical += dist == 0;
+            line_delta += std::abs(lines - ref_lines);
+        }
+    }
+    FLAGS_precision = saved[0];
+    FLAGS_det_precision = saved[1];
+    FLAGS_cls_precision = saved[2];
+    FLAGS_rec_precision = saved[3];
+    FLAGS_det_model_dir = saved[4];
+    FLAGS_cls_model_dir = saved[5];
+    FLAGS_rec_model_dir = saved[6];
+
+    nlohmann::json j;
+    j["images"] = images.size();
+    j["cer"] = ref_chars > 0 ? double(errors) / ref_chars : 0.0; // 字符错误率，相对于基准文本
+    j["edit_distance"] = errors;
+    j["identical_images"] = identical; // 文本与基准完全相同的图片数
+    j["line_count_delta"] = line_delta; // 各图片文本行数之差的绝对值之和
+    return j;
+}
+
+// 识别结果json中的文本行数
+static int count_lines(const std::string &reply)
+{
+    nlohmann::json j = nlohmann::json::parse(reply, nullptr, false);
+    if (j.is_discarded() || !j.contains("code") || j["code"] != CODE_OK || !j["data"].is_array())
+    {
+        return 0;
+    }
+    return int(j["data"].size());
+}
+
+int main(int argc, char **argv)
+{
+    google::SetUsageMessage("ppocr_bench --bench_dir=DIR [FLAG1=ARG1] [FLAG2=ARG2]");
+    google::SetVersionString(PROJECT_VER);
+    google::ParseCommandLineFlags(&argc, &argv, true);
+    std::string configMsg = read_config();
+    if (!configMsg.empty())
+    {
+        std::cerr << configMsg << std::endl;
+    }
+    std::string checkMsg = check_flags();
+    if (FLAGS_bench_dir.empty())
+    {
+        checkMsg += "bench_dir is required. ";
+    }
+    if (FLAGS_bench_concurrency < 1 || FLAGS_bench_batch < 1 || FLAGS_bench_engines < 0 ||
+        FLAGS_bench_warmup < 0 || FLAGS_bench_rounds < 1)
+    {
+        checkMsg += "bench_concurrency, bench_batch and bench_rounds must be >= 1, "
+                    "bench_engines and bench_warmup must be >= 0. ";
+    }
+    if (!checkMsg.empty())
+    {
+        std::cerr << "[ERROR] " << checkMsg << std::endl;
+        return 1;
+    }
+    int engines = FLAGS_bench_engines > 0 ? FLAGS_bench_engines : FLAGS_bench_concurrency;
+
+    // 预先读入全部图片，读图解码不计入端到端耗时
+    std::vector<std::string> paths;
+    Utility::GetAllFiles(FLAGS_bench_dir.c_str(), paths);
+    std::sort(paths.begin(), paths.end());
+    std::vector<cv::Mat> images;
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        cv::Mat img = cv::imread(paths[i], cv::IMREAD_COLOR);
+        if (img.empty())
+        {
+            std::cerr << "[WARNING] skip unreadable file: " << paths[i] << std::endl;
+            continue;
+        }
+        images.push_back(img);
+    }
+    if (images.empty())
+    {
+        std::cerr << "[ERROR] no image found in " << FLAGS_bench_dir << std::endl;
+        return 1;
+    }
+
+    EnginePool pool(engines);
+
+    // 请求序列：图片按顺序循环，每 bench_batch 张为一个请求
+    int batch = FLAGS_bench_batch;
+    int total_images = int(images.size()) * FLAGS_bench_rounds;
+    int total_requests = (total_images + batch - 1) / batch;
+
+    std::atomic<int> next(0);
+    std::atomic<int> lines(0);
+    std::vector<std::vector<double>> latencies(FLAGS_bench_concurrency);
+    // 每个线程从 next 领取请求序号，直到达到 count。record 为真时记录耗时与行数
+    auto run = [&](int count, bool record)
+    {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < FLAGS_bench_concurrency; t++)
+        {
+            threads.emplace_back([&, t]
+                                 {
+                for (int r = next.fetch_add(1); r < count; r = next.fetch_add(1))
+                {
+                    int beg = (r * batch) % int(images.size());
+                    int n = std::min(batch, total_images - r * batch);
+                    if (!record)
+                    {
+                        n = batch;
+                    }
+                    std::vector<cv::Mat> imgs;
+                    for (int k = 0; k < n; k++)
+                    {
+                        imgs.push_back(images[(beg + k) % images.size()]);
+                    }
+                    EnginePool::Lease engine = pool.acquire();
+                    auto start = std::chrono::steady_clock::now();
+                    std::vector<std::string> replies;
+                    if (n == 1)
+                    {
+                        replies.push_back(engine->run_ocr_mat(imgs[0]));
+                    }
+                    else
+                    {
+                        replies = engine->run_ocr_mats(imgs);
+                    }
+                    std::chrono::duration<double, std::milli> ms = std::chrono::steady_clock::now() - start;
+                    if (record)
+                    {
+                        latencies[t].push_back(ms.count());
+                        int found = 0;
+                        for (size_t k = 0; k < replies.size(); k++)
+                        {
+                            found += count_lines(replies[k]);
+                        }
+                        lines.fetch_add(found);
+                    }
+                } });
+        }
+        for (size_t t = 0; t < threads.size(); t++)
+        {
+            threads[t].join();
+        }
+    };
+
+    // 预热
+    if (FLAGS_bench_warmup > 0)
+    {
+        std::cerr << "Warmup: " << FLAGS_bench_warmup << " requests" << std::endl;
+        run(FLAGS_bench_warmup, false);
+    }
+
+    // 正式测试
+    std::cerr << "Benchmark: " << total_requests << " requests, " << total_images << " images" << std::endl;
+    next.store(0);
+    Metrics::get().set_sampling(true);
+    uint64_t allocs_before = g_alloc_count.load();
+    uint64_t alloc_bytes_before = g_alloc_bytes.load();
+    auto wall_start = std::chrono::steady_clock::now();
+    run(total_requests, true);
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - wall_start;
+    uint64_t allocs = g_alloc_count.load() - allocs_before;
+    uint64_t alloc_bytes = g_alloc_bytes.load() - alloc_bytes_before;
+
+    // 汇总报告
+    std::vector<double> e2e;
+    for (size_t t = 0; t < latencies.size(); t++)
+    {
+        e2e.insert(e2e.end(), latencies[t].begin(), latencies[t].end());
+    }
+    nlohmann::json stages = nlohmann::json::object();
+    for (int i = 0; i < Metrics::STAGE_COUNT; i++)
+    {
+        Metrics::Stage stage = Metrics::Stage(i);
+        std::vector<double> samples = Metrics::get().samples(stage);
+        if (!samples.empty())
+        {
+            stages[Metrics::stage_name(stage)] = latency_json(samples);
+        }
+    }
+    Metrics::get().set_sampling(false);
+
+    nlohmann::json report;
+    report["version"] = PROJECT_VER;
+    report["config"] = {
+        {"bench_dir", FLAGS_bench_dir},
+        {"images", images.size()},
+        {"concurrency", FLAGS_bench_concurrency},
+        {"batch", batch},
+        {"engines", engines},
+        {"warmup", FLAGS_bench_warmup},
+        {"rounds", FLAGS_bench_rounds},
+        {"cpu_threads", FLAGS_cpu_threads},
+        {"enable_mkldnn", FLAGS_enable_mkldnn},
+        {"det", FLAGS_det},
+        {"cls", FLAGS_cls},
+        {"rec", FLAGS_rec},
+        {"precision", {{"det", stage_precision(FLAGS_det_precision)},
+                       {"cls", stage_precision(FLAGS_cls_precision)},
+                       {"rec", stage_precision(FLAGS_rec_precision)}}},
+    };
+    report["requests"] = total_requests;
+    report["images"] = total_images;
+    report["text_lines"] = lines.load();
+    report["wall_s"] = wall.count();
+    report["images_per_s"] = total_images / wall.count();
+    report["lines_per_s"] = lines.load() / wall.count();
+    report["latency_ms"] = {
+        {"e2e", latency_json(e2e)},
+        {"stages", stages},
+    };
+    report["peak_rss_mb"] = peak_rss_mb();
+    report["allocations"] = {
+        {"count", allocs},
+        {"bytes", alloc_bytes},
+        {"per_image", double(allocs) / total_images},
+    };
+    // 精度漂移在统计内存之后进行，基准引擎不计入内存峰值
+    if (FLAGS_bench_drift)
+    {
+        std::cerr << "Drift: comparing " << images.size() << " images against fp32" << std::endl;
+        report["drift"] = drift_json(pool, images);
+    }
+
+    std::string out = report.dump(2);
+    if (FLAGS_bench_output.empty())
+    {
+        std::cout << out << std::endl;
+    }
+    else
+    {
+        std::ofstream file(FLAGS_bench_output);
+        if (!file)
+        {
+            std::cerr << "[ERROR] cannot write " << FLAGS_bench_output << std::endl;
+            return 1;
+        }
+        file << out << std::endl;
+        std::cerr << "Report saved to " << FLAGS_bench_output << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,120 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#ifndef ADMISSION_H
+#define ADMISSION_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace PaddleOCR
+{
+    // ==================== 准入控制 ====================
+    // HTTP同步请求的有界排队：同时执行的请求数不超过 max_inflight，其余排队等待。
+    // 排队的总代价超过 max_queue 时立即拒绝（503），排队期间超过截止时间的请求在推理前丢弃（504）。
+    // 代价由调用方估算（如按像素数），默认每个请求为1。
+    // 有空闲名额时按调度顺序交给排队者：优先级高者先（严格优先级）；同一优先级内，
+    // 选取已获得代价最少的租户（按代价的公平分享，防止一个租户的大批量请求挤占其他租户）；再按先来后到
+    class AdmissionControl
+    {
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        enum Result
+        {
+            ADMIT_OK,      // 获得执行名额
+            ADMIT_FULL,    // 队列已满，拒绝
+            ADMIT_EXPIRED, // 等待期间超过截止时间，丢弃
+        };
+
+        // 优先级，数值越小越优先
+        enum Priority
+        {
+            PRIORITY_HIGH = 0,   // 交互式请求，如截图识别
+            PRIORITY_NORMAL = 1, // 默认
+            PRIORITY_LOW = 2,    // 批量回填等
+        };
+        static Priority parse_priority(const std::string &name); // high/interactive, normal, low/batch/bulk 或 0~2，无法识别时为 NORMAL
+
+        AdmissionControl(int max_inflight, int max_queue);
+
+        // 执行名额：持有期间占用一个并发名额，析构时归还，并记录执行耗时
+        class Ticket
+        {
+        public:
+            ~Ticket();
+
+            // 让出点：在多图请求的图片之间调用。是否有更高优先级的请求在排队
+            bool should_yield() const;
+            // 把名额让给排队中更高优先级的请求，自身重新排队（不受队列上限与截止时间限制），再次获得名额后返回。
+            // 调用前应先归还引擎，否则让出的名额可能借不到引擎
+            void yield();
+
+            Priority priority() const { return priority_; }
+            const std::string &tenant() const { return tenant_; }
+
+        private:
+            friend class AdmissionControl;
+            Ticket(AdmissionControl *owner, int cost, Priority priority, const std::string &tenant)
+                : owner_(owner), cost_(cost), priority_(priority), tenant_(tenant), start_(Clock::now()) {}
+            Ticket(const Ticket &) = delete;
+            Ticket &operator=(const Ticket &) = delete;
+
+            AdmissionControl *owner_;
+            int cost_;
+            Priority priority_;
+            std::string tenant_;
+            Clock::time_point start_;
+        };
+
+        // 申请执行名额，必要时排队等待直到 deadline。成功时 ticket 置为新名额
+        Result enter(int cost, Priority priority, const std::string &tenant,
+                     const Clock::time_point &deadline, Ticket *&ticket);
+        // 不排队：有空闲名额且无人排队时立即返回新名额，否则返回空。用于多图请求借用额外的并发名额
+        Ticket *try_enter(Priority priority, const std::string &tenant);
+        // 建议客户端重试前等待的秒数，按平均执行耗时与当前排队量估算
+        int retry_after() const;
+
+        int inflight() const;
+        int queued() const;
+        uint64_t rejected() const;
+        uint64_t expired() const;
+
+    private:
+        // 排队中的请求
+        struct Waiter
+        {
+            int cost;
+            Priority priority;
+            std::string tenant;
+            uint64_t seq;         // 排队序号，同等条件下先来先得
+            bool granted = false; // 已获得名额
+        };
+
+        void leave(double ms); // 归还名额
+        void dispatch();       // 按调度顺序把空闲名额交给排队者，须持有锁
+        void wait_granted(std::unique_lock<std::mutex> &lock, Waiter &w); // 排队直到获得名额，不限时
+        bool has_higher(Priority priority) const; // 是否有更高优先级的排队者，须持有锁
+
+        const int max_inflight_;
+        const int max_queue_;
+        int inflight_ = 0;
+        int queued_cost_ = 0;   // 排队中请求的代价之和
+        std::list<Waiter *> waiters_;         // 排队中的请求
+        std::map<std::string, double> served_; // 各租户在本轮竞争中已获得的代价，队列清空时重置
+        uint64_t seq_ = 0;
+        double avg_ms_ = 0;     // 执行耗时的指数滑动平均
+        uint64_t rejected_ = 0; // 因队列满被拒绝的请求数
+        uint64_t expired_ = 0;  // 因超过截止时间被丢弃的请求数
+        mutable std::mutex mutex_;
+        std::condition_variable cond_;
+    };
+
+} // namespace PaddleOCR
+
+#endif // ADMISSION_H
@@ -0,0 +1,52 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+#include <string>
+#include <vector>
+
+namespace PaddleOCR
+{
+    // ==================== CPU绑定 ====================
+    // 为引擎池中的各引擎分配互不重叠的CPU集合，借出引擎期间把调用线程及其OpenMP线程组绑定到该集合，
+    // 推理库的计算线程不再跨CPU插槽漂移。缓冲区由绑定后的线程首次写入，按操作系统的首次访问策略
+    // 分配在本NUMA节点上（Linux默认策略）。模型权重由首个引擎加载后共享，不做迁移。
+    // 支持 Linux（sched_setaffinity，NUMA拓扑读取 /sys/devices/system/node）与 Windows（单处理器组内）
+    class CpuAffinity
+    {
+    public:
+        typedef std::vector<int> CpuSet; // 逻辑CPU编号，升序
+
+        // 按 --engine_affinity 为 engines 个引擎各分配一组CPU，每个引擎计划使用 threads 个计算线程。
+        //   auto        每个引擎 threads 个CPU，先在NUMA节点内切块，再在各节点间轮流分配
+        //   node        每个引擎绑定一整个NUMA节点，引擎数多于节点数时轮流复用
+        //   列表        以分号分隔各引擎的CPU，如 "0-7;8-15"，或 "node0;node1"，条目少于引擎数时轮流复用
+        // 返回空表示不绑定。参数无效时 error 非空；CPU不足以无重叠分配时 warning 非空
+        static std::vector<CpuSet> plan(const std::string &spec, int engines, int threads,
+                                        std::string &error, std::string &warning);
+        static bool valid(const std::string &spec); // 供 check_flags 检查格式
+
+        // 各NUMA节点中本进程可用的CPU。无法获取拓扑时为一个包含全部可用CPU的节点
+        static std::vector<CpuSet> numa_nodes();
+        // 进程启动时可用的CPU（尊重 taskset / cgroup cpuset）
+        static const CpuSet &process_cpus();
+
+        // 把当前线程绑定到 cpus，成功时返回true
+        static bool bind_thread(const CpuSet &cpus);
+        // 把当前线程的OpenMP线程组（threads 个线程）逐个绑定到 cpus。OpenMP线程池按发起线程复用，
+        // 新创建的池线程继承发起线程的绑定，但复用的池线程不会，因此调用线程更换引擎时须重新绑定。
+        // 同时绑定推理库的 libiomp5（MKLDNN 的计算线程，仅 Linux）与本程序自身 OpenMP 代码的线程组；
+        // Windows 上只绑定后者，MKLDNN 的线程只受调用线程绑定的影响（新建的池线程继承之）
+        static void bind_openmp(const CpuSet &cpus, int threads);
+        // 当前线程恢复为进程启动时的CPU集合
+        static void unbind_thread();
+
+        static bool parse_list(const std::string &text, CpuSet &cpus); // 解析 "0-3,8,10-11"
+        static std::string describe(const CpuSet &cpus);              // 格式化为 "0-3,8,10-11"
+    };
+
+} // namespace PaddleOCR
+
+#endif // AFFINITY_H
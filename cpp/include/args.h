@@ -16,28 +16,81 @@
 
 #include <gflags/gflags.h>
 
+#include <string>
+#include <vector>
+
 // 工作模式
 DECLARE_string(image_path);
+DECLARE_string(video);
+DECLARE_string(batch);
+DECLARE_string(batch_output);
+DECLARE_int32(batch_workers);
+DECLARE_int32(batch_chunk);
 DECLARE_int32(port);
 DECLARE_string(addr);
+DECLARE_int32(max_request_mb);
 DECLARE_bool(server);
 DECLARE_int32(server_port);
+DECLARE_string(engine_affinity);
+DECLARE_int32(server_engines);
+DECLARE_int32(supervisor);
+DECLARE_int32(supervisor_timeout_ms);
+DECLARE_int32(supervisor_retries);
+DECLARE_string(router);
+DECLARE_int32(router_poll_ms);
+DECLARE_int32(router_timeout_ms);
+DECLARE_int32(server_jobs_max);
+DECLARE_int32(server_jobs_ttl);
+DECLARE_int32(server_max_inflight);
+DECLARE_int32(server_queue_max);
+DECLARE_int32(server_cost_pixels);
+DECLARE_int32(server_rec_max_lines);
+DECLARE_int32(trace_keep);
+DECLARE_string(trace_dir);
 
 // common args
 DECLARE_bool(use_gpu);
 DECLARE_bool(use_tensorrt);
 DECLARE_int32(gpu_id);
 DECLARE_int32(gpu_mem);
+DECLARE_bool(gpu_pipeline);
+DECLARE_bool(gpu_preprocess);
 DECLARE_int32(cpu_threads);
 DECLARE_int32(cpu_mem);
+DECLARE_int32(cpu_mem_low);
+DECLARE_int32(memory_poll_ms);
+DECLARE_int32(max_image_pixels);
+DECLARE_bool(incremental_ocr);
+DECLARE_int32(result_cache_mb);
+DECLARE_string(optim_cache_dir);
 DECLARE_bool(enable_mkldnn);
 DECLARE_string(precision);
+DECLARE_string(det_precision);
+DECLARE_string(cls_precision);
+DECLARE_string(rec_precision);
+DECLARE_string(det_backend);
+DECLARE_string(cls_backend);
+DECLARE_string(rec_backend);
+DECLARE_string(layout_backend);
+DECLARE_string(table_backend);
 DECLARE_bool(benchmark);
 DECLARE_string(output);
 DECLARE_string(type);
 DECLARE_string(config_path);
 DECLARE_string(models_path);
 DECLARE_bool(ensure_ascii);
+DECLARE_string(log_level);
+DECLARE_int32(log_sample);
+DECLARE_bool(warmup);
+DECLARE_bool(calibrate);
+DECLARE_int32(pipeline_queue);
+DECLARE_int32(decode_reduce);
+DECLARE_int32(pdf_dpi);
+DECLARE_int32(doc_threads);
+DECLARE_int32(doc_max_pages);
+DECLARE_double(video_fps);
+DECLARE_int32(video_hash_dist);
+DECLARE_int32(video_hold);
 // detection related
 DECLARE_string(det_model_dir);
 DECLARE_string(limit_type);
@@ -47,18 +100,37 @@ DECLARE_double(det_db_box_thresh);
 DECLARE_double(det_db_unclip_ratio);
 DECLARE_bool(use_dilation);
 DECLARE_string(det_db_score_mode);
+DECLARE_int32(det_tile_size);
+DECLARE_int32(det_tile_overlap);
+DECLARE_bool(det_adaptive);
+DECLARE_int32(det_adaptive_side);
+DECLARE_int32(det_adaptive_text_px);
+DECLARE_int32(det_adaptive_max_side);
+DECLARE_bool(det_adaptive_roi);
+DECLARE_bool(text_group);
+DECLARE_string(tbpu_parser);
+DECLARE_int32(det_postprocess_threads);
 DECLARE_bool(visualize);
 // classification related
 DECLARE_bool(use_angle_cls);
 DECLARE_string(cls_model_dir);
 DECLARE_double(cls_thresh);
 DECLARE_int32(cls_batch_num);
+DECLARE_int32(cls_sample);
+DECLARE_double(cls_recheck_score);
+DECLARE_bool(page_orient);
 // recognition related
 DECLARE_string(rec_model_dir);
 DECLARE_int32(rec_batch_num);
 DECLARE_string(rec_char_dict_path);
 DECLARE_int32(rec_img_h);
 DECLARE_int32(rec_img_w);
+DECLARE_int32(rec_batch_window_ms);
+DECLARE_int32(rec_batch_window_max);
+DECLARE_string(rec_width_buckets);
+DECLARE_int32(rec_decode_threads);
+DECLARE_string(rec_languages);
+DECLARE_int32(rec_memory_mb);
 // layout model related
 DECLARE_string(layout_model_dir);
 DECLARE_string(layout_dict_path);
@@ -80,4 +152,10 @@ DECLARE_bool(layout);
 // 读取配置文件
 std::string read_config();
 // 检测参数合法性
-std::string check_flags();
\ No newline at end of file
+std::string check_flags();
+// 各阶段的精度：det_precision 等为空时取 precision
+std::string stage_precision(const std::string &precision);
+// 识别宽度分桶，由 rec_width_buckets 解析，升序
+std::vector<int> rec_width_buckets();
+// 为以 models 开头的路径前置拼接预测库路径
+void prepend_models(const std::string &models_path_base, std::string &value);
@@ -21,6 +21,15 @@ std::string base64_encode_mime(std::string const& s);
 std::string base64_decode(std::string const& s, bool remove_linebreaks = false);
 std::string base64_encode(unsigned char const*, size_t len, bool url = false);
 
+//
+// PaddleOCR-json: decode straight into a caller-provided buffer, without
+// building an intermediate std::string. base64_decoded_size() returns the
+// exact output size for well-formed input (padded or not); out must hold
+// at least that many bytes. Throws std::runtime_error on invalid input.
+//
+size_t base64_decoded_size(char const* in, size_t len);
+size_t base64_decode_into (char const* in, size_t len, unsigned char* out);
+
 #if __cplusplus >= 201703L
 //
 // Interface with std::string_view rather than const std::string&
@@ -0,0 +1,82 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace PaddleOCR
+{
+    // 有界阻塞队列：满时 push 阻塞，空时 pop 阻塞。close() 后 push 失败，pop 取完剩余元素后失败。
+    template <typename T>
+    class BoundedQueue
+    {
+    public:
+        explicit BoundedQueue(size_t capacity) : capacity_(capacity < 1 ? 1 : capacity) {}
+
+        // 放入元素，队列已关闭时返回false
+        bool push(T item)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_full_.wait(lock, [this]
+                           { return closed_ || items_.size() < capacity_; });
+            if (closed_)
+                return false;
+            items_.push_back(std::move(item));
+            if (items_.size() > peak_)
+                peak_ = items_.size();
+            not_empty_.notify_one();
+            return true;
+        }
+
+        // 取出元素，队列已关闭且为空时返回false
+        bool pop(T &item)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_empty_.wait(lock, [this]
+                            { return closed_ || !items_.empty(); });
+            if (items_.empty())
+                return false;
+            item = std::move(items_.front());
+            items_.pop_front();
+            not_full_.notify_one();
+            return true;
+        }
+
+        // 关闭队列，唤醒所有等待者
+        void close()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+            not_full_.notify_all();
+            not_empty_.notify_all();
+        }
+
+        size_t size() const // 当前深度
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return items_.size();
+        }
+
+        size_t peak() const // 历史最大深度
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return peak_;
+        }
+
+    private:
+        size_t capacity_;
+        size_t peak_ = 0;
+        bool closed_ = false;
+        std::deque<T> items_;
+        mutable std::mutex mutex_;
+        std::condition_variable not_full_;
+        std::condition_variable not_empty_;
+    };
+
+} // namespace PaddleOCR
+
+#endif // BOUNDED_QUEUE_H
@@ -0,0 +1,53 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#ifndef DET_CUDA_H
+#define DET_CUDA_H
+
+#include "opencv2/core.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace PaddleOCR
+{
+    // ==================== det 的GPU前后处理 ====================
+    // 只上传一次 uint8 原图，在设备上完成缩放、归一化与通道重排，结果直接作为推理输入；
+    // 推理输出的概率图也在设备上二值化，只把8位的二值图与概率图复制回主机供 findContours 与框打分使用，
+    // 代替CPU路径上整图 float 输入的上传与整张 float 概率图的下载。
+    // 须以 WITH_CUDA_PREPROCESS 编译（定义 PPOCR_CUDA_PREPROCESS），否则 available() 为false。
+    // 每个检测器实例一个，非线程安全；出错时抛出 std::runtime_error
+    class DetCudaOps
+    {
+    public:
+        // stream：与推理实例相同的CUDA流，保证核函数与推理按顺序执行
+        explicit DetCudaOps(void *stream);
+        ~DetCudaOps();
+
+        static bool available(); // 是否编译了CUDA前后处理
+
+        // img 须为 CV_8UC3。返回设备上的 1x3xdst_hxdst_w 输入，下次调用前有效
+        float *Preprocess(const cv::Mat &img, int dst_h, int dst_w, const std::vector<float> &mean,
+                          const std::vector<float> &scale, bool is_scale);
+        // prob 为设备上 h×w 的概率图。bitmap 为二值图（0/255），score 为 round(prob*255)，
+        // 均为 CV_8UC1，引用内部的主机缓冲区，下次调用前有效
+        void Threshold(const float *prob, int h, int w, double thresh, cv::Mat &bitmap, cv::Mat &score);
+        void Release(); // 释放全部设备与主机缓冲区（内存清理时调用）
+
+    private:
+        DetCudaOps(const DetCudaOps &) = delete;
+        DetCudaOps &operator=(const DetCudaOps &) = delete;
+
+        void *stream_;
+        unsigned char *src_ = nullptr; // 设备：原图
+        size_t src_cap_ = 0;
+        float *input_ = nullptr; // 设备：归一化后的推理输入
+        size_t input_cap_ = 0;
+        unsigned char *maps_ = nullptr; // 设备：二值图与8位概率图，各 h×w
+        size_t maps_cap_ = 0;
+        unsigned char *host_maps_ = nullptr; // 主机锁页内存：maps_ 的副本
+        size_t host_maps_cap_ = 0;
+    };
+} // namespace PaddleOCR
+
+#endif // DET_CUDA_H
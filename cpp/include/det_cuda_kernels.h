@@ -0,0 +1,33 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#ifndef DET_CUDA_KERNELS_H
+#define DET_CUDA_KERNELS_H
+
+// det 预处理与二值化的CUDA核函数入口（src/cuda/det_kernels.cu）。
+// 只使用基本类型，使调用方无需以 nvcc 编译；stream 为 cudaStream_t，可为空（默认流）
+
+namespace PaddleOCR
+{
+    namespace cuda
+    {
+        // 逐通道归一化系数：out = v * a[c] + b[c]，与 NormalizePermute 的查找表一致
+        struct NormCoef
+        {
+            float a[3];
+            float b[3];
+        };
+
+        // BGR uint8（HWC，行跨度 src_step 字节）双线性缩放到 dst_w×dst_h，归一化并写成 CHW float。
+        // 缩放结果先取整到 uint8，与 cv::resize 后再归一化的CPU路径一致
+        int LaunchResizeNormalize(const unsigned char *src, int src_h, int src_w, int src_step,
+                                  float *dst, int dst_h, int dst_w, NormCoef coef, void *stream);
+
+        // 概率图二值化：bitmap[i] = uchar(prob*255) > thresh_q ? 255 : 0，与 DBPostProcessor::Binarize 一致；
+        // score[i] = round(prob*255)，作为框打分用的8位概率图
+        int LaunchThreshold(const float *prob, int n, float thresh_q,
+                            unsigned char *bitmap, unsigned char *score, void *stream);
+    } // namespace cuda
+} // namespace PaddleOCR
+
+#endif // DET_CUDA_KERNELS_H
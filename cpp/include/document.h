@@ -0,0 +1,69 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#ifndef DOCUMENT_H
+#define DOCUMENT_H
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+namespace PaddleOCR
+{
+    // ==================== 多页文档 ====================
+    // 直接接收PDF与多页TIFF，逐页光栅化为BGR图片，客户端无需先把每页转为PNG再base64编码。
+    // TIFF由OpenCV按页解码（cv::imdecodemulti，需OpenCV 4.7+，更早的版本只识别第一页并输出警告），
+    // PDF由PDFium渲染（需编译时开启 WITH_PDFIUM）
+    class Document
+    {
+    public:
+        virtual ~Document() {}
+
+        // 识别文件格式并打开：PDF与多页TIFF返回文档（复制一份数据，调用方的缓冲区随后即可释放），
+        // 其余格式（包括单页TIFF）返回空，按普通图片解码。
+        // limit_side_len 为检测的长边限制，--pdf_dpi 为0时据此选取PDF的渲染DPI
+        static Document *open(const void *data, size_t size, int limit_side_len);
+        static bool is_pdf(const void *data, size_t size); // 文件头为 %PDF-
+        static bool is_tiff(const void *data, size_t size); // 文件头为 II*\0 或 MM\0*（可能为多页）
+        static bool pdf_supported();                       // 是否编译了PDF支持
+
+        virtual int pages() const = 0;
+        // 光栅化第 page 页（从0起），失败时返回空。可在多个线程中并发调用
+        virtual cv::Mat render(int page) = 0;
+    };
+
+    // 按页序读出文档：threads 个线程提前光栅化后续页面，与识别并行，至多领先 ahead 页，
+    // 已光栅化未取走的页面不会无限堆积
+    class PageReader
+    {
+    public:
+        PageReader(const std::shared_ptr<Document> &doc, int first, int threads, int ahead);
+        ~PageReader();
+
+        // 按页序取下一页，全部取完时返回false。光栅化失败的页 page 为空
+        bool next(cv::Mat &page, int &index);
+
+    private:
+        void worker();
+
+        std::shared_ptr<Document> doc_;
+        int pages_;
+        int ahead_;
+        int next_render_; // 下一个待领取光栅化的页码
+        int next_take_;   // 下一个按序取走的页码
+        bool stop_ = false;
+        std::map<int, cv::Mat> done_; // 已光栅化、未取走的页面
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::vector<std::thread> threads_;
+    };
+
+} // namespace PaddleOCR
+
+#endif // DOCUMENT_H
@@ -0,0 +1,71 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#ifndef ENGINE_POOL_H
+#define ENGINE_POOL_H
+
+#include "include/affinity.h"
+#include "include/rec_batcher.h"
+#include "include/task.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace PaddleOCR
+{
+    // ==================== 引擎池 ====================
+    // 持有 N 个 Task 实例，第一个实例加载模型，其余实例通过 predictor Clone 共享权重。
+    // 每个请求借出一个空闲实例独占使用，用完自动归还；无空闲实例时阻塞等待。
+    // 启用 --engine_affinity 时各引擎分到一组CPU，借出期间调用线程绑定到该组，N个引擎×M个线程恰好铺满各核。
+    class EnginePool
+    {
+    public:
+        explicit EnginePool(int size);
+
+        // 借用凭证：持有期间独占一个引擎实例，析构时归还
+        class Lease
+        {
+        public:
+            Lease(Lease &&other);
+            ~Lease();
+            Task *operator->() const { return task_; }
+            Task &operator*() const { return *task_; }
+
+        private:
+            friend class EnginePool;
+            Lease(EnginePool *pool, int index);
+            Lease(const Lease &) = delete;
+            Lease &operator=(const Lease &) = delete;
+
+            EnginePool *pool_;
+            Task *task_;
+            int index_;
+        };
+
+        Lease acquire(); // 借出一个空闲引擎，无空闲时阻塞
+        int size() const;  // 引擎总数
+        int idle() const;  // 当前空闲引擎数
+        ResultCache *cache() const; // 结果缓存，无需借出引擎。未启用时为空
+        // 释放当前空闲、且本轮尚未释放的引擎的内存，返回本次释放数（供 MemoryGovernor 调用）。
+        // 释放期间该引擎不可借出
+        int release_idle(std::vector<bool> &released);
+        std::string memory_report() const; // 各引擎最大输入形状，如 "#0 det 1x3x960x960, rec 6x3x48x320; #1 ..."
+
+    private:
+        void release(int index); // 归还引擎
+        void bind(int index);    // 当前线程绑定到第 index 个引擎的CPU，未启用绑定时无操作
+        void unbind();
+
+        std::unique_ptr<RecBatcher> rec_batcher_;    // 跨请求识别批处理器，未启用时为空
+        std::vector<std::unique_ptr<Task>> engines_; // 所有引擎实例
+        std::vector<int> idle_;                      // 空闲引擎的下标栈
+        std::vector<CpuAffinity::CpuSet> affinity_;  // 各引擎的CPU集合，未启用绑定时为空
+        mutable std::mutex mutex_;
+        std::condition_variable cond_;
+    };
+
+} // namespace PaddleOCR
+
+#endif // ENGINE_POOL_H
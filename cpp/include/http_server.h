@@ -5,10 +5,15 @@
 #define HTTP_SERVER_H
 
 #include "include/httplib.h"
-#include "include/task.h"
+#include "include/admission.h"
+#include "include/engine_pool.h"
+#include "include/job_queue.h"
+#include "include/memory_governor.h"
 #include "opencv2/core.hpp"
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace PaddleOCR
 {
@@ -24,17 +29,69 @@ namespace PaddleOCR
     private:
         int port_;
         httplib::Server server_;
-        std::unique_ptr<Task> task_;
+        std::unique_ptr<EnginePool> pool_; // OCR引擎池，每个请求借用一个引擎
+        std::unique_ptr<JobQueue> jobs_;   // 异步任务队列，工作线程向引擎池借用引擎
+        std::unique_ptr<AdmissionControl> admission_; // 同步识别请求的并发与排队控制
+        std::unique_ptr<MemoryGovernor> governor_; // 后台内存管控，只清理空闲引擎。未限制内存时为空
 
         // Route handlers
-        void handle_ocr_upload(const httplib::Request &req, httplib::Response &res);
-        void handle_ocr_base64(const httplib::Request &req, httplib::Response &res);
+        // det_only 为true时是 /api/det：只检测，结果只有文本框
+        void handle_ocr_upload(const httplib::Request &req, httplib::Response &res, bool det_only = false);
+        void handle_ocr_base64(const httplib::Request &req, httplib::Response &res, bool det_only = false);
+        void handle_ocr_batch(const httplib::Request &req, httplib::Response &res);
+        void handle_rec(const httplib::Request &req, httplib::Response &res);
+        void handle_structure(const httplib::Request &req, httplib::Response &res);
         void handle_health(const httplib::Request &req, httplib::Response &res);
         void handle_version(const httplib::Request &req, httplib::Response &res);
+        void handle_metrics(const httplib::Request &req, httplib::Response &res);
+        void handle_trace(const httplib::Request &req, httplib::Response &res); // 最近请求的追踪，format=otlp 时为 OTLP json
+        void handle_job_submit(const httplib::Request &req, httplib::Response &res);
+        void handle_job_get(const httplib::Request &req, httplib::Response &res);
+        void handle_job_events(const httplib::Request &req, httplib::Response &res);
 
         // Helper methods
         cv::Mat decode_image_from_bytes(const std::string &data);
+        // options 非空时按 Task::imdecode_for_ocr 缩小解码，倍数记入 options
+        cv::Mat decode_image_from_bytes(const void *data, size_t size, OCROptions *options = nullptr);
+        // 识别PDF与多页TIFF（见 Task::open_document）：文档取出首页存入 first，多页时 doc 非空；
+        // 不是文档时两者均为空，由调用方按普通图片解码。文档有误时回复 415/413/400 并返回false
+        bool open_document(const void *data, size_t size, const OCROptions &options,
+                           std::shared_ptr<Document> &doc, cv::Mat &first, httplib::Response &res);
+        // 回复多页文档的结果：默认为各页结果的数组；stream 时以 NDJSON 逐行返回 {"index":页码,"result":结果}，按页序
+        void reply_document(const std::shared_ptr<Document> &doc, const cv::Mat &first, httplib::Response &res,
+                            const std::shared_ptr<AdmissionControl::Ticket> &ticket, const std::string &parser,
+                            const OCROptions &options, bool stream);
+        // 将多张图片分给引擎池中的引擎并行识别，每得到一张图片的结果就调用 on_result(下标, 结果json)。
+        // 除 ticket 外，每多用一个引擎另借一个空闲名额；图片之间有更高优先级的请求排队时让出引擎与名额。
+        // on_result 在各工作线程中调用，需自行加锁
+        void run_batch(const std::vector<cv::Mat> &imgs, AdmissionControl::Ticket &ticket, const std::string &parser,
+                       const OCROptions &options, const std::function<void(size_t, const std::string &)> &on_result);
         std::string create_error_response(int code, const std::string &message);
+        bool reject_oversize(const cv::Mat &img, httplib::Response &res); // 准入控制：图片超过 max_image_pixels 时回复413并返回true
+        bool restrict_det_only(httplib::Response &res, OCROptions &options); // /api/det：关闭本次请求的cls与rec，未启用det时回复400并返回false
+        bool reject_roi(cv::Mat &img, const OCROptions &options, httplib::Response &res); // 把图片裁切为请求的ROI，与图片不相交时回复400并返回true
+        bool wants_stream(const httplib::Request &req) const;    // 请求是否带有 ?stream=1
+        // 以 NDJSON 流式回复：先是各阶段的中间结果，最后一行为最终结果。ticket 在回复写完后释放
+        void stream_ocr(const cv::Mat &img, httplib::Response &res,
+                        const std::shared_ptr<AdmissionControl::Ticket> &ticket, const std::string &parser,
+                        const OCROptions &options);
+        // 排版解析方案：取自 parser 参数、表单字段，或json请求体中的同名字段（由调用方传入），为空时使用 tbpu_parser。
+        // 方案未知时回复400并返回false
+        bool request_parser(const httplib::Request &req, httplib::Response &res, const std::string &body_parser,
+                            std::string &parser);
+        // 本次请求的参数覆盖（见 Task::parse_options）：取自json请求体（由调用方传入，非对象时忽略），
+        // 其次为表单字段与URL参数，后者优先。取值无效时回复400并返回false
+        bool request_options(const httplib::Request &req, httplib::Response &res, const nlohmann::json &body,
+                             OCROptions &options);
+        // 准入：申请执行名额，排队直到请求的截止时间（X-Request-Timeout-Ms 头或 timeout_ms 参数）。
+        // 优先级与租户取自 X-Priority / X-Tenant 头、priority / tenant 参数，或json请求体中的同名字段（由调用方传入），
+        // 未指定租户时按客户端地址区分。队列满时回复503与Retry-After，超时回复504，均返回空
+        std::shared_ptr<AdmissionControl::Ticket> admit(const httplib::Request &req, httplib::Response &res, int cost,
+                                                        const std::string &body_priority = "",
+                                                        const std::string &body_tenant = "");
+        int request_cost(const cv::Mat &img) const; // 图片的准入代价
+        // 异步任务的回复写入 out。结果无法序列化（如含无效UTF-8）时 out 为500错误，返回false
+        bool create_job_response(const std::string &id, JobQueue::State state, const std::string &result, std::string &out);
         void setup_routes();
         void log_request(const std::string &method, const std::string &path, int status, long duration_ms);
     };
@@ -0,0 +1,80 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#ifndef JOB_QUEUE_H
+#define JOB_QUEUE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace PaddleOCR
+{
+    // ==================== 异步任务队列 ====================
+    // 客户端提交任务后立即返回任务ID，由后台工作线程执行，结果按ID轮询或等待获取。
+    // 已完成的任务保留 ttl 秒后清理；同时保留的任务数有上限，队列满时拒绝提交。
+    class JobQueue
+    {
+    public:
+        enum State
+        {
+            JOB_UNKNOWN, // 不存在或已过期
+            JOB_PENDING, // 排队中
+            JOB_RUNNING, // 执行中
+            JOB_DONE,    // 已完成，结果可取
+        };
+
+        // workers: 工作线程数；max_jobs: 同时保留的任务数上限；ttl_s: 已完成任务的保留秒数
+        JobQueue(int workers, int max_jobs, int ttl_s);
+        ~JobQueue();
+
+        enum Submit
+        {
+            SUBMIT_OK,
+            SUBMIT_DUPLICATE, // id 已存在
+            SUBMIT_FULL,      // 保留的任务数已达上限
+        };
+
+        // 提交任务，fn 返回结果json字符串，不应抛出异常。id 为空时自动生成并写回
+        Submit submit(std::string &id, std::function<std::string()> fn);
+
+        // 查询任务。timeout_ms > 0 时，在未完成期间最多等待这么久（长轮询）
+        State wait(const std::string &id, int timeout_ms, std::string &result);
+
+        static const char *state_name(State state);
+
+        int pending(); // 排队中（未开始执行）的任务数
+
+    private:
+        struct Job
+        {
+            std::function<std::string()> fn;
+            State state;
+            std::string result;
+            std::chrono::steady_clock::time_point done_at;
+        };
+
+        void worker();  // 工作线程
+        void expire();  // 清理过期任务，调用方需持有锁
+
+        int max_jobs_;
+        std::chrono::seconds ttl_;
+        unsigned long long next_id_ = 1; // 自动生成的ID序号
+        std::unordered_map<std::string, Job> jobs_;
+        std::deque<std::string> queue_; // 待执行的任务ID
+        bool stop_ = false;
+        std::mutex mutex_;
+        std::condition_variable job_cond_;  // 通知工作线程：有新任务
+        std::condition_variable done_cond_; // 通知等待方：有任务完成
+        std::vector<std::thread> threads_;
+    };
+
+} // namespace PaddleOCR
+
+#endif // JOB_QUEUE_H
@@ -0,0 +1,62 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include "include/utility.h" // Quad
+
+namespace PaddleOCR
+{
+    // ==================== JSON流式写入 ====================
+    // 把JSON文本直接追加到调用方的字符串中，不构造 nlohmann::json 对象，不逐项分配内存。
+    // 字符串转义与数字格式与 nlohmann::json::dump(-1, ' ', ensure_ascii) 一致（浮点数同为最短表示，
+    // NaN/Inf 输出 null）。nlohmann 的对象按键名排序，调用方按字母序写入键即可得到逐字节相同的输出。
+    // 字符串含无效UTF-8时 ok() 为false（对应 dump 抛出的异常），输出内容不可用
+    class JsonWriter
+    {
+    public:
+        JsonWriter(std::string &out, bool ensure_ascii) : out_(out), ensure_ascii_(ensure_ascii) {}
+
+        JsonWriter &begin_object();
+        JsonWriter &end_object();
+        JsonWriter &begin_array();
+        JsonWriter &end_array();
+        JsonWriter &key(const char *name); // 键名须为无需转义的ASCII
+
+        JsonWriter &value(const std::string &text) { return string(text.data(), text.size()); }
+        JsonWriter &value(const char *text);
+        JsonWriter &value(bool flag);
+        JsonWriter &value(double number);
+        JsonWriter &value(const Quad &box); // [[x,y],[x,y],[x,y],[x,y]]
+        template <typename T>
+        typename std::enable_if<std::is_integral<T>::value, JsonWriter &>::type value(T number)
+        {
+            return std::is_signed<T>::value ? integer(static_cast<long long>(number))
+                                            : unsigned_integer(static_cast<unsigned long long>(number));
+        }
+        JsonWriter &raw(const std::string &json); // 写入已序列化的JSON文本
+
+        bool ok() const { return ok_; }
+
+    private:
+        void separator();
+        JsonWriter &string(const char *text, size_t size);
+        JsonWriter &integer(long long number);
+        JsonWriter &unsigned_integer(unsigned long long number);
+
+        std::string &out_;
+        bool ensure_ascii_;
+        bool ok_ = true;
+        bool after_key_ = false;
+        int depth_ = 0;
+        uint64_t first_ = 0; // 位栈：第 d 位表示第 d 层容器尚无元素（嵌套不超过64层）
+    };
+
+} // namespace PaddleOCR
+
+#endif // JSON_WRITER_H
@@ -0,0 +1,58 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#ifndef LABEL_TABLE_H
+#define LABEL_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace PaddleOCR
+{
+    // ==================== 识别字典 ====================
+    // 识别模型的标签表：下标0为CTC空白 "#"，之后为字典各行，末尾为空格。
+    // 全部字符存放在一段连续的UTF-8文本中，另有一个 uint32 偏移数组：第i个字符为 chars[offsets[i], offsets[i+1])。
+    // 可以从文本字典解析，也可以直接映射预编译的二进制字典（.bin），映射为只读共享，多个进程使用同一份页缓存。
+    // 同一路径的标签表在进程内只加载一次，所有识别器（包括克隆体、各语言的识别器）共享
+    class LabelTable
+    {
+    public:
+        // 加载字典。path 以 .bin 结尾时按二进制字典映射；否则解析文本字典，
+        // cache_dir 非空时先找其中编译好且与源文件一致（大小与修改时间）的 .bin，没有时解析后写入。失败时退出程序
+        static std::shared_ptr<const LabelTable> load(const std::string &path, const std::string &cache_dir = "");
+        // 把文本字典编译为二进制字典，写入临时文件后改名。成功返回true
+        static bool compile(const std::string &dict_path, const std::string &bin_path);
+
+        ~LabelTable();
+
+        uint32_t size() const { return count_; } // 标签数（含空白与末尾空格）
+        const char *chars() const { return chars_; }
+        const uint32_t *offsets() const { return offsets_; }
+        size_t length(uint32_t i) const { return offsets_[i + 1] - offsets_[i]; }
+        std::string at(uint32_t i) const { return std::string(chars_ + offsets_[i], length(i)); }
+        bool mapped() const { return map_ != nullptr; } // 是否为映射的二进制字典
+
+    private:
+        LabelTable() {}
+        LabelTable(const LabelTable &) = delete;
+        LabelTable &operator=(const LabelTable &) = delete;
+
+        static std::shared_ptr<LabelTable> parse(const std::string &path);
+        static std::shared_ptr<LabelTable> map(const std::string &path, uint64_t source_size, int64_t source_mtime,
+                                               bool check_source);
+
+        uint32_t count_ = 0;
+        const char *chars_ = nullptr;
+        const uint32_t *offsets_ = nullptr;
+        std::string storage_chars_;         // 解析文本字典时的存储，映射时为空
+        std::unique_ptr<uint32_t[]> storage_offsets_;
+        void *map_ = nullptr;               // 映射的起始地址
+        size_t map_size_ = 0;
+        void *map_handle_ = nullptr;        // Windows 的文件映射句柄
+    };
+
+} // namespace PaddleOCR
+
+#endif // LABEL_TABLE_H
@@ -0,0 +1,102 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace PaddleOCR
+{
+    // ==================== 异步日志 ====================
+    // 请求线程只把日志放入无锁环形缓冲区，由后台线程批量写到 stderr，
+    // 终端或日志收集端变慢时不会阻塞识别。缓冲区满时丢弃新日志并计数。
+
+    enum LogLevel
+    {
+        LOG_LEVEL_DEBUG,
+        LOG_LEVEL_INFO,
+        LOG_LEVEL_WARN,
+        LOG_LEVEL_ERROR,
+    };
+
+    class Logger
+    {
+    public:
+        static Logger &get(); // 进程内唯一实例，首次使用时按 --log_level、--log_sample 初始化
+
+        bool enabled(LogLevel level) const { return level >= level_; }
+        bool sampled(); // 按 --log_sample 采样：每N条高频日志记录一条
+        void write(LogLevel level, std::string msg); // 放入缓冲区，不阻塞
+        void flush(); // 等待已放入缓冲区的日志写出
+
+    private:
+        static const size_t CAPACITY = 4096; // 缓冲区槽数，须为2的幂
+
+        struct Slot
+        {
+            std::atomic<size_t> seq; // 槽的序号，标识槽当前可写还是可读
+            int level;
+            int64_t time_ms; // 写入时刻（自纪元起的毫秒数）
+            std::string msg;
+        };
+
+        Logger();
+        ~Logger();
+        Logger(const Logger &) = delete;
+        Logger &operator=(const Logger &) = delete;
+
+        bool pop(Slot &out); // 取出一条，仅后台线程调用
+        void worker();       // 后台线程：批量取出并写出
+
+        LogLevel level_;
+        int sample_;
+        std::atomic<uint64_t> sample_counter_;
+        std::unique_ptr<Slot[]> slots_;
+        std::atomic<size_t> head_;    // 下一个写入位置（多个生产者竞争）
+        size_t tail_ = 0;             // 下一个读取位置（只有后台线程访问）
+        std::atomic<uint64_t> dropped_;
+        std::atomic<uint64_t> written_; // 后台线程已写出的条数，用于 flush
+        std::atomic<bool> stop_;
+        std::mutex wake_mutex_;
+        std::condition_variable wake_cond_; // 仅用于 flush 与退出时唤醒后台线程，写日志时不加锁
+        std::thread thread_;
+    };
+
+} // namespace PaddleOCR
+
+// 日志宏：级别未启用时不格式化。x 为流式表达式，如 OCR_LOG_INFO("size: " << n)
+#define OCR_LOG(level, x)                                                  \
+    do                                                                     \
+    {                                                                      \
+        if (PaddleOCR::Logger::get().enabled(level))                       \
+        {                                                                  \
+            std::ostringstream _log_oss;                                   \
+            _log_oss << x;                                                 \
+            PaddleOCR::Logger::get().write(level, _log_oss.str());         \
+        }                                                                  \
+    } while (0)
+#define OCR_LOG_DEBUG(x) OCR_LOG(PaddleOCR::LOG_LEVEL_DEBUG, x)
+#define OCR_LOG_INFO(x) OCR_LOG(PaddleOCR::LOG_LEVEL_INFO, x)
+#define OCR_LOG_WARN(x) OCR_LOG(PaddleOCR::LOG_LEVEL_WARN, x)
+#define OCR_LOG_ERROR(x) OCR_LOG(PaddleOCR::LOG_LEVEL_ERROR, x)
+// 高频日志（如每个请求一条），按 --log_sample 采样
+#define OCR_LOG_SAMPLED(level, x)                                                       \
+    do                                                                                  \
+    {                                                                                   \
+        if (PaddleOCR::Logger::get().enabled(level) && PaddleOCR::Logger::get().sampled()) \
+        {                                                                               \
+            std::ostringstream _log_oss;                                                \
+            _log_oss << x;                                                              \
+            PaddleOCR::Logger::get().write(level, _log_oss.str());                      \
+        }                                                                               \
+    } while (0)
+
+#endif // LOGGER_H
@@ -0,0 +1,57 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#ifndef MEMORY_GOVERNOR_H
+#define MEMORY_GOVERNOR_H
+
+#include "opencv2/core.hpp"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace PaddleOCR
+{
+    // ==================== 内存管控 ====================
+    // 后台线程定期读取进程内存占用，带高低水位的滞回：达到高水位（cpu_mem）时开始清理，
+    // 只清理当前空闲的引擎，忙碌的引擎留到下次轮询；降到低水位以下时停止。
+    // 全部引擎都清理过仍高于低水位时放弃本轮，直到内存继续上涨才再次触发，避免反复清理。
+    // 内存明显上涨或触发清理时，记录各引擎自上次清理以来最大的输入形状，便于定位是哪类输入撑大了内存。
+    class MemoryGovernor
+    {
+    public:
+        // 释放空闲引擎的内存，返回本次释放的引擎数。released[i] 为本轮中第 i 个引擎是否已释放，释放后由回调置为true
+        typedef std::function<int(std::vector<bool> &released)> ReleaseIdle;
+        // 各引擎最大输入形状的描述，用于日志
+        typedef std::function<std::string()> Report;
+
+        MemoryGovernor(int engines, const ReleaseIdle &release_idle, const Report &report);
+        ~MemoryGovernor();
+
+        // 准入控制：图片像素数不超过 max_image_pixels 时返回true
+        static bool admit(const cv::Mat &img);
+
+    private:
+        MemoryGovernor(const MemoryGovernor &) = delete;
+        MemoryGovernor &operator=(const MemoryGovernor &) = delete;
+
+        void loop();
+
+        int engines_;
+        int high_mb_; // 高水位，达到时开始清理
+        int low_mb_;  // 低水位，降到以下时停止清理
+        ReleaseIdle release_idle_;
+        Report report_;
+
+        bool stop_ = false;
+        std::mutex mutex_;
+        std::condition_variable cond_;
+        std::thread thread_;
+    };
+
+} // namespace PaddleOCR
+
+#endif // MEMORY_GOVERNOR_H
@@ -0,0 +1,118 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "include/trace.h"
+
+namespace PaddleOCR
+{
+    // ==================== 运行指标 ====================
+    // 各阶段耗时、每图文本框数的直方图与请求计数，以 Prometheus 文本格式输出。
+    // 计数全部为原子操作，记录时不加锁，可在任意线程中调用。
+
+    // 固定分桶的直方图。bounds 为各桶上界（升序），另有一个 +Inf 桶
+    class Histogram
+    {
+    public:
+        static const int MAX_BUCKETS = 16;
+
+        Histogram(const double *bounds, int count);
+        void observe(double value);
+        // 以 Prometheus 格式输出，labels 形如 stage="det_pre"，可为空
+        void render(std::string &out, const std::string &name, const std::string &labels,
+                    double scale = 1) const;
+
+    private:
+        const double *bounds_;
+        int count_;
+        std::atomic<uint64_t> buckets_[MAX_BUCKETS + 1]; // 各桶的非累积计数，最后一个为 +Inf
+        std::atomic<uint64_t> sum_;                       // 观测值之和，单位为 1/1000
+        std::atomic<uint64_t> total_;
+    };
+
+    class Metrics
+    {
+    public:
+        enum Stage
+        {
+            STAGE_DECODE,    // 读图解码
+            STAGE_DET_PRE,   // 检测：预处理
+            STAGE_DET_INFER, // 检测：推理
+            STAGE_DET_POST,  // 检测：后处理
+            STAGE_CROP,      // 裁切文本碎图
+            STAGE_CLS,       // 方向分类（整个阶段）
+            STAGE_REC_PRE,   // 识别：预处理
+            STAGE_REC_INFER, // 识别：推理
+            STAGE_REC_POST,  // 识别：后处理
+            STAGE_JSON,      // 结果编码为json
+            STAGE_COUNT,
+        };
+
+        static Metrics &get(); // 进程内唯一实例
+
+        void observe(Stage stage, double ms) // 记录一次阶段耗时，单位毫秒
+        {
+            stages_[stage]->observe(ms);
+            if (sampling_.load(std::memory_order_relaxed))
+            {
+                record_sample(stage, ms);
+            }
+        }
+        void observe_boxes(int boxes) { boxes_.observe(boxes); }              // 记录一张图片的文本框数
+        void count_request(int status);                                       // 记录一个HTTP请求的状态码
+
+        // 以 Prometheus 文本格式输出全部指标
+        std::string render() const;
+
+        // 原始样本：开启后额外保存每次阶段耗时，供基准测试计算分位数。开启/关闭时清空已有样本
+        void set_sampling(bool on);
+        std::vector<double> samples(Stage stage) const; // 取出某阶段的全部样本（毫秒）
+        static const char *stage_name(Stage stage);     // 阶段名，与 Prometheus 标签一致
+
+    private:
+        Metrics();
+        Metrics(const Metrics &) = delete;
+        Metrics &operator=(const Metrics &) = delete;
+        ~Metrics();
+
+        void record_sample(Stage stage, double ms);
+
+        Histogram *stages_[STAGE_COUNT];
+        Histogram boxes_;
+        std::atomic<bool> sampling_;
+        mutable std::mutex samples_mutex_;
+        std::vector<double> samples_[STAGE_COUNT];
+        std::atomic<uint64_t> requests_[600]; // 按状态码计数
+    };
+
+    // 作用域计时：析构时将经过的时间记入指定阶段，并记入当前的请求追踪
+    class StageTimer
+    {
+    public:
+        explicit StageTimer(Metrics::Stage stage)
+            : stage_(stage), start_(std::chrono::steady_clock::now()) {}
+        ~StageTimer()
+        {
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            std::chrono::duration<double, std::milli> ms = end - start_;
+            Metrics::get().observe(stage_, ms.count());
+            Trace::record(Metrics::stage_name(stage_), start_, end);
+        }
+
+    private:
+        Metrics::Stage stage_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+} // namespace PaddleOCR
+
+#endif // METRICS_H
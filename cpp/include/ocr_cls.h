@@ -14,10 +14,9 @@
 
 #pragma once
 
-#include "paddle_api.h"
-#include "paddle_inference_api.h"
-
 #include <include/preprocess_op.h>
+#include <include/predictor.h>
+#include <include/tensor_arena.h>
 #include <include/utility.h>
 
 namespace PaddleOCR
@@ -31,7 +30,10 @@ namespace PaddleOCR
                             const int &cpu_math_library_num_threads,
                             const bool &use_mkldnn, const double &cls_thresh,
                             const bool &use_tensorrt, const std::string &precision,
-                            const int &cls_batch_num)
+                            const int &cls_batch_num,
+                            const std::string &optim_cache_dir = "",
+                            const bool &gpu_pipeline = false,
+                            const std::string &backend = "paddle")
         {
             this->use_gpu_ = use_gpu;
             this->gpu_id_ = gpu_id;
@@ -43,17 +45,26 @@ namespace PaddleOCR
             this->use_tensorrt_ = use_tensorrt;
             this->precision_ = precision;
             this->cls_batch_num_ = cls_batch_num;
+            this->optim_cache_dir_ = optim_cache_dir;
+            this->gpu_pipeline_ = gpu_pipeline && use_gpu;
+            this->backend_ = backend;
+            this->arena_.SetPinned(this->gpu_pipeline_);
 
             LoadModel(model_dir);
         }
         double cls_thresh = 0.9;
 
-        // Load Paddle inference model
+        // Load inference model
         void LoadModel(const std::string &model_dir);
 
+        // 克隆一个新的分类器实例，与本实例共享模型权重，但拥有独立的推理状态
+        Classifier *Clone() const;
+
         void Run(std::vector<cv::Mat> img_list, std::vector<int> &cls_labels,
                  std::vector<float> &cls_scores, std::vector<double> &times);
-        std::shared_ptr<paddle_infer::Predictor> predictor_; // 推理库实例
+        std::shared_ptr<void> stream_;                       // 推理实例独占的CUDA流，未启用GPU流水线时为空。须先于 predictor_ 声明，晚于它析构
+        std::shared_ptr<Predictor> predictor_;               // 推理实例
+        TensorArena arena_;                                  // 跨调用复用的输入输出缓冲区
 
     private:
         bool use_gpu_ = false;
@@ -68,10 +79,12 @@ namespace PaddleOCR
         bool use_tensorrt_ = false;
         std::string precision_ = "fp32";
         int cls_batch_num_ = 1;
+        std::string optim_cache_dir_; // 模型优化缓存的根目录，为空时不缓存
+        std::string backend_ = "paddle"; // 推理后端
+        bool gpu_pipeline_ = false;   // GPU流水线：双缓冲预处理、锁页内存与独立CUDA流
         // pre-process
         ClsResizeImg resize_op_;
-        Normalize normalize_op_;
-        PermuteBatch permute_op_;
+        NormalizePermute norm_permute_op_;
 
     }; // class Classifier
 
@@ -14,11 +14,12 @@
 
 #pragma once
 
-#include "paddle_api.h"
-#include "paddle_inference_api.h"
-
 #include <include/postprocess_op.h>
+#include <include/predictor.h>
 #include <include/preprocess_op.h>
+#include <include/det_cuda.h>
+#include <include/ocr_options.h>
+#include <include/tensor_arena.h>
 
 namespace PaddleOCR
 {
@@ -35,7 +36,14 @@ namespace PaddleOCR
                             const double &det_db_unclip_ratio,
                             const std::string &det_db_score_mode,
                             const bool &use_dilation, const bool &use_tensorrt,
-                            const std::string &precision)
+                            const std::string &precision,
+                            const int &det_postprocess_threads = 1,
+                            const int &det_tile_size = 0,
+                            const int &det_tile_overlap = 128,
+                            const std::string &optim_cache_dir = "",
+                            const bool &gpu_pipeline = false,
+                            const bool &gpu_preprocess = false,
+                            const std::string &backend = "paddle")
         {
             this->use_gpu_ = use_gpu;
             this->gpu_id_ = gpu_id;
@@ -51,20 +59,40 @@ namespace PaddleOCR
             this->det_db_unclip_ratio_ = det_db_unclip_ratio;
             this->det_db_score_mode_ = det_db_score_mode;
             this->use_dilation_ = use_dilation;
+            this->det_postprocess_threads_ = det_postprocess_threads;
+            this->det_tile_size_ = det_tile_size;
+            this->det_tile_overlap_ = det_tile_overlap;
 
             this->use_tensorrt_ = use_tensorrt;
             this->precision_ = precision;
+            this->optim_cache_dir_ = optim_cache_dir;
+            this->gpu_pipeline_ = gpu_pipeline && use_gpu;
+            this->backend_ = backend;
+            // GPU前后处理直接把设备内存交给推理库，仅 paddle 后端支持
+            this->gpu_preprocess_ = gpu_preprocess && use_gpu && backend == "paddle" && DetCudaOps::available();
+            this->arena_.SetPinned(this->gpu_pipeline_);
 
             LoadModel(model_dir);
         }
 
-        // Load Paddle inference model
+        // Load inference model
         void LoadModel(const std::string &model_dir);
 
-        // Run predictor
-        void Run(cv::Mat &img, std::vector<std::vector<std::vector<int>>> &boxes,
-                 std::vector<double> &times);
-        std::shared_ptr<paddle_infer::Predictor> predictor_; // 推理库实例
+        // 克隆一个新的检测器实例，与本实例共享模型权重，但拥有独立的推理状态
+        DBDetector *Clone() const;
+
+        // Run predictor。启用分块且图片长边超过块边长时，分块检测并合并结果。
+        // options 非空时，其中的尺寸限制与阈值覆盖构造时的参数，只作用于本次调用
+        void Run(cv::Mat &img, std::vector<Quad> &boxes,
+                 std::vector<double> &times, const OCROptions *options = nullptr);
+        // 自适应检测分辨率：先以长边 low_side 做一次低分辨率预检，按检出文字的高度决定接受结果，
+        // 还是以使文字高度达到 text_px 的分辨率（不超过 max_side 与原图）重新检测；roi 为真时只在预检到的文本区域内重新检测。
+        // enabled 为默认开关，请求可用 det_adaptive 单独开关
+        void SetAdaptive(bool enabled, int low_side, int text_px, int max_side, bool roi);
+        std::shared_ptr<void> stream_;                       // 推理实例独占的CUDA流，未启用GPU流水线时为空。须先于 predictor_ 声明，晚于它析构
+        std::shared_ptr<Predictor> predictor_;               // 推理实例
+        TensorArena arena_;                                  // 跨调用复用的输入输出缓冲区
+        void ReleaseDevice(); // 释放GPU前后处理的设备缓冲区（内存清理时调用）
 
     private:
         bool use_gpu_ = false;
@@ -81,6 +109,19 @@ namespace PaddleOCR
         double det_db_unclip_ratio_ = 2.0;
         std::string det_db_score_mode_ = "slow";
         bool use_dilation_ = false;
+        int det_postprocess_threads_ = 1;
+        int det_tile_size_ = 0;      // 分块检测的块边长，0为关闭
+        int det_tile_overlap_ = 128; // 相邻块的重叠宽度
+        bool adaptive_ = false;         // 默认启用自适应检测分辨率
+        int adaptive_side_ = 640;       // 低分辨率预检的长边
+        int adaptive_text_px_ = 16;     // 检测输入中文字高度的目标下限（像素）
+        int adaptive_max_side_ = 4096;  // 重新检测的长边上限
+        bool adaptive_roi_ = false;     // 只在预检到的文本区域内重新检测
+        std::string optim_cache_dir_; // 模型优化缓存的根目录，为空时不缓存
+        std::string backend_ = "paddle"; // 推理后端
+        bool gpu_pipeline_ = false;   // GPU流水线：锁页内存与独立CUDA流
+        bool gpu_preprocess_ = false; // 在GPU上预处理与二值化
+        std::shared_ptr<DetCudaOps> cuda_ops_; // GPU前后处理，未启用时为空
 
         bool visualize_ = true;
         bool use_tensorrt_ = false;
@@ -92,11 +133,43 @@ namespace PaddleOCR
 
         // pre-process
         ResizeImgType0 resize_op_;
-        Normalize normalize_op_;
-        Permute permute_op_;
+        NormalizePermute norm_permute_op_;
 
         // post-process
         DBPostProcessor post_processor_;
+
+        // 本次检测实际使用的尺寸限制与阈值
+        struct Params
+        {
+            std::string limit_type;
+            int limit_side_len;
+            double db_thresh;
+            double db_box_thresh;
+            double db_unclip_ratio;
+            std::string db_score_mode;
+        };
+        Params ResolveParams(const OCROptions *options) const; // 构造时的参数，按 options 覆盖
+
+        // 对整张图（或一个块的视图）做一次检测，boxes 为相对 img 的坐标
+        void RunImage(const cv::Mat &img, const Params &params, std::vector<Quad> &boxes,
+                      std::vector<double> &times);
+        // 同 RunImage，预处理与二值化在GPU上完成，只下载8位的二值图与概率图
+        void RunImageDevice(const cv::Mat &img, const Params &params, std::vector<Quad> &boxes,
+                            std::vector<double> &times);
+
+        // 按原分辨率切成重叠的块逐块检测，块内结果平移回原图后合并接缝处的文本框。
+        // 一次只推理一个块，峰值内存取决于块大小而非原图大小
+        void RunTiled(const cv::Mat &img, const Params &params, std::vector<Quad> &boxes,
+                      std::vector<double> &times);
+
+        // 自适应检测分辨率：低分辨率预检，字太小时按所需分辨率对整图或文本区域重新检测
+        void RunAdaptive(const cv::Mat &img, const Params &params, std::vector<Quad> &boxes,
+                         std::vector<double> &times);
+
+        // 合并来自不同块、相互重叠的文本框：重复的去重，被接缝切断的取并集的最小外接矩形
+        std::vector<Quad> MergeTileBoxes(const std::vector<Quad> &boxes,
+                                         const std::vector<int> &tile_ids,
+                                         const cv::Mat &img);
     };
 
 } // namespace PaddleOCR
\ No newline at end of file
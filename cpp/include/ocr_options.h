@@ -0,0 +1,60 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#ifndef OCR_OPTIONS_H
+#define OCR_OPTIONS_H
+
+#include <string>
+
+namespace PaddleOCR
+{
+    // ==================== 单次请求的参数 ====================
+    // 覆盖启动参数中的阈值、尺寸限制与阶段开关，只对本次请求生效，不修改全局 FLAGS_*。
+    // 各项为默认值（空字符串、负数）时沿用启动参数。同一个引擎（池）因此可以按请求
+    // 在“快速截图”与“精细扫描”等不同配置之间切换，无需另起进程
+    struct OCROptions
+    {
+        // 阶段开关：只能关闭启动时已启用的阶段，不能开启未加载模型的阶段
+        bool det = true;
+        bool cls = true;
+        bool rec = true;
+
+        // det
+        std::string limit_type;          // 长/短边限制 max/min
+        int limit_side_len = -1;         // 限制边长
+        double det_db_thresh = -1;       // 二值化阈值
+        double det_db_box_thresh = -1;   // 文本框得分阈值
+        double det_db_unclip_ratio = -1; // 文本框扩张比例
+        std::string det_db_score_mode;   // 文本框打分方式 fast/slow
+        int det_adaptive = -1;           // 自适应检测分辨率：1开启，0关闭，-1沿用启动参数
+
+        // cls
+        double cls_thresh = -1; // 方向分类的得分阈值
+
+        // rec
+        int rec_batch_num = -1; // 识别批大小，不超过启动参数（TensorRT引擎按它构建）
+        std::string lang;       // 识别语言，须为 rec_languages 中登记的语言。为空时用启动参数的识别模型
+
+        // 读图：只识别原图中的一块区域（原图坐标），宽高为0时为整图。结果坐标仍为原图坐标。只作用于OCR，不作用于版面分析
+        int roi_x = 0;
+        int roi_y = 0;
+        int roi_w = 0;
+        int roi_h = 0;
+        int decode_scale = 1; // 由读图设置，不从请求读取：JPEG缩小解码的倍数（1/2/4/8），结果坐标按它放大回原图
+
+        bool operator==(const OCROptions &o) const
+        {
+            return det == o.det && cls == o.cls && rec == o.rec && limit_type == o.limit_type &&
+                   limit_side_len == o.limit_side_len && det_db_thresh == o.det_db_thresh &&
+                   det_db_box_thresh == o.det_db_box_thresh && det_db_unclip_ratio == o.det_db_unclip_ratio &&
+                   det_db_score_mode == o.det_db_score_mode && det_adaptive == o.det_adaptive &&
+                   cls_thresh == o.cls_thresh &&
+                   rec_batch_num == o.rec_batch_num && lang == o.lang && roi_x == o.roi_x &&
+                   roi_y == o.roi_y && roi_w == o.roi_w && roi_h == o.roi_h && decode_scale == o.decode_scale;
+        }
+        bool operator!=(const OCROptions &o) const { return !(*this == o); }
+    };
+
+} // namespace PaddleOCR
+
+#endif // OCR_OPTIONS_H
@@ -0,0 +1,62 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#ifndef OCR_PIPELINE_H
+#define OCR_PIPELINE_H
+
+#include "include/bounded_queue.h"
+#include "include/utility.h"
+
+#include <memory>
+#include <mutex>
+
+namespace PaddleOCR
+{
+    class PPOCR;
+
+    // ==================== 多图流水线 ====================
+    // 将一批图片按 det → 裁切+cls → rec 三级流水执行，每级一个工作线程，级间以有界队列相连。
+    // 第 k 张图在 rec 时，第 k+1 张图已在 det。结果按提交顺序返回。
+    class OCRPipeline
+    {
+    public:
+        // 每级队列深度统计
+        struct QueueDepth
+        {
+            size_t cls;      // det → 裁切+cls 队列的当前深度
+            size_t rec;      // 裁切+cls → rec 队列的当前深度
+            size_t cls_peak; // 最近一次运行中的最大深度
+            size_t rec_peak;
+        };
+
+        // ppocr: 执行各阶段的引擎（不持有）；queue_size: 级间队列容量
+        OCRPipeline(PPOCR *ppocr, int queue_size);
+
+        // 以流水线方式OCR一批图片，det固定开启
+        std::vector<std::vector<OCRPredictResult>> run(const std::vector<cv::Mat> &img_list,
+                                                       bool rec, bool cls);
+
+        QueueDepth queue_depth() const; // 线程安全，可在运行中查询
+
+    private:
+        struct Item // 在各级之间流转的单张图片
+        {
+            size_t index; // 提交顺序
+            cv::Mat img;          // 启用 page_orient 时为转正后的图片
+            int rotation = 0;     // 转正所用的顺时针旋转角度
+            std::vector<OCRPredictResult> result;
+            std::vector<cv::Mat> crops;
+            std::vector<char> inferred; // 沿用抽样方向、未经分类的碎图
+        };
+        typedef std::shared_ptr<Item> ItemPtr;
+
+        PPOCR *ppocr_;
+        int queue_size_;
+        mutable std::mutex mutex_;                  // 保护下面两个指针
+        std::shared_ptr<BoundedQueue<ItemPtr>> q_cls_; // det → 裁切+cls
+        std::shared_ptr<BoundedQueue<ItemPtr>> q_rec_; // 裁切+cls → rec
+    };
+
+} // namespace PaddleOCR
+
+#endif // OCR_PIPELINE_H
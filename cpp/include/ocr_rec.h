@@ -14,15 +14,20 @@
 
 #pragma once
 
-#include "paddle_api.h"
-#include "paddle_inference_api.h"
-
+#include <include/label_table.h>
 #include <include/ocr_cls.h>
+#include <include/ocr_options.h>
+#include <include/predictor.h>
 #include <include/utility.h>
 
+#include <functional>
+
 namespace PaddleOCR
 {
 
+    // 一批碎图识别完成的回调：indices 为本批碎图在 img_list 中的下标，共 count 个
+    typedef std::function<void(const int *indices, int count)> RecBatchCallback;
+
     class CRNNRecognizer
     {
     public:
@@ -33,7 +38,12 @@ namespace PaddleOCR
                                 const bool &use_tensorrt,
                                 const std::string &precision,
                                 const int &rec_batch_num, const int &rec_img_h,
-                                const int &rec_img_w)
+                                const int &rec_img_w, const int &rec_decode_threads = 1,
+                                const std::vector<int> &rec_width_buckets = std::vector<int>(),
+                                const std::string &optim_cache_dir = "",
+                                const bool &gpu_pipeline = false,
+                                const std::string &backend = "paddle",
+                                const bool &exit_on_error = true)
         {
             this->use_gpu_ = use_gpu;
             this->gpu_id_ = gpu_id;
@@ -45,23 +55,38 @@ namespace PaddleOCR
             this->rec_batch_num_ = rec_batch_num;
             this->rec_img_h_ = rec_img_h;
             this->rec_img_w_ = rec_img_w;
+            this->rec_decode_threads_ = rec_decode_threads;
+            this->rec_width_buckets_ = rec_width_buckets;
+            this->optim_cache_dir_ = optim_cache_dir;
+            this->gpu_pipeline_ = gpu_pipeline && use_gpu;
+            this->backend_ = backend;
+            this->exit_on_error_ = exit_on_error;
+            this->arena_.SetPinned(this->gpu_pipeline_);
             std::vector<int> rec_image_shape = {3, rec_img_h, rec_img_w};
             this->rec_image_shape_ = rec_image_shape;
 
-            this->label_list_ = Utility::ReadDict(label_path);
-            this->label_list_.insert(this->label_list_.begin(),
-                                     "#"); // blank char for ctc
-            this->label_list_.push_back(" ");
+            // 标签表在进程内按路径共享；有模型优化缓存目录时，文本字典编译为二进制后映射
+            this->labels_ = LabelTable::load(label_path, optim_cache_dir);
 
             LoadModel(model_dir);
         }
 
-        // Load Paddle inference model
+        // Load inference model
         void LoadModel(const std::string &model_dir);
 
+        // 克隆一个新的识别器实例，与本实例共享模型权重，但拥有独立的推理状态
+        CRNNRecognizer *Clone() const;
+
+        // on_batch 非空时，每批识别完成后调用，此时本批的 rec_texts 与 rec_text_scores 已写入。
+        // options 非空时，其中的批大小（不超过构造时的值）只作用于本次调用
         void Run(std::vector<cv::Mat> img_list, std::vector<std::string> &rec_texts,
-                 std::vector<float> &rec_text_scores, std::vector<double> &times);
-        std::shared_ptr<paddle_infer::Predictor> predictor_; // 推理库实例
+                 std::vector<float> &rec_text_scores, std::vector<double> &times,
+                 const RecBatchCallback &on_batch = RecBatchCallback(),
+                 const OCROptions *options = nullptr);
+        const std::vector<int> &width_buckets() const { return rec_width_buckets_; } // 输入宽度分桶，未分桶时为空
+        std::shared_ptr<void> stream_;                       // 推理实例独占的CUDA流，未启用GPU流水线时为空。须先于 predictor_ 声明，晚于它析构
+        std::shared_ptr<Predictor> predictor_;               // 推理实例
+        TensorArena arena_;                                  // 跨调用复用的输入输出缓冲区
 
     private:
         bool use_gpu_ = false;
@@ -70,7 +95,19 @@ namespace PaddleOCR
         int cpu_math_library_num_threads_ = 4;
         bool use_mkldnn_ = false;
 
-        std::vector<std::string> label_list_;
+        std::shared_ptr<const LabelTable> labels_; // 字典的连续UTF-8文本与各字符的偏移，克隆体共享
+        int rec_decode_threads_ = 1;
+        std::vector<int> rec_width_buckets_; // 输入宽度分桶（升序），为空时按固定数量分批
+        std::string optim_cache_dir_;        // 模型优化缓存的根目录，为空时不缓存
+        std::string backend_ = "paddle";     // 推理后端
+        bool gpu_pipeline_ = false;          // GPU流水线：双缓冲预处理、锁页内存与独立CUDA流
+        bool exit_on_error_ = true;          // 模型加载失败时退出进程；为false时 predictor_ 为空
+
+        // 碎图缩放后的宽度所属的桶。超过最大桶时，向上取整到最大桶的整数倍
+        int WidthBucket(const cv::Mat &img) const;
+
+        // CTC贪心解码一行输出：每个时间步取 argmax，合并重复并去除空白。返回平均置信度（无字符时为NaN）
+        float CTCDecode(const float *probs, int steps, int classes, std::string &text) const;
 
         std::vector<float> mean_ = {0.5f, 0.5f, 0.5f};
         std::vector<float> scale_ = {1 / 0.5f, 1 / 0.5f, 1 / 0.5f};
@@ -83,8 +120,7 @@ namespace PaddleOCR
         std::vector<int> rec_image_shape_ = {3, rec_img_h_, rec_img_w_};
         // pre-process
         CrnnResizeImg resize_op_;
-        Normalize normalize_op_;
-        PermuteBatch permute_op_;
+        NormalizePermute norm_permute_op_;
 
     }; // class CrnnRecognizer
 
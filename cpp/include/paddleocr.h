@@ -17,23 +17,54 @@
 #include <include/ocr_cls.h>
 #include <include/ocr_det.h>
 #include <include/ocr_rec.h>
+#include <include/ocr_pipeline.h>
+#include <include/rec_batcher.h>
 
 namespace PaddleOCR
 {
+    // OCR过程的观察者：检测、识别各阶段完成时收到已有的结果，用于流式输出
+    class OCRObserver
+    {
+    public:
+        virtual ~OCRObserver() {}
+        // 检测（及方向分类）完成，results 中已有包围盒，尚无文字
+        virtual void on_det(const std::vector<OCRPredictResult> &results) {}
+        // 一批文字识别完成，indices 为 results 中本批文本框的下标，共 count 个
+        virtual void on_rec(const std::vector<OCRPredictResult> &results,
+                            const int *indices, int count) {}
+    };
+
     class PPOCR
     {
     public:
         explicit PPOCR();
-        ~PPOCR() = default; // 默认析构函数
+        // 克隆构造：与 base 共享模型权重，各自持有独立的推理状态，可在另一线程中并行使用
+        explicit PPOCR(const PPOCR &base);
+        virtual ~PPOCR() = default; // 虚析构：任务可持有派生的 PaddleStructure
+
+        // 以下各 ocr 方法中，options 非空时，其中的阈值与尺寸限制覆盖启动参数，只作用于本次调用。
+        // 阶段开关以 det/rec/cls 参数为准
 
         // OCR方法，处理图像列表，返回每个图像的OCR结果向量
         std::vector<std::vector<OCRPredictResult>> ocr(std::vector<cv::Mat> img_list,
                                                        bool det = true,
                                                        bool rec = true,
-                                                       bool cls = true);
-        // OCR方法，处理单个图像，返回OCR结果
+                                                       bool cls = true,
+                                                       const OCROptions *options = nullptr);
+        // OCR方法，处理单个图像，返回OCR结果。observer 非空时，逐阶段通知中间结果
         std::vector<OCRPredictResult> ocr(cv::Mat img, bool det = true,
-                                          bool rec = true, bool cls = true);
+                                          bool rec = true, bool cls = true,
+                                          OCRObserver *observer = nullptr,
+                                          const OCROptions *options = nullptr);
+        // 增量OCR（启用det）：与上一张图片比较，只对变化区域重新检测与识别，
+        // 其余文本框沿用上次的结果。尺寸、类型或任务选项不同，或变化过大时，退化为完整OCR
+        std::vector<OCRPredictResult> ocr_incremental(cv::Mat img, bool rec = true,
+                                                      bool cls = true,
+                                                      const OCROptions *options = nullptr);
+
+        // 预热：以合成输入覆盖配置中的检测尺寸、识别宽度分桶与批大小，提前构建各形状的推理内核。
+        // 启用TensorRT形状采集时，同时采集到这些形状的范围
+        void warmup();
 
         void reset_timer();              // 重置计时器
         void benchmark_log(int img_num); // 记录基准测试日志，参数为图像数量
@@ -42,21 +73,58 @@ namespace PaddleOCR
         std::unique_ptr<DBDetector> detector_;       // 指向 文本检测器实例
         std::unique_ptr<Classifier> classifier_;     // 指向 方向分类器实例
         std::unique_ptr<CRNNRecognizer> recognizer_; // 指向 文本识别器实例
+        RecBatcher *rec_batcher_ = nullptr;          // 跨请求识别批处理器，非空时rec经由它执行（不持有）
+        std::unique_ptr<OCRPipeline> pipeline_;      // 多图流水线，首次批量OCR时创建，可查询队列深度
 
     protected:
+        friend class OCRPipeline; // 流水线需调用 det/cls/rec 各阶段
+
         // 时间信息
         std::vector<double> time_info_det = {0, 0, 0};
         std::vector<double> time_info_rec = {0, 0, 0};
         std::vector<double> time_info_cls = {0, 0, 0};
 
+        // 本次调用的参数，由各 ocr 方法在调用期间设置，返回时恢复。det/cls/rec 各阶段从这里读取
+        OCROptions options_;
+        double cls_thresh() const; // 本次调用的方向分类阈值
+
+        // 增量OCR的上一帧状态
+        cv::Mat prev_frame_;                         // 上一张图片的副本
+        std::vector<OCRPredictResult> prev_results_; // 上一张图片的结果
+        bool prev_rec_ = false;
+        bool prev_cls_ = false;
+        OCROptions prev_options_;
+
+        // 求出与上一帧相比变化的区域（已扩展到覆盖所涉及的旧文本框，互不相交）。
+        // 变化过大、不值得增量处理时返回false
+        bool dirty_regions(const cv::Mat &img, std::vector<cv::Rect> &regions);
+
         // 文本检测：输入单张图片，在ocr_results向量中存放单行文本碎图的检测信息
         void det(cv::Mat img,
                  std::vector<OCRPredictResult> &ocr_results);
-        // 方向分类：输入单行碎图向量，在ocr_results向量中存放每个碎图的方向标志
+        // 同上。启用 page_orient 时先判断整页方向，img 原地替换为转正后的图片，文本框为转正后的坐标。
+        // 返回转正所用的顺时针旋转角度（0/90/180/270）
+        int det_upright(cv::Mat &img,
+                        std::vector<OCRPredictResult> &ocr_results);
+        // 将转正后图片上的文本框映射回原图坐标，width/height 为原图尺寸
+        static void unrotate_boxes(std::vector<OCRPredictResult> &ocr_results,
+                                   int rotation, int width, int height);
+        // 方向分类：输入单行碎图向量，在ocr_results向量中存放每个碎图的方向标志。
+        // 传入 inferred 且启用 cls_sample 时（碎图须来自同一页），只分类抽样的横排长条与其它短小碎图，
+        // 抽样结果一致时其余长条沿用该方向，inferred[i] 置为1
         void cls(std::vector<cv::Mat> img_list,
-                 std::vector<OCRPredictResult> &ocr_results);
+                 std::vector<OCRPredictResult> &ocr_results,
+                 std::vector<char> *inferred = nullptr);
+        // 按方向分类结果旋转碎图
+        void rotate_by_cls(std::vector<cv::Mat> &img_list,
+                           const std::vector<OCRPredictResult> &ocr_results);
+        // rec之后：沿用方向且识别置信度低于 cls_recheck_score 的碎图旋转180°再识别，取置信度高者
+        void recheck_cls(const std::vector<cv::Mat> &img_list,
+                         std::vector<OCRPredictResult> &ocr_results,
+                         const std::vector<char> &inferred);
         // 文本识别：输入单行碎图向量，在ocr_results向量中存放每个碎图的文本
         void rec(std::vector<cv::Mat> img_list,
-                 std::vector<OCRPredictResult> &ocr_results);
+                 std::vector<OCRPredictResult> &ocr_results,
+                 OCRObserver *observer = nullptr);
     };
 } // namespace PaddleOCR
@@ -25,8 +25,12 @@ namespace PaddleOCR
     {
     public:
         explicit PaddleStructure();
+        // 克隆构造：与 base 共享模型权重，可在另一线程中并行使用
+        explicit PaddleStructure(const PaddleStructure &base);
         ~PaddleStructure() = default;
 
+        // 版面分析与整页文本检测并行；各区域、各表格的文字碎图合并为一次识别。
+        // 文字区域的 text_res 与表格的 cell_box 均相对于区域左上角
         std::vector<StructurePredictResult> structure(cv::Mat img,
                                                       bool layout = false,
                                                       bool table = true,
@@ -45,30 +49,17 @@ namespace PaddleOCR
         void layout(cv::Mat img,
                     std::vector<StructurePredictResult> &structure_result);
 
-        void table(cv::Mat img, StructurePredictResult &structure_result);
+        // 表格结构识别：img_list 为各表格区域的图片，regions 为其在 structure_results 中的下标
+        void table(std::vector<cv::Mat> &img_list,
+                   std::vector<std::vector<std::string>> &structure_html_tags,
+                   std::vector<std::vector<std::vector<int>>> &structure_boxes,
+                   std::vector<StructurePredictResult> &structure_results,
+                   const std::vector<int> &regions);
 
-        std::string rebuild_table(std::vector<std::string> rec_html_tags,
-                                  std::vector<std::vector<int>> rec_boxes,
-                                  std::vector<OCRPredictResult> &ocr_result);
-
-        float dis(std::vector<int> &box1, std::vector<int> &box2);
-
-        static bool comparison_dis(const std::vector<float> &dis1,
-                                   const std::vector<float> &dis2)
-        {
-            if (dis1[1] < dis2[1])
-            {
-                return true;
-            }
-            else if (dis1[1] == dis2[1])
-            {
-                return dis1[0] < dis2[0];
-            }
-            else
-            {
-                return false;
-            }
-        }
+        // 按单元格匹配文本并填入html标签。单元格建立网格索引，每个文本框只与附近的单元格比较
+        std::string rebuild_table(const std::vector<std::string> &rec_html_tags,
+                                  const std::vector<std::vector<int>> &rec_boxes,
+                                  const std::vector<OCRPredictResult> &ocr_result);
     };
 
 } // namespace PaddleOCR
\ No newline at end of file
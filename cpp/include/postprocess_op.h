@@ -21,38 +21,45 @@ namespace PaddleOCR {
 
 class DBPostProcessor {
 public:
-  void GetContourArea(const std::vector<std::vector<float>> &box,
-                      float unclip_ratio, float &distance);
+  void GetContourArea(const QuadF &box, float unclip_ratio, float &distance);
 
-  cv::RotatedRect UnClip(std::vector<std::vector<float>> box,
-                         const float &unclip_ratio);
+  // 矩形按闭式解外扩，其它四边形退回 Clipper 圆角偏移
+  cv::RotatedRect UnClip(const QuadF &box, const float &unclip_ratio);
 
   float **Mat2Vec(cv::Mat mat);
 
-  std::vector<std::vector<int>>
-  OrderPointsClockwise(std::vector<std::vector<int>> pts);
+  Quad OrderPointsClockwise(const Quad &pts);
 
-  std::vector<std::vector<float>> GetMiniBoxes(cv::RotatedRect box,
-                                               float &ssid);
+  QuadF GetMiniBoxes(cv::RotatedRect box, float &ssid);
 
-  float BoxScoreFast(std::vector<std::vector<float>> box_array, cv::Mat pred);
-  float PolygonScoreAcc(std::vector<cv::Point> contour, cv::Mat pred);
+  // 在概率图的ROI上以掩膜求平均分，mask_buf 为复用的掩膜缓冲区
+  float BoxScoreFast(const QuadF &box_array,
+                     const cv::Mat &pred, std::vector<unsigned char> &mask_buf);
+  float PolygonScoreAcc(const std::vector<cv::Point> &contour,
+                        const cv::Mat &pred,
+                        std::vector<unsigned char> &mask_buf);
 
-  std::vector<std::vector<std::vector<int>>>
+  // 概率图一次遍历二值化到复用的缓冲区 buf，bitmap 引用该缓冲区
+  void Binarize(const cv::Mat &pred, double thresh,
+                std::vector<unsigned char> &buf, cv::Mat &bitmap);
+
+  // threads > 1 时并行为候选框打分
+  std::vector<Quad>
   BoxesFromBitmap(const cv::Mat pred, const cv::Mat bitmap,
                   const float &box_thresh, const float &det_db_unclip_ratio,
-                  const std::string &det_db_score_mode);
+                  const std::string &det_db_score_mode, const int threads = 1);
 
-  std::vector<std::vector<std::vector<int>>>
-  FilterTagDetRes(std::vector<std::vector<std::vector<int>>> boxes,
-                  float ratio_h, float ratio_w, cv::Mat srcimg);
+  std::vector<Quad> FilterTagDetRes(std::vector<Quad> boxes, float ratio_h,
+                                    float ratio_w, const cv::Mat &srcimg);
 
 private:
-  static bool XsortInt(std::vector<int> a, std::vector<int> b);
+  // Clipper 圆角偏移 distance 后取最小外接矩形
+  cv::RotatedRect UnClipPolygon(const QuadF &box, float distance);
 
-  static bool XsortFp32(std::vector<float> a, std::vector<float> b);
+  static bool XsortInt(const std::array<int, 2> &a, const std::array<int, 2> &b);
 
-  std::vector<std::vector<float>> Mat2Vector(cv::Mat mat);
+  static bool XsortFp32(const std::array<float, 2> &a,
+                        const std::array<float, 2> &b);
 
   inline int _max(int a, int b) { return a >= b ? a : b; }
 
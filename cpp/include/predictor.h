@@ -0,0 +1,93 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#ifndef PREDICTOR_H
+#define PREDICTOR_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace PaddleOCR
+{
+    // ==================== 推理后端 ====================
+    // 各模型只通过 Predictor / InferTensor 访问推理库，不直接依赖 paddle_infer。
+    // paddle 为默认后端；onnxruntime、openvino 需编译时开启 WITH_ONNXRUNTIME / WITH_OPENVINO，
+    // 可按阶段选择（--det_backend 等），模型目录中须有对应格式的模型文件：
+    //   paddle      inference.pdmodel / inference.pdiparams（版面、表格模型也可为 model.*）
+    //   onnxruntime inference.onnx
+    //   openvino    inference.xml（IR），其次 inference.onnx、inference.pdmodel
+
+    // 创建推理实例的配置，对应 paddle_infer::Config 中各模型用到的部分，其他后端取其能支持的子集
+    struct PredictorOptions
+    {
+        std::string backend = "paddle";
+        std::string model_dir;
+        bool use_gpu = false;
+        int gpu_id = 0;
+        int gpu_mem = 4000;
+        int cpu_threads = 4;
+        bool use_mkldnn = false;
+        int mkldnn_cache_capacity = 0; // MKLDNN缓存的形状数，0为不限
+        std::string precision = "fp32"; // fp32/fp16/bf16/int8
+        bool use_tensorrt = false;
+        int trt_workspace = 1 << 20;
+        int trt_max_batch = 1;
+        int trt_min_subgraph = 3;
+        std::string trt_shape_file; // TensorRT动态形状文件，不存在时先收集形状。有优化缓存目录时放在其中
+        std::string optim_cache_dir; // 模型优化缓存的根目录，为空时不缓存。TensorRT下用于序列化引擎
+        void *stream = nullptr;      // 推理使用的CUDA流，为空时使用默认流（仅paddle）
+        std::vector<std::string> delete_passes; // 需禁用的图优化pass（仅paddle）
+        bool exit_on_error = true;              // 加载失败时退出进程；为false时输出错误并返回空（按需加载的模型）
+    };
+
+    // 输入输出张量。数据类型均为float
+    class InferTensor
+    {
+    public:
+        virtual ~InferTensor() {}
+        virtual void Reshape(const std::vector<int> &shape) = 0;
+        virtual std::vector<int> shape() const = 0;
+        // 输入张量在主机上的可写内存（零拷贝），须先 Reshape。后端不支持时返回空
+        virtual float *MutableCpuData() { return nullptr; }
+        virtual void CopyFromCpu(const float *data) = 0;
+        virtual void CopyToCpu(float *data) = 0;
+        // 输出数据在主机上时返回其指针与元素数，否则返回空，须用 CopyToCpu 取出
+        virtual const float *CpuData(int &size) = 0;
+        // 直接以设备内存为输入（GPU前后处理），后端不支持时返回false
+        virtual bool ShareDeviceData(float *data, const std::vector<int> &shape) { return false; }
+        // 输出数据在设备上时返回其指针与元素数，否则返回空
+        virtual const float *DeviceData(int &size) { return nullptr; }
+    };
+
+    class Predictor
+    {
+    public:
+        virtual ~Predictor() {}
+
+        // 按 options.backend 创建推理实例。模型文件缺失或加载失败时输出错误并退出，与各模型原先的行为一致；
+        // options.exit_on_error 为false时改为返回空
+        static std::shared_ptr<Predictor> Create(const PredictorOptions &options);
+        // 后端名称是否有效且已编译
+        static bool Available(const std::string &backend);
+        // 已编译的后端，如 "paddle, onnxruntime"
+        static std::string Backends();
+
+        // 第 i 个输入/输出张量。指针在以同一下标再次调用或推理实例析构前有效
+        virtual InferTensor *Input(int i) = 0;
+        virtual InferTensor *Output(int i) = 0;
+        virtual int OutputCount() = 0;
+        virtual bool Run() = 0;
+        // 克隆：共享模型权重，只新建推理状态。stream 为新实例使用的CUDA流（仅paddle）
+        virtual Predictor *Clone(void *stream) = 0;
+        // 释放中间张量与缓存的内存（内存清理时调用）
+        virtual void ShrinkMemory() {}
+    };
+
+    // 各后端的创建函数，未编译的后端返回空
+    std::shared_ptr<Predictor> CreatePaddlePredictor(const PredictorOptions &options);
+    std::shared_ptr<Predictor> CreateOnnxRuntimePredictor(const PredictorOptions &options);
+    std::shared_ptr<Predictor> CreateOpenVinoPredictor(const PredictorOptions &options);
+} // namespace PaddleOCR
+
+#endif // PREDICTOR_H
@@ -40,11 +40,23 @@ public:
   virtual void Run(const std::vector<cv::Mat> imgs, float *data);
 };
 
+// uint8 BGR HWC -> normalized float CHW，一次遍历完成 Normalize + Permute，
+// 直接写入输入缓冲区。目标每通道 dst_h 行、每行 dst_w 个float，图片之外的区域保持原值（通常为0）
+class NormalizePermute {
+public:
+  virtual void Run(const cv::Mat &im, float *data, const int dst_h,
+                   const int dst_w, const std::vector<float> &mean,
+                   const std::vector<float> &scale, const bool is_scale = true);
+};
+
 class ResizeImgType0 {
 public:
   virtual void Run(const cv::Mat &img, cv::Mat &resize_img,
                    std::string limit_type, int limit_side_len, float &ratio_h,
                    float &ratio_w, bool use_tensorrt);
+  // 只计算缩放后的尺寸（32的倍数），不缩放。供在设备上缩放时使用
+  static void TargetSize(int h, int w, const std::string &limit_type,
+                         int limit_side_len, int &resize_h, int &resize_w);
 };
 
 class CrnnResizeImg {
@@ -0,0 +1,36 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#ifndef READING_ORDER_H
+#define READING_ORDER_H
+
+#include "include/utility.h"
+
+#include <array>
+#include <vector>
+
+namespace PaddleOCR
+{
+    // ==================== 阅读顺序 ====================
+    // 文本框按行聚类后排序，复杂度 O(n log n)：
+    // 以各框长边角度的中位数估计整页旋转，在转正后的坐标系中取各框的外接矩形；
+    // 按y中心排序后扫描，与当前行的y中心相差不超过行高一半的框归入该行（阈值随框高自适应），行内按x排序。
+    // 可选地为每个框标注行号与段落号。段落的判断参照 tbpu 的单栏-自然段：
+    // 相邻两行左右边缘对齐、行距不明显大于段内行距时为同一段；只有一行的段，按缩进与对齐并入上一段末尾或下一段开头
+    class ReadingOrder
+    {
+    public:
+        typedef std::array<float, 4> BBox; // 外接矩形 [左, 上, 右, 下]
+
+        // 就地排序。group 为true时写入各结果的 line 与 paragraph
+        static void sort(std::vector<OCRPredictResult> &results, bool group = false);
+
+        // 各结果转正后的外接矩形。整页旋转超过3°时，先按估计的旋转角转正
+        static std::vector<BBox> normalized_bboxes(const std::vector<OCRPredictResult> &results);
+        // 对从上到下排列的行划分自然段，返回各行的段落号。同一段的行是连续的
+        static std::vector<int> paragraphs(const std::vector<BBox> &rows);
+    };
+
+} // namespace PaddleOCR
+
+#endif // READING_ORDER_H
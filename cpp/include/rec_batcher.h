@@ -0,0 +1,60 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#ifndef REC_BATCHER_H
+#define REC_BATCHER_H
+
+#include <include/ocr_rec.h>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace PaddleOCR
+{
+    // ==================== 跨请求识别批处理 ====================
+    // 多个引擎并发调用 Run() 时，在一个短时间窗口内收集各请求的文本碎图，
+    // 合并为一次 CRNNRecognizer::Run （统一按宽高比排序、按 rec_batch_num 分批），
+    // 再将结果分发回各请求。调用方在结果就绪前阻塞。
+    class RecBatcher
+    {
+    public:
+        // recognizer: 批处理专用的识别器实例，所有权移交给本对象
+        // window_ms: 收集窗口（毫秒）；max_crops: 碎图数达到该值时不再等待窗口结束
+        RecBatcher(CRNNRecognizer *recognizer, int window_ms, int max_crops);
+        ~RecBatcher();
+
+        // 与 CRNNRecognizer::Run 相同的接口。times 为本请求所在合并批次的耗时
+        void Run(const std::vector<cv::Mat> &img_list, std::vector<std::string> &rec_texts,
+                 std::vector<float> &rec_text_scores, std::vector<double> &times);
+
+    private:
+        struct Job
+        {
+            const std::vector<cv::Mat> *img_list;
+            std::vector<std::string> *rec_texts;
+            std::vector<float> *rec_text_scores;
+            std::vector<double> *times;
+            bool done;
+        };
+
+        void worker(); // 后台调度线程
+
+        std::unique_ptr<CRNNRecognizer> recognizer_;
+        int window_ms_;
+        int max_crops_;
+
+        std::deque<Job *> pending_; // 等待合并的请求
+        int pending_crops_ = 0;     // pending_ 中的碎图总数
+        bool stop_ = false;
+        std::mutex mutex_;
+        std::condition_variable job_cond_;  // 通知调度线程：有新请求
+        std::condition_variable done_cond_; // 通知调用方：结果就绪
+        std::thread thread_;
+    };
+
+} // namespace PaddleOCR
+
+#endif // REC_BATCHER_H
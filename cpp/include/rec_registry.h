@@ -0,0 +1,86 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#ifndef REC_REGISTRY_H
+#define REC_REGISTRY_H
+
+#include <condition_variable>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "include/ocr_rec.h"
+
+namespace PaddleOCR
+{
+    // ==================== 多语言识别模型 ====================
+    // 按 --rec_languages 登记各语言的识别模型（来自 models/config_xxx.txt 中的 rec_model_dir、
+    // rec_char_dict_path、rec_img_h、rec_img_w），请求以 lang 指定语言。首次使用时才加载，
+    // 检测与方向分类模型与语言无关，仍由启动参数的引擎共用。
+    // 已加载模型的权重大小之和超过 --rec_memory_mb 时，按最近最少使用卸载未被借用的语言。
+    // 进程内唯一实例，引擎池中各引擎共享同一份权重，各自借用独立的推理实例
+    class RecRegistry
+    {
+    public:
+        struct Profile
+        {
+            std::string name;
+            std::string config_path;
+            std::string model_dir;
+            std::string dict_path;
+            int img_h = 0;
+            int img_w = 0;
+        };
+
+        static RecRegistry &get();
+
+        // 按 spec 登记语言，models_path 为模型库目录。spec 为：
+        //   auto        models_path 下的全部 config_<lang>.txt
+        //   列表        以分号分隔，如 "en;japan" 即 config_en.txt、config_japan.txt，
+        //               或 "en=D:/models/config_en.txt" 指定配置文件路径
+        // 出错时返回报错信息，供 check_flags 汇总
+        std::string configure(const std::string &spec, const std::string &models_path,
+                              size_t budget_bytes);
+
+        bool has(const std::string &lang) const;
+        std::vector<std::string> languages() const; // 已登记的语言，按名称排序
+        std::vector<std::string> loaded() const;    // 其中模型已加载的语言
+
+        // 借出 lang 的一个识别器，未加载时先加载。归还（shared_ptr析构）前该语言不会被卸载。
+        // 未登记或加载失败时返回空
+        std::shared_ptr<CRNNRecognizer> acquire(const std::string &lang);
+        // 未加载时先加载，返回 lang 的模型是否可用。供解析请求时提前报告加载失败
+        bool ready(const std::string &lang);
+
+    private:
+        struct Entry
+        {
+            Profile profile;
+            std::unique_ptr<CRNNRecognizer> base;               // 持有权重，只用于克隆，不直接推理
+            std::vector<std::unique_ptr<CRNNRecognizer>> idle; // 已归还、可再借出的实例
+            size_t bytes = 0;                                   // 估算的权重大小
+            int leased = 0;                                     // 借出中的实例数
+            bool loading = false;                               // 正在（锁外）加载
+            std::list<std::string>::iterator lru;               // 在 lru_ 中的位置，未加载时为 end
+        };
+
+        RecRegistry() = default;
+        void release(const std::string &lang, CRNNRecognizer *recognizer);
+        void evict(const std::string &keep); // 持锁调用：超出预算时卸载最久未用的空闲语言
+        static CRNNRecognizer *load(const Profile &profile);
+        static size_t weight_bytes(const std::string &model_dir);
+
+        mutable std::mutex mutex_;
+        std::condition_variable loaded_;
+        std::map<std::string, Entry> entries_;
+        std::list<std::string> lru_; // 已加载的语言，最近使用的在前
+        size_t budget_bytes_ = 0;    // 0为不限
+        size_t total_bytes_ = 0;
+    };
+
+} // namespace PaddleOCR
+
+#endif // REC_REGISTRY_H
@@ -0,0 +1,39 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#ifndef REPLY_ENCODING_H
+#define REPLY_ENCODING_H
+
+#include "include/httplib.h"
+
+namespace PaddleOCR
+{
+    // ==================== 回复编码 ====================
+    // 回复的编码：format=msgpack/cbor（或 Accept 头要求 application/msgpack、application/cbor）时，
+    // json回复转为 MessagePack/CBOR；compact=1 时文本框 [[x,y]×4] 展平为 [x1,y1,...,x4,y4]；
+    // omit_cls=1 时去掉 cls_label 与 cls_score。均为默认json时不做任何处理。HTTP服务器与监督进程共用
+    enum ReplyFormat
+    {
+        FORMAT_JSON,
+        FORMAT_MSGPACK,
+        FORMAT_CBOR,
+        FORMAT_INVALID,
+    };
+
+    ReplyFormat reply_format(const httplib::Request &req);
+
+    // 请求参数 name 存在且不为 0/false
+    bool flag_param(const httplib::Request &req, const char *name);
+
+    // 只控制回复编码、不应转交给识别引擎的请求参数
+    bool reply_param(const std::string &key);
+
+    // 按请求的格式重新编码 Content-Type 为 application/json 的回复。正文为空（流式回复）时不转换
+    void encode_reply(const httplib::Request &req, httplib::Response &res);
+
+    // format 参数不合法时回复400并返回true，应在读取正文与识别之前调用
+    bool reject_reply_format(const httplib::Request &req, httplib::Response &res);
+
+} // namespace PaddleOCR
+
+#endif // REPLY_ENCODING_H
@@ -0,0 +1,62 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include "opencv2/core.hpp" // cv::Mat
+#include "include/ocr_options.h"
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace PaddleOCR
+{
+    // ==================== 识别结果缓存 ====================
+    // 以解码后的像素内容与 det/cls/rec 选项的哈希为键，缓存结果json字符串。
+    // 相同图片（如重复的窗口截图、同一模板渲染的PDF）再次请求时，直接返回缓存而不推理。
+    // 按最近最少使用淘汰，总大小不超过上限。线程安全，可被引擎池中的多个引擎共享。
+    class ResultCache
+    {
+    public:
+        explicit ResultCache(size_t max_bytes);
+
+        // 计算缓存键：像素内容、尺寸、类型与任务选项（含排版解析方案与请求的参数覆盖）的64位哈希
+        static uint64_t key(const cv::Mat &img, bool det, bool cls, bool rec, const std::string &parser = "",
+                            const OCROptions *options = nullptr);
+
+        bool get(uint64_t key, std::string &json); // 命中时取出结果并置为最新
+        void put(uint64_t key, const std::string &json); // 存入结果，超出上限时淘汰最久未用的条目
+
+        struct Stats
+        {
+            uint64_t hits;
+            uint64_t misses;
+            size_t entries;
+            size_t bytes;
+        };
+        Stats stats() const;
+
+    private:
+        struct Entry
+        {
+            uint64_t key;
+            std::string json;
+        };
+        static size_t entry_bytes(const Entry &e); // 条目的内存占用估计
+
+        size_t max_bytes_;
+        size_t bytes_ = 0;
+        uint64_t hits_ = 0;
+        uint64_t misses_ = 0;
+        std::list<Entry> lru_; // 表头为最近使用
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> index_;
+        mutable std::mutex mutex_;
+    };
+
+} // namespace PaddleOCR
+
+#endif // RESULT_CACHE_H
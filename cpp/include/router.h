@@ -0,0 +1,73 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#ifndef ROUTER_H
+#define ROUTER_H
+
+#include "include/httplib.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace PaddleOCR
+{
+    // ==================== 集群路由 ====================
+    // --router 列出多个 --server 实例（host:port，以分号分隔）时，本进程不加载模型，只做转发：
+    // 后台定期读取各后端的 /api/health（执行中与排队的请求数、引擎数、已登记与已加载的识别语言），
+    // 每个请求交给能识别其 lang、负载最低的后端，离线或繁忙（503）时换下一个。
+    // /api/ocr/batch 按各后端的空闲容量拆分到多个后端并行识别，结果按输入顺序合并
+    class Router
+    {
+    public:
+        Router(int port, const std::string &backends);
+
+        int run(); // 开始轮询与监听，直到服务器停止
+
+    private:
+        struct Backend
+        {
+            std::string host;
+            int port = 0;
+            bool up = false;
+            int engines = 1;
+            int reported = 0;    // 上次轮询时后端执行中与排队的请求数
+            int sent = 0;        // 上次轮询以来本路由发出的请求数，下次轮询时清零
+            int outstanding = 0; // 本路由发出、尚未完成的请求数
+            std::set<std::string> languages; // 已登记的识别语言
+            std::set<std::string> loaded;    // 其中模型已加载的语言
+        };
+
+        void handle_forward(const httplib::Request &req, httplib::Response &res);
+        void handle_batch(const httplib::Request &req, httplib::Response &res);
+        void handle_health(const httplib::Request &req, httplib::Response &res);
+
+        // 选出能识别 lang（为空时不限）、代价最低的在线后端，跳过 tried 中的后端。没有时返回-1。
+        // 代价为每个引擎的负载；未加载该语言模型的后端多计一个请求，首次加载较慢
+        int pick(const std::string &lang, const std::vector<char> &tried);
+        double cost(const Backend &backend, const std::string &lang) const; // 持锁调用
+        // 批量拆分：选出负载与最低者相近的后端（至多 count 个），按引擎数分配图片数，返回各后端下标与分得的数量
+        std::vector<std::pair<int, size_t>> shard(const std::string &lang, size_t count);
+        void begin(int index); // 发出请求，计入负载
+        void end(int index, bool reachable); // 请求完成；连接失败时把后端标为离线，等下次轮询恢复
+        // 把请求原样（路径、参数、优先级等头部、正文）发给后端。连接失败时返回false
+        bool send(int index, const httplib::Request &req, const std::string &body,
+                  const httplib::UploadFormDataItems *items, httplib::Response &res);
+        // 选后端并转交（preferred 非负时先试它），连接失败或后端繁忙时换一个，直到没有可用的后端
+        void dispatch(const httplib::Request &req, const std::string &lang, const std::string &body,
+                      const httplib::UploadFormDataItems *items, httplib::Response &res, int preferred = -1);
+        void poll(); // 轮询线程
+
+        int port_;
+        httplib::Server server_;
+        std::vector<Backend> backends_;
+        std::mutex mutex_;
+        std::condition_variable stop_cv_;
+        bool stopping_ = false;
+    };
+
+} // namespace PaddleOCR
+
+#endif // ROUTER_H
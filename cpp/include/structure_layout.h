@@ -14,10 +14,8 @@
 
 #pragma once
 
-#include "paddle_api.h"
-#include "paddle_inference_api.h"
-
 #include <include/postprocess_op.h>
+#include <include/predictor.h>
 #include <include/preprocess_op.h>
 
 namespace PaddleOCR {
@@ -30,7 +28,8 @@ public:
       const bool &use_mkldnn, const std::string &label_path,
       const bool &use_tensorrt, const std::string &precision,
       const double &layout_score_threshold,
-      const double &layout_nms_threshold) {
+      const double &layout_nms_threshold,
+      const std::string &backend = "paddle") {
     this->use_gpu_ = use_gpu;
     this->gpu_id_ = gpu_id;
     this->gpu_mem_ = gpu_mem;
@@ -38,20 +37,24 @@ public:
     this->use_mkldnn_ = use_mkldnn;
     this->use_tensorrt_ = use_tensorrt;
     this->precision_ = precision;
+    this->backend_ = backend;
 
     this->post_processor_.init(label_path, layout_score_threshold,
                                layout_nms_threshold);
     LoadModel(model_dir);
   }
 
-  // Load Paddle inference model
+  // Load inference model
   void LoadModel(const std::string &model_dir);
 
+  // 克隆：共享模型权重，新建推理状态，用于引擎池中的其它实例
+  StructureLayoutRecognizer *Clone() const;
+
   void Run(cv::Mat img, std::vector<StructurePredictResult> &result,
            std::vector<double> &times);
 
 private:
-  std::shared_ptr<paddle_infer::Predictor> predictor_;
+  std::shared_ptr<Predictor> predictor_;
 
   bool use_gpu_ = false;
   int gpu_id_ = 0;
@@ -65,11 +68,11 @@ private:
 
   bool use_tensorrt_ = false;
   std::string precision_ = "fp32";
+  std::string backend_ = "paddle"; // 推理后端
 
   // pre-process
   Resize resize_op_;
-  Normalize normalize_op_;
-  Permute permute_op_;
+  NormalizePermute norm_permute_op_;
 
   // post-process
   PicodetPostProcessor post_processor_;
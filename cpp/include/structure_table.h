@@ -14,10 +14,8 @@
 
 #pragma once
 
-#include "paddle_api.h"
-#include "paddle_inference_api.h"
-
 #include <include/postprocess_op.h>
+#include <include/predictor.h>
 #include <include/preprocess_op.h>
 
 namespace PaddleOCR {
@@ -30,7 +28,8 @@ public:
       const bool &use_mkldnn, const std::string &label_path,
       const bool &use_tensorrt, const std::string &precision,
       const int &table_batch_num, const int &table_max_len,
-      const bool &merge_no_span_structure) {
+      const bool &merge_no_span_structure,
+      const std::string &backend = "paddle") {
     this->use_gpu_ = use_gpu;
     this->gpu_id_ = gpu_id;
     this->gpu_mem_ = gpu_mem;
@@ -38,6 +37,7 @@ public:
     this->use_mkldnn_ = use_mkldnn;
     this->use_tensorrt_ = use_tensorrt;
     this->precision_ = precision;
+    this->backend_ = backend;
     this->table_batch_num_ = table_batch_num;
     this->table_max_len_ = table_max_len;
 
@@ -45,9 +45,12 @@ public:
     LoadModel(model_dir);
   }
 
-  // Load Paddle inference model
+  // Load inference model
   void LoadModel(const std::string &model_dir);
 
+  // 克隆：共享模型权重，新建推理状态，用于引擎池中的其它实例
+  StructureTableRecognizer *Clone() const;
+
   void Run(std::vector<cv::Mat> img_list,
            std::vector<std::vector<std::string>> &rec_html_tags,
            std::vector<float> &rec_scores,
@@ -55,7 +58,7 @@ public:
            std::vector<double> &times);
 
 private:
-  std::shared_ptr<paddle_infer::Predictor> predictor_;
+  std::shared_ptr<Predictor> predictor_;
 
   bool use_gpu_ = false;
   int gpu_id_ = 0;
@@ -70,13 +73,12 @@ private:
 
   bool use_tensorrt_ = false;
   std::string precision_ = "fp32";
+  std::string backend_ = "paddle"; // 推理后端
   int table_batch_num_ = 1;
 
   // pre-process
   TableResizeImg resize_op_;
-  Normalize normalize_op_;
-  PermuteBatch permute_op_;
-  TablePadImg pad_op_;
+  NormalizePermute norm_permute_op_;
 
   // post-process
   TablePostProcessor post_processor_;
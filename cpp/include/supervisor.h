@@ -0,0 +1,96 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#ifndef SUPERVISOR_H
+#define SUPERVISOR_H
+
+#include "include/httplib.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace PaddleOCR
+{
+    // ==================== 多进程隔离 ====================
+    // --server 且 --supervisor=K 时，本进程只持有HTTP监听，不加载模型；另起K个工作进程
+    // （同一可执行文件的匿名管道模式），请求经由工作进程的 stdin/stdout 转交：单图上传以二进制帧发送，
+    // 带参数或base64的请求以json指令发送。个别图片使推理库崩溃或卡死时，只重启那一个工作进程，
+    // 其余工作进程的已加载模型不受影响；等待中的请求继续排队，交给其它空闲的工作进程。
+    // 只支持 Linux，只提供 /api/ocr、/api/ocr/base64 与 /api/health。
+    // 回复同样按 format、compact、omit_cls 编码；工作进程不记录阶段耗时，不支持 timing
+    class Supervisor
+    {
+    public:
+        // worker_args 为工作进程的命令行参数（不含可执行文件路径）
+        Supervisor(int port, int workers, const std::vector<std::string> &worker_args);
+        ~Supervisor();
+
+        int run(); // 启动工作进程并监听，直到服务器停止
+
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        enum WorkerState
+        {
+            WORKER_STARTING, // 正在启动（加载模型）
+            WORKER_IDLE,
+            WORKER_BUSY,
+            WORKER_DEAD, // 等待重启
+        };
+
+        struct Worker
+        {
+            int pid = -1;
+            int in_fd = -1;      // 工作进程的 stdin
+            int out_fd = -1;     // 工作进程的 stdout
+            std::string pending; // 已读取、尚未取走的输出
+            WorkerState state = WORKER_DEAD;
+            int restarts = 0;
+        };
+
+        // 一次请求的结果
+        enum Exchange
+        {
+            EXCHANGE_OK,
+            EXCHANGE_TIMEOUT, // 超过 supervisor_timeout_ms 未回复
+            EXCHANGE_CRASHED, // 管道断开，工作进程已退出
+        };
+
+        void handle_upload(const httplib::Request &req, httplib::Response &res);
+        void handle_base64(const httplib::Request &req, httplib::Response &res);
+        void handle_health(const httplib::Request &req, httplib::Response &res);
+
+        // 交给一个空闲的工作进程执行，返回回复正文与HTTP状态码。工作进程崩溃时换一个重试至多 supervisor_retries 次
+        std::string dispatch(const std::string &request, int &status);
+        int acquire(Clock::time_point deadline); // 借用空闲的工作进程，超时返回-1
+        void release(int index, bool healthy);   // 归还；不健康时交给重启线程
+        Exchange exchange(Worker &worker, const std::string &request, std::vector<std::string> &lines,
+                          Clock::time_point deadline);
+
+        // 启动工作进程（锁外调用）。PR_SET_PDEATHSIG 在 fork 的线程退出时即触发，
+        // 须在长期存活的线程（主线程、重启线程）中调用
+        bool launch(Worker &worker);
+        bool wait_ready(Worker &worker); // 等待 launch 的工作进程初始化完成，失败时结束它（锁外调用）
+        bool spawn(Worker &worker);      // launch 并 wait_ready，供重启线程使用
+        static void terminate(Worker &worker); // 结束工作进程并回收
+        bool read_line(Worker &worker, std::string &line, Clock::time_point deadline, bool &eof);
+        void keeper(); // 重启线程：逐个重启 WORKER_DEAD 的工作进程
+
+        int port_;
+        std::vector<std::string> worker_args_;
+        std::string exe_;
+        httplib::Server server_;
+        std::vector<Worker> workers_;
+        std::mutex mutex_;
+        std::condition_variable idle_;  // 有工作进程变为空闲
+        std::condition_variable dead_;  // 有工作进程等待重启
+        bool stopping_ = false;
+        unsigned long long sequence_ = 0; // 请求序号，用于回复的结束标记
+    };
+
+} // namespace PaddleOCR
+
+#endif // SUPERVISOR_H
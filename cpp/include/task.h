@@ -5,11 +5,20 @@
 #define TASK_H
 
 #include "include/nlohmann/json.hpp" // json库
+#include "include/json_writer.h" // 结果json流式写入
 #include "include/paddleocr.h" // OCR引擎
+#include "include/memory_governor.h" // 内存管控
+#include "include/result_cache.h" // 识别结果缓存
+#include "include/document.h" // 多页PDF/TIFF
 #include "opencv2/core.hpp" // cv::Mat
 
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
 namespace PaddleOCR
 {
+    class PaddleStructure;
 
 // ==================== 标志码 ====================
 #define CODE_INIT 0 // 每回合初始值，回合结束时仍为它代表受管控的区域内未发现错误
@@ -61,41 +70,191 @@ namespace PaddleOCR
 #define MSG_ERR_JSON_PARSE_KEY(k) "Json parse key [" + k + "] failed."
 #define CODE_ERR_NO_TASK 403 // 未发现有效任务
 #define MSG_ERR_NO_TASK "No valid tasks."
+#define CODE_ERR_PARSER 404 // 未知的排版解析方案（parser 键）
+#define MSG_ERR_PARSER(p) "Unknown parser: \"" + p + "\""
+#define CODE_ERR_OPTION 405 // 请求参数（阈值、尺寸限制等）的类型或取值无效
+#define MSG_ERR_OPTION(k) "Invalid option [" + k + "]."
+#define CODE_ERR_REQUEST_SIZE 406 // 套接字连接中一行请求超过 max_request_mb 仍未结束，连接随后关闭
+#define MSG_ERR_REQUEST_SIZE "Request exceeds max_request_mb."
+// 二进制帧读图，失败
+#define CODE_ERR_FRAME_HEADER 500 // 帧头不合法（版本、格式或尺寸有误）
+#define MSG_ERR_FRAME_HEADER "Binary frame header invalid."
+#define CODE_ERR_FRAME_INCOMPLETE 501 // 负载长度不足，连接或管道在帧结束前关闭
+#define MSG_ERR_FRAME_INCOMPLETE "Binary frame payload incomplete."
+#define CODE_ERR_FRAME_DECODE 502 // 负载读取成功，但无法被opencv解码
+#define MSG_ERR_FRAME_DECODE "Binary frame image decode failed."
+#define CODE_ERR_FRAME_SIZE 503 // 负载长度超过 max_request_mb，不读取
+#define MSG_ERR_FRAME_SIZE(n) "Binary frame payload of " + std::to_string(n) + " bytes exceeds max_request_mb."
+// 共享内存读图，失败
+#define CODE_ERR_SHM_OPEN 600 // 共享内存打开或映射失败
+#define MSG_ERR_SHM_OPEN(n) "Shared memory open failed. Name: \"" + n + "\""
+#define CODE_ERR_SHM_PARAM 601 // 共享内存的偏移、尺寸或格式不合法，或超出共享内存范围
+#define MSG_ERR_SHM_PARAM(n) "Shared memory image parameters invalid. Name: \"" + n + "\""
+// 准入控制，拒绝
+#define CODE_ERR_IMAGE_SIZE 700 // 图片像素数超过 max_image_pixels
+#define MSG_ERR_IMAGE_SIZE(w, h) "Image too large: " + std::to_string(w) + "x" + std::to_string(h) + " exceeds max_image_pixels."
+// 多页文档（PDF/多页TIFF），失败
+#define CODE_ERR_DOC_PDF 800 // 收到PDF，但未编译PDF支持
+#define MSG_ERR_DOC_PDF "PDF is not supported, rebuild with -DWITH_PDFIUM=ON."
+#define CODE_ERR_DOC_PAGES 801 // 页数超过 doc_max_pages
+#define MSG_ERR_DOC_PAGES(n) "Document has " + std::to_string(n) + " pages, exceeds doc_max_pages."
+#define CODE_ERR_DOC_RENDER 802 // 文档无法打开，或某一页光栅化失败
+#define MSG_ERR_DOC_RENDER(i) "Document page " + std::to_string(i) + " render failed."
+// 视频OCR，失败
+#define CODE_ERR_VIDEO_OPEN 900 // 视频源无法打开
+#define MSG_ERR_VIDEO_OPEN(s) "Video open failed. Source: \"" + s + "\""
+
+// ==================== 二进制帧 ====================
+// 管道/套接字模式下，可用二进制帧代替json指令，跳过 base64 与 json 解析。
+// 帧头共24字节，整数为小端序，其后紧跟 length 字节的负载：
+//   [0,4) magic "\x89OCR"   [4] version=1   [5] format   [6] options   [7] 保留
+//   [8,12) width   [12,16) height   [16,20) stride   [20,24) length
+// 首字节0x89不可能出现在json文本行的开头，因此帧与json指令可以在同一个流中混用。
+#define FRAME_MAGIC "\x89OCR"
+#define FRAME_HEADER_SIZE 24
+#define FRAME_VERSION 1
+// format：负载格式
+#define FRAME_FORMAT_ENCODED 0 // 编码后的图片文件（jpg/png/bmp等），忽略宽高
+#define FRAME_FORMAT_BGR 1     // BGR 像素，每像素3字节
+#define FRAME_FORMAT_BGRA 2    // BGRA 像素，每像素4字节
+#define FRAME_FORMAT_GRAY 3    // 灰度像素，每像素1字节
+// options：按位的任务选项
+#define FRAME_OPT_OVERRIDE 0x01 // 置位时，使用下面三位代替启动参数中的 det/cls/rec
+#define FRAME_OPT_DET 0x02
+#define FRAME_OPT_CLS 0x04
+#define FRAME_OPT_REC 0x08
+
+    // 解析后的帧头
+    struct FrameHeader
+    {
+        uint8_t version;
+        uint8_t format;
+        uint8_t options;
+        uint32_t width;
+        uint32_t height;
+        uint32_t stride; // 每行字节数，0表示紧密排列
+        uint32_t length; // 负载字节数
+    };
 
     // ==================== 任务调用类 ====================
     class Task
     {
 
     public:
+        ~Task();   // 解除仍保留的共享内存映射
         int ocr(); // OCR图片
         void init_engine(); // 初始化OCR引擎（公开给HTTP服务器使用）
-        std::string run_ocr_mat(cv::Mat img); // 直接传入Mat进行OCR，返回json字符串
+        void init_engine(const Task &base); // 从已初始化的任务克隆OCR引擎，共享模型权重（用于引擎池）
+        PPOCR *engine() const { return ppocr.get(); } // 获取OCR引擎，未初始化时为空
+        PaddleStructure *structure_engine() const;    // type=structure 时获取版面与表格识别引擎，否则为空
+        ResultCache *cache() const { return result_cache.get(); } // 获取结果缓存，未启用时为空
+        static int get_memory_mb(); // 获取当前进程内存占用。返回整数，单位MB。失败时返回-1。
+        // 以下 parser 为排版解析方案（见 tbpu.h），为空时使用 tbpu_parser 参数；options 为本次请求的参数覆盖
+        std::string run_ocr_mat(cv::Mat img, const std::string &parser = "",
+                                const OCROptions &options = OCROptions()); // 直接传入Mat进行OCR，返回json字符串
+        std::string run_ocr_mat(cv::Mat img, const std::function<void(const std::string &)> &emit,
+                                const std::string &parser = "",
+                                const OCROptions &options = OCROptions()); // 同上，流式：检测完成、每批识别完成时先调用 emit 输出一行中间结果
+        std::vector<std::string> run_ocr_mats(std::vector<cv::Mat> imgs, const std::string &parser = "",
+                                              const OCROptions &options = OCROptions()); // 一次传入多张Mat进行OCR，返回各图片的json字符串
+        // 只识别：imgs 为裁好的单行文字图片，跳过检测，一次性按宽度分批识别（options.det 被忽略）。
+        // 返回一个结果json，data 中每张图片一项、与输入顺序一致，未识别出文字的项 text 为空
+        std::string run_rec_mats(std::vector<cv::Mat> imgs, const OCROptions &options = OCROptions());
+        // 从请求json的同名键（det、cls、rec、limit_side_len、det_db_box_thresh 等）读取参数覆盖，
+        // 未出现的键保持不变。某个键的类型或取值无效时返回false，key 为该键名
+        static bool parse_options(const nlohmann::json &j, OCROptions &options, std::string &key);
+        // 读图（OCR用）：JPEG且启用 decode_reduce 时，按 options 中的检测尺寸与ROI选取缩小倍数直接缩小解码，
+        // 倍数记入 options.decode_scale。其它格式原样解码
+        static cv::Mat imdecode_for_ocr(const void *data, size_t size, OCROptions &options);
+        // 识别多页文档：PDF与多页TIFF打开为 doc，first 为光栅化的首页；单页PDF的 doc 为空，first 为其唯一一页。
+        // 不是文档时 doc 与 first 均为空。返回 CODE_INIT，文档有误时返回错误码，msg 为错误信息
+        static int open_document(const void *data, size_t size, const OCROptions &options,
+                                 std::shared_ptr<Document> &doc, cv::Mat &first, std::string &msg);
+        // 逐页OCR多页文档：后续页面在后台提前光栅化，每次取若干页经由多图流水线识别，
+        // 按页序对每页调用 on_page(页码, 结果json)。first 非空时为已处理（裁切）过的首页，从第二页起读取
+        void run_ocr_document(const std::shared_ptr<Document> &doc, cv::Mat first, const std::string &parser,
+                              const OCROptions &options, const std::function<void(int, const std::string &)> &on_page);
+        // 把图片裁切为 options 中的ROI（不复制像素），ROI与图片不相交时返回false
+        static bool apply_roi(cv::Mat &img, const OCROptions &options);
+        std::string run_structure_mat(cv::Mat img); // 直接传入Mat进行版面与表格识别，返回json字符串。须以 type=structure 启动
+        void release_memory();            // 释放引擎的中间张量与各缓冲区。调用时引擎不得在使用中
+        std::string memory_report() const; // 各模型自上次释放以来最大的输入形状，用于内存日志
 
     private:
         bool is_exit = false;         // 为true时退出任务循环
         std::unique_ptr<PPOCR> ppocr; // OCR引擎智能指针
+        std::mutex run_mutex;         // 管道/套接字模式下处理请求时持有，后台内存清理只在未持有时进行
+        std::unique_ptr<MemoryGovernor> governor; // 管道/套接字模式的内存管控，未限制内存时为空
+        std::shared_ptr<ResultCache> result_cache; // 识别结果缓存，克隆的引擎之间共享。未启用时为空
         int t_code;                   // 本轮任务状态码
         std::string t_msg;            // 本轮任务状态消息
+        bool t_stream = false;        // 本轮任务是否流式输出中间结果
+        bool t_structure = false;     // 本轮任务是否执行版面与表格识别（type=structure 时默认开启）
+        std::string t_parser;         // 本轮任务的排版解析方案，为空时使用 tbpu_parser 参数
+        OCROptions t_options;         // 本轮任务的参数覆盖
+        std::string t_image_path;     // 本轮任务的图片路径标记，用于无文字时的信息输出
+        std::function<void(const std::string &)> stream_sink; // 流式中间结果的输出方式，为空时中间结果与最终结果一并回复
+        std::string t_id;             // 本轮任务ID（json文本），请求中带 id 时原样回传，便于客户端连续发送多个请求后对应结果
+        std::vector<cv::Mat> batch_imgs;       // 本轮批量任务的图片，非批量任务时为空
+        std::vector<std::string> batch_errors; // 本轮批量任务中各图片的读图错误回复，读图成功的项为空
+        std::shared_ptr<Document> t_document; // 本轮任务的多页文档，非空时逐页识别
+        OCROptions *decode_options = nullptr; // 读取单图OCR任务的图片期间指向 t_options，其余时候为空（批量与版面任务不缩小解码）
+        std::vector<uchar> decode_buffer; // base64解码缓冲区，跨任务复用，只增不减（内存清理时释放）
+        size_t json_reserve = 0;          // 上一次结果json的长度，下次写入时按此预留，避免逐步扩容
+        std::string shm_name;             // 当前映射的共享内存名。映射跨任务保留，同名请求不再重复打开
+        void *shm_addr = nullptr;         // 当前共享内存映射首地址
+        size_t shm_size = 0;              // 当前共享内存映射大小
+#ifdef _WIN32
+        void *shm_handle = nullptr; // 共享内存的映射对象句柄
+#else
+        unsigned long shm_ino = 0; // 共享内存的inode，用于识别同名重建的共享内存
+#endif
 
         // 任务流程
-        void memory_check_cleanup();        // 检查内存占用，达到上限时释放内存
+        void warmup_engine();               // 启用 warmup 时预热OCR引擎
+        void start_governor();              // 管道/套接字模式：启动后台内存管控
+        bool check_image_size(const cv::Mat &img); // 准入控制：图片超过 max_image_pixels 时设置错误码，返回false
         std::string run_ocr(std::string); // 输入用户传入值（字符串），返回结果json字符串
+        std::string run_ocr_batch();      // 执行本轮批量任务，每张图片回复一行
+        std::string run_document(cv::Mat first); // 执行本轮多页文档任务，每页回复一行
+        std::string ocr_json(cv::Mat &img, bool det, bool cls, bool rec, const std::string &parser = "",
+                             const OCROptions *options = nullptr); // OCR图片并返回结果json字符串（无文字时为空），优先查缓存
+        std::string ocr_json_stream(cv::Mat &img, bool det, bool cls, bool rec,
+                                    const std::function<void(const std::string &)> &emit,
+                                    const std::string &parser = "",
+                                    const OCROptions *options = nullptr); // 同上，各阶段完成时调用 emit 输出中间结果，不查缓存
+        static void map_to_source(std::vector<OCRPredictResult> &results, const OCROptions &options); // 结果坐标按解码倍数与ROI映射回原图
+        std::string structure_json(cv::Mat &img); // 版面与表格识别并返回结果json字符串（无结果时为空）
         int single_image_mode();          // 单次识别模式
+        int video_mode();                 // 视频OCR模式
+        int batch_mode();                 // 离线批量模式：自建引擎池，不使用本实例的引擎（见 task_batch.cpp）
         int socket_mode();                // 套接字模式
+        std::string socket_handle(std::string &buffer, bool &eof); // 套接字模式：处理连接缓冲区中的完整请求，返回回复。须关闭连接时置 eof
+        static size_t max_request_bytes(); // 单个请求（二进制帧负载或一行文本）的大小上限，由 max_request_mb 决定
         int anonymous_pipe_mode();        // 匿名管道模式
-        int get_memory_mb();           // 获取当前内存占用。返回整数，单位MB。失败时返回-1。
 
         // 输出相关
         void set_state(int code = CODE_INIT, std::string msg = "");             // 设置状态
         std::string get_state_json(int code = CODE_INIT, std::string msg = ""); // 获取状态json字符串
         std::string get_ocr_result_json(const std::vector<OCRPredictResult> &); // 传入OCR结果，返回json字符串
+        std::string get_ocr_result_json(const std::vector<OCRPredictResult> &, bool det, bool rec); // 同上，指定本轮是否启用det/rec
+        std::string get_structure_result_json(const std::vector<StructurePredictResult> &); // 传入版面与表格识别结果，返回json字符串
+        std::string tag_reply(const std::string &reply, int index = -1);    // 将本轮请求的id、批量任务的下标插入回复json
+        std::string json_finish(const JsonWriter &writer, std::string &out); // 取出写完的json，写入失败时返回序列化失败的状态
 
         // 输入相关
-        std::string json_dump(nlohmann::json);                             // json对象转字符串
-        cv::Mat imread_json(std::string &);                                // 输入json字符串，解析json并返回图片Mat
+        cv::Mat imread_json(std::string &);                                // 输入json字符串，解析json并返回图片Mat。批量任务的图片存入 batch_imgs
+        cv::Mat imread_json(const nlohmann::json &j, bool &is_image_found); // 从json对象的图片键读图，找到图片键时 is_image_found 置为true
+        cv::Mat imdecode(const void *data, size_t size, int flag); // 解码图片文件。decode_options 非空时按 imdecode_for_ocr 缩小解码
         cv::Mat imread_u8(std::string path, int flag = cv::IMREAD_COLOR);  // 代替cv imread，输入utf-8字符串，返回Mat。失败时设置错误码，并返回空Mat。
         cv::Mat imread_clipboard(int flag = cv::IMREAD_COLOR);             // 从当前剪贴板中读取图片
-        cv::Mat imread_base64(std::string &, int flag = cv::IMREAD_COLOR); // 输入base64编码的字符串，返回Mat
+        cv::Mat imread_base64(const std::string &, int flag = cv::IMREAD_COLOR); // 输入base64编码的字符串，返回Mat
+        bool parse_frame_header(const char *data, FrameHeader &header);   // 解析二进制帧头，失败时设置错误码
+        cv::Mat imread_shm(const nlohmann::json &j);                       // 从json指定的共享内存读取像素，不复制数据
+        const char *shm_map(const std::string &name, size_t &size);       // 映射命名共享内存（只读），返回首地址与大小。失败时返回空
+        void shm_unmap();                                                  // 解除当前共享内存映射
+        cv::Mat imread_frame(const FrameHeader &header, const char *payload); // 从二进制帧负载读图，不复制数据
+        std::string run_ocr_frame(const FrameHeader &header, const char *payload); // 执行一个二进制帧任务，返回结果json字符串
 #ifdef _WIN32
         cv::Mat imread_wstr(std::wstring pathW, int flags = cv::IMREAD_COLOR); // 输入unicode wstring字符串，返回Mat。
 #endif
@@ -0,0 +1,30 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#ifndef TBPU_H
+#define TBPU_H
+
+#include "include/utility.h"
+
+#include <string>
+#include <vector>
+
+namespace PaddleOCR
+{
+    // ==================== 排版解析 ====================
+    // tbpu (text block processing unit) 的C++实现，与 api/python/tbpu 中的各排版解析方案相同：
+    // 按阅读顺序重新排列OCR结果，并为每个文本块写入结尾间隔符 end（换行、空格或无），客户端按顺序拼接 text+end 即得全文。
+    // 多栏方案以间隙树（GapTree）划分区块，另写入每个文本块所在区块的序号 block；
+    // single_code 将每行合并为一个文本块，并按缩进层级补充行首空格
+    class Tbpu
+    {
+    public:
+        // 方案名：none, multi_para, multi_line, multi_none, single_para, single_line, single_none, single_code
+        static bool valid(const std::string &parser);
+        // 按 parser 方案处理 results。parser 为空时不做处理
+        static void run(const std::string &parser, std::vector<OCRPredictResult> &results);
+    };
+
+} // namespace PaddleOCR
+
+#endif // TBPU_H
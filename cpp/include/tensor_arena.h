@@ -0,0 +1,99 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#ifndef TENSOR_ARENA_H
+#define TENSOR_ARENA_H
+
+#include "include/predictor.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace PaddleOCR
+{
+    // ==================== 张量缓冲区 ====================
+    // 每个推理实例持有一个，跨调用复用输入输出缓冲区，避免每次推理都按整图大小分配内存。
+    // CPU推理时直接读写张量自身的内存（零拷贝，后端支持时），不再经过 CopyFromCpu / CopyToCpu；
+    // GPU推理时使用只增不减的主机缓冲区中转。启用锁页内存时（需编译时找到CUDA头文件），
+    // 中转缓冲区以 cudaHostAlloc 分配，主机与设备间的复制走DMA，不再经过驱动的分页内存中转。
+    // GPU流水线（双缓冲）：Stage 写入两个中转缓冲区之一，Commit 时才设置形状并复制到张量，
+    // 因此可以在第k批推理期间，于另一线程向另一个缓冲区预处理第k+1批。
+    class TensorArena
+    {
+    public:
+        TensorArena() {}
+        // 复制（克隆推理实例时）不复制缓冲区，新实例按需重新分配
+        TensorArena(const TensorArena &other) : pinned_(other.pinned_) {}
+
+        // 是否以锁页内存分配主机缓冲区，未编译CUDA支持时无效。应在首次推理前设置
+        void SetPinned(bool pinned);
+
+        // 设置输入形状，返回已清零的可写缓冲区。写完后须调用 CommitInput
+        float *Input(InferTensor *tensor, const std::vector<int> &shape, bool zero_copy);
+        // 提交输入：非零拷贝时把主机缓冲区复制到张量
+        void CommitInput(InferTensor *tensor);
+        // 双缓冲输入：返回第 slot（0或1）个中转缓冲区，已按 shape 清零。可在推理线程以外调用
+        float *Stage(int slot, const std::vector<int> &shape);
+        // 把第 slot 个中转缓冲区设为张量的输入（设置形状并复制）
+        void Commit(InferTensor *tensor, int slot);
+        // 取输出数据与元素数。返回的指针在下一次推理前有效
+        const float *Output(InferTensor *tensor, int &size);
+        // 只增不减的临时缓冲区，供后处理使用
+        std::vector<unsigned char> &Scratch(size_t size);
+        // 释放全部主机缓冲区（内存清理时调用），并重置最大输入形状
+        void Release();
+        // 记录一次输入形状，供输入不经过本缓冲区（如直接使用设备内存）时统计最大输入形状
+        void Track(const std::vector<int> &shape, size_t size);
+        // 自上次 Release 以来元素数最多的输入形状，如 "1x3x960x960"，无输入时为空。可在其他线程中读取
+        std::string PeakShape() const;
+
+    private:
+        // 只增不减的主机缓冲区，可选锁页内存
+        class HostBuffer
+        {
+        public:
+            HostBuffer() {}
+            ~HostBuffer() { Free(); }
+            // 容量不足 size 时重新分配，不保留原有内容
+            float *Reserve(size_t size, bool pinned);
+            float *data() const { return data_; }
+            void Free();
+
+        private:
+            HostBuffer(const HostBuffer &) = delete;
+            HostBuffer &operator=(const HostBuffer &) = delete;
+
+            float *data_ = nullptr;
+            size_t capacity_ = 0;
+            bool pinned_ = false; // 当前内存是否为锁页内存
+        };
+
+        HostBuffer input_;                   // 输入主机缓冲区
+        HostBuffer output_;                  // 输出主机缓冲区
+        HostBuffer staging_[2];              // 双缓冲输入
+        std::vector<int> staged_shape_[2];   // 双缓冲输入的形状
+        std::vector<unsigned char> scratch_; // 后处理临时缓冲区
+        bool zero_copy_ = false;             // 本轮输入是否直接写入张量
+        bool pinned_ = false;                // 是否使用锁页内存
+
+        static const int MAX_DIMS = 4;
+        std::atomic<size_t> peak_size_{0};     // 最大输入的元素数
+        std::atomic<int> peak_shape_[MAX_DIMS]; // 最大输入的形状，不足 MAX_DIMS 维时其余为0
+    };
+
+    // ==================== 推理实例的CUDA流 ====================
+    // 各推理实例独占一个CUDA流，多个引擎的推理与复制互不等待。流须晚于使用它的推理实例析构
+
+    // enabled 时新建CUDA流并设为 options.stream，否则或创建失败时返回空（使用默认流）
+    std::shared_ptr<void> CreateInferStream(bool enabled, PredictorOptions &options);
+
+    // 克隆推理实例（共享权重）：原实例有独占的流时，克隆体使用新的流，创建失败时沿用原实例的流。
+    // clone_stream 返回克隆体的流
+    std::shared_ptr<Predictor> ClonePredictor(const std::shared_ptr<Predictor> &predictor,
+                                              const std::shared_ptr<void> &stream,
+                                              std::shared_ptr<void> &clone_stream);
+} // namespace PaddleOCR
+
+#endif // TENSOR_ARENA_H
@@ -0,0 +1,97 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace PaddleOCR
+{
+    // ==================== 请求追踪 ====================
+    // 每个HTTP识别请求一个 Trace：沿用请求头 traceparent（W3C Trace Context）中的 trace id，
+    // 记录排队、借用引擎、解码、检测、裁切、分类、识别（含跨请求合批的等待）与json编码各阶段的区间。
+    // 处理请求的线程（及其派生的批量、流水线线程）把它设为当前追踪，各阶段用 Trace::record 记录，
+    // 没有当前追踪时为空操作。Metrics 的直方图是全部请求的汇总，这里是单个请求的时间线
+    class Trace
+    {
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        struct Span
+        {
+            const char *name; // 阶段名，须为静态字符串
+            Clock::time_point start;
+            Clock::time_point end;
+            int thread; // 记录线程的序号，Chrome trace 中每个线程一行
+        };
+
+        // traceparent 为请求头，为空或格式无效时新建 trace id。name 为整个请求的区间名，如 "POST /api/ocr"
+        Trace(const std::string &traceparent, const std::string &name);
+
+        const std::string &trace_id() const { return trace_id_; }
+        std::string traceresponse() const; // 回复头 traceresponse：00-<trace id>-<本请求的span id>-<flags>
+
+        void add(const char *name, Clock::time_point start, Clock::time_point end); // 可在任意线程中调用
+        void finish(); // 请求处理完毕，记下结束时间
+
+        // 回复中的 timing：{"stages":{阶段名:累计毫秒},"total_ms":总耗时,"trace_id":...}
+        std::string timing_json() const;
+        std::string chrome_json() const; // Chrome trace event 格式，可直接在 Perfetto / chrome://tracing 中打开
+        std::string otlp_json() const;   // OpenTelemetry OTLP/JSON（ExportTraceServiceRequest），可发给 collector 的 /v1/traces
+
+        static Trace *current();                  // 本线程的当前追踪，没有时为空
+        static Trace *set_current(Trace *trace);  // 设置本线程的当前追踪，返回原来的
+        class Scope                               // 作用域内把 trace 设为当前追踪，用于派生的工作线程
+        {
+        public:
+            explicit Scope(Trace *trace) : prev_(set_current(trace)) {}
+            ~Scope() { set_current(prev_); }
+
+        private:
+            Trace *prev_;
+        };
+
+        // 在当前追踪中记录一个区间
+        static void record(const char *name, Clock::time_point start, Clock::time_point end);
+        // 在当前追踪中记录到此刻为止、首尾相接的 count 个区间，ms 为各自的耗时（毫秒）。
+        // 用于推理库只报告各阶段耗时之和的场合（如检测、识别的前处理/推理/后处理）
+        static void record_sequence(const char *const *names, const double *ms, int count);
+
+    private:
+        std::string trace_id_;  // 32位十六进制
+        std::string parent_id_; // 调用方的span id，没有时为空
+        std::string span_id_;   // 本请求的span id，16位十六进制
+        std::string flags_;
+        std::string name_;
+        Clock::time_point start_;
+        Clock::time_point end_;
+        int thread_; // 创建追踪（处理请求）的线程
+        std::chrono::system_clock::time_point wall_start_; // OTLP 需要 Unix 时间
+        mutable std::mutex mutex_;
+        std::vector<Span> spans_;
+    };
+
+    // 最近完成的追踪，保留 trace_keep 个，供 /api/traces/<trace id> 取回
+    class TraceStore
+    {
+    public:
+        static TraceStore &get();
+
+        void put(const std::shared_ptr<Trace> &trace);
+        std::shared_ptr<Trace> find(const std::string &trace_id) const; // 同一 trace id 有多个请求时取最近的
+
+    private:
+        TraceStore() {}
+        mutable std::mutex mutex_;
+        std::deque<std::shared_ptr<Trace>> traces_;
+    };
+
+} // namespace PaddleOCR
+
+#endif // TRACE_H
@@ -17,11 +17,13 @@
 #include <chrono>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <ostream>
 #include <stdlib.h>
 #include <vector>
 
 #include <algorithm>
+#include <array>
 #include <cstring>
 #include <fstream>
 #include <numeric>
@@ -33,13 +35,45 @@
 namespace PaddleOCR
 {
 
+    // 四边形文本框：左上、右上、右下、左下四个点，每点 {x, y}。
+    // 定长、可平凡复制，按值传递没有堆分配。默认各点为 -1，表示无包围盒（未启用det）
+    struct Quad
+    {
+        std::array<std::array<int, 2>, 4> pts;
+
+        Quad()
+        {
+            for (int i = 0; i < 4; i++)
+                pts[i][0] = pts[i][1] = -1;
+        }
+        Quad(int x0, int y0, int x1, int y1, int x2, int y2, int x3, int y3)
+        {
+            pts[0][0] = x0, pts[0][1] = y0, pts[1][0] = x1, pts[1][1] = y1;
+            pts[2][0] = x2, pts[2][1] = y2, pts[3][0] = x3, pts[3][1] = y3;
+        }
+
+        std::array<int, 2> &operator[](size_t i) { return pts[i]; }
+        const std::array<int, 2> &operator[](size_t i) const { return pts[i]; }
+        std::array<int, 2> *begin() { return pts.data(); }
+        std::array<int, 2> *end() { return pts.data() + 4; }
+        size_t size() const { return 4; }
+        bool empty() const { return pts[0][0] < 0; } // 无包围盒
+    };
+
+    // 浮点四边形，det后处理的中间结果
+    typedef std::array<std::array<float, 2>, 4> QuadF;
+
     struct OCRPredictResult
     {
-        std::vector<std::vector<int>> box;
+        Quad box;
         std::string text;
         float score = -1.0;
         float cls_score;
         int cls_label = -1;
+        int line = -1;      // 阅读顺序中的行号，启用 text_group 时有效
+        int paragraph = -1; // 阅读顺序中的段落号，启用 text_group 时有效
+        std::string end;    // 排版解析写入的结尾间隔符，见 tbpu.h
+        int block = -1;     // 排版解析（多栏方案）写入的区块序号
     };
 
     struct StructurePredictResult
@@ -72,11 +106,19 @@ namespace PaddleOCR
             return std::distance(first, std::max_element(first, last));
         }
 
+        // 一次遍历同时求最大值与其下标（相同最大值取第一个），等价于 argmax + max_element
+        static int argmax_max(const float *data, int n, float &max_value);
+
         static void GetAllFiles(const char *dir_name,
                                 std::vector<std::string> &all_inputs);
 
         static cv::Mat GetRotateCropImage(const cv::Mat &srcimage,
-                                          std::vector<std::vector<int>> box);
+                                          const Quad &box);
+
+        // 按每个结果的框裁切，追加到 crops。threads > 1 且框较多时并行
+        static void GetRotateCropImages(const cv::Mat &srcimage,
+                                        const std::vector<OCRPredictResult> &ocr_result,
+                                        std::vector<cv::Mat> &crops, int threads = 1);
 
         static std::vector<int> argsort(const std::vector<float> &array);
 
@@ -99,16 +141,30 @@ namespace PaddleOCR
 
         static bool PathExists(const std::string &path);
 
+        static bool IsDir(const std::string &path); // 路径存在且为目录
+
         static void CreateDir(const std::string &path);
 
+        // 模型优化缓存目录：cache_root/<模型目录名>_<设备与精度>_<模型指纹>，不存在时创建。cache_root 为空时返回空
+        static std::string OptimCacheDir(const std::string &cache_root, const std::string &model_dir,
+                                         bool use_gpu, bool use_tensorrt, bool use_mkldnn,
+                                         const std::string &precision);
+
+        // 新建一个非阻塞的CUDA流，供 Config::SetExecStream 使用，最后一个引用释放时销毁。
+        // 未编译CUDA支持或创建失败时返回空
+        static std::shared_ptr<void> CreateCudaStream();
+
         static void print_result(const std::vector<OCRPredictResult> &ocr_result);
 
+        // 从内存解码图片文件。只用Mat头包装 data 而不复制，data 在返回前须保持有效
+        static cv::Mat imdecode_buffer(const void *data, size_t size, int flag = cv::IMREAD_COLOR);
+        // 从JPEG文件头（SOF段）读出宽高，不解码。不是JPEG或文件头不完整时返回false
+        static bool jpeg_size(const void *data, size_t size, int &width, int &height);
+
         static cv::Mat crop_image(cv::Mat &img, const std::vector<int> &area);
         static cv::Mat crop_image(cv::Mat &img, const std::vector<float> &area);
 
-        static void sorted_boxes(std::vector<OCRPredictResult> &ocr_result);
-
-        static std::vector<int> xyxyxyxy2xyxy(std::vector<std::vector<int>> &box);
+        static std::vector<int> xyxyxyxy2xyxy(const Quad &box);
         static std::vector<int> xyxyxyxy2xyxy(std::vector<int> &box);
 
         static float fast_exp(float x);
@@ -116,24 +172,6 @@ namespace PaddleOCR
         activation_function_softmax(std::vector<float> &src);
         static float iou(std::vector<int> &box1, std::vector<int> &box2);
         static float iou(std::vector<float> &box1, std::vector<float> &box2);
-
-    private:
-        static bool comparison_box(const OCRPredictResult &result1,
-                                   const OCRPredictResult &result2)
-        {
-            if (result1.box[0][1] < result2.box[0][1])
-            {
-                return true;
-            }
-            else if (result1.box[0][1] == result2.box[0][1])
-            {
-                return result1.box[0][0] < result2.box[0][0];
-            }
-            else
-            {
-                return false;
-            }
-        }
     };
 
 } // namespace PaddleOCR
\ No newline at end of file
@@ -0,0 +1,60 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#ifndef VIDEO_OCR_H
+#define VIDEO_OCR_H
+
+#include <bitset>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "include/paddleocr.h"
+#include "opencv2/core.hpp"
+
+namespace PaddleOCR
+{
+    // ==================== 视频OCR ====================
+    // 从视频文件、网络流（RTSP等）或摄像头连续读帧：按 --video_fps 抽帧，与上一识别帧感知哈希相同的帧跳过，
+    // 其余帧经由增量OCR只对变化区域重新检测与识别。各帧的文本框按位置跨帧跟踪，
+    // 只在文字出现、改变、消失时输出一行带时间戳的事件json，而不是每帧的完整结果：
+    //   {"box":...,"event":"appear","id":1,"score":0.98,"text":"...","time_ms":1500}
+    //   {"box":...,"event":"change","id":1,"score":0.97,"text":"...","time_ms":2000}
+    //   {"event":"disappear","id":1,"since_ms":1500,"text":"...","time_ms":4500}
+    // 视频结束时先报告仍在画面中的文字消失，最后一行为 {"event":"end",...} 及帧数统计
+    class VideoOCR
+    {
+    public:
+        // 事件逐行交给 emit 输出
+        VideoOCR(PPOCR &engine, const std::function<void(const std::string &)> &emit);
+
+        // 打开视频源并识别到结束（网络流断开）为止。source 为纯数字时是摄像头序号。打不开时返回false
+        bool run(const std::string &source, bool cls, bool rec);
+
+        // 感知哈希（差值哈希）：缩小到17x16的灰度图，每个像素比右侧相邻像素亮时该位为1。
+        // 对压缩噪声与轻微亮度变化不敏感
+        static std::bitset<256> frame_hash(const cv::Mat &img);
+
+    private:
+        struct Track
+        {
+            int id;
+            OCRPredictResult result;
+            cv::Rect rect;      // 文本框的外接矩形，用于跨帧匹配
+            long long since_ms; // 出现的时间
+            int missing = 0;    // 连续缺失的识别帧数
+        };
+
+        // 把一个识别帧的结果与已有的文字匹配，输出出现、改变与消失事件
+        void update(const std::vector<OCRPredictResult> &results, bool rec, long long time_ms);
+        void emit_event(const char *event, const Track &track, long long time_ms);
+
+        PPOCR &engine_;
+        std::function<void(const std::string &)> emit_;
+        std::vector<Track> tracks_; // 当前画面中的文字
+        int next_id_ = 1;
+    };
+
+} // namespace PaddleOCR
+
+#endif // VIDEO_OCR_H
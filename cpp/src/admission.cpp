@@ -0,0 +1,206 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#include "include/admission.h"
+
+#include <cmath>
+
+namespace PaddleOCR
+{
+    AdmissionControl::AdmissionControl(int max_inflight, int max_queue)
+        : max_inflight_(max_inflight > 0 ? max_inflight : 1), max_queue_(max_queue > 0 ? max_queue : 0)
+    {
+    }
+
+    AdmissionControl::Priority AdmissionControl::parse_priority(const std::string &name)
+    {
+        if (name == "high" || name == "interactive" || name == "0")
+            return PRIORITY_HIGH;
+        if (name == "low" || name == "batch" || name == "bulk" || name == "2")
+            return PRIORITY_LOW;
+        return PRIORITY_NORMAL;
+    }
+
+    AdmissionControl::Ticket::~Ticket()
+    {
+        std::chrono::duration<double, std::milli> ms = Clock::now() - start_;
+        owner_->leave(ms.count());
+    }
+
+    bool AdmissionControl::Ticket::should_yield() const
+    {
+        std::lock_guard<std::mutex> lock(owner_->mutex_);
+        return owner_->has_higher(priority_);
+    }
+
+    void AdmissionControl::Ticket::yield()
+    {
+        std::unique_lock<std::mutex> lock(owner_->mutex_);
+        if (!owner_->has_higher(priority_))
+        {
+            return;
+        }
+        Waiter w;
+        w.cost = cost_;
+        w.priority = priority_;
+        w.tenant = tenant_;
+        w.seq = owner_->seq_++;
+        owner_->inflight_--;
+        owner_->queued_cost_ += cost_;
+        owner_->waiters_.push_back(&w);
+        owner_->dispatch();
+        owner_->cond_.notify_all();
+        owner_->wait_granted(lock, w);
+    }
+
+    AdmissionControl::Result AdmissionControl::enter(int cost, Priority priority, const std::string &tenant,
+                                                     const Clock::time_point &deadline, Ticket *&ticket)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (Clock::now() >= deadline)
+        {
+            expired_++;
+            return ADMIT_EXPIRED;
+        }
+        if (inflight_ >= max_inflight_ || !waiters_.empty())
+        {
+            // 需要排队。队列为空时，即使单个请求的代价超过上限也允许排队，避免大图永远无法执行
+            if (max_queue_ == 0 || (!waiters_.empty() && queued_cost_ + cost > max_queue_))
+            {
+                rejected_++;
+                return ADMIT_FULL;
+            }
+            Waiter w;
+            w.cost = cost;
+            w.priority = priority;
+            w.tenant = tenant;
+            w.seq = seq_++;
+            queued_cost_ += cost;
+            waiters_.push_back(&w);
+            if (deadline == Clock::time_point::max())
+            {
+                wait_granted(lock, w);
+            }
+            else if (!cond_.wait_until(lock, deadline, [&w]
+                                       { return w.granted; }))
+            {
+                waiters_.remove(&w);
+                queued_cost_ -= cost;
+                expired_++;
+                return ADMIT_EXPIRED;
+            }
+            // 排队者获得名额时，dispatch 已计入 inflight_ 与 served_
+        }
+        else
+        {
+            inflight_++;
+            served_[tenant] += cost;
+        }
+        ticket = new Ticket(this, cost, priority, tenant);
+        return ADMIT_OK;
+    }
+
+    AdmissionControl::Ticket *AdmissionControl::try_enter(Priority priority, const std::string &tenant)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (inflight_ >= max_inflight_ || !waiters_.empty())
+        {
+            return nullptr;
+        }
+        inflight_++;
+        served_[tenant] += 1;
+        return new Ticket(this, 1, priority, tenant);
+    }
+
+    void AdmissionControl::leave(double ms)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            inflight_--;
+            avg_ms_ = avg_ms_ > 0 ? avg_ms_ * 0.9 + ms * 0.1 : ms;
+            dispatch();
+        }
+        cond_.notify_all(); // 唤醒全部：由各等待者检查自己是否获得了名额
+    }
+
+    void AdmissionControl::dispatch()
+    {
+        while (inflight_ < max_inflight_ && !waiters_.empty())
+        {
+            std::list<Waiter *>::iterator best = waiters_.begin();
+            for (std::list<Waiter *>::iterator it = waiters_.begin(); it != waiters_.end(); ++it)
+            {
+                const Waiter &a = **it, &b = **best;
+                if (a.priority != b.priority)
+                {
+                    if (a.priority < b.priority)
+                        best = it;
+                    continue;
+                }
+                double sa = served_[a.tenant], sb = served_[b.tenant];
+                if (sa < sb || (sa == sb && a.seq < b.seq))
+                    best = it;
+            }
+            Waiter *w = *best;
+            waiters_.erase(best);
+            w->granted = true;
+            queued_cost_ -= w->cost;
+            inflight_++;
+            served_[w->tenant] += w->cost;
+        }
+        if (waiters_.empty())
+        {
+            served_.clear(); // 无竞争时不再需要记账，也避免租户表无限增长
+        }
+    }
+
+    void AdmissionControl::wait_granted(std::unique_lock<std::mutex> &lock, Waiter &w)
+    {
+        cond_.wait(lock, [&w]
+                   { return w.granted; });
+    }
+
+    bool AdmissionControl::has_higher(Priority priority) const
+    {
+        for (std::list<Waiter *>::const_iterator it = waiters_.begin(); it != waiters_.end(); ++it)
+        {
+            if ((*it)->priority < priority)
+                return true;
+        }
+        return false;
+    }
+
+    int AdmissionControl::retry_after() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // 排在当前队列之后，约需等待的执行轮数 × 平均耗时
+        double seconds = (waiters_.size() + 1) * avg_ms_ / max_inflight_ / 1000;
+        int s = int(std::ceil(seconds));
+        return s < 1 ? 1 : (s > 60 ? 60 : s);
+    }
+
+    int AdmissionControl::inflight() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return inflight_;
+    }
+
+    int AdmissionControl::queued() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return int(waiters_.size());
+    }
+
+    uint64_t AdmissionControl::rejected() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return rejected_;
+    }
+
+    uint64_t AdmissionControl::expired() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return expired_;
+    }
+
+} // namespace PaddleOCR
@@ -0,0 +1,430 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#include "include/affinity.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <dirent.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace PaddleOCR
+{
+    // 按分隔符切分，去掉空条目
+    static std::vector<std::string> split(const std::string &text, char sep)
+    {
+        std::vector<std::string> out;
+        std::stringstream ss(text);
+        std::string item;
+        while (std::getline(ss, item, sep))
+        {
+            item.erase(0, item.find_first_not_of(" \t"));
+            item.erase(item.find_last_not_of(" \t") + 1);
+            if (!item.empty())
+            {
+                out.push_back(item);
+            }
+        }
+        return out;
+    }
+
+    // 解析 "node3" 形式的节点编号，不是该形式时返回-1
+    static int parse_node(const std::string &text)
+    {
+        if (text.size() <= 4 || text.compare(0, 4, "node") != 0 ||
+            text.find_first_not_of("0123456789", 4) != std::string::npos)
+        {
+            return -1;
+        }
+        return atoi(text.c_str() + 4);
+    }
+
+    static CpuAffinity::CpuSet intersect(const CpuAffinity::CpuSet &a, const CpuAffinity::CpuSet &b)
+    {
+        CpuAffinity::CpuSet out;
+        std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(out));
+        return out;
+    }
+
+    // 各NUMA节点的编号与CPU（已与进程可用的CPU取交集，去掉无CPU的节点）
+    static void read_nodes(std::vector<int> &ids, std::vector<CpuAffinity::CpuSet> &nodes)
+    {
+        const CpuAffinity::CpuSet &all = CpuAffinity::process_cpus();
+#ifdef _WIN32
+        ULONG highest = 0;
+        if (GetNumaHighestNodeNumber(&highest))
+        {
+            for (ULONG n = 0; n <= highest; n++)
+            {
+                ULONGLONG mask = 0;
+                if (!GetNumaNodeProcessorMask(UCHAR(n), &mask))
+                {
+                    continue;
+                }
+                CpuAffinity::CpuSet cpus;
+                for (int i = 0; i < 64; i++)
+                {
+                    if (mask & (ULONGLONG(1) << i))
+                    {
+                        cpus.push_back(i);
+                    }
+                }
+                cpus = intersect(cpus, all);
+                if (!cpus.empty())
+                {
+                    ids.push_back(int(n));
+                    nodes.push_back(cpus);
+                }
+            }
+        }
+#elif defined(__linux__)
+        const std::string root = "/sys/devices/system/node";
+        DIR *dir = opendir(root.c_str());
+        if (dir)
+        {
+            std::vector<int> found;
+            while (struct dirent *entry = readdir(dir))
+            {
+                int id = parse_node(entry->d_name);
+                if (id >= 0)
+                {
+                    found.push_back(id);
+                }
+            }
+            closedir(dir);
+            std::sort(found.begin(), found.end());
+            for (int id : found)
+            {
+                std::ifstream file(root + "/node" + std::to_string(id) + "/cpulist");
+                std::string line;
+                CpuAffinity::CpuSet cpus;
+                if (!std::getline(file, line) || !CpuAffinity::parse_list(line, cpus))
+                {
+                    continue;
+                }
+                cpus = intersect(cpus, all);
+                if (!cpus.empty())
+                {
+                    ids.push_back(id);
+                    nodes.push_back(cpus);
+                }
+            }
+        }
+#endif
+        if (nodes.empty() && !all.empty())
+        { // 无法获取拓扑时视为一个节点
+            ids.push_back(0);
+            nodes.push_back(all);
+        }
+    }
+
+    const CpuAffinity::CpuSet &CpuAffinity::process_cpus()
+    {
+        static const CpuSet cpus = []
+        {
+            CpuSet out;
+#ifdef _WIN32
+            DWORD_PTR process_mask = 0, system_mask = 0;
+            if (GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask))
+            {
+                for (int i = 0; i < int(sizeof(DWORD_PTR) * 8); i++)
+                {
+                    if (process_mask & (DWORD_PTR(1) << i))
+                    {
+                        out.push_back(i);
+                    }
+                }
+            }
+#elif defined(__linux__)
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            if (sched_getaffinity(0, sizeof(set), &set) == 0)
+            {
+                for (int i = 0; i < CPU_SETSIZE; i++)
+                {
+                    if (CPU_ISSET(i, &set))
+                    {
+                        out.push_back(i);
+                    }
+                }
+            }
+#endif
+            return out;
+        }();
+        return cpus;
+    }
+
+    std::vector<CpuAffinity::CpuSet> CpuAffinity::numa_nodes()
+    {
+        std::vector<int> ids;
+        std::vector<CpuSet> nodes;
+        read_nodes(ids, nodes);
+        return nodes;
+    }
+
+    bool CpuAffinity::valid(const std::string &spec)
+    {
+        if (spec.empty() || spec == "auto" || spec == "node")
+        {
+            return true;
+        }
+        std::vector<std::string> entries = split(spec, ';');
+        for (const auto &entry : entries)
+        {
+            CpuSet cpus;
+            if (parse_node(entry) < 0 && !parse_list(entry, cpus))
+            {
+                return false;
+            }
+        }
+        return !entries.empty();
+    }
+
+    std::vector<CpuAffinity::CpuSet> CpuAffinity::plan(const std::string &spec, int engines, int threads,
+                                                       std::string &error, std::string &warning)
+    {
+        error.clear();
+        warning.clear();
+        std::vector<CpuSet> out;
+        if (spec.empty() || engines < 1)
+        {
+            return out;
+        }
+        const CpuSet &all = process_cpus(); // 首次调用须在任何线程绑定之前
+        if (all.empty())
+        {
+            error = "cannot get the CPUs of this process";
+            return out;
+        }
+        std::vector<int> ids;
+        std::vector<CpuSet> nodes;
+        read_nodes(ids, nodes);
+
+        std::vector<CpuSet> sets; // 候选的CPU集合，引擎依次取用，不足时轮流复用
+        if (spec == "auto")
+        {
+            threads = std::max(1, threads);
+            // 在每个节点内切成 threads 个CPU一块，不跨节点
+            std::vector<std::vector<CpuSet>> chunks(nodes.size());
+            size_t rounds = 0;
+            for (size_t n = 0; n < nodes.size(); n++)
+            {
+                for (size_t k = 0; k + threads <= nodes[n].size(); k += threads)
+                {
+                    chunks[n].push_back(CpuSet(nodes[n].begin() + k, nodes[n].begin() + k + threads));
+                }
+                rounds = std::max(rounds, chunks[n].size());
+            }
+            // 各节点轮流分配，引擎较少时也能用上每个节点的内存带宽
+            for (size_t r = 0; r < rounds; r++)
+            {
+                for (size_t n = 0; n < nodes.size(); n++)
+                {
+                    if (r < chunks[n].size())
+                    {
+                        sets.push_back(chunks[n][r]);
+                    }
+                }
+            }
+            if (sets.empty())
+            { // 线程数超过单个节点的CPU数，只能跨节点
+                for (size_t k = 0; k < all.size(); k += threads)
+                {
+                    sets.push_back(CpuSet(all.begin() + k, all.begin() + std::min(all.size(), k + threads)));
+                }
+            }
+        }
+        else if (spec == "node")
+        {
+            sets = nodes;
+        }
+        else
+        {
+            for (const auto &entry : split(spec, ';'))
+            {
+                CpuSet cpus;
+                int node = parse_node(entry);
+                if (node >= 0)
+                {
+                    std::vector<int>::iterator it = std::find(ids.begin(), ids.end(), node);
+                    if (it == ids.end())
+                    {
+                        error = "NUMA " + entry + " not found or has no usable CPU";
+                        return out;
+                    }
+                    cpus = nodes[it - ids.begin()];
+                }
+                else if (!parse_list(entry, cpus))
+                {
+                    error = "invalid CPU list " + entry;
+                    return out;
+                }
+                if (intersect(cpus, all).size() != cpus.size())
+                {
+                    error = "CPUs " + entry + " are not all available to this process (" + describe(all) + ")";
+                    return out;
+                }
+                sets.push_back(cpus);
+            }
+        }
+        if (sets.empty())
+        {
+            error = "no CPU set for " + spec;
+            return out;
+        }
+        for (int i = 0; i < engines; i++)
+        {
+            out.push_back(sets[i % sets.size()]);
+        }
+        if (size_t(engines) > sets.size())
+        {
+            warning = std::to_string(engines) + " engines share " + std::to_string(sets.size()) +
+                      " CPU sets, some engines will compete for the same cores";
+        }
+        return out;
+    }
+
+    bool CpuAffinity::bind_thread(const CpuSet &cpus)
+    {
+        if (cpus.empty())
+        {
+            return false;
+        }
+#ifdef _WIN32
+        DWORD_PTR mask = 0;
+        for (int cpu : cpus)
+        {
+            if (cpu < int(sizeof(DWORD_PTR) * 8))
+            {
+                mask |= DWORD_PTR(1) << cpu;
+            }
+        }
+        return mask && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#elif defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus)
+        {
+            if (cpu < CPU_SETSIZE)
+            {
+                CPU_SET(cpu, &set);
+            }
+        }
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        return false;
+#endif
+    }
+
+#ifdef __linux__
+    // 推理库随附的 Intel OpenMP（libiomp5）与编译器的 OpenMP（gomp）是两个运行时，各有各的线程池，
+    // MKLDNN 的计算线程属于前者。libiomp5 兼容 GOMP 接口，经由它的 GOMP_parallel 发起并行区域，
+    // 才能进入 MKLDNN 实际使用的线程组。未加载 libiomp5（如推理库未使用MKL）时返回空
+    typedef void (*GompParallel)(void (*fn)(void *), void *data, unsigned num_threads, unsigned flags);
+    static GompParallel iomp_parallel()
+    {
+        static GompParallel parallel = []() -> GompParallel
+        {
+            void *handle = dlopen("libiomp5.so", RTLD_NOW | RTLD_NOLOAD);
+            return handle ? reinterpret_cast<GompParallel>(dlsym(handle, "GOMP_parallel")) : nullptr;
+        }();
+        return parallel;
+    }
+
+    static void bind_team_thread(void *cpus)
+    {
+        CpuAffinity::bind_thread(*static_cast<const CpuAffinity::CpuSet *>(cpus));
+    }
+#endif
+
+    void CpuAffinity::bind_openmp(const CpuSet &cpus, int threads)
+    {
+        if (threads <= 1)
+        {
+            return;
+        }
+#ifdef __linux__
+        GompParallel parallel = iomp_parallel();
+        if (parallel)
+        {
+            parallel(bind_team_thread, const_cast<CpuSet *>(&cpus), unsigned(threads), 0);
+        }
+#endif
+#ifdef _OPENMP
+        // 本程序自身的 OpenMP 代码（编译器的运行时）
+#pragma omp parallel num_threads(threads)
+        {
+            bind_thread(cpus);
+        }
+#endif
+    }
+
+    void CpuAffinity::unbind_thread()
+    {
+        bind_thread(process_cpus());
+    }
+
+    bool CpuAffinity::parse_list(const std::string &text, CpuSet &cpus)
+    {
+        cpus.clear();
+        for (const auto &item : split(text, ','))
+        {
+            size_t dash = item.find('-');
+            std::string first = item.substr(0, dash);
+            std::string last = dash == std::string::npos ? first : item.substr(dash + 1);
+            if (first.empty() || last.empty() ||
+                first.find_first_not_of("0123456789") != std::string::npos ||
+                last.find_first_not_of("0123456789") != std::string::npos)
+            {
+                return false;
+            }
+            int a = atoi(first.c_str()), b = atoi(last.c_str());
+            if (a > b || b > 4095)
+            {
+                return false;
+            }
+            for (int i = a; i <= b; i++)
+            {
+                cpus.push_back(i);
+            }
+        }
+        std::sort(cpus.begin(), cpus.end());
+        cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+        return !cpus.empty();
+    }
+
+    std::string CpuAffinity::describe(const CpuSet &cpus)
+    {
+        std::string out;
+        for (size_t i = 0; i < cpus.size();)
+        {
+            size_t j = i;
+            while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1)
+            {
+                j++;
+            }
+            out += (out.empty() ? "" : ",") + std::to_string(cpus[i]);
+            if (j > i)
+            {
+                out += "-" + std::to_string(cpus[j]);
+            }
+            i = j + 1;
+        }
+        return out;
+    }
+
+} // namespace PaddleOCR
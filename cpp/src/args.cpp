@@ -13,33 +13,89 @@
 // limitations under the License.
 
 #include <string>
+#include <algorithm>
+#include <sstream>
 #include <fstream>
 #include <include/utility.h>
+#include <include/tbpu.h>
+#include <include/predictor.h>
+#include <include/affinity.h>
+#include <include/rec_registry.h>
 
 #include <gflags/gflags.h>
 
 // 工作模式
 DEFINE_string(image_path, "", "Set image_path to run a single task.");                                                          // 若填写了图片路径，则执行一次OCR。
+DEFINE_string(video, "", "Set a video file, RTSP/HTTP stream URL or camera index to run video OCR.");                         // 若填写了视频源（视频文件、网络流地址或摄像头序号），则按帧识别并输出文字事件。需编译时开启 WITH_VIDEO
+DEFINE_string(batch, "", "Set an image directory or a file listing image paths (one per line) to run offline batch OCR.");          // 若填写了图片目录或文件列表（每行一个路径），则识别其中全部图片后退出，结果写入 batch_output
+DEFINE_string(batch_output, "", "NDJSON output of batch OCR (used with --batch), resumed from <batch_output>.ckpt if present.");   // 批量模式的输出文件，每张图片一行。检查点为同名 .ckpt 文件，存在时从中断处续跑
+DEFINE_int32(batch_workers, 1, "OCR engines working in parallel in batch mode.");                                               // 批量模式并行工作的引擎数，各引擎共享模型权重
+DEFINE_int32(batch_chunk, 16, "Images taken by a batch worker at a time, recognized through the multi-image pipeline.");       // 批量模式每个引擎每次领取的图片数，一次交给多图流水线
 DEFINE_int32(port, -1, "Set to 0 enable random port, set to 1~65535 enables specified port.");                                  // 填写0随机端口号，填1^65535指定端口号。默认则启用匿名管道模式。
 DEFINE_string(addr, "loopback", "Socket server addr, the value can be 'loopback', 'localhost', 'any', or other IPv4 address."); // 套接字服务器的地址模式，本地环回/任何可用。
+DEFINE_int32(max_request_mb, 64, "Max size of one pipe/socket request (binary frame payload or text line), in MB.");          // 管道与套接字模式中单个请求（二进制帧负载或一行文本）的大小上限，MB。超出时回复错误而不分配内存
 DEFINE_bool(server, false, "Enable HTTP server mode.");                                                                         // true时启用HTTP服务器模式
 DEFINE_int32(server_port, 8080, "HTTP server port (used with --server).");                                                     // HTTP服务器端口
+DEFINE_int32(server_jobs_max, 1000, "Max async jobs held by the HTTP server, pending or finished.");                                 // HTTP服务器异步任务（/api/jobs）同时保留的数量上限，含未完成与已完成未过期的任务
+DEFINE_int32(server_jobs_ttl, 300, "Seconds to keep finished async job results.");                                              // 异步任务完成后，结果保留的秒数
+DEFINE_int32(server_max_inflight, 0, "Max HTTP OCR requests running at once, 0 for server_engines.");                  // 同时执行的HTTP识别请求数上限，0为与 server_engines 相同
+DEFINE_int32(server_queue_max, 64, "Max queued HTTP OCR requests (weighted by cost), 503 when full.");                  // 排队等待的HTTP识别请求上限（按代价加权），超出时立即回复503与Retry-After。0为不排队
+DEFINE_int32(server_cost_pixels, 0, "Pixels per extra admission cost unit, 0 to count each request as 1.");             // 按图片大小加权准入：每N像素多计1个代价单位。0为每个请求计1
+DEFINE_int32(server_rec_max_lines, 1024, "Max pre-cropped text lines in one /api/rec request.");               // 一个 /api/rec 请求中单行文字图片的数量上限
+DEFINE_int32(trace_keep, 100, "Recent request traces kept for /api/traces/<trace id> (used with --server), 0 to disable.");     // 保留最近多少个请求的追踪（各阶段时间线），供 /api/traces 取回。0为不保留
+DEFINE_string(trace_dir, "", "Write each request trace as Chrome trace JSON into this directory (used with --server).");         // 每个请求的追踪另存为 <trace id>.json（Chrome trace 格式，可在 Perfetto 中打开）。为空时不保存
+DEFINE_string(engine_affinity, "", "Pin engines to CPUs: auto, node, or per-engine lists like 0-7;8-15 or node0;node1.");    // 引擎的CPU绑定，为空时不绑定。auto为每个引擎 cpu_threads 个核（不跨NUMA节点）；node为每个引擎一个NUMA节点；或以分号分隔各引擎的CPU列表
+DEFINE_int32(server_engines, 1, "Number of OCR engines serving HTTP requests in parallel (used with --server).");                // HTTP服务器的引擎池大小，各引擎共享模型权重。建议 server_engines*cpu_threads 不超过CPU核数
+DEFINE_int32(supervisor, 0, "Run K isolated OCR worker processes behind the HTTP listener (used with --server), 0 to disable."); // 多进程隔离：HTTP监听进程不加载模型，另起K个工作进程识别，工作进程崩溃或超时时单独重启。0为关闭。仅Linux
+DEFINE_int32(supervisor_timeout_ms, 60000, "Restart a worker process that does not reply within this time.");                   // 工作进程处理一个请求的时限，超时时回复504并重启该工作进程；也是请求排队等待工作进程的时限
+DEFINE_int32(supervisor_retries, 1, "Times to retry a request on another worker after its worker crashed.");                     // 工作进程崩溃时，把请求交给另一个工作进程重试的次数。总是使其崩溃的图片在重试后回复502
+DEFINE_string(router, "", "Run as a load-aware router in front of these servers: host:port;host:port.");                      // 集群路由：本进程不加载模型，把请求转发给列出的 --server 实例中负载最低、能识别所需语言的一个，批量请求拆分到多个实例
+DEFINE_int32(router_poll_ms, 500, "Interval of polling the backends' /api/health (used with --router).");                     // 路由读取各后端负载与语言的间隔，毫秒
+DEFINE_int32(router_timeout_ms, 120000, "Timeout of a request forwarded to a backend (used with --router).");                 // 转发给后端的请求的时限，毫秒
 
 // common args 常用参数
 DEFINE_bool(use_gpu, false, "Infering with GPU or CPU.");                                              // true时启用GPU（需要推理库支持）
 DEFINE_bool(use_tensorrt, false, "Whether use tensorrt.");                                             // true时启用tensorrt
 DEFINE_int32(gpu_id, 0, "Device id of GPU to execute.");                                               // GPU id，使用GPU时有效
 DEFINE_int32(gpu_mem, 4000, "GPU memory when infering with GPU.");                                     // 申请的GPU内存
+DEFINE_bool(gpu_preprocess, false, "Run det resize/normalize and DB thresholding on GPU (needs WITH_CUDA_PREPROCESS)."); // det的缩放、归一化与概率图二值化在GPU上执行，只下载8位二值图与概率图。需启用use_gpu，且以WITH_CUDA_PREPROCESS编译
+DEFINE_bool(gpu_pipeline, false, "Overlap CPU pre-processing with GPU inference, pinned buffers and a CUDA stream per predictor."); // GPU流水线：rec/cls下一批的预处理与当前批的推理重叠，并使用锁页内存与各推理实例独立的CUDA流。需启用use_gpu
 DEFINE_int32(cpu_threads, 10, "Num of threads with CPU.");                                             // CPU线程
-DEFINE_int32(cpu_mem, 2000, "CPU memory limit in MB. Cleanup if exceeded. -1 means no limit.");        // CPU内存占用上限，单位MB。-1表示不限制
+DEFINE_int32(cpu_mem, 2000, "CPU memory limit in MB. Cleanup if exceeded. -1 means no limit.");        // CPU内存占用上限（高水位），单位MB。超过时由后台线程清理空闲引擎。-1表示不限制
+DEFINE_int32(cpu_mem_low, 0, "Stop memory cleanup below this many MB. 0 for 80% of cpu_mem.");         // 内存清理的低水位，单位MB，降到以下时停止清理。0为cpu_mem的80%
+DEFINE_int32(memory_poll_ms, 1000, "Interval of the background memory check in milliseconds.");       // 后台检查内存占用的间隔，单位毫秒
+DEFINE_int32(max_image_pixels, 0, "Reject images with more pixels than this. 0 for no limit.");        // 准入控制：拒绝像素数（宽×高）超过该值的图片，避免个别超大图片撑大内存。0为不限制
+DEFINE_bool(incremental_ocr, false, "Re-run det/rec only on regions changed since the previous image.");             // 增量OCR。保留上一张图片及其结果，新图片尺寸相同时只对变化区域重新检测与识别，适合连续截图
+DEFINE_int32(result_cache_mb, 0, "Result cache size limit in MB. 0 to disable.");                        // 识别结果缓存上限，单位MB。相同图片与选项再次请求时直接返回缓存结果。0为关闭
+DEFINE_string(optim_cache_dir, "", "Cache optimized models (and TensorRT engines) here to speed up startup."); // 模型优化缓存目录。首次启动时保存图优化后的模型，之后直接加载，缩短启动时间。为空时不缓存
 DEFINE_bool(enable_mkldnn, true, "Whether use mkldnn with CPU.");                                      // true时启用mkldnn
 DEFINE_string(precision, "fp32", "Precision be one of fp32/fp16/int8");                                // 预测的精度，支持fp32, fp16, int8 3种输入
+DEFINE_string(det_precision, "", "Precision of det, empty for the same as precision.");                // det的精度，为空时同 precision。另支持 bf16（仅CPU）
+DEFINE_string(cls_precision, "", "Precision of cls, empty for the same as precision.");                // cls的精度，同上
+DEFINE_string(rec_precision, "", "Precision of rec, empty for the same as precision.");                // rec的精度，同上。CPU下 int8 须配合量化模型，bf16/int8 均需启用mkldnn
+DEFINE_string(det_backend, "paddle", "Inference backend of det: paddle, onnxruntime or openvino.");     // det的推理后端。onnxruntime/openvino 需编译时开启 WITH_ONNXRUNTIME/WITH_OPENVINO，模型目录中须有对应格式的模型
+DEFINE_string(cls_backend, "paddle", "Inference backend of cls.");                                     // cls的推理后端，同上
+DEFINE_string(rec_backend, "paddle", "Inference backend of rec.");                                     // rec的推理后端，同上
+DEFINE_string(layout_backend, "paddle", "Inference backend of layout.");                               // 版面分析的推理后端，同上
+DEFINE_string(table_backend, "paddle", "Inference backend of table.");                                 // 表格识别的推理后端，同上
 DEFINE_bool(benchmark, false, "Whether use benchmark.");                                               // true时开启benchmark，对预测速度、显存占用等进行统计
 DEFINE_string(output, "./output/", "Save benchmark log path.");                                        // 可视化结果保存的路径 TODO
-DEFINE_string(type, "ocr", "Perform ocr or structure, the value is selected in ['ocr','structure']."); // 任务类型（暂不可用）
+DEFINE_string(type, "ocr", "Perform ocr or structure, the value is selected in ['ocr','structure']."); // 任务类型，structure 为版面与表格识别
 DEFINE_string(config_path, "", "Path of config file.");                                                // 配置文件路径
 DEFINE_string(models_path, "", "Path of models folder.");                                              // 预测库路径
 DEFINE_bool(ensure_ascii, true, "Enable JSON ascii escape.");                                          // true时json开启ascii转义
+DEFINE_string(log_level, "info", "Log level: debug, info, warn or error.");                            // 日志级别。日志由后台线程异步写到stderr，不阻塞识别
+DEFINE_int32(log_sample, 1, "Log 1 of every N per-request log lines.");                                // 每个请求一条的高频日志（如HTTP请求记录），每N条记录一条
+DEFINE_bool(warmup, false, "Warm up the models with synthetic inputs at startup.");                 // true时在启动时以合成输入预热各模型（覆盖检测尺寸与识别宽度分桶），首批请求不再慢
+DEFINE_bool(calibrate, false, "Collect TensorRT shape range files (trt_*_shape.txt) and exit.");       // 重新采集TensorRT动态形状文件后退出，需同时启用use_gpu与use_tensorrt
+DEFINE_int32(pipeline_queue, 2, "Queue size between det/cls/rec stages for multi-image OCR, 0 to disable."); // 多图OCR时各阶段流水线的队列容量，0为关闭流水线
+DEFINE_int32(decode_reduce, 1, "Max JPEG decode-time downscale (1, 2, 4 or 8) within det limit_side_len, 1 to disable."); // JPEG按检测尺寸缩小解码的最大倍数（1/2/4/8），1为关闭。只在缩小后长边仍不小于 limit_side_len 时缩小，检测输入不变；但识别用的碎图也来自缩小后的图片，小字可能降低识别率
+DEFINE_int32(pdf_dpi, 0, "PDF render DPI, 0 to match limit_side_len (within 150-300).");                  // PDF光栅化的DPI，0为按 limit_side_len 自动选取（限制在150~300）。需编译时开启 WITH_PDFIUM
+DEFINE_int32(doc_threads, 2, "Threads rasterizing the following pages of a PDF/TIFF while OCR runs.");      // 多页PDF/TIFF的光栅化线程数，在识别当前页时提前光栅化后续页面
+DEFINE_int32(doc_max_pages, 1000, "Max pages of a PDF/TIFF document.");                                    // 多页文档的页数上限，超过时拒绝整个文档
+DEFINE_double(video_fps, 2, "Frames per second sampled from the video, 0 for every frame.");             // 视频每秒抽取识别的帧数，0为每帧都识别
+DEFINE_int32(video_hash_dist, 0, "Skip sampled frames whose perceptual hash differs by at most this many bits, -1 to disable."); // 抽取的帧与上一识别帧的感知哈希（256位）相差不超过该位数时跳过。越大跳过越多，但可能漏掉小范围的文字变化。-1为不跳过
+DEFINE_int32(video_hold, 1, "Consecutive sampled frames a text must be missing before it is reported gone.");          // 文字连续缺失多少个识别帧后才报告消失，容忍个别帧的检测抖动
 
 // detection related DET检测相关
 DEFINE_string(det_model_dir, "models/ch_PP-OCRv4_det_infer", "Path of det inference model.");                     // det模型库路径
@@ -50,6 +106,16 @@ DEFINE_double(det_db_box_thresh, 0.6, "Threshold of det_db_box_thresh.");
 DEFINE_double(det_db_unclip_ratio, 1.5, "Threshold of det_db_unclip_ratio.");                                     // 表示文本框的紧致程度，越小则文本框更靠近文本
 DEFINE_bool(use_dilation, false, "Whether use the dilation on output map.");                                      // true时对分割结果进行膨胀以获取更优检测效果
 DEFINE_string(det_db_score_mode, "slow", "Whether use polygon score, the value is selected in ['slow','fast']."); // slow:使用多边形框计算bbox score，fast:使用矩形框计算。矩形框计算速度更快，多边形框对弯曲文本区域计算更准确
+DEFINE_int32(det_tile_size, 0, "Tile side length of tiled det for large images. 0 to disable.");                            // 分块检测的块边长（建议为32的倍数）。长边超过此值的图片按原分辨率切成重叠的块逐块检测，避免缩小后丢失小字。0为关闭
+DEFINE_int32(det_tile_overlap, 128, "Overlap between adjacent det tiles.");                                         // 分块检测中相邻块的重叠宽度，应大于一行文字的高度，以便合并接缝处被切断的文本框
+DEFINE_bool(det_adaptive, false, "Pick det resolution from the text size found by a low-res pass.");                // 自适应检测分辨率：先做一次低分辨率预检，按检出文字的高度决定接受结果，还是以所需分辨率重新检测。开启后 limit_type、limit_side_len 不再生效（请求中指定它们时除外）
+DEFINE_int32(det_adaptive_side, 640, "Long side of the low-res det pass in adaptive mode.");                       // 自适应检测的预检长边
+DEFINE_int32(det_adaptive_text_px, 16, "Target text height in det input pixels for adaptive mode.");               // 自适应检测中，检测输入里文字高度的目标下限（像素）。预检到的字低于它时提高分辨率重新检测
+DEFINE_int32(det_adaptive_max_side, 4096, "Max long side of the adaptive det re-run.");                            // 自适应检测重新检测时的长边上限，也不会超过原图
+DEFINE_bool(det_adaptive_roi, false, "Re-run adaptive det only on the text regions found by the low-res pass.");   // 自适应检测重新检测时只检测预检到的文本区域（文字稀疏时更快，但预检完全漏掉的小字不会再检出）
+DEFINE_int32(det_postprocess_threads, 1, "Threads for scoring det candidate boxes.");                                // 检测后处理中，并行为候选框打分的线程数。文字密集的图片可适当调大
+DEFINE_bool(text_group, false, "Output line and paragraph index of each text box.");                              // true时为每个文本框输出阅读顺序中的行号 line 与段落号 para，从0开始
+DEFINE_string(tbpu_parser, "", "Default layout parser of OCR results, empty to disable.");                           // 默认的排版解析方案：none, multi_para, multi_line, multi_none, single_para, single_line, single_none, single_code。为空时不做解析，可被请求中的 parser 覆盖
 DEFINE_bool(visualize, false, "Whether show the detection results.");                                             // true时启用结果进行可视化，预测结果保存在output字段指定的文件夹下和输入图像同名的图像上。
 
 // classification related CLS方向分类相关
@@ -57,13 +123,22 @@ DEFINE_bool(use_angle_cls, false, "Whether use use_angle_cls."); // true时启
 DEFINE_string(cls_model_dir, "models/ch_ppocr_mobile_v2.0_cls_infer", "Path of cls inference model.");
 DEFINE_double(cls_thresh, 0.9, "Threshold of cls_thresh."); // 方向分类器的得分阈值
 DEFINE_int32(cls_batch_num, 1, "cls_batch_num.");           // 方向分类器batchsize
+DEFINE_int32(cls_sample, 0, "Adaptive cls: classify this many long crops per page and skip the rest when they agree, 0 to classify all."); // 自适应方向分类：每页只抽样分类这么多个横排长条文本，结果一致时其余的沿用该方向。短小或近方形的文本仍逐个分类。0为全部分类
+DEFINE_double(cls_recheck_score, 0.5, "Adaptive cls: re-recognize skipped crops rotated by 180 degrees when rec score is below this."); // 自适应方向分类：沿用方向的文本识别置信度低于该值时，旋转180°再识别一次，取置信度高者
+DEFINE_bool(page_orient, false, "Detect whole-page rotation (0/90/180/270) before det, requires use_angle_cls."); // true时在检测前判断整页方向：按文本框横竖与抽样碎图的方向分类投票，将整页转正一次再检测与识别，输出的文本框仍为原图坐标。需启用use_angle_cls
 
 // recognition related REC文本识别相关
 DEFINE_string(rec_model_dir, "models/ch_PP-OCRv4_rec_infer", "Path of rec inference model.");
 DEFINE_int32(rec_batch_num, 6, "rec_batch_num.");                                    // 文字识别模型batchsize
-DEFINE_string(rec_char_dict_path, "models/dict_chinese.txt", "Path of dictionary."); // 字典路径
+DEFINE_string(rec_char_dict_path, "models/dict_chinese.txt", "Path of dictionary."); // 字典路径。以 .bin 结尾时为编译好的二进制字典，直接映射
 DEFINE_int32(rec_img_h, 48, "rec image height");                                     // 文字识别模型输入图像高度。V3模型是48，V2应该改为32
 DEFINE_int32(rec_img_w, 320, "rec image width");                                     // 文字识别模型输入图像宽度。V3和V2一致
+DEFINE_int32(rec_batch_window_ms, 0, "Cross-request rec batching window in ms, 0 to disable."); // HTTP引擎池中，合并多个请求的文本碎图进行识别的等待窗口。0为关闭
+DEFINE_int32(rec_batch_window_max, 64, "Max crops merged in one rec batching window.");          // 合并碎图数达到该值时立即识别，不再等待窗口结束
+DEFINE_string(rec_width_buckets, "", "Comma separated rec input widths, e.g. 320,640,960,1280. Empty to disable."); // 文字识别输入宽度分桶。非空时碎图按宽度归入桶，同桶组批并填充到桶宽度，减少填充浪费与输入形状种类
+DEFINE_int32(rec_decode_threads, 1, "Threads for rec CTC decoding within a batch.");            // 文字识别后处理（CTC解码）在一个批次内的并行线程数
+DEFINE_string(rec_languages, "", "Extra rec languages selectable per request: auto, or a list like en;japan or en=path/config_en.txt."); // 可按请求（lang）选用的其它语言识别模型。auto为模型库中全部 config_xxx.txt；或以分号分隔语言名，对应 config_<语言>.txt，也可写作 语言=配置文件路径。首次使用时才加载
+DEFINE_int32(rec_memory_mb, 0, "Memory budget in MB for rec_languages models, LRU unloaded when exceeded. 0 for no limit."); // rec_languages 各模型的内存预算（按权重文件大小计），单位MB。超出时卸载最久未用的语言，0为不限
 
 // layout model related 版面分析相关
 DEFINE_string(layout_model_dir, "", "Path of table layout inference model.");
@@ -164,6 +239,29 @@ std::string read_config()
     return msg;
 }
 
+// 各阶段的精度：det_precision 等为空时取 precision
+std::string stage_precision(const std::string &precision)
+{
+    return precision.empty() ? FLAGS_precision : precision;
+}
+
+// 识别宽度分桶，由 rec_width_buckets 解析，升序
+std::vector<int> rec_width_buckets()
+{
+    // 解析宽度分桶，如 "320,640,960,1280"
+    std::vector<int> width_buckets;
+    std::stringstream ss(FLAGS_rec_width_buckets);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        int width = atoi(item.c_str());
+        if (width > 0)
+            width_buckets.push_back(width);
+    }
+    std::sort(width_buckets.begin(), width_buckets.end());
+    return width_buckets;
+}
+
 // 检测参数合法性。成功返回空字符串，失败返回报错信息字符串。
 std::string check_flags()
 {
@@ -178,6 +276,26 @@ std::string check_flags()
     }
 
     std::string msg = "";
+    if (!FLAGS_router.empty())
+    { // 路由模式不加载模型，只检查路由参数
+        std::stringstream ss(FLAGS_router);
+        std::string item;
+        int count = 0;
+        while (std::getline(ss, item, ';'))
+        {
+            size_t colon = item.rfind(':');
+            if (item.empty())
+                continue;
+            if (colon == std::string::npos || colon == 0 || atoi(item.c_str() + colon + 1) <= 0)
+                msg += "router backend should be host:port, not " + item + ". ";
+            count++;
+        }
+        if (count == 0)
+            msg += "router should list at least one backend. ";
+        if (FLAGS_router_poll_ms < 10 || FLAGS_router_timeout_ms < 1)
+            msg += "router_poll_ms should be >= 10, router_timeout_ms >= 1. ";
+        return msg;
+    }
     if (FLAGS_det)
     { // 检查det
         prepend_models(models_path_base, FLAGS_det_model_dir);
@@ -188,7 +306,7 @@ std::string check_flags()
         prepend_models(models_path_base, FLAGS_rec_model_dir);
         check_path(FLAGS_rec_model_dir, "rec_model_dir", msg);
     }
-    if (FLAGS_cls && FLAGS_use_angle_cls)
+    if ((FLAGS_cls || FLAGS_page_orient) && FLAGS_use_angle_cls)
     { // 检查cls
         prepend_models(models_path_base, FLAGS_cls_model_dir);
         check_path(FLAGS_cls_model_dir, "cls_model_dir", msg);
@@ -198,6 +316,13 @@ std::string check_flags()
         prepend_models(models_path_base, FLAGS_rec_char_dict_path);
         check_path(FLAGS_rec_char_dict_path, "rec_char_dict_path", msg);
     }
+    if (!FLAGS_rec_languages.empty())
+    { // 登记其它语言的识别模型（只读取配置，不加载）
+        if (FLAGS_rec_memory_mb < 0)
+            msg += "rec_memory_mb should be >= 0. ";
+        msg += PaddleOCR::RecRegistry::get().configure(FLAGS_rec_languages, models_path_base,
+                                                       size_t(std::max(0, FLAGS_rec_memory_mb)) << 20);
+    }
     if (FLAGS_table)
     { // 检查table
         prepend_models(models_path_base, FLAGS_table_model_dir);
@@ -221,10 +346,59 @@ std::string check_flags()
     {
         msg += "precison should be 'fp32'(default), 'fp16' or 'int8', not " + FLAGS_precision + ". ";
     }
+    const std::string *stage_flags[] = {&FLAGS_det_precision, &FLAGS_cls_precision, &FLAGS_rec_precision};
+    const char *stage_names[] = {"det_precision", "cls_precision", "rec_precision"};
+    for (int i = 0; i < 3; i++)
+    {
+        const std::string &p = *stage_flags[i];
+        if (!p.empty() && p != "fp32" && p != "fp16" && p != "bf16" && p != "int8")
+        {
+            msg += std::string(stage_names[i]) + " should be empty, 'fp32', 'fp16', 'bf16' or 'int8', not " + p + ". ";
+        }
+        else if (p == "bf16" && FLAGS_use_gpu)
+        {
+            msg += std::string(stage_names[i]) + " bf16 is only supported on CPU. ";
+        }
+    }
+    if (!FLAGS_use_gpu && !FLAGS_enable_mkldnn)
+    { // CPU下 bf16/int8 由mkldnn实现
+        const std::string *all[] = {&FLAGS_precision, &FLAGS_det_precision, &FLAGS_cls_precision, &FLAGS_rec_precision};
+        for (int i = 0; i < 4; i++)
+        {
+            if (*all[i] == "bf16" || *all[i] == "int8")
+            {
+                msg += "bf16 and int8 on CPU require enable_mkldnn. ";
+                break;
+            }
+        }
+    }
+    const std::string *backend_flags[] = {&FLAGS_det_backend, &FLAGS_cls_backend, &FLAGS_rec_backend,
+                                          &FLAGS_layout_backend, &FLAGS_table_backend};
+    const char *backend_names[] = {"det_backend", "cls_backend", "rec_backend", "layout_backend", "table_backend"};
+    for (int i = 0; i < 5; i++)
+    {
+        if (!PaddleOCR::Predictor::Available(*backend_flags[i]))
+        {
+            msg += std::string(backend_names[i]) + " should be one of " + PaddleOCR::Predictor::Backends() +
+                   ", not " + *backend_flags[i] + ". ";
+        }
+    }
+    if (!PaddleOCR::CpuAffinity::valid(FLAGS_engine_affinity))
+    {
+        msg += "engine_affinity should be empty, 'auto', 'node' or CPU lists like '0-7;8-15' or 'node0;node1', not " + FLAGS_engine_affinity + ". ";
+    }
+    if (FLAGS_gpu_preprocess && FLAGS_det_backend != "paddle")
+    { // GPU前后处理直接把设备内存交给推理库
+        msg += "gpu_preprocess requires det_backend=paddle. ";
+    }
     if (FLAGS_type != "ocr" && FLAGS_type != "structure")
     {
         msg += "type should be 'ocr'(default) or 'structure', not " + FLAGS_type + ". ";
     }
+    if (FLAGS_type == "structure" && !FLAGS_layout && !FLAGS_table)
+    {
+        msg += "type=structure requires layout or table. ";
+    }
     if (FLAGS_limit_type != "max" && FLAGS_limit_type != "min")
     {
         msg += "limit_type should be 'max'(default) or 'min', not " + FLAGS_limit_type + ". ";
@@ -233,5 +407,128 @@ std::string check_flags()
     {
         msg += "limit_type should be 'slow'(default) or 'fast', not " + FLAGS_det_db_score_mode + ". ";
     }
+    if (FLAGS_log_level != "debug" && FLAGS_log_level != "info" && FLAGS_log_level != "warn" && FLAGS_log_level != "error")
+    {
+        msg += "log_level should be 'debug', 'info'(default), 'warn' or 'error', not " + FLAGS_log_level + ". ";
+    }
+    if (FLAGS_server_max_inflight < 0 || FLAGS_server_queue_max < 0 || FLAGS_server_cost_pixels < 0)
+    {
+        msg += "server_max_inflight, server_queue_max and server_cost_pixels should be >= 0. ";
+    }
+    if (FLAGS_supervisor < 0 || FLAGS_supervisor_timeout_ms < 1 || FLAGS_supervisor_retries < 0)
+    {
+        msg += "supervisor and supervisor_retries should be >= 0, supervisor_timeout_ms >= 1. ";
+    }
+#ifdef _WIN32
+    if (FLAGS_supervisor > 0)
+    {
+        msg += "supervisor is only available on Linux. ";
+    }
+#endif
+    if (FLAGS_max_request_mb < 1 || FLAGS_max_request_mb > 4095)
+    {
+        msg += "max_request_mb should be in [1, 4095]. ";
+    }
+    if (FLAGS_server_rec_max_lines < 1)
+    {
+        msg += "server_rec_max_lines should be >= 1. ";
+    }
+    if (FLAGS_trace_keep < 0)
+    {
+        msg += "trace_keep should be >= 0. ";
+    }
+    if (!FLAGS_trace_dir.empty())
+    {
+        check_path(FLAGS_trace_dir, "trace_dir", msg);
+    }
+    if (FLAGS_cpu_mem > 0 && FLAGS_cpu_mem_low >= FLAGS_cpu_mem)
+    {
+        msg += "cpu_mem_low should be less than cpu_mem. ";
+    }
+    if (FLAGS_memory_poll_ms < 10)
+    {
+        msg += "memory_poll_ms should be >= 10. ";
+    }
+    if (FLAGS_calibrate && !(FLAGS_use_gpu && FLAGS_use_tensorrt))
+    {
+        msg += "calibrate requires use_gpu and use_tensorrt. ";
+    }
+    if (FLAGS_gpu_pipeline && !FLAGS_use_gpu)
+    {
+        msg += "gpu_pipeline requires use_gpu. ";
+    }
+    if (FLAGS_gpu_preprocess && !FLAGS_use_gpu)
+    {
+        msg += "gpu_preprocess requires use_gpu. ";
+    }
+#ifndef PPOCR_CUDA_PREPROCESS
+    if (FLAGS_gpu_preprocess)
+    {
+        msg += "gpu_preprocess is not available, rebuild with -DWITH_CUDA_PREPROCESS=ON. ";
+    }
+#endif
+    if (FLAGS_page_orient && !(FLAGS_use_angle_cls && FLAGS_det))
+    {
+        msg += "page_orient requires use_angle_cls and det. ";
+    }
+    if (FLAGS_decode_reduce != 1 && FLAGS_decode_reduce != 2 && FLAGS_decode_reduce != 4 && FLAGS_decode_reduce != 8)
+    {
+        msg += "decode_reduce should be 1, 2, 4 or 8, not " + std::to_string(FLAGS_decode_reduce) + ". ";
+    }
+    if (FLAGS_pdf_dpi < 0 || FLAGS_doc_threads < 1 || FLAGS_doc_max_pages < 1)
+    {
+        msg += "pdf_dpi should be >= 0, doc_threads and doc_max_pages should be >= 1. ";
+    }
+    if (!FLAGS_batch.empty())
+    {
+        check_path(FLAGS_batch, "batch", msg);
+        if (FLAGS_batch_output.empty())
+        {
+            msg += "batch requires batch_output. ";
+        }
+        if (FLAGS_batch_workers < 1 || FLAGS_batch_chunk < 1)
+        {
+            msg += "batch_workers and batch_chunk should be >= 1. ";
+        }
+    }
+    if (!FLAGS_video.empty())
+    {
+#ifndef PPOCR_WITH_VIDEO
+        msg += "video is not available, rebuild with -DWITH_VIDEO=ON. ";
+#endif
+        if (!FLAGS_det)
+        {
+            msg += "video requires det. ";
+        }
+        if (FLAGS_video_fps < 0 || FLAGS_video_hash_dist < -1 || FLAGS_video_hash_dist > 256 || FLAGS_video_hold < 1)
+        {
+            msg += "video_fps should be >= 0, video_hash_dist within -1~256, video_hold >= 1. ";
+        }
+    }
+    if (FLAGS_cls_sample < 0)
+    {
+        msg += "cls_sample should be >= 0, not " + std::to_string(FLAGS_cls_sample) + ". ";
+    }
+    if (!FLAGS_tbpu_parser.empty() && !PaddleOCR::Tbpu::valid(FLAGS_tbpu_parser))
+    {
+        msg += "tbpu_parser should be one of none, multi_para, multi_line, multi_none, "
+               "single_para, single_line, single_none, single_code, not " + FLAGS_tbpu_parser + ". ";
+    }
+    if (FLAGS_det_tile_size > 0 && (FLAGS_det_tile_overlap < 0 || FLAGS_det_tile_overlap >= FLAGS_det_tile_size))
+    {
+        msg += "det_tile_overlap should be in [0, det_tile_size), not " + std::to_string(FLAGS_det_tile_overlap) + ". ";
+    }
+    if (FLAGS_det_adaptive_side < 32)
+    {
+        msg += "det_adaptive_side should be at least 32, not " + std::to_string(FLAGS_det_adaptive_side) + ". ";
+    }
+    if (FLAGS_det_adaptive_text_px < 4 || FLAGS_det_adaptive_text_px > 128)
+    {
+        msg += "det_adaptive_text_px should be in [4, 128], not " + std::to_string(FLAGS_det_adaptive_text_px) + ". ";
+    }
+    if (FLAGS_det_adaptive_max_side < FLAGS_det_adaptive_side)
+    {
+        msg += "det_adaptive_max_side should be at least det_adaptive_side, not " + std::to_string(FLAGS_det_adaptive_max_side) + ". ";
+    }
     return msg;
 }
\ No newline at end of file
@@ -240,6 +240,45 @@ static std::string decode(String const& encoded_string, bool remove_linebreaks)
     return ret;
 }
 
+//
+// PaddleOCR-json: buffer-to-buffer decoder (not part of the original library).
+//
+size_t base64_decoded_size(char const* in, size_t len) {
+    while (len > 0 && (in[len - 1] == '=' || in[len - 1] == '.')) len--;
+
+    return len / 4 * 3 + (len % 4 == 3 ? 2 : (len % 4 == 2 ? 1 : 0));
+}
+
+size_t base64_decode_into(char const* in, size_t len, unsigned char* out) {
+    while (len > 0 && (in[len - 1] == '=' || in[len - 1] == '.')) len--;
+
+    if (len % 4 == 1) {
+        throw std::runtime_error("Input is not valid base64-encoded data.");
+    }
+
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(in);
+    unsigned char* o = out;
+    size_t full = len / 4 * 4;
+
+    for (size_t pos = 0; pos < full; pos += 4) {
+        unsigned int n = (pos_of_char(p[pos    ]) << 18) | (pos_of_char(p[pos + 1]) << 12)
+                       | (pos_of_char(p[pos + 2]) <<  6) |  pos_of_char(p[pos + 3]);
+        *o++ = static_cast<unsigned char>(n >> 16);
+        *o++ = static_cast<unsigned char>(n >>  8);
+        *o++ = static_cast<unsigned char>(n      );
+    }
+
+    size_t rest = len - full;
+    if (rest >= 2) {
+        unsigned int n = (pos_of_char(p[full]) << 18) | (pos_of_char(p[full + 1]) << 12);
+        if (rest == 3) n |= pos_of_char(p[full + 2]) << 6;
+        *o++ = static_cast<unsigned char>(n >> 16);
+        if (rest == 3) *o++ = static_cast<unsigned char>(n >> 8);
+    }
+
+    return static_cast<size_t>(o - out);
+}
+
 std::string base64_decode(std::string const& s, bool remove_linebreaks) {
    return decode(s, remove_linebreaks);
 }
@@ -0,0 +1,73 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#include "include/det_cuda_kernels.h"
+
+#include <cuda_runtime.h>
+
+namespace PaddleOCR
+{
+    namespace cuda
+    {
+        // 每个线程计算一个输出像素的三个通道。坐标映射与 cv::resize(INTER_LINEAR) 相同（像素中心对齐）
+        __global__ void ResizeNormalizeKernel(const unsigned char *src, int src_h, int src_w, int src_step,
+                                              float *dst, int dst_h, int dst_w, NormCoef coef)
+        {
+            int x = blockIdx.x * blockDim.x + threadIdx.x;
+            int y = blockIdx.y * blockDim.y + threadIdx.y;
+            if (x >= dst_w || y >= dst_h)
+                return;
+            float fx = (x + 0.5f) * (float(src_w) / dst_w) - 0.5f;
+            float fy = (y + 0.5f) * (float(src_h) / dst_h) - 0.5f;
+            fx = fmaxf(fx, 0.f);
+            fy = fmaxf(fy, 0.f);
+            int x0 = min(int(fx), src_w - 1);
+            int y0 = min(int(fy), src_h - 1);
+            int x1 = min(x0 + 1, src_w - 1);
+            int y1 = min(y0 + 1, src_h - 1);
+            float wx = fx - x0;
+            float wy = fy - y0;
+            const unsigned char *r0 = src + size_t(y0) * src_step;
+            const unsigned char *r1 = src + size_t(y1) * src_step;
+            size_t plane = size_t(dst_h) * dst_w;
+            size_t offset = size_t(y) * dst_w + x;
+            for (int c = 0; c < 3; c++)
+            {
+                float top = r0[x0 * 3 + c] * (1.f - wx) + r0[x1 * 3 + c] * wx;
+                float bottom = r1[x0 * 3 + c] * (1.f - wx) + r1[x1 * 3 + c] * wx;
+                float v = fminf(fmaxf(rintf(top * (1.f - wy) + bottom * wy), 0.f), 255.f);
+                dst[c * plane + offset] = v * coef.a[c] + coef.b[c];
+            }
+        }
+
+        __global__ void ThresholdKernel(const float *prob, int n, float thresh_q,
+                                        unsigned char *bitmap, unsigned char *score)
+        {
+            int i = blockIdx.x * blockDim.x + threadIdx.x;
+            if (i >= n)
+                return;
+            float p = fminf(fmaxf(prob[i], 0.f), 1.f);
+            bitmap[i] = float((unsigned char)(p * 255)) > thresh_q ? 255 : 0;
+            score[i] = (unsigned char)(p * 255 + 0.5f);
+        }
+
+        int LaunchResizeNormalize(const unsigned char *src, int src_h, int src_w, int src_step,
+                                  float *dst, int dst_h, int dst_w, NormCoef coef, void *stream)
+        {
+            dim3 block(32, 8);
+            dim3 grid((dst_w + block.x - 1) / block.x, (dst_h + block.y - 1) / block.y);
+            ResizeNormalizeKernel<<<grid, block, 0, static_cast<cudaStream_t>(stream)>>>(
+                src, src_h, src_w, src_step, dst, dst_h, dst_w, coef);
+            return int(cudaGetLastError());
+        }
+
+        int LaunchThreshold(const float *prob, int n, float thresh_q,
+                            unsigned char *bitmap, unsigned char *score, void *stream)
+        {
+            int block = 256;
+            int grid = (n + block - 1) / block;
+            ThresholdKernel<<<grid, block, 0, static_cast<cudaStream_t>(stream)>>>(prob, n, thresh_q, bitmap, score);
+            return int(cudaGetLastError());
+        }
+    } // namespace cuda
+} // namespace PaddleOCR
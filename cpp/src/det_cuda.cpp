@@ -0,0 +1,126 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#include "include/det_cuda.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#ifdef PPOCR_CUDA_PREPROCESS
+#include "include/det_cuda_kernels.h"
+#include <cuda_runtime_api.h>
+#endif
+
+namespace PaddleOCR
+{
+#ifdef PPOCR_CUDA_PREPROCESS
+    static void check(cudaError_t err, const char *what)
+    {
+        if (err != cudaSuccess)
+        {
+            throw std::runtime_error(std::string("CUDA ") + what + ": " + cudaGetErrorString(err));
+        }
+    }
+
+    // 容量不足时重新分配设备内存，不保留原有内容
+    template <typename T>
+    static T *reserve_device(T *&ptr, size_t &cap, size_t count)
+    {
+        if (cap < count)
+        {
+            cudaFree(ptr);
+            ptr = nullptr;
+            cap = 0;
+            check(cudaMalloc(reinterpret_cast<void **>(&ptr), count * sizeof(T)), "malloc");
+            cap = count;
+        }
+        return ptr;
+    }
+#endif
+
+    DetCudaOps::DetCudaOps(void *stream) : stream_(stream)
+    {
+    }
+
+    DetCudaOps::~DetCudaOps()
+    {
+        Release();
+    }
+
+    bool DetCudaOps::available()
+    {
+#ifdef PPOCR_CUDA_PREPROCESS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    float *DetCudaOps::Preprocess(const cv::Mat &img, int dst_h, int dst_w, const std::vector<float> &mean,
+                                  const std::vector<float> &scale, bool is_scale)
+    {
+#ifdef PPOCR_CUDA_PREPROCESS
+        cudaStream_t stream = static_cast<cudaStream_t>(stream_);
+        size_t row = size_t(img.cols) * 3;
+        reserve_device(src_, src_cap_, row * img.rows);
+        check(cudaMemcpy2DAsync(src_, row, img.data, img.step[0], row, img.rows, cudaMemcpyHostToDevice, stream),
+              "upload");
+        reserve_device(input_, input_cap_, size_t(3) * dst_h * dst_w);
+        cuda::NormCoef coef;
+        float e = is_scale ? 1.f / 255.f : 1.f;
+        for (int c = 0; c < 3; c++)
+        {
+            coef.a[c] = e * scale[c];
+            coef.b[c] = -mean[c] * scale[c];
+        }
+        check(cudaError_t(cuda::LaunchResizeNormalize(src_, img.rows, img.cols, int(row), input_, dst_h, dst_w, coef,
+                                                      stream_)),
+              "resize");
+        return input_;
+#else
+        throw std::runtime_error("built without WITH_CUDA_PREPROCESS");
+#endif
+    }
+
+    void DetCudaOps::Threshold(const float *prob, int h, int w, double thresh, cv::Mat &bitmap, cv::Mat &score)
+    {
+#ifdef PPOCR_CUDA_PREPROCESS
+        cudaStream_t stream = static_cast<cudaStream_t>(stream_);
+        size_t n = size_t(h) * w;
+        reserve_device(maps_, maps_cap_, n * 2);
+        check(cudaError_t(cuda::LaunchThreshold(prob, int(n), float(std::floor(thresh * 255)), maps_, maps_ + n,
+                                                stream_)),
+              "threshold");
+        if (host_maps_cap_ < n * 2)
+        {
+            cudaFreeHost(host_maps_);
+            host_maps_ = nullptr;
+            host_maps_cap_ = 0;
+            check(cudaHostAlloc(reinterpret_cast<void **>(&host_maps_), n * 2, cudaHostAllocDefault), "host alloc");
+            host_maps_cap_ = n * 2;
+        }
+        check(cudaMemcpyAsync(host_maps_, maps_, n * 2, cudaMemcpyDeviceToHost, stream), "download");
+        check(cudaStreamSynchronize(stream), "sync");
+        bitmap = cv::Mat(h, w, CV_8UC1, host_maps_);
+        score = cv::Mat(h, w, CV_8UC1, host_maps_ + n);
+#else
+        throw std::runtime_error("built without WITH_CUDA_PREPROCESS");
+#endif
+    }
+
+    void DetCudaOps::Release()
+    {
+#ifdef PPOCR_CUDA_PREPROCESS
+        cudaFree(src_);
+        cudaFree(input_);
+        cudaFree(maps_);
+        cudaFreeHost(host_maps_);
+#endif
+        src_ = nullptr;
+        input_ = nullptr;
+        maps_ = nullptr;
+        host_maps_ = nullptr;
+        src_cap_ = input_cap_ = maps_cap_ = host_maps_cap_ = 0;
+    }
+} // namespace PaddleOCR
@@ -0,0 +1,335 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#include "include/document.h"
+#include "include/args.h"
+#include "include/logger.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+#include "opencv2/core/version.hpp"
+#include "opencv2/imgcodecs.hpp"
+#include "opencv2/imgproc.hpp"
+
+// 从内存解码多页图片（imdecodemulti）自 OpenCV 4.7 起提供，按页范围解码自 4.9 起提供。
+// 更早的版本不拆分多页TIFF，按普通图片解码，只识别第一页
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 7)
+#define PPOCR_CV_DECODE_MULTI
+#endif
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 9)
+#define PPOCR_CV_DECODE_MULTI_RANGE
+#endif
+
+#ifdef PPOCR_WITH_PDFIUM
+#include "fpdfview.h"
+#endif
+
+namespace PaddleOCR
+{
+    static const int MAX_PAGES = 100000;  // TIFF目录链的上限，防止循环链表
+    static const int MAX_RENDER_SIDE = 10000; // PDF渲染的长边上限（像素）
+
+    // 经典TIFF（不含BigTIFF）的页数：沿IFD链计数。不是TIFF或文件头有误时返回0
+    static int tiff_pages(const unsigned char *p, size_t size)
+    {
+        if (size < 8)
+        {
+            return 0;
+        }
+        bool le = p[0] == 'I' && p[1] == 'I';
+        if (!le && !(p[0] == 'M' && p[1] == 'M'))
+        {
+            return 0;
+        }
+        auto u16 = [&](size_t i)
+        { return le ? uint32_t(p[i] | (p[i + 1] << 8)) : uint32_t((p[i] << 8) | p[i + 1]); };
+        auto u32 = [&](size_t i)
+        { return le ? (u16(i) | (u16(i + 2) << 16)) : ((u16(i) << 16) | u16(i + 2)); };
+        if (u16(2) != 42)
+        {
+            return 0;
+        }
+        int pages = 0;
+        size_t offset = u32(4);
+        size_t last = 0;
+        while (offset != 0 && pages < MAX_PAGES)
+        {
+            // 目录须在文件内且向后推进（规范不要求，但实际文件都如此，可以挡住循环）
+            if (offset + 2 > size || (pages > 0 && offset <= last))
+            {
+                break;
+            }
+            size_t next = offset + 2 + 12 * size_t(u16(offset));
+            if (next + 4 > size)
+            {
+                break;
+            }
+            pages++;
+            last = offset;
+            offset = u32(next);
+        }
+        return pages;
+    }
+
+#ifdef PPOCR_CV_DECODE_MULTI
+    class TiffDocument : public Document
+    {
+    public:
+        TiffDocument(const void *data, size_t size, int pages)
+            : data_(static_cast<const uchar *>(data), static_cast<const uchar *>(data) + size), pages_(pages) {}
+
+        int pages() const override { return pages_; }
+
+        cv::Mat render(int page) override
+        {
+            cv::Mat buf(1, int(data_.size()), CV_8UC1, data_.data());
+#ifdef PPOCR_CV_DECODE_MULTI_RANGE
+            // 只解码这一页，跳过的页不解码。各调用各自创建解码器，可并行
+            std::vector<cv::Mat> mats;
+            try
+            {
+                if (!cv::imdecodemulti(buf, cv::IMREAD_COLOR, mats, cv::Range(page, page + 1)) || mats.empty())
+                {
+                    return cv::Mat();
+                }
+            }
+            catch (...)
+            {
+                return cv::Mat();
+            }
+            return mats[0];
+#else
+            // 不支持按页范围解码：首次调用时解码全部页并缓存，之后各页直接取出，不再重复解码
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!decoded_)
+            {
+                decoded_ = true;
+                try
+                {
+                    if (!cv::imdecodemulti(buf, cv::IMREAD_COLOR, mats_))
+                    {
+                        mats_.clear();
+                    }
+                }
+                catch (...)
+                {
+                    mats_.clear();
+                }
+            }
+            if (page >= int(mats_.size()))
+            {
+                return cv::Mat();
+            }
+            return mats_[page];
+#endif
+        }
+
+    private:
+        std::vector<uchar> data_;
+        int pages_;
+#ifndef PPOCR_CV_DECODE_MULTI_RANGE
+        std::mutex mutex_;
+        bool decoded_ = false;
+        std::vector<cv::Mat> mats_; // 全部页的解码结果，随文档释放
+#endif
+    };
+#endif // PPOCR_CV_DECODE_MULTI
+
+#ifdef PPOCR_WITH_PDFIUM
+    // PDFium 不是线程安全的，所有调用串行。PDF的页面因此只能逐页渲染，光栅化线程的作用是与识别重叠
+    static std::mutex &pdfium_mutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    class PdfDocument : public Document
+    {
+    public:
+        PdfDocument(const void *data, size_t size, int limit_side_len)
+            : data_(static_cast<const uchar *>(data), static_cast<const uchar *>(data) + size),
+              limit_side_len_(limit_side_len)
+        {
+            std::lock_guard<std::mutex> lock(pdfium_mutex());
+            static bool initialized = false;
+            if (!initialized)
+            {
+                FPDF_InitLibrary();
+                initialized = true;
+            }
+            // 数据须在文档关闭前保持有效
+            doc_ = FPDF_LoadMemDocument(data_.data(), int(data_.size()), nullptr);
+            pages_ = doc_ ? FPDF_GetPageCount(doc_) : 0;
+        }
+
+        ~PdfDocument()
+        {
+            std::lock_guard<std::mutex> lock(pdfium_mutex());
+            if (doc_)
+            {
+                FPDF_CloseDocument(doc_);
+            }
+        }
+
+        int pages() const override { return pages_; }
+
+        cv::Mat render(int page) override
+        {
+            std::lock_guard<std::mutex> lock(pdfium_mutex());
+            FPDF_PAGE p = FPDF_LoadPage(doc_, page);
+            if (!p)
+            {
+                return cv::Mat();
+            }
+            double w = FPDF_GetPageWidthF(p), h = FPDF_GetPageHeightF(p); // 单位为点，1/72英寸
+            double dpi = page_dpi(std::max(w, h));
+            int pw = std::max(1, int(w * dpi / 72 + 0.5));
+            int ph = std::max(1, int(h * dpi / 72 + 0.5));
+            cv::Mat out;
+            FPDF_BITMAP bitmap = FPDFBitmap_Create(pw, ph, 0);
+            if (bitmap)
+            {
+                FPDFBitmap_FillRect(bitmap, 0, 0, pw, ph, 0xFFFFFFFF); // 白底，透明背景的页面不会变黑
+                FPDF_RenderPageBitmap(bitmap, p, 0, 0, pw, ph, 0, FPDF_ANNOT);
+                cv::Mat bgra(ph, pw, CV_8UC4, FPDFBitmap_GetBuffer(bitmap), size_t(FPDFBitmap_GetStride(bitmap)));
+                cv::cvtColor(bgra, out, cv::COLOR_BGRA2BGR);
+                FPDFBitmap_Destroy(bitmap);
+            }
+            FPDF_ClosePage(p);
+            return out;
+        }
+
+    private:
+        // 渲染DPI：--pdf_dpi 为0时取使长边等于 limit_side_len 的DPI，并限制在150~300之间：
+        // 检测本来就缩小到 limit_side_len，再高的DPI只是浪费；但识别的碎图来自渲染图，低于150时小字难以辨认
+        double page_dpi(double long_side_pt) const
+        {
+            long_side_pt = std::max(long_side_pt, 1.0);
+            double dpi = FLAGS_pdf_dpi > 0 ? FLAGS_pdf_dpi
+                                           : std::min(300.0, std::max(150.0, limit_side_len_ * 72.0 / long_side_pt));
+            return std::min(dpi, MAX_RENDER_SIDE * 72.0 / long_side_pt);
+        }
+
+        std::vector<uchar> data_;
+        int limit_side_len_;
+        FPDF_DOCUMENT doc_ = nullptr;
+        int pages_ = 0;
+    };
+#endif
+
+    bool Document::is_pdf(const void *data, size_t size)
+    {
+        return data && size >= 5 && memcmp(data, "%PDF-", 5) == 0;
+    }
+
+    bool Document::is_tiff(const void *data, size_t size)
+    {
+        return data && size >= 4 &&
+               (memcmp(data, "II*\0", 4) == 0 || memcmp(data, "MM\0*", 4) == 0);
+    }
+
+    bool Document::pdf_supported()
+    {
+#ifdef PPOCR_WITH_PDFIUM
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    Document *Document::open(const void *data, size_t size, int limit_side_len)
+    {
+        if (data == nullptr || size == 0 || size > size_t(INT_MAX))
+        {
+            return nullptr;
+        }
+        if (is_pdf(data, size))
+        {
+#ifdef PPOCR_WITH_PDFIUM
+            PdfDocument *doc = new PdfDocument(data, size, limit_side_len);
+            if (doc->pages() > 0)
+            {
+                return doc;
+            }
+            delete doc;
+            OCR_LOG_WARN("PDF load failed: " << size << " bytes");
+#endif
+            return nullptr;
+        }
+        int pages = tiff_pages(static_cast<const unsigned char *>(data), size);
+        if (pages > 1)
+        {
+#ifdef PPOCR_CV_DECODE_MULTI
+            return new TiffDocument(data, size, pages);
+#else
+            OCR_LOG_WARN("multi-page TIFF (" << pages << " pages) needs OpenCV 4.7+, only page 0 is recognized");
+#endif
+        }
+        return nullptr;
+    }
+
+    // ==================== 按页序读出 ====================
+
+    PageReader::PageReader(const std::shared_ptr<Document> &doc, int first, int threads, int ahead)
+        : doc_(doc), pages_(doc->pages()), ahead_(std::max(1, ahead)), next_render_(first), next_take_(first)
+    {
+        int count = std::min(std::max(1, threads), pages_ - first);
+        for (int i = 0; i < count; i++)
+        {
+            threads_.emplace_back(&PageReader::worker, this);
+        }
+    }
+
+    PageReader::~PageReader()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto &t : threads_)
+        {
+            t.join();
+        }
+    }
+
+    void PageReader::worker()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true)
+        {
+            cv_.wait(lock, [this]
+                     { return stop_ || next_render_ >= pages_ || next_render_ < next_take_ + ahead_; });
+            if (stop_ || next_render_ >= pages_)
+            {
+                return;
+            }
+            int page = next_render_++;
+            lock.unlock();
+            cv::Mat img = doc_->render(page);
+            lock.lock();
+            done_[page] = img;
+            cv_.notify_all();
+        }
+    }
+
+    bool PageReader::next(cv::Mat &page, int &index)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (next_take_ >= pages_)
+        {
+            return false;
+        }
+        cv_.wait(lock, [this]
+                 { return done_.count(next_take_) > 0; });
+        auto it = done_.find(next_take_);
+        page = it->second;
+        done_.erase(it);
+        index = next_take_++;
+        cv_.notify_all(); // 腾出一个领先名额
+        return true;
+    }
+
+} // namespace PaddleOCR
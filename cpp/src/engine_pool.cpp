@@ -0,0 +1,188 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#include "include/engine_pool.h"
+#include "include/args.h"
+#include "include/trace.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace PaddleOCR
+{
+    EnginePool::EnginePool(int size)
+    {
+        if (size < 1)
+        {
+            size = 1;
+        }
+        engines_.reserve(size);
+        std::string error, warning;
+        affinity_ = CpuAffinity::plan(FLAGS_engine_affinity, size, FLAGS_cpu_threads, error, warning);
+        if (!error.empty())
+        {
+            std::cerr << "OCR engine affinity disabled: " << error << std::endl;
+        }
+        if (!warning.empty())
+        {
+            std::cerr << "OCR engine affinity: " << warning << std::endl;
+        }
+        for (size_t i = 0; i < affinity_.size(); i++)
+        {
+            std::cerr << "OCR engine #" << i << " CPUs: " << CpuAffinity::describe(affinity_[i]) << std::endl;
+        }
+        for (int i = 0; i < size; i++)
+        {
+            bind(i); // 在引擎的CPU上创建与预热，缓冲区首次写入即分配在本节点
+            Task *task = new Task();
+            if (i == 0)
+            {
+                task->init_engine(); // 首个实例加载模型
+            }
+            else
+            {
+                task->init_engine(*engines_[0]); // 其余实例克隆，共享权重
+            }
+            engines_.emplace_back(task);
+            idle_.push_back(i);
+        }
+        unbind();
+        // 多个引擎时，可将各请求的rec阶段合并批处理
+        PPOCR *base = engines_[0]->engine();
+        if (FLAGS_rec_batch_window_ms > 0 && size > 1 && base->recognizer_)
+        {
+            rec_batcher_.reset(new RecBatcher(base->recognizer_->Clone(), FLAGS_rec_batch_window_ms,
+                                              FLAGS_rec_batch_window_max));
+            for (int i = 0; i < size; i++)
+            {
+                engines_[i]->engine()->rec_batcher_ = rec_batcher_.get();
+            }
+            std::cerr << "OCR rec batching window: " << FLAGS_rec_batch_window_ms << "ms" << std::endl;
+        }
+        std::cerr << "OCR engine pool size: " << size << std::endl;
+    }
+
+    EnginePool::Lease EnginePool::acquire()
+    {
+        Trace::Clock::time_point start = Trace::Clock::now();
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [this]
+                   { return !idle_.empty(); });
+        int index = idle_.back();
+        idle_.pop_back();
+        lock.unlock();
+        Trace::record("engine_wait", start, Trace::Clock::now());
+        return Lease(this, index);
+    }
+
+    void EnginePool::release(int index)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            idle_.push_back(index);
+        }
+        cond_.notify_one();
+    }
+
+    void EnginePool::bind(int index)
+    {
+        if (affinity_.empty())
+        {
+            return;
+        }
+        // 本线程的OpenMP线程组上次绑定到的CPU集合，相同则不必逐个重新绑定
+        static thread_local const CpuAffinity::CpuSet *omp_bound = nullptr;
+        const CpuAffinity::CpuSet &cpus = affinity_[index];
+        CpuAffinity::bind_thread(cpus);
+        if (omp_bound != &cpus)
+        {
+            CpuAffinity::bind_openmp(cpus, FLAGS_cpu_threads);
+            omp_bound = &cpus;
+        }
+    }
+
+    void EnginePool::unbind()
+    {
+        if (!affinity_.empty())
+        { // 请求的解码、序列化等不受引擎CPU的限制。OpenMP线程组保持绑定，只在推理中使用
+            CpuAffinity::unbind_thread();
+        }
+    }
+
+    int EnginePool::size() const
+    {
+        return static_cast<int>(engines_.size());
+    }
+
+    int EnginePool::idle() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return static_cast<int>(idle_.size());
+    }
+
+    ResultCache *EnginePool::cache() const
+    {
+        return engines_[0]->cache(); // 所有引擎共享同一个缓存
+    }
+
+    int EnginePool::release_idle(std::vector<bool> &released)
+    {
+        int count = 0;
+        for (size_t i = 0; i < engines_.size() && i < released.size(); i++)
+        {
+            if (released[i])
+            {
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                std::vector<int>::iterator it = std::find(idle_.begin(), idle_.end(), int(i));
+                if (it == idle_.end()) // 忙碌，留到下次
+                {
+                    continue;
+                }
+                idle_.erase(it); // 取出，释放期间不会被借出
+            }
+            engines_[i]->release_memory(); // 只释放内存，重新分配发生在下次推理的绑定线程中
+            release(int(i));
+            released[i] = true;
+            count++;
+        }
+        return count;
+    }
+
+    std::string EnginePool::memory_report() const
+    {
+        std::string out;
+        for (size_t i = 0; i < engines_.size(); i++)
+        {
+            out += (i > 0 ? "; #" : "#") + std::to_string(i) + " " + engines_[i]->memory_report();
+        }
+        return out;
+    }
+
+    // ==================== 借用凭证 ====================
+
+    EnginePool::Lease::Lease(EnginePool *pool, int index)
+        : pool_(pool), task_(pool->engines_[index].get()), index_(index)
+    {
+        pool_->bind(index_);
+    }
+
+    EnginePool::Lease::Lease(Lease &&other)
+        : pool_(other.pool_), task_(other.task_), index_(other.index_)
+    {
+        other.pool_ = nullptr;
+        other.task_ = nullptr;
+    }
+
+    EnginePool::Lease::~Lease()
+    {
+        if (pool_)
+        {
+            pool_->unbind();
+            pool_->release(index_);
+        }
+    }
+
+} // namespace PaddleOCR
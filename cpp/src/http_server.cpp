@@ -2,25 +2,90 @@
 
 #include "include/http_server.h"
 #include "include/nlohmann/json.hpp"
+#include "include/json_writer.h"
 #include "include/args.h"
 #include "include/base64.h"
+#include "include/utility.h"
+#include "include/logger.h"
+#include "include/metrics.h"
+#include "include/tbpu.h"
+#include "include/rec_registry.h"
+#include "include/reply_encoding.h"
+#include "include/trace.h"
 #include <opencv2/imgcodecs.hpp>
+#include <atomic>
 #include <chrono>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <thread>
 
 #define PROJECT_VER "v1.4.1 dev.1"
 
 namespace PaddleOCR
 {
+    // 处理请求的线程的请求追踪，由 pre_routing 创建，post_routing 结束
+    static thread_local std::shared_ptr<Trace> t_trace;
+
+    // 在处理函数返回前整理回复（之后 httplib 按 Accept-Encoding 压缩）：
+    // 请求带 ?timing=1 时在json对象回复中加入本请求的 timing 汇总，再按请求的格式编码
+    static void finish_reply(const httplib::Request &req, httplib::Response &res)
+    {
+        if (t_trace && flag_param(req, "timing") && res.body.size() > 2 && res.body[0] == '{' &&
+            res.body[res.body.size() - 1] == '}' && res.get_header_value("Content-Type") == "application/json")
+        {
+            t_trace->finish();
+            res.body.insert(res.body.size() - 1, ",\"timing\":" + t_trace->timing_json());
+        }
+        encode_reply(req, res);
+    }
+
+    // 结束本线程的请求追踪（回复写出之前）：回复头带上 traceresponse，
+    // 保存以供 /api/traces 取回，设置了 trace_dir 时另存为 Chrome trace 文件
+    static void finish_trace(const httplib::Request &req, httplib::Response &res)
+    {
+        std::shared_ptr<Trace> trace;
+        trace.swap(t_trace);
+        Trace::set_current(nullptr);
+        if (!trace)
+        {
+            return;
+        }
+        trace->finish();
+        res.set_header("traceresponse", trace->traceresponse());
+        TraceStore::get().put(trace);
+        if (!FLAGS_trace_dir.empty())
+        {
+            std::ofstream out(FLAGS_trace_dir + "/" + trace->trace_id() + ".json", std::ios::binary);
+            out << trace->chrome_json();
+            if (!out)
+            {
+                OCR_LOG_WARN("Failed to write trace to " << FLAGS_trace_dir);
+            }
+        }
+    }
+
     HttpServer::HttpServer(int port) : port_(port)
     {
         std::cout << "Initializing OCR HTTP Server on port " << port_ << "..." << std::endl;
 
-        // Initialize task and OCR engine
-        task_.reset(new Task());
-        std::cout << "Initializing OCR engine..." << std::endl;
-        task_->init_engine();
-        std::cout << "OCR engine initialized successfully" << std::endl;
+        // Initialize OCR engine pool
+        std::cout << "Initializing OCR engines (" << FLAGS_server_engines << ")..." << std::endl;
+        pool_.reset(new EnginePool(FLAGS_server_engines));
+        std::cout << "OCR engines initialized successfully" << std::endl;
+        // 每个引擎一个工作线程，引擎全忙时任务在队列中排队
+        jobs_.reset(new JobQueue(FLAGS_server_engines, FLAGS_server_jobs_max, FLAGS_server_jobs_ttl));
+        admission_.reset(new AdmissionControl(FLAGS_server_max_inflight > 0 ? FLAGS_server_max_inflight : FLAGS_server_engines,
+                                              FLAGS_server_queue_max));
+        if (FLAGS_cpu_mem > 0)
+        {
+            EnginePool *pool = pool_.get();
+            governor_.reset(new MemoryGovernor(
+                pool->size(), [pool](std::vector<bool> &released)
+                { return pool->release_idle(released); },
+                [pool]
+                { return pool->memory_report(); }));
+        }
 
         // Setup routes
         setup_routes();
@@ -32,23 +97,48 @@ namespace PaddleOCR
         server_.set_default_headers({
             {"Access-Control-Allow-Origin", "*"},
             {"Access-Control-Allow-Methods", "POST, GET, OPTIONS"},
-            {"Access-Control-Allow-Headers", "Content-Type, Authorization"}
+            {"Access-Control-Allow-Headers", "Content-Type, Authorization, X-Priority, X-Tenant, X-Request-Timeout-Ms, traceparent"},
+            {"Access-Control-Expose-Headers", "traceresponse"},
+            {"Vary", "Accept, Accept-Encoding"} // 回复的格式与压缩随这两个请求头变化
         });
 
+        // 请求追踪：POST 请求在读取正文之前开始，回复写出之前结束（流式回复只含回复开始之前的阶段）。
+        // 回复格式参数不合法时在此直接回复400
+        server_.set_pre_routing_handler([](const httplib::Request &req, httplib::Response &res)
+                                        {
+            if (req.method == "POST")
+            {
+                if (reject_reply_format(req, res)) // 在读取正文与识别之前拒绝
+                {
+                    return httplib::Server::HandlerResponse::Handled;
+                }
+                t_trace.reset(new Trace(req.get_header_value("traceparent"), req.method + " " + req.path));
+                Trace::set_current(t_trace.get());
+            }
+            return httplib::Server::HandlerResponse::Unhandled; });
+        server_.set_post_routing_handler([](const httplib::Request &req, httplib::Response &res)
+                                         { finish_trace(req, res); });
+
         // Health check endpoint
         server_.Get("/api/health", [this](const httplib::Request &req, httplib::Response &res)
                     {
             auto start_time = std::chrono::high_resolution_clock::now();
             handle_health(req, res);
+            finish_reply(req, res);
             auto end_time = std::chrono::high_resolution_clock::now();
             auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
             log_request("GET", "/api/health", res.status, duration); });
 
+        // Metrics endpoint - Prometheus text format
+        server_.Get("/api/metrics", [this](const httplib::Request &req, httplib::Response &res)
+                    { handle_metrics(req, res); });
+
         // Version endpoint
         server_.Get("/api/version", [this](const httplib::Request &req, httplib::Response &res)
                     {
             auto start_time = std::chrono::high_resolution_clock::now();
             handle_version(req, res);
+            finish_reply(req, res);
             auto end_time = std::chrono::high_resolution_clock::now();
             auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
             log_request("GET", "/api/version", res.status, duration); });
@@ -58,6 +148,7 @@ namespace PaddleOCR
                      {
             auto start_time = std::chrono::high_resolution_clock::now();
             handle_ocr_upload(req, res);
+            finish_reply(req, res);
             auto end_time = std::chrono::high_resolution_clock::now();
             auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
             log_request("POST", "/api/ocr", res.status, duration); });
@@ -67,10 +158,87 @@ namespace PaddleOCR
                      {
             auto start_time = std::chrono::high_resolution_clock::now();
             handle_ocr_base64(req, res);
+            finish_reply(req, res);
             auto end_time = std::chrono::high_resolution_clock::now();
             auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
             log_request("POST", "/api/ocr/base64", res.status, duration); });
 
+        // OCR endpoint - many images in one request
+        server_.Post("/api/ocr/batch", [this](const httplib::Request &req, httplib::Response &res)
+                     {
+            auto start_time = std::chrono::high_resolution_clock::now();
+            handle_ocr_batch(req, res);
+            finish_reply(req, res);
+            auto end_time = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+            log_request("POST", "/api/ocr/batch", res.status, duration); });
+
+        // Det-only endpoint - text boxes without recognition, multipart or base64 JSON
+        server_.Post("/api/det", [this](const httplib::Request &req, httplib::Response &res)
+                     {
+            auto start_time = std::chrono::high_resolution_clock::now();
+            if (req.form.has_file("image"))
+                handle_ocr_upload(req, res, true);
+            else
+                handle_ocr_base64(req, res, true);
+            finish_reply(req, res);
+            auto end_time = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+            log_request("POST", "/api/det", res.status, duration); });
+
+        // Rec-only endpoint - many pre-cropped text lines in one request
+        server_.Post("/api/rec", [this](const httplib::Request &req, httplib::Response &res)
+                     {
+            auto start_time = std::chrono::high_resolution_clock::now();
+            handle_rec(req, res);
+            finish_reply(req, res);
+            auto end_time = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+            log_request("POST", "/api/rec", res.status, duration); });
+
+        // Structure endpoint - layout + table, multipart or base64 JSON
+        server_.Post("/api/structure", [this](const httplib::Request &req, httplib::Response &res)
+                     {
+            auto start_time = std::chrono::high_resolution_clock::now();
+            handle_structure(req, res);
+            finish_reply(req, res);
+            auto end_time = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+            log_request("POST", "/api/structure", res.status, duration); });
+
+        // Async job endpoints - submit, then poll / long-poll / SSE by id
+        server_.Post("/api/jobs", [this](const httplib::Request &req, httplib::Response &res)
+                     {
+            auto start_time = std::chrono::high_resolution_clock::now();
+            handle_job_submit(req, res);
+            finish_reply(req, res);
+            auto end_time = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+            log_request("POST", "/api/jobs", res.status, duration); });
+
+        server_.Get("/api/jobs/:id", [this](const httplib::Request &req, httplib::Response &res)
+                    {
+            auto start_time = std::chrono::high_resolution_clock::now();
+            handle_job_get(req, res);
+            finish_reply(req, res);
+            auto end_time = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+            log_request("GET", "/api/jobs/" + req.path_params.at("id"), res.status, duration); });
+
+        // Trace endpoint - timeline of a recent request, Chrome trace (default) or OTLP json
+        server_.Get("/api/traces/:id", [this](const httplib::Request &req, httplib::Response &res)
+                    { handle_trace(req, res); });
+
+        server_.Get("/api/jobs/:id/events", [this](const httplib::Request &req, httplib::Response &res)
+                    { handle_job_events(req, res); });
+
+        // 工作线程：执行中与排队中的请求各占一个，另留一些给健康检查等轻量请求。
+        // 超出的请求不再在 httplib 内无限排队，而是由准入控制立即回复503
+        int inflight = FLAGS_server_max_inflight > 0 ? FLAGS_server_max_inflight : FLAGS_server_engines;
+        size_t threads = size_t(inflight + FLAGS_server_queue_max + 8);
+        server_.new_task_queue = [threads]
+        { return new httplib::ThreadPool(threads, threads); };
+
         // Set max request body size (10MB)
         server_.set_payload_max_length(10 * 1024 * 1024);
 
@@ -84,11 +252,87 @@ namespace PaddleOCR
         nlohmann::json response = {
             {"status", "ok"},
             {"version", PROJECT_VER},
+            {"engines", pool_->size()},
+            {"engines_idle", pool_->idle()},
+            {"admission", {{"inflight", admission_->inflight()}, {"queued", admission_->queued()}, {"rejected", admission_->rejected()}, {"expired", admission_->expired()}}},
+            {"rec_languages", RecRegistry::get().languages()}, // 可按请求的 lang 识别的语言，供路由选择后端
+            {"rec_loaded", RecRegistry::get().loaded()},
             {"timestamp", std::time(nullptr)}};
+        ResultCache *cache = pool_->cache();
+        if (cache)
+        {
+            ResultCache::Stats stats = cache->stats();
+            response["cache"] = {
+                {"hits", stats.hits},
+                {"misses", stats.misses},
+                {"entries", stats.entries},
+                {"size_mb", stats.bytes / 1048576.0},
+                {"limit_mb", FLAGS_result_cache_mb}};
+        }
 
         res.set_content(response.dump(), "application/json");
     }
 
+    void HttpServer::handle_metrics(const httplib::Request &req, httplib::Response &res)
+    {
+        std::string out = Metrics::get().render();
+        out += "# HELP paddleocr_engines OCR engines in the pool.\n";
+        out += "# TYPE paddleocr_engines gauge\n";
+        out += "paddleocr_engines " + std::to_string(pool_->size()) + "\n";
+        out += "# HELP paddleocr_engines_busy OCR engines currently leased.\n";
+        out += "# TYPE paddleocr_engines_busy gauge\n";
+        out += "paddleocr_engines_busy " + std::to_string(pool_->size() - pool_->idle()) + "\n";
+        out += "# HELP paddleocr_jobs_pending Async jobs waiting for an engine.\n";
+        out += "# TYPE paddleocr_jobs_pending gauge\n";
+        out += "paddleocr_jobs_pending " + std::to_string(jobs_->pending()) + "\n";
+        out += "# HELP paddleocr_requests_inflight OCR requests admitted and running.\n";
+        out += "# TYPE paddleocr_requests_inflight gauge\n";
+        out += "paddleocr_requests_inflight " + std::to_string(admission_->inflight()) + "\n";
+        out += "# HELP paddleocr_requests_queued OCR requests waiting for admission.\n";
+        out += "# TYPE paddleocr_requests_queued gauge\n";
+        out += "paddleocr_requests_queued " + std::to_string(admission_->queued()) + "\n";
+        out += "# HELP paddleocr_requests_rejected_total OCR requests rejected because the queue was full.\n";
+        out += "# TYPE paddleocr_requests_rejected_total counter\n";
+        out += "paddleocr_requests_rejected_total " + std::to_string(admission_->rejected()) + "\n";
+        out += "# HELP paddleocr_requests_expired_total OCR requests dropped after their deadline passed while queued.\n";
+        out += "# TYPE paddleocr_requests_expired_total counter\n";
+        out += "paddleocr_requests_expired_total " + std::to_string(admission_->expired()) + "\n";
+        ResultCache *cache = pool_->cache();
+        if (cache)
+        {
+            ResultCache::Stats stats = cache->stats();
+            out += "# HELP paddleocr_cache_hits_total Result cache hits.\n";
+            out += "# TYPE paddleocr_cache_hits_total counter\n";
+            out += "paddleocr_cache_hits_total " + std::to_string(stats.hits) + "\n";
+            out += "# HELP paddleocr_cache_misses_total Result cache misses.\n";
+            out += "# TYPE paddleocr_cache_misses_total counter\n";
+            out += "paddleocr_cache_misses_total " + std::to_string(stats.misses) + "\n";
+        }
+        int rss_mb = Task::get_memory_mb();
+        if (rss_mb >= 0)
+        {
+            out += "# HELP paddleocr_resident_memory_bytes Resident memory of the process.\n";
+            out += "# TYPE paddleocr_resident_memory_bytes gauge\n";
+            out += "paddleocr_resident_memory_bytes " + std::to_string((long long)rss_mb << 20) + "\n";
+        }
+        res.set_content(out, "text/plain; version=0.0.4");
+    }
+
+    void HttpServer::handle_trace(const httplib::Request &req, httplib::Response &res)
+    {
+        std::shared_ptr<Trace> trace = TraceStore::get().find(req.path_params.at("id"));
+        if (!trace)
+        {
+            res.status = 404;
+            res.set_content(create_error_response(404, "Trace not found"), "application/json");
+            return;
+        }
+        if (req.has_param("format") && req.get_param_value("format") == "otlp")
+            res.set_content(trace->otlp_json(), "application/json");
+        else
+            res.set_content(trace->chrome_json(), "application/json");
+    }
+
     void HttpServer::handle_version(const httplib::Request &req, httplib::Response &res)
     {
         nlohmann::json response = {
@@ -99,7 +343,7 @@ namespace PaddleOCR
         res.set_content(response.dump(), "application/json");
     }
 
-    void HttpServer::handle_ocr_upload(const httplib::Request &req, httplib::Response &res)
+    void HttpServer::handle_ocr_upload(const httplib::Request &req, httplib::Response &res, bool det_only)
     {
         try
         {
@@ -115,8 +359,7 @@ namespace PaddleOCR
             // Get uploaded file
             auto file = req.form.get_file("image");
 
-            std::cout << "Received file: " << file.filename
-                      << " (" << file.content.size() << " bytes)" << std::endl;
+            OCR_LOG_DEBUG("Received file: " << file.filename << " (" << file.content.size() << " bytes)");
 
             // Validate file size
             if (file.content.size() > 10 * 1024 * 1024)
@@ -127,8 +370,28 @@ namespace PaddleOCR
                 return;
             }
 
-            // Decode image from bytes
-            cv::Mat img = decode_image_from_bytes(file.content);
+            std::string parser;
+            if (!request_parser(req, res, "", parser))
+            {
+                return;
+            }
+            OCROptions options; // 先于解码读取：解码按其中的检测尺寸与ROI缩小
+            if (!request_options(req, res, nlohmann::json(), options) || (det_only && !restrict_det_only(res, options)))
+            {
+                return;
+            }
+
+            // Decode image from bytes（PDF与多页TIFF先取出首页）
+            std::shared_ptr<Document> doc;
+            cv::Mat img;
+            if (!open_document(file.content.data(), file.content.size(), options, doc, img, res))
+            {
+                return;
+            }
+            if (img.empty())
+            {
+                img = decode_image_from_bytes(file.content.data(), file.content.size(), &options);
+            }
 
             if (img.empty())
             {
@@ -138,32 +401,41 @@ namespace PaddleOCR
                 return;
             }
 
-            std::cout << "Image decoded: " << img.cols << "x" << img.rows << std::endl;
-
-            // Run OCR
-            std::string result = task_->run_ocr_mat(img);
+            OCR_LOG_DEBUG("Image decoded: " << img.cols << "x" << img.rows << " (1/" << options.decode_scale << ")");
+            if (reject_oversize(img, res) || reject_roi(img, options, res))
+            {
+                return;
+            }
+            std::shared_ptr<AdmissionControl::Ticket> ticket = admit(req, res, request_cost(img));
+            if (!ticket)
+            {
+                return;
+            }
 
-            // Parse result to add processing time
-            try
+            if (doc)
             {
-                nlohmann::json result_json = nlohmann::json::parse(result);
-                res.set_content(result_json.dump(), "application/json");
+                reply_document(doc, img, res, ticket, parser, options, wants_stream(req));
+                return;
             }
-            catch (...)
+            if (wants_stream(req))
             {
-                res.set_content(result, "application/json");
+                stream_ocr(img, res, ticket, parser, options);
+                return;
             }
+
+            // Run OCR
+            res.set_content(pool_->acquire()->run_ocr_mat(img, parser, options), "application/json");
         }
         catch (const std::exception &e)
         {
-            std::cerr << "Error: " << e.what() << std::endl;
+            OCR_LOG_ERROR("Error: " << e.what());
             res.status = 500;
             res.set_content(create_error_response(500, std::string("Internal server error: ") + e.what()),
                             "application/json");
         }
     }
 
-    void HttpServer::handle_ocr_base64(const httplib::Request &req, httplib::Response &res)
+    void HttpServer::handle_ocr_base64(const httplib::Request &req, httplib::Response &res, bool det_only)
     {
         try
         {
@@ -178,14 +450,15 @@ namespace PaddleOCR
                 return;
             }
 
-            std::string base64_str = body["image"];
+            // Reference the string inside the parsed JSON instead of copying it
+            const std::string &base64_str = body["image"].get_ref<const std::string &>();
 
-            // Decode base64 to bytes
-            std::string decoded_str;
+            // Decode base64 straight into a pre-sized byte buffer
+            std::vector<uchar> decoded;
             try
             {
-                // Simple base64 decode (you may need to include base64.h)
-                decoded_str = base64_decode(base64_str);
+                decoded.resize(base64_decoded_size(base64_str.data(), base64_str.size()));
+                decoded.resize(base64_decode_into(base64_str.data(), base64_str.size(), decoded.data()));
             }
             catch (...)
             {
@@ -195,8 +468,28 @@ namespace PaddleOCR
                 return;
             }
 
-            // Decode image from bytes
-            cv::Mat img = decode_image_from_bytes(decoded_str);
+            std::string parser;
+            if (!request_parser(req, res, body.value("parser", std::string()), parser))
+            {
+                return;
+            }
+            OCROptions options; // 先于解码读取：解码按其中的检测尺寸与ROI缩小
+            if (!request_options(req, res, body, options) || (det_only && !restrict_det_only(res, options)))
+            {
+                return;
+            }
+
+            // Decode image from bytes（PDF与多页TIFF先取出首页）
+            std::shared_ptr<Document> doc;
+            cv::Mat img;
+            if (!open_document(decoded.data(), decoded.size(), options, doc, img, res))
+            {
+                return;
+            }
+            if (img.empty())
+            {
+                img = decode_image_from_bytes(decoded.data(), decoded.size(), &options);
+            }
 
             if (img.empty())
             {
@@ -205,9 +498,31 @@ namespace PaddleOCR
                                 "application/json");
                 return;
             }
+            if (reject_oversize(img, res) || reject_roi(img, options, res))
+            {
+                return;
+            }
+            std::shared_ptr<AdmissionControl::Ticket> ticket = admit(req, res, request_cost(img),
+                                                                     body.value("priority", std::string()),
+                                                                     body.value("tenant", std::string()));
+            if (!ticket)
+            {
+                return;
+            }
+
+            if (doc)
+            {
+                reply_document(doc, img, res, ticket, parser, options, wants_stream(req));
+                return;
+            }
+            if (wants_stream(req))
+            {
+                stream_ocr(img, res, ticket, parser, options);
+                return;
+            }
 
             // Run OCR
-            std::string result = task_->run_ocr_mat(img);
+            std::string result = pool_->acquire()->run_ocr_mat(img, parser, options);
 
             // Return result
             res.set_content(result, "application/json");
@@ -226,10 +541,791 @@ namespace PaddleOCR
         }
     }
 
+    // 只识别：multipart 的多个 image 文件，或 json 的 images 数组（base64），每张为裁好的单行文字图片。
+    // 在一个引擎上一次性识别，各行按宽度分批送入识别器。返回一个结果，data 中各项与输入顺序一致
+    void HttpServer::handle_rec(const httplib::Request &req, httplib::Response &res)
+    {
+        try
+        {
+            if (!FLAGS_rec)
+            {
+                res.status = 400;
+                res.set_content(create_error_response(400, "rec is disabled at startup"), "application/json");
+                return;
+            }
+            std::vector<cv::Mat> imgs;
+            std::string error;
+            nlohmann::json body;
+            // 行数在解码前检查：超出上限的请求不值得先解码成千上万张图再拒绝
+            const std::string too_many = "Too many images, server_rec_max_lines is " +
+                                         std::to_string(FLAGS_server_rec_max_lines);
+            if (req.form.has_file("image"))
+            {
+                auto range = req.form.files.equal_range("image");
+                if (std::distance(range.first, range.second) > FLAGS_server_rec_max_lines)
+                {
+                    error = too_many;
+                }
+                for (auto it = range.first; error.empty() && it != range.second; ++it)
+                {
+                    imgs.push_back(decode_image_from_bytes(it->second.content));
+                }
+            }
+            else
+            {
+                try
+                {
+                    body = nlohmann::json::parse(req.body);
+                    if (!body.contains("images") || !body["images"].is_array())
+                    {
+                        error = "Missing 'image' files or 'images' array";
+                    }
+                    else if (body["images"].size() > size_t(FLAGS_server_rec_max_lines))
+                    {
+                        error = too_many;
+                    }
+                    else
+                    {
+                        std::vector<uchar> decoded;
+                        for (auto &item : body["images"])
+                        {
+                            const std::string &base64_str = item.get_ref<const std::string &>();
+                            decoded.resize(base64_decoded_size(base64_str.data(), base64_str.size()));
+                            decoded.resize(base64_decode_into(base64_str.data(), base64_str.size(), decoded.data()));
+                            imgs.push_back(decode_image_from_bytes(decoded.data(), decoded.size()));
+                        }
+                    }
+                }
+                catch (...)
+                {
+                    error = "Invalid JSON or base64 image";
+                }
+            }
+            if (error.empty() && imgs.empty())
+            {
+                error = "No images provided";
+            }
+            for (size_t i = 0; error.empty() && i < imgs.size(); i++)
+            {
+                if (imgs[i].empty())
+                    error = "Invalid image format at index " + std::to_string(i);
+            }
+            if (!error.empty())
+            {
+                res.status = 400;
+                res.set_content(create_error_response(400, error), "application/json");
+                return;
+            }
+            size_t pixels = 0;
+            for (size_t i = 0; i < imgs.size(); i++)
+            {
+                if (reject_oversize(imgs[i], res))
+                {
+                    return;
+                }
+                pixels += imgs[i].total();
+            }
+            OCROptions options;
+            if (!request_options(req, res, body, options))
+            {
+                return;
+            }
+            if (!options.rec)
+            {
+                res.status = 400;
+                res.set_content(create_error_response(400, "rec cannot be disabled on /api/rec"), "application/json");
+                return;
+            }
+            options.det = false; // 不检测，不裁切ROI
+            // 单行小图的代价按总像素数计，而不是每行一个单位：上千行的请求不应占满准入队列
+            int cost = FLAGS_server_cost_pixels > 0 ? 1 + int(pixels / size_t(FLAGS_server_cost_pixels)) : 1;
+            std::shared_ptr<AdmissionControl::Ticket> ticket = admit(req, res, cost,
+                                                                     body.is_object() ? body.value("priority", std::string()) : std::string(),
+                                                                     body.is_object() ? body.value("tenant", std::string()) : std::string());
+            if (!ticket)
+            {
+                return;
+            }
+            OCR_LOG_DEBUG("Rec received: " << imgs.size() << " lines");
+            res.set_content(pool_->acquire()->run_rec_mats(imgs, options), "application/json");
+        }
+        catch (const std::exception &e)
+        {
+            OCR_LOG_ERROR("Error: " << e.what());
+            res.status = 500;
+            res.set_content(create_error_response(500, std::string("Internal server error: ") + e.what()),
+                            "application/json");
+        }
+    }
+
+    // 版面与表格识别：multipart 的 image 文件，或 json 的 image 字段（base64）。须以 type=structure 启动
+    void HttpServer::handle_structure(const httplib::Request &req, httplib::Response &res)
+    {
+        try
+        {
+            if (FLAGS_type != "structure")
+            {
+                res.status = 400;
+                res.set_content(create_error_response(400, "Structure is not enabled. Start the server with --type=structure"),
+                                "application/json");
+                return;
+            }
+            cv::Mat img;
+            std::string priority, tenant;
+            if (req.form.has_file("image"))
+            {
+                img = decode_image_from_bytes(req.form.get_file("image").content);
+            }
+            else
+            {
+                nlohmann::json body = nlohmann::json::parse(req.body);
+                if (!body.contains("image") || !body["image"].is_string())
+                {
+                    res.status = 400;
+                    res.set_content(create_error_response(400, "No image provided. Use 'image' field in form data or JSON body."),
+                                    "application/json");
+                    return;
+                }
+                const std::string &base64_str = body["image"].get_ref<const std::string &>();
+                std::vector<uchar> decoded;
+                try
+                {
+                    decoded.resize(base64_decoded_size(base64_str.data(), base64_str.size()));
+                    decoded.resize(base64_decode_into(base64_str.data(), base64_str.size(), decoded.data()));
+                }
+                catch (...)
+                {
+                    res.status = 400;
+                    res.set_content(create_error_response(400, "Invalid base64 encoding"),
+                                    "application/json");
+                    return;
+                }
+                img = decode_image_from_bytes(decoded.data(), decoded.size());
+                priority = body.value("priority", std::string());
+                tenant = body.value("tenant", std::string());
+            }
+            if (img.empty())
+            {
+                res.status = 400;
+                res.set_content(create_error_response(400, "Invalid image format"),
+                                "application/json");
+                return;
+            }
+            if (reject_oversize(img, res))
+            {
+                return;
+            }
+            std::shared_ptr<AdmissionControl::Ticket> ticket = admit(req, res, request_cost(img), priority, tenant);
+            if (!ticket)
+            {
+                return;
+            }
+            res.set_content(pool_->acquire()->run_structure_mat(img), "application/json");
+        }
+        catch (const nlohmann::json::parse_error &e)
+        {
+            res.status = 400;
+            res.set_content(create_error_response(400, std::string("Invalid JSON: ") + e.what()),
+                            "application/json");
+        }
+        catch (const std::exception &e)
+        {
+            OCR_LOG_ERROR("Error: " << e.what());
+            res.status = 500;
+            res.set_content(create_error_response(500, std::string("Internal server error: ") + e.what()),
+                            "application/json");
+        }
+    }
+
+    bool HttpServer::wants_stream(const httplib::Request &req) const
+    {
+        return req.has_param("stream") && req.get_param_value("stream") != "0";
+    }
+
+    void HttpServer::stream_ocr(const cv::Mat &img, httplib::Response &res,
+                                const std::shared_ptr<AdmissionControl::Ticket> &ticket, const std::string &parser,
+                                const OCROptions &options)
+    {
+        res.set_chunked_content_provider("application/x-ndjson", [this, img, ticket, parser, options](size_t, httplib::DataSink &sink)
+                                         {
+            bool writable = true;
+            std::string result;
+            try
+            {
+                result = pool_->acquire()->run_ocr_mat(img, [&](const std::string &line)
+                                                       {
+                    if (writable)
+                        writable = sink.write((line + "\n").data(), line.size() + 1); }, parser, options);
+            }
+            catch (const std::exception &e)
+            {
+                result = create_error_response(500, std::string("Internal server error: ") + e.what());
+            }
+            result += "\n";
+            if (writable)
+                writable = sink.write(result.data(), result.size());
+            sink.done();
+            return writable; });
+    }
+
+    void HttpServer::reply_document(const std::shared_ptr<Document> &doc, const cv::Mat &first, httplib::Response &res,
+                                    const std::shared_ptr<AdmissionControl::Ticket> &ticket, const std::string &parser,
+                                    const OCROptions &options, bool stream)
+    {
+        // 各页在同一个引擎上依次识别（引擎内的流水线并行处理相邻几页），不像批量那样占用多个引擎：
+        // 页数可达上千，独占整个引擎池会饿死其它请求
+        if (!stream)
+        {
+            std::string out = "[";
+            pool_->acquire()->run_ocr_document(doc, first, parser, options, [&](int index, const std::string &result)
+                                               {
+                if (index > 0)
+                    out += ",";
+                out += result; });
+            out += "]";
+            res.set_content(out, "application/json");
+            return;
+        }
+        res.set_chunked_content_provider("application/x-ndjson", [this, doc, first, ticket, parser, options](size_t, httplib::DataSink &sink)
+                                         {
+            bool writable = true;
+            try
+            {
+                pool_->acquire()->run_ocr_document(doc, first, parser, options, [&](int index, const std::string &result)
+                                                   {
+                    if (!writable)
+                        return;
+                    std::string line = "{\"index\":" + std::to_string(index) + ",\"result\":" + result + "}\n";
+                    writable = sink.write(line.data(), line.size()); });
+            }
+            catch (const std::exception &e)
+            {
+                std::string line = create_error_response(500, std::string("Internal server error: ") + e.what()) + "\n";
+                if (writable)
+                    writable = sink.write(line.data(), line.size());
+            }
+            sink.done();
+            return writable; });
+    }
+
+    // 批量OCR：multipart 的多个 image 文件，或 json 的 images 数组（base64）。
+    // 默认返回结果数组（与输入顺序一致）；?stream=1 时以 NDJSON 逐行返回，每行带 index，按完成顺序
+    void HttpServer::handle_ocr_batch(const httplib::Request &req, httplib::Response &res)
+    {
+        std::vector<cv::Mat> imgs;
+        std::string error;
+        std::string body_priority, body_tenant, body_parser;
+        OCROptions options;
+        if (req.form.has_file("image"))
+        {
+            auto range = req.form.files.equal_range("image");
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                imgs.push_back(decode_image_from_bytes(it->second.content));
+            }
+        }
+        else
+        {
+            try
+            {
+                nlohmann::json body = nlohmann::json::parse(req.body);
+                if (!body.contains("images") || !body["images"].is_array())
+                {
+                    error = "Missing 'image' files or 'images' array";
+                }
+                else
+                {
+                    body_priority = body.value("priority", std::string());
+                    body_tenant = body.value("tenant", std::string());
+                    body_parser = body.value("parser", std::string());
+                    std::string option_key;
+                    if (!Task::parse_options(body, options, option_key))
+                    {
+                        error = "Invalid option: " + option_key;
+                    }
+                    std::vector<uchar> decoded;
+                    for (auto &item : body["images"])
+                    {
+                        const std::string &base64_str = item.get_ref<const std::string &>();
+                        decoded.resize(base64_decoded_size(base64_str.data(), base64_str.size()));
+                        decoded.resize(base64_decode_into(base64_str.data(), base64_str.size(), decoded.data()));
+                        imgs.push_back(decode_image_from_bytes(decoded.data(), decoded.size()));
+                    }
+                }
+            }
+            catch (...)
+            {
+                error = "Invalid JSON or base64 image";
+            }
+        }
+        if (error.empty() && imgs.empty())
+        {
+            error = "No images provided";
+        }
+        for (size_t i = 0; error.empty() && i < imgs.size(); i++)
+        {
+            if (imgs[i].empty())
+                error = "Invalid image format at index " + std::to_string(i);
+        }
+        if (!error.empty())
+        {
+            res.status = 400;
+            res.set_content(create_error_response(400, error), "application/json");
+            return;
+        }
+        int cost = 0;
+        for (size_t i = 0; i < imgs.size(); i++)
+        {
+            if (reject_oversize(imgs[i], res))
+            {
+                return;
+            }
+            cost += request_cost(imgs[i]);
+        }
+        std::string parser;
+        if (!request_parser(req, res, body_parser, parser) || !request_options(req, res, nlohmann::json(), options))
+        {
+            return;
+        }
+        for (size_t i = 0; i < imgs.size(); i++)
+        { // 批量任务不缩小解码，各图片按同一ROI裁切
+            if (reject_roi(imgs[i], options, res))
+            {
+                return;
+            }
+        }
+        std::shared_ptr<AdmissionControl::Ticket> ticket = admit(req, res, cost, body_priority, body_tenant);
+        if (!ticket)
+        {
+            return;
+        }
+
+        OCR_LOG_DEBUG("Batch received: " << imgs.size() << " images");
+        if (wants_stream(req))
+        { // NDJSON：识别线程产出结果，响应线程逐行写出
+            std::shared_ptr<std::vector<cv::Mat>> shared_imgs(new std::vector<cv::Mat>());
+            shared_imgs->swap(imgs);
+            res.set_chunked_content_provider("application/x-ndjson", [this, shared_imgs, ticket, parser, options](size_t, httplib::DataSink &sink)
+                                             {
+                std::mutex mutex;
+                bool writable = true;
+                run_batch(*shared_imgs, *ticket, parser, options, [&](size_t index, const std::string &result)
+                          {
+                    std::string line = "{\"index\":" + std::to_string(index) +
+                                       (result.size() > 2 ? "," : "") + result.substr(1) + "\n";
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (writable)
+                        writable = sink.write(line.data(), line.size()); });
+                sink.done();
+                return writable; });
+            return;
+        }
+        std::vector<std::string> results(imgs.size());
+        run_batch(imgs, *ticket, parser, options, [&results](size_t index, const std::string &result)
+                  { results[index] = result; }); // 各下标只由一个线程写入
+        std::string body = "[";
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            if (i > 0)
+                body += ",";
+            body += results[i];
+        }
+        body += "]";
+        res.set_content(body, "application/json");
+    }
+
+    void HttpServer::run_batch(const std::vector<cv::Mat> &imgs, AdmissionControl::Ticket &ticket, const std::string &parser,
+                               const OCROptions &options, const std::function<void(size_t, const std::string &)> &on_result)
+    {
+        // 每个引擎一个线程。启用流水线时，按引擎数切成连续的几段，每段在一个引擎内走流水线；
+        // 否则逐张领取，先完成的引擎继续领下一张
+        // 额外的工作线程各借一个空闲名额，借不到时不再增加线程
+        std::vector<std::unique_ptr<AdmissionControl::Ticket>> extra;
+        for (size_t i = 1; i < std::min((size_t)pool_->size(), imgs.size()); i++)
+        {
+            AdmissionControl::Ticket *t = admission_->try_enter(ticket.priority(), ticket.tenant());
+            if (!t)
+                break;
+            extra.emplace_back(t);
+        }
+        size_t workers = extra.size() + 1;
+        size_t step = FLAGS_pipeline_queue > 0 ? (imgs.size() + workers - 1) / workers : 1;
+        std::atomic<size_t> next(0);
+        Trace *trace = Trace::current();
+        auto work = [&](AdmissionControl::Ticket *own)
+        {
+            Trace::Scope scope(trace);
+            std::unique_ptr<EnginePool::Lease> engine(new EnginePool::Lease(pool_->acquire()));
+            for (bool first = true;; first = false)
+            {
+                if (!first && own->should_yield())
+                { // 让出点：额外的线程直接退出，余下的图片由主线程完成；主线程归还引擎与名额，排队后继续
+                    if (own != &ticket)
+                        break;
+                    engine.reset();
+                    own->yield();
+                    engine.reset(new EnginePool::Lease(pool_->acquire()));
+                }
+                size_t begin = next.fetch_add(step);
+                if (begin >= imgs.size())
+                    break;
+                size_t end = std::min(begin + step, imgs.size());
+                std::vector<cv::Mat> chunk(imgs.begin() + begin, imgs.begin() + end);
+                std::vector<std::string> results;
+                try
+                {
+                    results = (*engine)->run_ocr_mats(chunk, parser, options);
+                }
+                catch (const std::exception &e)
+                {
+                    results.assign(chunk.size(), create_error_response(500, std::string("Internal server error: ") + e.what()));
+                }
+                for (size_t i = 0; i < results.size(); i++)
+                    on_result(begin + i, results[i]);
+            }
+        };
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < extra.size(); i++)
+            threads.emplace_back([&work, &extra, i]
+                                 { work(extra[i].get()); extra[i].reset(); });
+        work(&ticket); // 当前线程也作为一个工作线程
+        for (size_t i = 0; i < threads.size(); i++)
+            threads[i].join();
+    }
+
+    // 提交异步任务：multipart 的 image 文件，或 json 的 base64 image 字段；可选 id 字段
+    void HttpServer::handle_job_submit(const httplib::Request &req, httplib::Response &res)
+    {
+        std::string id;
+        cv::Mat img;
+        if (req.form.has_file("image"))
+        {
+            img = decode_image_from_bytes(req.form.get_file("image").content);
+            if (req.form.has_field("id"))
+            {
+                id = req.form.get_field("id");
+            }
+        }
+        else
+        {
+            try
+            {
+                nlohmann::json body = nlohmann::json::parse(req.body);
+                if (!body.contains("image"))
+                {
+                    res.status = 400;
+                    res.set_content(create_error_response(400, "Missing 'image' file or field"),
+                                    "application/json");
+                    return;
+                }
+                const std::string &base64_str = body["image"].get_ref<const std::string &>();
+                std::vector<uchar> decoded(base64_decoded_size(base64_str.data(), base64_str.size()));
+                decoded.resize(base64_decode_into(base64_str.data(), base64_str.size(), decoded.data()));
+                img = decode_image_from_bytes(decoded.data(), decoded.size());
+                if (body.contains("id"))
+                {
+                    id = body["id"].is_string() ? body["id"].get<std::string>() : body["id"].dump();
+                }
+            }
+            catch (...)
+            {
+                res.status = 400;
+                res.set_content(create_error_response(400, "Invalid JSON or base64 image"),
+                                "application/json");
+                return;
+            }
+        }
+        if (img.empty()) // 读图失败在提交时就报告，不进入队列
+        {
+            res.status = 400;
+            res.set_content(create_error_response(400, "Invalid image format"), "application/json");
+            return;
+        }
+        if (reject_oversize(img, res))
+        {
+            return;
+        }
+
+        JobQueue::Submit submitted = jobs_->submit(id, [this, img]()
+                                                   {
+            try
+            {
+                return pool_->acquire()->run_ocr_mat(img);
+            }
+            catch (const std::exception &e)
+            {
+                return create_error_response(500, std::string("Internal server error: ") + e.what());
+            } });
+        if (submitted == JobQueue::SUBMIT_DUPLICATE)
+        {
+            res.status = 409;
+            res.set_content(create_error_response(409, "Job id already exists: " + id), "application/json");
+            return;
+        }
+        if (submitted == JobQueue::SUBMIT_FULL)
+        {
+            res.status = 503;
+            res.set_content(create_error_response(503, "Too many jobs in queue"), "application/json");
+            return;
+        }
+        std::string body;
+        res.status = create_job_response(id, JobQueue::JOB_PENDING, "", body) ? 202 : 500;
+        res.set_content(body, "application/json");
+    }
+
+    // 查询异步任务。?wait=毫秒 时长轮询，在任务完成或超时后返回
+    void HttpServer::handle_job_get(const httplib::Request &req, httplib::Response &res)
+    {
+        const std::string &id = req.path_params.at("id");
+        int wait_ms = 0;
+        if (req.has_param("wait"))
+        {
+            wait_ms = std::min(std::max(atoi(req.get_param_value("wait").c_str()), 0), 25000); // 小于读写超时
+        }
+        std::string result;
+        JobQueue::State state = jobs_->wait(id, wait_ms, result);
+        if (state == JobQueue::JOB_UNKNOWN)
+        {
+            res.status = 404;
+            res.set_content(create_error_response(404, "Job not found: " + id), "application/json");
+            return;
+        }
+        std::string body;
+        if (!create_job_response(id, state, result, body))
+        {
+            res.status = 500;
+        }
+        res.set_content(body, "application/json");
+    }
+
+    // 以 SSE 推送异步任务的结果：等待期间定时发送注释行保活，完成时发送 result 事件后结束
+    void HttpServer::handle_job_events(const httplib::Request &req, httplib::Response &res)
+    {
+        std::string id = req.path_params.at("id");
+        res.set_header("Cache-Control", "no-cache");
+        res.set_chunked_content_provider("text/event-stream", [this, id](size_t, httplib::DataSink &sink)
+                                         {
+            std::string result;
+            JobQueue::State state = jobs_->wait(id, 15000, result);
+            if (state == JobQueue::JOB_DONE || state == JobQueue::JOB_UNKNOWN)
+            {
+                std::string data;
+                bool written = state == JobQueue::JOB_DONE && create_job_response(id, state, result, data);
+                if (state == JobQueue::JOB_UNKNOWN)
+                    data = create_error_response(404, "Job not found: " + id);
+                std::string event = written ? "result" : "error";
+                std::string msg = "event: " + event + "\ndata: " + data + "\n\n";
+                sink.write(msg.data(), msg.size());
+                sink.done();
+                return true;
+            }
+            std::string ping = ": " + std::string(JobQueue::state_name(state)) + "\n\n";
+            return sink.write(ping.data(), ping.size()); });
+    }
+
+    bool HttpServer::create_job_response(const std::string &id, JobQueue::State state, const std::string &result,
+                                         std::string &out)
+    {
+        // The result is already a json object written by Task, embed it as is
+        out.clear();
+        JsonWriter response(out, false);
+        response.begin_object().key("id").value(id);
+        if (state == JobQueue::JOB_DONE)
+        {
+            response.key("result");
+            if (!result.empty() && result[0] == '{')
+            {
+                response.raw(result);
+            }
+            else
+            {
+                response.value(result);
+            }
+        }
+        response.key("status").value(JobQueue::state_name(state)).end_object();
+        if (!response.ok())
+        {
+            out = create_error_response(500, "Internal server error: job response could not be serialized");
+            return false;
+        }
+        return true;
+    }
+
     cv::Mat HttpServer::decode_image_from_bytes(const std::string &data)
     {
-        std::vector<uchar> buffer(data.begin(), data.end());
-        return cv::imdecode(buffer, cv::IMREAD_COLOR);
+        // Decode directly from the request buffer, no intermediate copy
+        return decode_image_from_bytes(data.data(), data.size());
+    }
+
+    cv::Mat HttpServer::decode_image_from_bytes(const void *data, size_t size, OCROptions *options)
+    {
+        StageTimer timer(Metrics::STAGE_DECODE);
+        return options ? Task::imdecode_for_ocr(data, size, *options) : Utility::imdecode_buffer(data, size);
+    }
+
+    bool HttpServer::open_document(const void *data, size_t size, const OCROptions &options,
+                                   std::shared_ptr<Document> &doc, cv::Mat &first, httplib::Response &res)
+    {
+        std::string msg;
+        int code;
+        {
+            StageTimer timer(Metrics::STAGE_DECODE);
+            code = Task::open_document(data, size, options, doc, first, msg);
+        }
+        if (code == CODE_INIT)
+        {
+            return true;
+        }
+        res.status = code == CODE_ERR_DOC_PDF ? 415 : code == CODE_ERR_DOC_PAGES ? 413 : 400;
+        res.set_content(create_error_response(res.status, msg), "application/json");
+        return false;
+    }
+
+    std::shared_ptr<AdmissionControl::Ticket> HttpServer::admit(const httplib::Request &req, httplib::Response &res, int cost,
+                                                                const std::string &body_priority,
+                                                                const std::string &body_tenant)
+    {
+        std::string priority = req.get_header_value("X-Priority");
+        if (priority.empty())
+            priority = req.has_param("priority") ? req.get_param_value("priority") : body_priority;
+        std::string tenant = req.get_header_value("X-Tenant");
+        if (tenant.empty())
+            tenant = req.has_param("tenant") ? req.get_param_value("tenant") : body_tenant;
+        if (tenant.empty())
+            tenant = req.remote_addr;
+
+        AdmissionControl::Clock::time_point deadline = AdmissionControl::Clock::time_point::max();
+        std::string timeout = req.get_header_value("X-Request-Timeout-Ms");
+        if (timeout.empty() && req.has_param("timeout_ms"))
+        {
+            timeout = req.get_param_value("timeout_ms");
+        }
+        long timeout_ms = atol(timeout.c_str());
+        if (timeout_ms > 0) // 从开始处理请求时算起
+        {
+            deadline = AdmissionControl::Clock::now() + std::chrono::milliseconds(timeout_ms);
+        }
+        AdmissionControl::Ticket *ticket = nullptr;
+        Trace::Clock::time_point queued = Trace::Clock::now();
+        AdmissionControl::Result admitted = admission_->enter(cost, AdmissionControl::parse_priority(priority), tenant,
+                                                              deadline, ticket);
+        Trace::record("queue", queued, Trace::Clock::now());
+        switch (admitted)
+        {
+        case AdmissionControl::ADMIT_OK:
+            return std::shared_ptr<AdmissionControl::Ticket>(ticket);
+        case AdmissionControl::ADMIT_FULL:
+            res.status = 503;
+            res.set_header("Retry-After", std::to_string(admission_->retry_after()));
+            res.set_content(create_error_response(503, "Server busy, retry later"), "application/json");
+            break;
+        case AdmissionControl::ADMIT_EXPIRED:
+            res.status = 504;
+            res.set_content(create_error_response(504, "Request deadline exceeded before processing"),
+                            "application/json");
+            break;
+        }
+        return std::shared_ptr<AdmissionControl::Ticket>();
+    }
+
+    int HttpServer::request_cost(const cv::Mat &img) const
+    {
+        if (FLAGS_server_cost_pixels <= 0)
+        {
+            return 1;
+        }
+        return 1 + int(img.total() / size_t(FLAGS_server_cost_pixels));
+    }
+
+    bool HttpServer::restrict_det_only(httplib::Response &res, OCROptions &options)
+    {
+        if (!FLAGS_det)
+        {
+            res.status = 400;
+            res.set_content(create_error_response(400, "det is disabled at startup"), "application/json");
+            return false;
+        }
+        options.cls = false; // 方向分类只影响识别，跳过
+        options.rec = false;
+        return true;
+    }
+
+    bool HttpServer::reject_oversize(const cv::Mat &img, httplib::Response &res)
+    {
+        if (MemoryGovernor::admit(img))
+        {
+            return false;
+        }
+        res.status = 413;
+        res.set_content(create_error_response(413, "Image " + std::to_string(img.cols) + "x" +
+                                                       std::to_string(img.rows) + " exceeds max_image_pixels"),
+                        "application/json");
+        return true;
+    }
+
+    bool HttpServer::reject_roi(cv::Mat &img, const OCROptions &options, httplib::Response &res)
+    {
+        if (Task::apply_roi(img, options))
+        {
+            return false;
+        }
+        res.status = 400;
+        res.set_content(create_error_response(400, "Invalid option: roi is outside the " + std::to_string(img.cols) + "x" +
+                                                       std::to_string(img.rows) + " image"),
+                        "application/json");
+        return true;
+    }
+
+    bool HttpServer::request_parser(const httplib::Request &req, httplib::Response &res, const std::string &body_parser,
+                                    std::string &parser)
+    {
+        if (req.has_param("parser"))
+        {
+            parser = req.get_param_value("parser");
+        }
+        else if (req.form.has_field("parser"))
+        {
+            parser = req.form.get_field("parser");
+        }
+        else
+        {
+            parser = body_parser;
+        }
+        if (parser.empty() || Tbpu::valid(parser))
+        {
+            return true;
+        }
+        res.status = 400;
+        res.set_content(create_error_response(400, "Unknown parser: " + parser), "application/json");
+        return false;
+    }
+
+    bool HttpServer::request_options(const httplib::Request &req, httplib::Response &res, const nlohmann::json &body,
+                                     OCROptions &options)
+    {
+        // 表单字段与URL参数的值为文本：能解析为json（数值、布尔）时按解析结果，否则视为字符串
+        auto to_json = [](const std::string &text)
+        {
+            nlohmann::json value = nlohmann::json::parse(text, nullptr, false);
+            return value.is_discarded() ? nlohmann::json(text) : value;
+        };
+        nlohmann::json fields = nlohmann::json::object();
+        for (const auto &field : req.form.fields)
+        {
+            fields[field.first] = to_json(field.second.content);
+        }
+        for (const auto &param : req.params)
+        {
+            fields[param.first] = to_json(param.second);
+        }
+        std::string key;
+        if ((!body.is_object() || Task::parse_options(body, options, key)) && Task::parse_options(fields, options, key))
+        {
+            return true;
+        }
+        res.status = 400;
+        res.set_content(create_error_response(400, "Invalid option: " + key), "application/json");
+        return false;
     }
 
     std::string HttpServer::create_error_response(int code, const std::string &message)
@@ -243,10 +1339,11 @@ namespace PaddleOCR
 
     void HttpServer::log_request(const std::string &method, const std::string &path, int status, long duration_ms)
     {
-        std::cout << "[" << method << "] " << path
-                  << " - Status: " << status
-                  << " - Duration: " << duration_ms << "ms"
-                  << std::endl;
+        Metrics::get().count_request(status);
+        if (status >= 500) // 服务端错误总是记录，其余按采样率记录
+            OCR_LOG_WARN("[" << method << "] " << path << " - Status: " << status << " - Duration: " << duration_ms << "ms");
+        else
+            OCR_LOG_SAMPLED(LOG_LEVEL_INFO, "[" << method << "] " << path << " - Status: " << status << " - Duration: " << duration_ms << "ms");
     }
 
     void HttpServer::start()
@@ -262,7 +1359,14 @@ namespace PaddleOCR
         std::cout << "API Endpoints:" << std::endl;
         std::cout << "  POST http://localhost:" << port_ << "/api/ocr         - Upload image for OCR" << std::endl;
         std::cout << "  POST http://localhost:" << port_ << "/api/ocr/base64  - Submit base64 encoded image" << std::endl;
+        std::cout << "  POST http://localhost:" << port_ << "/api/ocr/batch   - Submit many images (?stream=1 for NDJSON)" << std::endl;
+        std::cout << "  POST http://localhost:" << port_ << "/api/det         - Text boxes only, no recognition" << std::endl;
+        std::cout << "  POST http://localhost:" << port_ << "/api/rec         - Recognize pre-cropped text lines" << std::endl;
+        std::cout << "  POST http://localhost:" << port_ << "/api/jobs        - Submit async OCR job" << std::endl;
+        std::cout << "  GET  http://localhost:" << port_ << "/api/jobs/{id}   - Poll job (?wait=ms to long-poll)" << std::endl;
+        std::cout << "  GET  http://localhost:" << port_ << "/api/jobs/{id}/events - Job result as SSE" << std::endl;
         std::cout << "  GET  http://localhost:" << port_ << "/api/health      - Health check" << std::endl;
+        std::cout << "  GET  http://localhost:" << port_ << "/api/metrics     - Prometheus metrics" << std::endl;
         std::cout << "  GET  http://localhost:" << port_ << "/api/version     - Version info" << std::endl;
         std::cout << std::endl;
         std::cout << "Example:" << std::endl;
@@ -0,0 +1,154 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#include "include/job_queue.h"
+
+namespace PaddleOCR
+{
+    JobQueue::JobQueue(int workers, int max_jobs, int ttl_s)
+        : max_jobs_(max_jobs), ttl_(ttl_s)
+    {
+        if (workers < 1)
+        {
+            workers = 1;
+        }
+        for (int i = 0; i < workers; i++)
+        {
+            threads_.emplace_back(&JobQueue::worker, this);
+        }
+    }
+
+    JobQueue::~JobQueue()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        job_cond_.notify_all();
+        for (size_t i = 0; i < threads_.size(); i++)
+        {
+            threads_[i].join();
+        }
+    }
+
+    JobQueue::Submit JobQueue::submit(std::string &id, std::function<std::string()> fn)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            expire();
+            if ((int)jobs_.size() >= max_jobs_)
+            {
+                return SUBMIT_FULL;
+            }
+            if (id.empty())
+            {
+                do
+                {
+                    id = "job-" + std::to_string(next_id_++);
+                } while (jobs_.count(id));
+            }
+            else if (jobs_.count(id))
+            {
+                return SUBMIT_DUPLICATE;
+            }
+            Job &job = jobs_[id];
+            job.fn = std::move(fn);
+            job.state = JOB_PENDING;
+            queue_.push_back(id);
+        }
+        job_cond_.notify_one();
+        return SUBMIT_OK;
+    }
+
+    JobQueue::State JobQueue::wait(const std::string &id, int timeout_ms, std::string &result)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        while (true)
+        {
+            auto it = jobs_.find(id);
+            if (it == jobs_.end())
+            {
+                return JOB_UNKNOWN;
+            }
+            if (it->second.state == JOB_DONE)
+            {
+                result = it->second.result;
+                return JOB_DONE;
+            }
+            if (timeout_ms <= 0 ||
+                done_cond_.wait_until(lock, deadline) == std::cv_status::timeout)
+            {
+                it = jobs_.find(id); // 等待期间可能被清理
+                return it == jobs_.end() ? JOB_UNKNOWN : it->second.state;
+            }
+        }
+    }
+
+    int JobQueue::pending()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return (int)queue_.size();
+    }
+
+    const char *JobQueue::state_name(State state)
+    {
+        switch (state)
+        {
+        case JOB_PENDING:
+            return "pending";
+        case JOB_RUNNING:
+            return "running";
+        case JOB_DONE:
+            return "done";
+        default:
+            return "unknown";
+        }
+    }
+
+    void JobQueue::expire()
+    {
+        auto now = std::chrono::steady_clock::now();
+        for (auto it = jobs_.begin(); it != jobs_.end();)
+        {
+            if (it->second.state == JOB_DONE && now - it->second.done_at > ttl_)
+                it = jobs_.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    void JobQueue::worker()
+    {
+        while (true)
+        {
+            std::string id;
+            std::function<std::string()> fn;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                job_cond_.wait(lock, [this]
+                               { return stop_ || !queue_.empty(); });
+                if (stop_)
+                {
+                    return;
+                }
+                id = queue_.front();
+                queue_.pop_front();
+                Job &job = jobs_[id];
+                job.state = JOB_RUNNING;
+                fn.swap(job.fn); // 取出后释放任务持有的图片等资源
+            }
+            std::string result = fn();
+            fn = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                Job &job = jobs_[id];
+                job.result.swap(result);
+                job.state = JOB_DONE;
+                job.done_at = std::chrono::steady_clock::now();
+            }
+            done_cond_.notify_all();
+        }
+    }
+
+} // namespace PaddleOCR
@@ -0,0 +1,269 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#include "include/json_writer.h"
+#include "include/nlohmann/json.hpp" // 浮点数最短表示 nlohmann::detail::to_chars
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace PaddleOCR
+{
+    static const char HEX[] = "0123456789abcdef";
+
+    static void append_u(std::string &out, unsigned int unit)
+    {
+        char buf[6] = {'\\', 'u', HEX[(unit >> 12) & 0xF], HEX[(unit >> 8) & 0xF], HEX[(unit >> 4) & 0xF], HEX[unit & 0xF]};
+        out.append(buf, 6);
+    }
+
+    // 解码 text[i] 起的一个UTF-8字符，返回其字节数，无效时返回0（与 nlohmann 的校验一致：
+    // 拒绝超长编码、代理区与超出 U+10FFFF 的码点）
+    static size_t decode_utf8(const unsigned char *text, size_t size, size_t i, unsigned int &cp)
+    {
+        unsigned char c = text[i];
+        size_t len;
+        unsigned char lo = 0x80, hi = 0xBF; // 第二个字节的范围
+        if (c >= 0xC2 && c <= 0xDF)
+        {
+            len = 2, cp = c & 0x1F;
+        }
+        else if (c >= 0xE0 && c <= 0xEF)
+        {
+            len = 3, cp = c & 0x0F;
+            lo = c == 0xE0 ? 0xA0 : 0x80;
+            hi = c == 0xED ? 0x9F : 0xBF;
+        }
+        else if (c >= 0xF0 && c <= 0xF4)
+        {
+            len = 4, cp = c & 0x07;
+            lo = c == 0xF0 ? 0x90 : 0x80;
+            hi = c == 0xF4 ? 0x8F : 0xBF;
+        }
+        else
+        {
+            return 0;
+        }
+        if (i + len > size || text[i + 1] < lo || text[i + 1] > hi)
+        {
+            return 0;
+        }
+        for (size_t k = 1; k < len; k++)
+        {
+            if ((text[i + k] & 0xC0) != 0x80)
+            {
+                return 0;
+            }
+            cp = (cp << 6) | (text[i + k] & 0x3F);
+        }
+        return len;
+    }
+
+    void JsonWriter::separator()
+    {
+        if (after_key_)
+        {
+            after_key_ = false;
+            return;
+        }
+        if (depth_ > 0)
+        {
+            uint64_t bit = uint64_t(1) << (depth_ - 1);
+            if (first_ & bit)
+            {
+                first_ &= ~bit;
+            }
+            else
+            {
+                out_ += ',';
+            }
+        }
+    }
+
+    JsonWriter &JsonWriter::begin_object()
+    {
+        separator();
+        out_ += '{';
+        first_ |= uint64_t(1) << depth_++;
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::end_object()
+    {
+        out_ += '}';
+        depth_--;
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::begin_array()
+    {
+        separator();
+        out_ += '[';
+        first_ |= uint64_t(1) << depth_++;
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::end_array()
+    {
+        out_ += ']';
+        depth_--;
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::key(const char *name)
+    {
+        separator();
+        out_ += '"';
+        out_ += name;
+        out_ += "\":";
+        after_key_ = true;
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::value(const char *text)
+    {
+        return string(text, strlen(text));
+    }
+
+    JsonWriter &JsonWriter::value(bool flag)
+    {
+        separator();
+        out_ += flag ? "true" : "false";
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::value(double number)
+    {
+        separator();
+        if (!std::isfinite(number))
+        {
+            out_ += "null";
+            return *this;
+        }
+        char buf[64];
+        char *end = nlohmann::detail::to_chars(buf, buf + sizeof(buf), number);
+        out_.append(buf, end - buf);
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::value(const Quad &box)
+    {
+        begin_array();
+        for (int i = 0; i < 4; i++)
+        {
+            begin_array().value(box[i][0]).value(box[i][1]).end_array();
+        }
+        return end_array();
+    }
+
+    JsonWriter &JsonWriter::raw(const std::string &json)
+    {
+        separator();
+        out_ += json;
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::integer(long long number)
+    {
+        separator();
+        char buf[24];
+        int len = snprintf(buf, sizeof(buf), "%lld", number);
+        out_.append(buf, len);
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::unsigned_integer(unsigned long long number)
+    {
+        separator();
+        char buf[24];
+        int len = snprintf(buf, sizeof(buf), "%llu", number);
+        out_.append(buf, len);
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::string(const char *text, size_t size)
+    {
+        separator();
+        const unsigned char *s = reinterpret_cast<const unsigned char *>(text);
+        out_ += '"';
+        size_t plain = 0; // 无需转义、可原样复制的一段的起点
+        for (size_t i = 0; i < size;)
+        {
+            unsigned char c = s[i];
+            if (c >= 0x20 && c < 0x7F && c != '"' && c != '\\')
+            {
+                i++;
+                continue;
+            }
+            if (c >= 0x80)
+            { // 多字节字符：校验后原样复制，或按 ensure_ascii 转义
+                unsigned int cp;
+                size_t len = decode_utf8(s, size, i, cp);
+                if (len == 0)
+                {
+                    ok_ = false;
+                    return *this;
+                }
+                if (!ensure_ascii_)
+                {
+                    i += len;
+                    continue;
+                }
+                out_.append(text + plain, i - plain);
+                if (cp <= 0xFFFF)
+                {
+                    append_u(out_, cp);
+                }
+                else
+                { // 补充平面：UTF-16代理对
+                    append_u(out_, 0xD7C0u + (cp >> 10));
+                    append_u(out_, 0xDC00u + (cp & 0x3FFu));
+                }
+                i += len;
+                plain = i;
+                continue;
+            }
+            out_.append(text + plain, i - plain);
+            switch (c)
+            {
+            case '\b':
+                out_ += "\\b";
+                break;
+            case '\t':
+                out_ += "\\t";
+                break;
+            case '\n':
+                out_ += "\\n";
+                break;
+            case '\f':
+                out_ += "\\f";
+                break;
+            case '\r':
+                out_ += "\\r";
+                break;
+            case '"':
+                out_ += "\\\"";
+                break;
+            case '\\':
+                out_ += "\\\\";
+                break;
+            default: // 其它控制字符，以及 ensure_ascii 下的 DEL
+                if (c == 0x7F && !ensure_ascii_)
+                {
+                    out_ += char(c);
+                }
+                else
+                {
+                    append_u(out_, c);
+                }
+            }
+            i++;
+            plain = i;
+        }
+        out_.append(text + plain, size - plain);
+        out_ += '"';
+        return *this;
+    }
+
+} // namespace PaddleOCR
@@ -0,0 +1,295 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#include "include/label_table.h"
+#include "include/logger.h"
+#include "include/utility.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace PaddleOCR
+{
+    // 二进制字典的文件头，之后依次为 offsets[count+1]（uint32）与 chars[chars_size]。按本机字节序存放
+    struct LabelTableHeader
+    {
+        char magic[8];         // "PPOCRLBL"
+        uint32_t version;      // 格式版本
+        uint32_t count;        // 标签数
+        uint64_t source_size;  // 编译时文本字典的大小与修改时间，用于判断缓存是否过期；直接给出的 .bin 不检查
+        int64_t source_mtime;
+        uint64_t chars_size;   // UTF-8文本的字节数
+    };
+    static const char LABEL_MAGIC[8] = {'P', 'P', 'O', 'C', 'R', 'L', 'B', 'L'};
+    static const uint32_t LABEL_VERSION = 2; // 2：行尾的 \r 不再计入标签
+
+    static bool ends_with(const std::string &s, const std::string &suffix)
+    {
+        return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    // 文件大小与修改时间（秒），失败时返回false
+    static bool file_stat(const std::string &path, uint64_t &size, int64_t &mtime)
+    {
+#ifdef _WIN32
+        struct _stat64 st;
+        if (_stat64(path.c_str(), &st) != 0)
+            return false;
+#else
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0)
+            return false;
+#endif
+        size = uint64_t(st.st_size);
+        mtime = int64_t(st.st_mtime);
+        return true;
+    }
+
+    // 缓存目录中 .bin 的路径：文件名加上完整路径的散列，不同目录下的同名字典互不覆盖
+    static std::string cache_path(const std::string &cache_dir, const std::string &dict_path)
+    {
+        char hash[24];
+        snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)std::hash<std::string>()(dict_path));
+        return Utility::pathjoin(cache_dir, Utility::basename(dict_path) + "_" + hash + ".bin");
+    }
+
+    LabelTable::~LabelTable()
+    {
+        if (!map_)
+            return;
+#ifdef _WIN32
+        UnmapViewOfFile(map_);
+        CloseHandle((HANDLE)map_handle_);
+#else
+        munmap(map_, map_size_);
+#endif
+    }
+
+    // 按 \n 切分，去掉行尾的 \r（CRLF字典），末尾空行不计，在前后加上CTC空白与空格。
+    // 与 Utility::ReadDict 在Windows上以文本模式读取的结果相同，且不随平台变化
+    std::shared_ptr<LabelTable> LabelTable::parse(const std::string &path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+        {
+            std::cout << "no such label file: " << path << ", exit the program..." << std::endl;
+            exit(1);
+        }
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        const std::string text = buffer.str();
+
+        std::vector<uint32_t> offsets;
+        std::shared_ptr<LabelTable> table(new LabelTable());
+        std::string &chars = table->storage_chars_;
+        chars.reserve(text.size() + 2);
+        offsets.push_back(0);
+        chars += '#'; // blank char for ctc
+        offsets.push_back(uint32_t(chars.size()));
+        size_t pos = 0;
+        while (pos < text.size())
+        {
+            size_t eol = text.find('\n', pos);
+            if (eol == std::string::npos)
+                eol = text.size();
+            size_t end = eol;
+            if (end > pos && text[end - 1] == '\r')
+                end--;
+            chars.append(text, pos, end - pos);
+            offsets.push_back(uint32_t(chars.size()));
+            pos = eol + 1;
+        }
+        chars += ' ';
+        offsets.push_back(uint32_t(chars.size()));
+
+        table->count_ = uint32_t(offsets.size() - 1);
+        table->storage_offsets_.reset(new uint32_t[offsets.size()]);
+        memcpy(table->storage_offsets_.get(), offsets.data(), offsets.size() * sizeof(uint32_t));
+        table->offsets_ = table->storage_offsets_.get();
+        table->chars_ = chars.data();
+        return table;
+    }
+
+    // 映射二进制字典并校验。check_source 为真时文件头中的源文件信息须与给出的一致。失败时返回空
+    std::shared_ptr<LabelTable> LabelTable::map(const std::string &path, uint64_t source_size,
+                                                int64_t source_mtime, bool check_source)
+    {
+        void *addr = nullptr;
+        size_t size = 0;
+        void *handle = nullptr;
+#ifdef _WIN32
+        HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+                                   OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (hFile == INVALID_HANDLE_VALUE)
+            return nullptr;
+        LARGE_INTEGER sz;
+        if (!GetFileSizeEx(hFile, &sz) || sz.QuadPart < (LONGLONG)sizeof(LabelTableHeader))
+        {
+            CloseHandle(hFile);
+            return nullptr;
+        }
+        HANDLE hMap = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+        CloseHandle(hFile); // 映射句柄保有文件
+        addr = hMap ? MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0) : NULL;
+        if (!addr)
+        {
+            if (hMap)
+                CloseHandle(hMap);
+            return nullptr;
+        }
+        size = size_t(sz.QuadPart);
+        handle = hMap;
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return nullptr;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || size_t(st.st_size) < sizeof(LabelTableHeader))
+        {
+            close(fd);
+            return nullptr;
+        }
+        size = size_t(st.st_size);
+        addr = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd); // 映射建立后即可关闭文件描述符
+        if (addr == MAP_FAILED)
+            return nullptr;
+#endif
+        std::shared_ptr<LabelTable> table(new LabelTable());
+        table->map_ = addr; // 之后校验失败时由析构解除映射
+        table->map_size_ = size;
+        table->map_handle_ = handle;
+
+        const char *base = static_cast<const char *>(addr);
+        LabelTableHeader header;
+        memcpy(&header, base, sizeof(header));
+        if (memcmp(header.magic, LABEL_MAGIC, sizeof(LABEL_MAGIC)) != 0 || header.version != LABEL_VERSION ||
+            header.count == 0)
+            return nullptr;
+        if (check_source && (header.source_size != source_size || header.source_mtime != source_mtime))
+            return nullptr; // 源文件已修改
+        uint64_t offsets_bytes = (uint64_t(header.count) + 1) * sizeof(uint32_t);
+        if (uint64_t(size) != sizeof(LabelTableHeader) + offsets_bytes + header.chars_size)
+            return nullptr;
+        const uint32_t *offsets = reinterpret_cast<const uint32_t *>(base + sizeof(LabelTableHeader));
+        if (offsets[0] != 0 || offsets[header.count] != header.chars_size)
+            return nullptr;
+        for (uint32_t i = 0; i < header.count; i++)
+        {
+            if (offsets[i] > offsets[i + 1])
+                return nullptr;
+        }
+        table->count_ = header.count;
+        table->offsets_ = offsets;
+        table->chars_ = base + sizeof(LabelTableHeader) + offsets_bytes;
+        return table;
+    }
+
+    bool LabelTable::compile(const std::string &dict_path, const std::string &bin_path)
+    {
+        LabelTableHeader header;
+        memset(&header, 0, sizeof(header));
+        if (!file_stat(dict_path, header.source_size, header.source_mtime))
+            return false;
+        std::shared_ptr<LabelTable> table = parse(dict_path);
+        memcpy(header.magic, LABEL_MAGIC, sizeof(LABEL_MAGIC));
+        header.version = LABEL_VERSION;
+        header.count = table->count_;
+        header.chars_size = table->storage_chars_.size();
+
+        std::string tmp = bin_path + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out)
+                return false;
+            out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char *>(table->offsets_), (size_t(table->count_) + 1) * sizeof(uint32_t));
+            out.write(table->storage_chars_.data(), table->storage_chars_.size());
+            if (!out.flush())
+            {
+                out.close();
+                std::remove(tmp.c_str());
+                return false;
+            }
+        }
+#ifdef _WIN32
+        std::remove(bin_path.c_str()); // Windows 下 rename 不覆盖已有文件
+#endif
+        if (std::rename(tmp.c_str(), bin_path.c_str()) != 0)
+        {
+            std::remove(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    std::shared_ptr<const LabelTable> LabelTable::load(const std::string &path, const std::string &cache_dir)
+    {
+        uint64_t source_size = 0;
+        int64_t source_mtime = 0;
+        if (!file_stat(path, source_size, source_mtime))
+        {
+            std::cout << "no such label file: " << path << ", exit the program..." << std::endl;
+            exit(1);
+        }
+        // 已加载过且文件未变化时直接共享
+        static std::mutex mutex;
+        static std::map<std::string, std::weak_ptr<const LabelTable>> loaded;
+        std::ostringstream key_stream;
+        key_stream << path << '|' << source_size << '|' << source_mtime;
+        const std::string key = key_stream.str();
+        std::lock_guard<std::mutex> lock(mutex);
+        std::shared_ptr<const LabelTable> table = loaded[key].lock();
+        if (table)
+            return table;
+
+        if (ends_with(path, ".bin"))
+        {
+            table = map(path, 0, 0, false);
+            if (!table)
+            {
+                std::cout << "invalid compiled label file: " << path << ", exit the program..." << std::endl;
+                exit(1);
+            }
+        }
+        else if (!cache_dir.empty())
+        {
+            if (!Utility::PathExists(cache_dir))
+                Utility::CreateDir(cache_dir);
+            std::string bin = cache_path(cache_dir, path);
+            table = map(bin, source_size, source_mtime, true);
+            if (!table && compile(path, bin))
+            {
+                table = map(bin, source_size, source_mtime, true);
+            }
+            if (!table)
+            {
+                OCR_LOG_WARN("Failed to cache compiled label file: " << bin);
+            }
+        }
+        if (!table)
+        {
+            table = parse(path);
+        }
+        loaded[key] = table;
+        return table;
+    }
+
+} // namespace PaddleOCR
@@ -0,0 +1,166 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#include "include/logger.h"
+#include "include/args.h"
+
+#include <chrono>
+#include <ctime>
+#include <iostream>
+
+namespace PaddleOCR
+{
+    static const char *LEVEL_NAMES[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+
+    static LogLevel parse_level(const std::string &name)
+    {
+        if (name == "debug")
+            return LOG_LEVEL_DEBUG;
+        if (name == "warn")
+            return LOG_LEVEL_WARN;
+        if (name == "error")
+            return LOG_LEVEL_ERROR;
+        return LOG_LEVEL_INFO;
+    }
+
+    Logger &Logger::get()
+    {
+        static Logger instance;
+        return instance;
+    }
+
+    Logger::Logger()
+        : level_(parse_level(FLAGS_log_level)), sample_(FLAGS_log_sample > 1 ? FLAGS_log_sample : 1),
+          sample_counter_(0), slots_(new Slot[CAPACITY]), head_(0), dropped_(0), written_(0), stop_(false)
+    {
+        for (size_t i = 0; i < CAPACITY; i++)
+        {
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+        }
+        thread_ = std::thread(&Logger::worker, this);
+    }
+
+    Logger::~Logger()
+    {
+        stop_.store(true);
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+        }
+        wake_cond_.notify_one();
+        thread_.join();
+    }
+
+    bool Logger::sampled()
+    {
+        return sample_ == 1 || sample_counter_.fetch_add(1, std::memory_order_relaxed) % sample_ == 0;
+    }
+
+    // 有界多生产者队列（Vyukov）：生产者以 CAS 抢占位置，槽的序号表明其是否可写
+    void Logger::write(LogLevel level, std::string msg)
+    {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        Slot *slot;
+        while (true)
+        {
+            slot = &slots_[pos & (CAPACITY - 1)];
+            size_t seq = slot->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0)
+            {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0) // 缓冲区满，丢弃
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            else
+            {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+        slot->level = level;
+        slot->time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            std::chrono::system_clock::now().time_since_epoch())
+                            .count();
+        slot->msg.swap(msg);
+        slot->seq.store(pos + 1, std::memory_order_release); // 交给后台线程
+    }
+
+    bool Logger::pop(Slot &out)
+    {
+        Slot &slot = slots_[tail_ & (CAPACITY - 1)];
+        if (slot.seq.load(std::memory_order_acquire) != tail_ + 1)
+        {
+            return false; // 空，或生产者尚未写完
+        }
+        out.level = slot.level;
+        out.time_ms = slot.time_ms;
+        out.msg.swap(slot.msg);
+        slot.msg.clear();
+        slot.seq.store(tail_ + CAPACITY, std::memory_order_release); // 槽可再次写入
+        tail_++;
+        return true;
+    }
+
+    void Logger::worker()
+    {
+        Slot item;
+        std::string batch;
+        uint64_t reported_dropped = 0;
+        while (true)
+        {
+            batch.clear();
+            uint64_t count = 0;
+            while (pop(item))
+            {
+                time_t sec = (time_t)(item.time_ms / 1000);
+                struct tm t;
+#ifdef _WIN32
+                localtime_s(&t, &sec);
+#else
+                localtime_r(&sec, &t);
+#endif
+                char head[48];
+                snprintf(head, sizeof(head), "%02d:%02d:%02d.%03d [%s] ", t.tm_hour, t.tm_min, t.tm_sec,
+                         int(item.time_ms % 1000), LEVEL_NAMES[item.level]);
+                batch += head;
+                batch += item.msg;
+                batch += '\n';
+                count++;
+            }
+            uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+            if (dropped != reported_dropped)
+            {
+                batch += "[log] " + std::to_string(dropped - reported_dropped) + " messages dropped\n";
+                reported_dropped = dropped;
+            }
+            if (!batch.empty())
+            {
+                std::cerr.write(batch.data(), batch.size());
+                std::cerr.flush(); // 每批只刷新一次
+            }
+            written_.fetch_add(count, std::memory_order_release);
+            if (count == 0)
+            {
+                if (stop_.load())
+                    return;
+                std::unique_lock<std::mutex> lock(wake_mutex_);
+                wake_cond_.wait_for(lock, std::chrono::milliseconds(20)); // 生产者不通知，定时轮询
+            }
+        }
+    }
+
+    void Logger::flush()
+    {
+        // 等待后台线程写出当前已放入的所有日志（被丢弃的不占位置）
+        uint64_t target = head_.load(std::memory_order_acquire);
+        while (written_.load(std::memory_order_acquire) < target)
+        {
+            wake_cond_.notify_one();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+} // namespace PaddleOCR
@@ -19,6 +19,7 @@
 #include "opencv2/core.hpp"
 #include "opencv2/imgcodecs.hpp"
 #include "opencv2/imgproc.hpp"
+#include <cstdio>
 #include <iostream>
 #include <vector>
 
@@ -27,6 +28,8 @@
 #include <include/paddlestructure.h>
 #include <include/task.h>
 #include <include/http_server.h>
+#include <include/router.h>
+#include <include/supervisor.h>
 
 using namespace PaddleOCR;
 
@@ -96,12 +99,38 @@ void structure(std::vector<cv::String> &cv_all_img_names)
     }
 }
 
+// 采集TensorRT动态形状文件：删除旧文件后以合成输入覆盖各形状，引擎析构时由推理库写出新文件
+int calibrate()
+{
+    const char *shape_files[] = {"./trt_det_shape.txt", "./trt_rec_shape.txt", "./trt_cls_shape.txt"};
+    for (int i = 0; i < 3; i++)
+    {
+        if (Utility::PathExists(shape_files[i]))
+        {
+            std::remove(shape_files[i]);
+        }
+    }
+    {
+        PPOCR engine;
+        engine.warmup();
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        if (Utility::PathExists(shape_files[i]))
+        {
+            std::cout << "Shape range saved: " << shape_files[i] << std::endl;
+        }
+    }
+    return 0;
+}
+
 int main(int argc, char **argv)
 {
     std::cout << PROJECT_NAME << std::endl; // 版本提示
     // 设置gflags并读取命令行
     google::SetUsageMessage("PaddleOCR-json [FLAG1=ARG1] [FLAG2=ARG2]");
     google::SetVersionString(PROJECT_VER);
+    std::vector<std::string> args(argv + 1, argv + argc); // 原始参数，供多进程隔离模式启动工作进程
     google::ParseCommandLineFlags(&argc, &argv, true);
     // 读取配置文件
     std::string configMsg = read_config();
@@ -117,6 +146,28 @@ int main(int argc, char **argv)
         return 1;
     }
 
+    // 采集TensorRT形状文件后退出
+    if (FLAGS_calibrate)
+    {
+        return calibrate();
+    }
+
+    // 集群路由：不加载模型，转发给 --router 中的服务器
+    if (!FLAGS_router.empty())
+    {
+        Router router(FLAGS_server_port, FLAGS_router);
+        return router.run();
+    }
+
+    // 多进程隔离的HTTP服务器：本进程只监听，工作进程以相同参数的匿名管道模式运行（后出现的参数优先）
+    if (FLAGS_server && FLAGS_supervisor > 0)
+    {
+        const char *overrides[] = {"--server=false", "--supervisor=0", "--port=-1", "--image_path=", "--video=", "--batch="};
+        args.insert(args.end(), overrides, overrides + 6);
+        Supervisor supervisor(FLAGS_server_port, FLAGS_supervisor, args);
+        return supervisor.run();
+    }
+
     // 检查是否启用HTTP服务器模式
     if (FLAGS_server)
     {
@@ -127,15 +178,7 @@ int main(int argc, char **argv)
     }
 
     // 启动任务
-    Task task = Task();
-    if (FLAGS_type == "ocr")
-    { // OCR图片模式
-        return task.ocr();
-    }
-    // TODO: 图表识别模式
-    else if (FLAGS_type == "structure")
-    {
-        std::cerr << "[ERROR] structure not support. " << std::endl;
-        // structure(cv_all_img_names);
-    }
+    // OCR图片模式；type=structure 时为版面与表格识别模式，各种输入方式与OCR相同
+    Task task;
+    return task.ocr();
 }
@@ -0,0 +1,101 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#include "include/memory_governor.h"
+#include "include/args.h"
+#include "include/logger.h"
+#include "include/task.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace PaddleOCR
+{
+    // 两次轮询之间上涨超过该值（MB）时，记录最大输入形状
+    static const int GROWTH_LOG_MB = 100;
+
+    MemoryGovernor::MemoryGovernor(int engines, const ReleaseIdle &release_idle, const Report &report)
+        : engines_(engines), high_mb_(FLAGS_cpu_mem), release_idle_(release_idle), report_(report)
+    {
+        low_mb_ = FLAGS_cpu_mem_low > 0 ? FLAGS_cpu_mem_low : high_mb_ * 4 / 5;
+        thread_ = std::thread(&MemoryGovernor::loop, this);
+    }
+
+    MemoryGovernor::~MemoryGovernor()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cond_.notify_all();
+        thread_.join();
+    }
+
+    bool MemoryGovernor::admit(const cv::Mat &img)
+    {
+        return FLAGS_max_image_pixels <= 0 || img.total() <= size_t(FLAGS_max_image_pixels);
+    }
+
+    void MemoryGovernor::loop()
+    {
+        int last = Task::get_memory_mb(); // 上次轮询时的内存占用
+        int rearm = 0;                    // 放弃一轮清理后，再次触发所需的内存占用
+        bool shrinking = false;           // 是否处于清理中（高于高水位后、降到低水位前）
+        std::vector<bool> released;       // 本轮清理中各引擎是否已释放
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop_)
+        {
+            cond_.wait_for(lock, std::chrono::milliseconds(FLAGS_memory_poll_ms), [this]
+                           { return stop_; });
+            if (stop_)
+            {
+                break;
+            }
+            lock.unlock();
+            int mem = Task::get_memory_mb();
+            if (mem > 0)
+            {
+                if (last > 0 && mem - last >= GROWTH_LOG_MB)
+                {
+                    OCR_LOG_INFO("memory grew " << last << "->" << mem << "MB, largest inputs: " << report_());
+                }
+                last = mem;
+                if (mem <= low_mb_)
+                {
+                    rearm = 0;
+                }
+                if (!shrinking && mem >= std::max(high_mb_, rearm))
+                {
+                    OCR_LOG_INFO("memory " << mem << "MB reached " << high_mb_ << "MB, largest inputs: " << report_());
+                    shrinking = true;
+                    released.assign(engines_, false);
+                }
+                if (shrinking)
+                {
+                    auto cleanup_start = std::chrono::steady_clock::now();
+                    int count = release_idle_(released); // 忙碌的引擎留到下次轮询
+                    if (count > 0)
+                    {
+                        std::chrono::duration<double> duration = std::chrono::steady_clock::now() - cleanup_start;
+                        int mem2 = Task::get_memory_mb();
+                        OCR_LOG_INFO("memory cleanup (" << count << " engines): " << mem << "->" << mem2
+                                                        << "MB, time: " << duration.count() << "s");
+                        last = mem2 > 0 ? mem2 : mem;
+                    }
+                    if (last <= low_mb_)
+                    {
+                        shrinking = false;
+                    }
+                    else if (std::find(released.begin(), released.end(), false) == released.end())
+                    { // 已全部清理仍高于低水位，上涨超过水位差前不再触发
+                        OCR_LOG_WARN("memory " << last << "MB still above " << low_mb_ << "MB after releasing all engines");
+                        shrinking = false;
+                        rearm = last + (high_mb_ - low_mb_);
+                    }
+                }
+            }
+            lock.lock();
+        }
+    }
+
+} // namespace PaddleOCR
@@ -0,0 +1,158 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#include "include/metrics.h"
+
+#include <cstdio>
+
+namespace PaddleOCR
+{
+    // 阶段耗时的分桶上界，单位毫秒（输出时换算为秒）
+    static const double STAGE_BOUNDS[] = {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000};
+    // 每图文本框数的分桶上界
+    static const double BOX_BOUNDS[] = {0, 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000};
+
+    static const char *STAGE_NAMES[Metrics::STAGE_COUNT] = {
+        "decode", "det_pre", "det_infer", "det_post", "crop", "cls",
+        "rec_pre", "rec_infer", "rec_post", "json_encode"};
+
+    static std::string fmt_double(double v)
+    {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.6g", v);
+        return buf;
+    }
+
+    // ==================== 直方图 ====================
+
+    Histogram::Histogram(const double *bounds, int count)
+        : bounds_(bounds), count_(count < MAX_BUCKETS ? count : MAX_BUCKETS), sum_(0), total_(0)
+    {
+        for (int i = 0; i <= MAX_BUCKETS; i++)
+        {
+            buckets_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void Histogram::observe(double value)
+    {
+        int i = 0;
+        while (i < count_ && value > bounds_[i])
+        {
+            i++;
+        }
+        buckets_[i < count_ ? i : MAX_BUCKETS].fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(uint64_t(value > 0 ? value * 1000 : 0), std::memory_order_relaxed);
+        total_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Histogram::render(std::string &out, const std::string &name, const std::string &labels,
+                           double scale) const
+    {
+        std::string prefix = labels.empty() ? "" : labels + ",";
+        uint64_t cumulative = 0;
+        for (int i = 0; i < count_; i++)
+        {
+            cumulative += buckets_[i].load(std::memory_order_relaxed);
+            out += name + "_bucket{" + prefix + "le=\"" + fmt_double(bounds_[i] * scale) + "\"} " +
+                   std::to_string(cumulative) + "\n";
+        }
+        cumulative += buckets_[MAX_BUCKETS].load(std::memory_order_relaxed);
+        out += name + "_bucket{" + prefix + "le=\"+Inf\"} " + std::to_string(cumulative) + "\n";
+        std::string braces = labels.empty() ? "" : "{" + labels + "}";
+        out += name + "_sum" + braces + " " +
+               fmt_double(sum_.load(std::memory_order_relaxed) / 1000.0 * scale) + "\n";
+        out += name + "_count" + braces + " " + std::to_string(total_.load(std::memory_order_relaxed)) + "\n";
+    }
+
+    // ==================== 指标 ====================
+
+    Metrics &Metrics::get()
+    {
+        static Metrics instance;
+        return instance;
+    }
+
+    Metrics::Metrics() : boxes_(BOX_BOUNDS, sizeof(BOX_BOUNDS) / sizeof(BOX_BOUNDS[0])), sampling_(false)
+    {
+        for (int i = 0; i < STAGE_COUNT; i++)
+        {
+            stages_[i] = new Histogram(STAGE_BOUNDS, sizeof(STAGE_BOUNDS) / sizeof(STAGE_BOUNDS[0]));
+        }
+        for (int i = 0; i < 600; i++)
+        {
+            requests_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    Metrics::~Metrics()
+    {
+        for (int i = 0; i < STAGE_COUNT; i++)
+        {
+            delete stages_[i];
+        }
+    }
+
+    void Metrics::count_request(int status)
+    {
+        if (status >= 0 && status < 600)
+        {
+            requests_[status].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void Metrics::set_sampling(bool on)
+    {
+        std::lock_guard<std::mutex> lock(samples_mutex_);
+        for (int i = 0; i < STAGE_COUNT; i++)
+        {
+            std::vector<double>().swap(samples_[i]);
+        }
+        sampling_.store(on, std::memory_order_relaxed);
+    }
+
+    void Metrics::record_sample(Stage stage, double ms)
+    {
+        std::lock_guard<std::mutex> lock(samples_mutex_);
+        samples_[stage].push_back(ms);
+    }
+
+    std::vector<double> Metrics::samples(Stage stage) const
+    {
+        std::lock_guard<std::mutex> lock(samples_mutex_);
+        return samples_[stage];
+    }
+
+    const char *Metrics::stage_name(Stage stage)
+    {
+        return STAGE_NAMES[stage];
+    }
+
+    std::string Metrics::render() const
+    {
+        std::string out;
+        out += "# HELP paddleocr_stage_duration_seconds Time spent in each OCR stage.\n";
+        out += "# TYPE paddleocr_stage_duration_seconds histogram\n";
+        for (int i = 0; i < STAGE_COUNT; i++)
+        {
+            stages_[i]->render(out, "paddleocr_stage_duration_seconds",
+                               std::string("stage=\"") + STAGE_NAMES[i] + "\"", 0.001);
+        }
+        out += "# HELP paddleocr_boxes_per_image Text boxes detected per image.\n";
+        out += "# TYPE paddleocr_boxes_per_image histogram\n";
+        boxes_.render(out, "paddleocr_boxes_per_image", "");
+        out += "# HELP paddleocr_http_requests_total HTTP requests by status code.\n";
+        out += "# TYPE paddleocr_http_requests_total counter\n";
+        for (int i = 0; i < 600; i++)
+        {
+            uint64_t n = requests_[i].load(std::memory_order_relaxed);
+            if (n > 0)
+            {
+                out += "paddleocr_http_requests_total{status=\"" + std::to_string(i) + "\"} " +
+                       std::to_string(n) + "\n";
+            }
+        }
+        return out;
+    }
+
+} // namespace PaddleOCR
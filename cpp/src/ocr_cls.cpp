@@ -14,6 +14,8 @@
 
 #include <include/ocr_cls.h>
 
+#include <future>
+
 namespace PaddleOCR
 {
 
@@ -28,58 +30,45 @@ namespace PaddleOCR
 
         int img_num = img_list.size();
         std::vector<int> cls_image_shape = {3, 48, 192};
-        for (int beg_img_no = 0; beg_img_no < img_num;
-             beg_img_no += this->cls_batch_num_)
+        InferTensor *input_t = this->predictor_->Input(0);
+
+        // 预处理从 beg_img_no 开始的一批。slot < 0 时写入输入张量（CPU下零拷贝），
+        // 否则写入第 slot 个中转缓冲区，此时可在其他线程中执行
+        auto preprocess = [&](int beg_img_no, int slot)
         {
             auto preprocess_start = std::chrono::steady_clock::now();
             int end_img_no = std::min(img_num, beg_img_no + this->cls_batch_num_);
             int batch_num = end_img_no - beg_img_no;
             // preprocess
-            std::vector<cv::Mat> norm_img_batch;
+            // 归一化后的图片直接写入输入缓冲区，右侧不足宽度的部分保持为0
+            int image_size = cls_image_shape[0] * cls_image_shape[1] * cls_image_shape[2];
+            std::vector<int> shape = {batch_num, cls_image_shape[0], cls_image_shape[1], cls_image_shape[2]};
+            float *input = slot < 0 ? this->arena_.Input(input_t, shape, !this->use_gpu_)
+                                    : this->arena_.Stage(slot, shape);
             for (int ino = beg_img_no; ino < end_img_no; ino++)
             {
-                cv::Mat srcimg;
-                img_list[ino].copyTo(srcimg);
                 cv::Mat resize_img;
-                this->resize_op_.Run(srcimg, resize_img, this->use_tensorrt_,
+                this->resize_op_.Run(img_list[ino], resize_img, this->use_tensorrt_,
                                      cls_image_shape);
-
-                this->normalize_op_.Run(&resize_img, this->mean_, this->scale_,
-                                        this->is_scale_);
-                if (resize_img.cols < cls_image_shape[2])
-                {
-                    cv::copyMakeBorder(resize_img, resize_img, 0, 0, 0,
-                                       cls_image_shape[2] - resize_img.cols,
-                                       cv::BORDER_CONSTANT, cv::Scalar(0, 0, 0));
-                }
-                norm_img_batch.push_back(resize_img);
+                this->norm_permute_op_.Run(resize_img,
+                                           input + (ino - beg_img_no) * image_size,
+                                           cls_image_shape[1], cls_image_shape[2],
+                                           this->mean_, this->scale_, this->is_scale_);
             }
-            std::vector<float> input(batch_num * cls_image_shape[0] *
-                                         cls_image_shape[1] * cls_image_shape[2],
-                                     0.0f);
-            this->permute_op_.Run(norm_img_batch, input.data());
             auto preprocess_end = std::chrono::steady_clock::now();
-            preprocess_diff += preprocess_end - preprocess_start;
+            preprocess_diff += preprocess_end - preprocess_start; // 同一时刻只有一批在预处理
+        };
 
-            // inference.
-            auto input_names = this->predictor_->GetInputNames();
-            auto input_t = this->predictor_->GetInputHandle(input_names[0]);
-            input_t->Reshape({batch_num, cls_image_shape[0], cls_image_shape[1],
-                              cls_image_shape[2]});
-            auto inference_start = std::chrono::steady_clock::now();
-            input_t->CopyFromCpu(input.data());
+        // 推理已提交输入的一批并取分类结果
+        auto infer = [&](int beg_img_no, const std::chrono::steady_clock::time_point &inference_start)
+        {
             this->predictor_->Run();
 
-            std::vector<float> predict_batch;
-            auto output_names = this->predictor_->GetOutputNames();
-            auto output_t = this->predictor_->GetOutputHandle(output_names[0]);
+            InferTensor *output_t = this->predictor_->Output(0);
             auto predict_shape = output_t->shape();
 
-            int out_num = std::accumulate(predict_shape.begin(), predict_shape.end(), 1,
-                                          std::multiplies<int>());
-            predict_batch.resize(out_num);
-
-            output_t->CopyToCpu(predict_batch.data());
+            int out_num = 0;
+            const float *predict_batch = this->arena_.Output(output_t, out_num);
             auto inference_end = std::chrono::steady_clock::now();
             inference_diff += inference_end - inference_start;
 
@@ -98,67 +87,73 @@ namespace PaddleOCR
             }
             auto postprocess_end = std::chrono::steady_clock::now();
             postprocess_diff += postprocess_end - postprocess_start;
-        }
-        times.push_back(double(preprocess_diff.count() * 1000));
-        times.push_back(double(inference_diff.count() * 1000));
-        times.push_back(double(postprocess_diff.count() * 1000));
-    }
-
-    void Classifier::LoadModel(const std::string &model_dir)
-    {
-        paddle_infer::Config config;
-        config.SetModel(model_dir + "/inference.pdmodel",
-                        model_dir + "/inference.pdiparams");
+        };
 
-        if (this->use_gpu_)
-        {
-            config.EnableUseGpu(this->gpu_mem_, this->gpu_id_);
-            if (this->use_tensorrt_)
+        if (this->gpu_pipeline_ && img_num > 0)
+        { // 双缓冲：第k批提交到设备后，在后台线程预处理第k+1批，与第k批的推理重叠
+            int slot = 0;
+            preprocess(0, slot);
+            for (int beg_img_no = 0; beg_img_no < img_num; beg_img_no += this->cls_batch_num_)
             {
-                auto precision = paddle_infer::Config::Precision::kFloat32;
-                if (this->precision_ == "fp16")
+                auto inference_start = std::chrono::steady_clock::now();
+                this->arena_.Commit(input_t, slot);
+                slot ^= 1;
+                std::future<void> next;
+                if (beg_img_no + this->cls_batch_num_ < img_num)
                 {
-                    precision = paddle_infer::Config::Precision::kHalf;
+                    next = std::async(std::launch::async, preprocess, beg_img_no + this->cls_batch_num_, slot);
                 }
-                if (this->precision_ == "int8")
+                infer(beg_img_no, inference_start);
+                if (next.valid())
                 {
-                    precision = paddle_infer::Config::Precision::kInt8;
-                }
-                config.EnableTensorRtEngine(1 << 20, 10, 3, precision, false, false);
-                if (!Utility::PathExists("./trt_cls_shape.txt"))
-                {
-                    config.CollectShapeRangeInfo("./trt_cls_shape.txt");
-                }
-                else
-                {
-                    config.EnableTunedTensorRtDynamicShape("./trt_cls_shape.txt", true);
+                    next.get();
                 }
             }
         }
         else
         {
-            config.DisableGpu();
-            if (this->use_mkldnn_)
-            {
-                config.EnableMKLDNN();
-            }
-            else
+            for (int beg_img_no = 0; beg_img_no < img_num;
+                 beg_img_no += this->cls_batch_num_)
             {
-                config.DisableMKLDNN();
+                preprocess(beg_img_no, -1);
+                // inference.
+                auto inference_start = std::chrono::steady_clock::now();
+                this->arena_.CommitInput(input_t);
+                infer(beg_img_no, inference_start);
             }
-            config.SetCpuMathLibraryNumThreads(this->cpu_math_library_num_threads_);
         }
+        times.push_back(double(preprocess_diff.count() * 1000));
+        times.push_back(double(inference_diff.count() * 1000));
+        times.push_back(double(postprocess_diff.count() * 1000));
+    }
 
-        // false for zero copy tensor
-        config.SwitchUseFeedFetchOps(false);
-        // true for multiple input
-        config.SwitchSpecifyInputNames(true);
-
-        config.SwitchIrOptim(true);
-
-        config.EnableMemoryOptim();
-        config.DisableGlogInfo();
+    void Classifier::LoadModel(const std::string &model_dir)
+    {
+        PredictorOptions options;
+        options.backend = this->backend_;
+        options.model_dir = model_dir;
+        options.use_gpu = this->use_gpu_;
+        options.gpu_id = this->gpu_id_;
+        options.gpu_mem = this->gpu_mem_;
+        options.cpu_threads = this->cpu_math_library_num_threads_;
+        options.use_mkldnn = this->use_mkldnn_;
+        options.precision = this->precision_;
+        options.use_tensorrt = this->use_tensorrt_;
+        options.trt_workspace = 1 << 20;
+        options.trt_max_batch = 10;
+        options.trt_min_subgraph = 3;
+        options.trt_shape_file = "./trt_cls_shape.txt";
+        options.optim_cache_dir = this->optim_cache_dir_;
+        this->stream_ = CreateInferStream(this->use_gpu_ && this->gpu_pipeline_, options);
+        this->predictor_ = Predictor::Create(options);
+    }
 
-        this->predictor_ = paddle_infer::CreatePredictor(config);
+    Classifier *Classifier::Clone() const
+    {
+        Classifier *other = new Classifier(*this); // 复制参数与前后处理算子
+        // 推理实例的 Clone 共享权重，只新建中间张量等推理状态
+        other->predictor_ = ClonePredictor(this->predictor_, this->stream_, other->stream_);
+        return other;
     }
+
 } // namespace PaddleOCR
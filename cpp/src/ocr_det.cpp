@@ -19,105 +19,132 @@ namespace PaddleOCR
 
     void DBDetector::LoadModel(const std::string &model_dir)
     {
-        //   AnalysisConfig config;
-        paddle_infer::Config config;
-        config.SetModel(model_dir + "/inference.pdmodel",
-                        model_dir + "/inference.pdiparams");
+        PredictorOptions options;
+        options.backend = this->backend_;
+        options.model_dir = model_dir;
+        options.use_gpu = this->use_gpu_;
+        options.gpu_id = this->gpu_id_;
+        options.gpu_mem = this->gpu_mem_;
+        options.cpu_threads = this->cpu_math_library_num_threads_;
+        options.use_mkldnn = this->use_mkldnn_;
+        // cache 10 different shapes for mkldnn to avoid memory leak
+        options.mkldnn_cache_capacity = 10;
+        options.precision = this->precision_;
+        options.use_tensorrt = this->use_tensorrt_;
+        options.trt_workspace = 1 << 30;
+        options.trt_max_batch = 1;
+        options.trt_min_subgraph = 20;
+        options.trt_shape_file = "./trt_det_shape.txt";
+        options.optim_cache_dir = this->optim_cache_dir_;
+        // GPU前后处理的核函数也在独占的流上，与推理按顺序执行
+        this->stream_ = CreateInferStream(this->use_gpu_ && (this->gpu_pipeline_ || this->gpu_preprocess_), options);
 
-        if (this->use_gpu_)
+        this->predictor_ = Predictor::Create(options);
+        if (this->gpu_preprocess_ && this->stream_)
         {
-            config.EnableUseGpu(this->gpu_mem_, this->gpu_id_);
-            if (this->use_tensorrt_)
-            {
-                auto precision = paddle_infer::Config::Precision::kFloat32;
-                if (this->precision_ == "fp16")
-                {
-                    precision = paddle_infer::Config::Precision::kHalf;
-                }
-                if (this->precision_ == "int8")
-                {
-                    precision = paddle_infer::Config::Precision::kInt8;
-                }
-                config.EnableTensorRtEngine(1 << 30, 1, 20, precision, false, false);
-                if (!Utility::PathExists("./trt_det_shape.txt"))
-                {
-                    config.CollectShapeRangeInfo("./trt_det_shape.txt");
-                }
-                else
-                {
-                    config.EnableTunedTensorRtDynamicShape("./trt_det_shape.txt", true);
-                }
-            }
+            this->cuda_ops_.reset(new DetCudaOps(this->stream_.get()));
         }
-        else
+    }
+
+    void DBDetector::ReleaseDevice()
+    {
+        if (this->cuda_ops_)
         {
-            config.DisableGpu();
-            if (this->use_mkldnn_)
-            {
-                config.EnableMKLDNN();
-                // cache 10 different shapes for mkldnn to avoid memory leak
-                config.SetMkldnnCacheCapacity(10);
-            }
-            else
-            {
-                config.DisableMKLDNN();
-            }
-            config.SetCpuMathLibraryNumThreads(this->cpu_math_library_num_threads_);
+            this->cuda_ops_->Release();
         }
-        // use zero_copy_run as default
-        config.SwitchUseFeedFetchOps(false);
-        // true for multiple input
-        config.SwitchSpecifyInputNames(true);
+    }
 
-        config.SwitchIrOptim(true);
+    DBDetector::Params DBDetector::ResolveParams(const OCROptions *options) const
+    {
+        Params p = {this->limit_type_, this->limit_side_len_, this->det_db_thresh_,
+                    this->det_db_box_thresh_, this->det_db_unclip_ratio_, this->det_db_score_mode_};
+        if (options)
+        {
+            if (!options->limit_type.empty())
+                p.limit_type = options->limit_type;
+            if (options->limit_side_len > 0)
+                p.limit_side_len = options->limit_side_len;
+            if (options->det_db_thresh >= 0)
+                p.db_thresh = options->det_db_thresh;
+            if (options->det_db_box_thresh >= 0)
+                p.db_box_thresh = options->det_db_box_thresh;
+            if (options->det_db_unclip_ratio > 0)
+                p.db_unclip_ratio = options->det_db_unclip_ratio;
+            if (!options->det_db_score_mode.empty())
+                p.db_score_mode = options->det_db_score_mode;
+        }
+        return p;
+    }
 
-        config.EnableMemoryOptim();
-        config.DisableGlogInfo();
+    void DBDetector::Run(cv::Mat &img,
+                         std::vector<Quad> &boxes,
+                         std::vector<double> &times,
+                         const OCROptions *options)
+    {
+        Params params = ResolveParams(options);
+        // 请求明确开关时以请求为准；否则请求指定了尺寸限制时按该限制做一次检测
+        bool adaptive = (options && options->det_adaptive >= 0)
+                            ? options->det_adaptive > 0
+                            : this->adaptive_ && !(options && (options->limit_side_len > 0 || !options->limit_type.empty()));
+        if (adaptive)
+        {
+            RunAdaptive(img, params, boxes, times);
+            return;
+        }
+        if (this->det_tile_size_ > 0 &&
+            std::max(img.rows, img.cols) > this->det_tile_size_)
+        {
+            RunTiled(img, params, boxes, times);
+            return;
+        }
+        RunImage(img, params, boxes, times);
+    }
 
-        this->predictor_ = paddle_infer::CreatePredictor(config);
+    void DBDetector::SetAdaptive(bool enabled, int low_side, int text_px, int max_side, bool roi)
+    {
+        this->adaptive_ = enabled;
+        this->adaptive_side_ = low_side;
+        this->adaptive_text_px_ = text_px;
+        this->adaptive_max_side_ = max_side;
+        this->adaptive_roi_ = roi;
     }
 
-    void DBDetector::Run(cv::Mat &img,
-                         std::vector<std::vector<std::vector<int>>> &boxes,
-                         std::vector<double> &times)
+    void DBDetector::RunImage(const cv::Mat &img, const Params &params, std::vector<Quad> &boxes,
+                              std::vector<double> &times)
     {
+        if (this->cuda_ops_ && img.type() == CV_8UC3)
+        {
+            RunImageDevice(img, params, boxes, times);
+            return;
+        }
         float ratio_h{};
         float ratio_w{};
 
-        cv::Mat srcimg;
         cv::Mat resize_img;
-        img.copyTo(srcimg);
 
         auto preprocess_start = std::chrono::steady_clock::now();
-        this->resize_op_.Run(img, resize_img, this->limit_type_,
-                             this->limit_side_len_, ratio_h, ratio_w,
-                             this->use_tensorrt_);
-
-        this->normalize_op_.Run(&resize_img, this->mean_, this->scale_,
-                                this->is_scale_);
+        this->resize_op_.Run(img, resize_img, params.limit_type, params.limit_side_len,
+                             ratio_h, ratio_w, this->use_tensorrt_);
 
-        std::vector<float> input(1 * 3 * resize_img.rows * resize_img.cols, 0.0f);
-        this->permute_op_.Run(&resize_img, input.data());
+        // 归一化结果直接写入输入张量（CPU）或复用的主机缓冲区（GPU）
+        InferTensor *input_t = this->predictor_->Input(0);
+        float *input = this->arena_.Input(input_t, {1, 3, resize_img.rows, resize_img.cols},
+                                          !this->use_gpu_);
+        this->norm_permute_op_.Run(resize_img, input, resize_img.rows,
+                                   resize_img.cols, this->mean_, this->scale_,
+                                   this->is_scale_);
         auto preprocess_end = std::chrono::steady_clock::now();
 
         // Inference.
-        auto input_names = this->predictor_->GetInputNames();
-        auto input_t = this->predictor_->GetInputHandle(input_names[0]);
-        input_t->Reshape({1, 3, resize_img.rows, resize_img.cols});
         auto inference_start = std::chrono::steady_clock::now();
-        input_t->CopyFromCpu(input.data());
+        this->arena_.CommitInput(input_t);
 
         this->predictor_->Run();
 
-        std::vector<float> out_data;
-        auto output_names = this->predictor_->GetOutputNames();
-        auto output_t = this->predictor_->GetOutputHandle(output_names[0]);
+        InferTensor *output_t = this->predictor_->Output(0);
         std::vector<int> output_shape = output_t->shape();
-        int out_num = std::accumulate(output_shape.begin(), output_shape.end(), 1,
-                                      std::multiplies<int>());
-
-        out_data.resize(out_num);
-        output_t->CopyToCpu(out_data.data());
+        int out_num = 0;
+        const float *out_data = this->arena_.Output(output_t, out_num);
         auto inference_end = std::chrono::steady_clock::now();
 
         auto postprocess_start = std::chrono::steady_clock::now();
@@ -125,22 +152,78 @@ namespace PaddleOCR
         int n3 = output_shape[3];
         int n = n2 * n3;
 
-        std::vector<float> pred(n, 0.0);
-        std::vector<unsigned char> cbuf(n, ' ');
-
-        for (int i = 0; i < n; i++)
+        // 概率图直接引用输出数据，一次遍历二值化到复用的临时缓冲区
+        cv::Mat pred_map(n2, n3, CV_32F, (float *)out_data);
+        cv::Mat bit_map;
+        post_processor_.Binarize(pred_map, params.db_thresh,
+                                 this->arena_.Scratch(n), bit_map);
+        if (this->use_dilation_)
         {
-            pred[i] = float(out_data[i]);
-            cbuf[i] = (unsigned char)((out_data[i]) * 255);
+            cv::Mat dila_ele =
+                cv::getStructuringElement(cv::MORPH_RECT, cv::Size(2, 2));
+            cv::dilate(bit_map, bit_map, dila_ele);
         }
 
-        cv::Mat cbuf_map(n2, n3, CV_8UC1, (unsigned char *)cbuf.data());
-        cv::Mat pred_map(n2, n3, CV_32F, (float *)pred.data());
+        boxes = post_processor_.BoxesFromBitmap(
+            pred_map, bit_map, params.db_box_thresh, params.db_unclip_ratio,
+            params.db_score_mode, this->det_postprocess_threads_);
+
+        boxes = post_processor_.FilterTagDetRes(boxes, ratio_h, ratio_w, img);
+        auto postprocess_end = std::chrono::steady_clock::now();
+
+        std::chrono::duration<float> preprocess_diff =
+            preprocess_end - preprocess_start;
+        times.push_back(double(preprocess_diff.count() * 1000));
+        std::chrono::duration<float> inference_diff = inference_end - inference_start;
+        times.push_back(double(inference_diff.count() * 1000));
+        std::chrono::duration<float> postprocess_diff =
+            postprocess_end - postprocess_start;
+        times.push_back(double(postprocess_diff.count() * 1000));
+    }
+
+    void DBDetector::RunImageDevice(const cv::Mat &img, const Params &params, std::vector<Quad> &boxes,
+                                    std::vector<double> &times)
+    {
+        auto preprocess_start = std::chrono::steady_clock::now();
+        int resize_h, resize_w;
+        ResizeImgType0::TargetSize(img.rows, img.cols, params.limit_type, params.limit_side_len, resize_h, resize_w);
+        float ratio_h = float(resize_h) / float(img.rows);
+        float ratio_w = float(resize_w) / float(img.cols);
+
+        // 原图只上传一次，缩放与归一化的结果留在设备上，直接作为输入张量
+        std::vector<int> shape = {1, 3, resize_h, resize_w};
+        float *input = this->cuda_ops_->Preprocess(img, resize_h, resize_w, this->mean_, this->scale_,
+                                                   this->is_scale_);
+        this->predictor_->Input(0)->ShareDeviceData(input, shape);
+        this->arena_.Track(shape, size_t(3) * resize_h * resize_w);
+        auto preprocess_end = std::chrono::steady_clock::now();
+
+        // Inference.
+        auto inference_start = std::chrono::steady_clock::now();
+        this->predictor_->Run();
+
+        InferTensor *output_t = this->predictor_->Output(0);
+        std::vector<int> output_shape = output_t->shape();
+        int out_num = 0;
+        const float *out_data = output_t->DeviceData(out_num);
+        auto inference_end = std::chrono::steady_clock::now();
 
-        const double threshold = this->det_db_thresh_ * 255;
-        const double maxvalue = 255;
+        auto postprocess_start = std::chrono::steady_clock::now();
+        int n2 = output_shape[2];
+        int n3 = output_shape[3];
+        cv::Mat pred_map; // 框打分用的概率图：GPU二值化时为8位，否则为主机上的 float
         cv::Mat bit_map;
-        cv::threshold(cbuf_map, bit_map, threshold, maxvalue, cv::THRESH_BINARY);
+        if (out_data)
+        {
+            this->cuda_ops_->Threshold(out_data, n2, n3, params.db_thresh, bit_map, pred_map);
+        }
+        else
+        {
+            out_data = this->arena_.Output(output_t, out_num);
+            pred_map = cv::Mat(n2, n3, CV_32F, (float *)out_data);
+            post_processor_.Binarize(pred_map, params.db_thresh,
+                                     this->arena_.Scratch(size_t(n2) * n3), bit_map);
+        }
         if (this->use_dilation_)
         {
             cv::Mat dila_ele =
@@ -149,10 +232,10 @@ namespace PaddleOCR
         }
 
         boxes = post_processor_.BoxesFromBitmap(
-            pred_map, bit_map, this->det_db_box_thresh_, this->det_db_unclip_ratio_,
-            this->det_db_score_mode_);
+            pred_map, bit_map, params.db_box_thresh, params.db_unclip_ratio,
+            params.db_score_mode, this->det_postprocess_threads_);
 
-        boxes = post_processor_.FilterTagDetRes(boxes, ratio_h, ratio_w, srcimg);
+        boxes = post_processor_.FilterTagDetRes(boxes, ratio_h, ratio_w, img);
         auto postprocess_end = std::chrono::steady_clock::now();
 
         std::chrono::duration<float> preprocess_diff =
@@ -165,4 +248,326 @@ namespace PaddleOCR
         times.push_back(double(postprocess_diff.count() * 1000));
     }
 
+    // 一个方向上各块的起点。最后一块贴齐边缘，使所有块尺寸相同，推理库只见到一种输入形状
+    static std::vector<int> TileStarts(int length, int tile, int stride)
+    {
+        std::vector<int> starts(1, 0);
+        if (length <= tile)
+            return starts;
+        while (starts.back() + tile < length)
+        {
+            starts.push_back(std::min(starts.back() + stride, length - tile));
+        }
+        return starts;
+    }
+
+    void DBDetector::RunTiled(const cv::Mat &img, const Params &params, std::vector<Quad> &boxes,
+                              std::vector<double> &times)
+    {
+        const int tile = this->det_tile_size_;
+        const int stride = tile - this->det_tile_overlap_;
+        Params tile_params = params; // 以块边长为限制，块内保持原分辨率
+        tile_params.limit_type = "max";
+        tile_params.limit_side_len = tile;
+        std::vector<int> xs = TileStarts(img.cols, tile, stride);
+        std::vector<int> ys = TileStarts(img.rows, tile, stride);
+
+        std::vector<Quad> all_boxes;
+        std::vector<int> tile_ids; // 每个框来自哪一块
+        std::vector<double> tile_times;
+        times.assign(3, 0);
+        for (size_t yi = 0; yi < ys.size(); yi++)
+        {
+            for (size_t xi = 0; xi < xs.size(); xi++)
+            {
+                cv::Rect roi(xs[xi], ys[yi], std::min(tile, img.cols - xs[xi]),
+                             std::min(tile, img.rows - ys[yi]));
+                std::vector<Quad> tile_boxes;
+                tile_times.clear();
+                RunImage(img(roi), tile_params, tile_boxes, tile_times); // 块视图不复制像素
+                for (int k = 0; k < 3; k++)
+                    times[k] += tile_times[k];
+
+                for (size_t i = 0; i < tile_boxes.size(); i++)
+                {
+                    for (int m = 0; m < 4; m++)
+                    {
+                        tile_boxes[i][m][0] += roi.x;
+                        tile_boxes[i][m][1] += roi.y;
+                    }
+                    all_boxes.push_back(tile_boxes[i]);
+                    tile_ids.push_back(int(yi * xs.size() + xi));
+                }
+            }
+        }
+
+        auto merge_start = std::chrono::steady_clock::now();
+        boxes = MergeTileBoxes(all_boxes, tile_ids, img);
+        auto merge_end = std::chrono::steady_clock::now();
+        times[2] += std::chrono::duration<float>(merge_end - merge_start).count() * 1000;
+    }
+
+    static void AddTimes(std::vector<double> &times, const std::vector<double> &pass)
+    {
+        for (size_t k = 0; k < 3 && k < pass.size(); k++)
+            times[k] += pass[k];
+    }
+
+    // 文本框的宽与高（两组对边的平均长度），较短者为字高
+    static void QuadSize(const Quad &box, float &width, float &height)
+    {
+        float e[4];
+        for (int m = 0; m < 4; m++)
+        {
+            float dx = float(box[(m + 1) % 4][0] - box[m][0]);
+            float dy = float(box[(m + 1) % 4][1] - box[m][1]);
+            e[m] = std::sqrt(dx * dx + dy * dy);
+        }
+        width = (e[0] + e[2]) / 2;
+        height = (e[1] + e[3]) / 2;
+    }
+
+    // 预检的文本框向外扩展 margin 后合并为互不重叠的矩形区域（原图坐标）。
+    // 先在缩小 scale 倍的掩膜上画出各框、取连通域的外接矩形，再合并外接矩形之间的重叠
+    static std::vector<cv::Rect> TextRegions(const std::vector<Quad> &boxes, int margin, double scale,
+                                             const cv::Size &size)
+    {
+        cv::Mat mask = cv::Mat::zeros(std::max(1, int(size.height * scale)), std::max(1, int(size.width * scale)), CV_8U);
+        for (size_t i = 0; i < boxes.size(); i++)
+        {
+            cv::Point pts[4];
+            for (int m = 0; m < 4; m++)
+                pts[m] = cv::Point(int(boxes[i][m][0] * scale), int(boxes[i][m][1] * scale));
+            cv::fillConvexPoly(mask, pts, 4, cv::Scalar(255));
+        }
+        int pad = std::max(1, int(margin * scale));
+        cv::dilate(mask, mask, cv::getStructuringElement(cv::MORPH_RECT, cv::Size(2 * pad + 1, 2 * pad + 1)));
+        std::vector<std::vector<cv::Point>> contours;
+        cv::findContours(mask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+        std::vector<cv::Rect> rects;
+        const cv::Rect full(0, 0, size.width, size.height);
+        for (size_t i = 0; i < contours.size(); i++)
+        {
+            cv::Rect r = cv::boundingRect(contours[i]);
+            rects.push_back(cv::Rect(int(r.x / scale), int(r.y / scale), int(std::ceil(r.width / scale)),
+                                     int(std::ceil(r.height / scale))) &
+                            full);
+        }
+        for (bool merged = true; merged;) // 区域数很少，反复两两合并直到不再重叠
+        {
+            merged = false;
+            for (size_t i = 0; i < rects.size() && !merged; i++)
+            {
+                for (size_t j = i + 1; j < rects.size(); j++)
+                {
+                    if ((rects[i] & rects[j]).area() > 0)
+                    {
+                        rects[i] |= rects[j];
+                        rects.erase(rects.begin() + j);
+                        merged = true;
+                        break;
+                    }
+                }
+            }
+        }
+        return rects;
+    }
+
+    void DBDetector::RunAdaptive(const cv::Mat &img, const Params &params, std::vector<Quad> &boxes,
+                                 std::vector<double> &times)
+    {
+        const int long_side = std::max(img.rows, img.cols);
+        std::vector<double> pass_times;
+        times.assign(3, 0);
+
+        // 预检：长边缩到 adaptive_side_。原图不大于它时已是原分辨率，结果即为最终结果；
+        // 没有检出文字时也直接接受，空白图片只花一次低分辨率检测
+        Params low = params;
+        low.limit_type = "max";
+        low.limit_side_len = this->adaptive_side_;
+        RunImage(img, low, boxes, pass_times);
+        AddTimes(times, pass_times);
+        if (long_side <= this->adaptive_side_ || boxes.empty())
+            return;
+
+        // 字高取各框短边的第20百分位：照顾较小的字，又不被个别噪点左右
+        std::vector<float> heights(boxes.size());
+        for (size_t i = 0; i < boxes.size(); i++)
+        {
+            float w, h;
+            QuadSize(boxes[i], w, h);
+            heights[i] = std::max(1.f, std::min(w, h));
+        }
+        std::nth_element(heights.begin(), heights.begin() + heights.size() / 5, heights.end());
+        const float text_h = heights[heights.size() / 5];
+        int low_h, low_w;
+        ResizeImgType0::TargetSize(img.rows, img.cols, "max", this->adaptive_side_, low_h, low_w);
+        const double low_scale = double(std::max(low_h, low_w)) / long_side;
+        if (text_h * low_scale >= this->adaptive_text_px_)
+            return; // 预检分辨率下字已足够大
+
+        // 使字高达到 adaptive_text_px_ 所需的长边，不超过上限与原图。提升不到四分之一时不值得重新检测
+        int side = int(std::ceil(double(long_side) * this->adaptive_text_px_ / text_h));
+        side = std::min(std::min(side, this->adaptive_max_side_), long_side);
+        if (side * 4 <= this->adaptive_side_ * 5)
+            return;
+        const double scale = double(side) / long_side;
+
+        if (this->adaptive_roi_)
+        { // 文字稀疏时只重新检测文本区域；区域过大（文字密集）时不如直接检测整图
+            std::vector<cv::Rect> regions = TextRegions(boxes, int(text_h * 2), low_scale, img.size());
+            double region_area = 0;
+            for (size_t i = 0; i < regions.size(); i++)
+                region_area += regions[i].area();
+            if (region_area * 2 < double(img.rows) * img.cols)
+            {
+                std::vector<Quad> result;
+                for (size_t i = 0; i < regions.size(); i++)
+                {
+                    const cv::Rect &r = regions[i];
+                    Params rp = params;
+                    rp.limit_type = "max";
+                    rp.limit_side_len = std::max(32, int(std::ceil(std::max(r.width, r.height) * scale)));
+                    std::vector<Quad> region_boxes;
+                    pass_times.clear();
+                    RunImage(img(r), rp, region_boxes, pass_times); // 区域视图不复制像素
+                    AddTimes(times, pass_times);
+                    for (size_t k = 0; k < region_boxes.size(); k++)
+                    {
+                        for (int m = 0; m < 4; m++)
+                        {
+                            region_boxes[k][m][0] += r.x;
+                            region_boxes[k][m][1] += r.y;
+                        }
+                        result.push_back(region_boxes[k]);
+                    }
+                }
+                boxes.swap(result);
+                return;
+            }
+        }
+
+        // 整图重新检测。需要原分辨率、且启用了分块时，按块检测以限制峰值内存
+        boxes.clear();
+        pass_times.clear();
+        if (this->det_tile_size_ > 0 && side >= long_side && long_side > this->det_tile_size_)
+        {
+            RunTiled(img, params, boxes, pass_times);
+        }
+        else
+        {
+            Params high = params;
+            high.limit_type = "max";
+            high.limit_side_len = side;
+            RunImage(img, high, boxes, pass_times);
+        }
+        AddTimes(times, pass_times);
+    }
+
+    static int FindRoot(std::vector<int> &parent, int i)
+    {
+        while (parent[i] != i)
+        {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+
+    // 两个来自不同块的框是否为同一段文本
+    static bool SameText(const cv::Rect &a, const cv::Rect &b)
+    {
+        int iw = std::min(a.x + a.width, b.x + b.width) - std::max(a.x, b.x);
+        int ih = std::min(a.y + a.height, b.y + b.height) - std::max(a.y, b.y);
+        if (iw <= 0 || ih <= 0)
+            return false;
+        bool a_horizontal = a.width >= a.height;
+        bool b_horizontal = b.width >= b.height;
+        if (a_horizontal && b_horizontal) // 横排：同一行，左右相接
+            return ih * 2 >= std::min(a.height, b.height);
+        if (!a_horizontal && !b_horizontal) // 竖排：同一列，上下相接
+            return iw * 2 >= std::min(a.width, b.width);
+        // 方向不一致：仅当一个框大半落在另一个框内时视为重复
+        return double(iw) * ih * 2 >= std::min(a.area(), b.area());
+    }
+
+    std::vector<Quad> DBDetector::MergeTileBoxes(const std::vector<Quad> &boxes,
+                                                 const std::vector<int> &tile_ids,
+                                                 const cv::Mat &img)
+    {
+        int n = int(boxes.size());
+        std::vector<cv::Rect> rects(n);
+        std::vector<int> order(n), parent(n);
+        for (int i = 0; i < n; i++)
+        {
+            int xmin = boxes[i][0][0], xmax = xmin, ymin = boxes[i][0][1], ymax = ymin;
+            for (int m = 1; m < 4; m++)
+            {
+                xmin = std::min(xmin, boxes[i][m][0]);
+                xmax = std::max(xmax, boxes[i][m][0]);
+                ymin = std::min(ymin, boxes[i][m][1]);
+                ymax = std::max(ymax, boxes[i][m][1]);
+            }
+            rects[i] = cv::Rect(xmin, ymin, xmax - xmin + 1, ymax - ymin + 1);
+            order[i] = parent[i] = i;
+        }
+        // 按左边界排序后扫描，只比较横向有交叠的框
+        std::sort(order.begin(), order.end(),
+                  [&rects](int a, int b)
+                  { return rects[a].x < rects[b].x; });
+        for (int oi = 0; oi < n; oi++)
+        {
+            int i = order[oi];
+            for (int oj = oi + 1; oj < n; oj++)
+            {
+                int j = order[oj];
+                if (rects[j].x >= rects[i].x + rects[i].width)
+                    break;
+                if (tile_ids[i] != tile_ids[j] && SameText(rects[i], rects[j]))
+                    parent[FindRoot(parent, j)] = FindRoot(parent, i);
+            }
+        }
+
+        std::vector<std::vector<cv::Point>> groups(n);
+        for (int i = 0; i < n; i++)
+        {
+            std::vector<cv::Point> &pts = groups[FindRoot(parent, i)];
+            for (int m = 0; m < 4; m++)
+                pts.push_back(cv::Point(boxes[i][m][0], boxes[i][m][1]));
+        }
+        std::vector<Quad> merged;
+        for (int i = 0; i < n; i++)
+        {
+            if (groups[i].empty())
+                continue;
+            if (groups[i].size() == 4) // 未合并，保持原样
+            {
+                merged.push_back(boxes[i]);
+                continue;
+            }
+            float ssid;
+            QuadF fbox = post_processor_.GetMiniBoxes(cv::minAreaRect(groups[i]), ssid);
+            Quad box;
+            for (int m = 0; m < 4; m++)
+            {
+                box[m][0] = std::min(std::max(int(round(fbox[m][0])), 0), img.cols - 1);
+                box[m][1] = std::min(std::max(int(round(fbox[m][1])), 0), img.rows - 1);
+            }
+            merged.push_back(box);
+        }
+        return merged;
+    }
+
+    DBDetector *DBDetector::Clone() const
+    {
+        DBDetector *other = new DBDetector(*this); // 复制参数与前后处理算子
+        // 推理实例的 Clone 共享权重，只新建中间张量等推理状态
+        other->predictor_ = ClonePredictor(this->predictor_, this->stream_, other->stream_);
+        if (this->cuda_ops_)
+        { // 设备缓冲区不共享
+            other->cuda_ops_.reset(new DetCudaOps(other->stream_.get()));
+        }
+        return other;
+    }
+
 } // namespace PaddleOCR
@@ -0,0 +1,144 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#include "include/ocr_pipeline.h"
+#include "include/paddleocr.h"
+#include "include/args.h"
+#include "include/metrics.h"
+#include "include/trace.h"
+
+#include <exception>
+#include <thread>
+
+namespace PaddleOCR
+{
+    OCRPipeline::OCRPipeline(PPOCR *ppocr, int queue_size)
+        : ppocr_(ppocr), queue_size_(queue_size)
+    {
+    }
+
+    std::vector<std::vector<OCRPredictResult>>
+    OCRPipeline::run(const std::vector<cv::Mat> &img_list, bool rec, bool cls)
+    {
+        std::vector<std::vector<OCRPredictResult>> ocr_results(img_list.size());
+        std::shared_ptr<BoundedQueue<ItemPtr>> q_cls(new BoundedQueue<ItemPtr>(queue_size_));
+        std::shared_ptr<BoundedQueue<ItemPtr>> q_rec(new BoundedQueue<ItemPtr>(queue_size_));
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            q_cls_ = q_cls;
+            q_rec_ = q_rec;
+        }
+
+        // 任一级出错时记录异常并关闭所有队列，让其它级尽快退出
+        std::exception_ptr error;
+        std::mutex error_mutex;
+        auto fail = [&]()
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error)
+                error = std::current_exception();
+            q_cls->close();
+            q_rec->close();
+        };
+
+        Trace *trace = Trace::current(); // 各级线程记入调用方的请求追踪
+
+        // 第一级：det
+        std::thread det_thread([&]()
+                               {
+            Trace::Scope scope(trace);
+            try
+            {
+                for (size_t i = 0; i < img_list.size(); i++)
+                {
+                    ItemPtr item(new Item());
+                    item->index = i;
+                    item->img = img_list[i];
+                    item->rotation = ppocr_->det_upright(item->img, item->result);
+                    if (!q_cls->push(item))
+                        break;
+                }
+            }
+            catch (...)
+            {
+                fail();
+            }
+            q_cls->close(); });
+
+        // 第二级：按det结果裁切，并进行方向分类
+        std::thread cls_thread([&]()
+                               {
+            Trace::Scope scope(trace);
+            try
+            {
+                ItemPtr item;
+                while (q_cls->pop(item))
+                {
+                    {
+                        StageTimer timer(Metrics::STAGE_CROP);
+                        Utility::GetRotateCropImages(item->img, item->result, item->crops, FLAGS_cpu_threads);
+                        PPOCR::unrotate_boxes(item->result, item->rotation, img_list[item->index].cols,
+                                              img_list[item->index].rows);
+                    }
+                    if (cls && ppocr_->classifier_ && !item->crops.empty())
+                    {
+                        ppocr_->cls(item->crops, item->result, &item->inferred);
+                        ppocr_->rotate_by_cls(item->crops, item->result);
+                    }
+                    item->img.release(); // 后续不再需要原图
+                    if (!q_rec->push(item))
+                        break;
+                }
+            }
+            catch (...)
+            {
+                fail();
+            }
+            q_rec->close(); });
+
+        // 第三级：rec，在当前线程执行，按提交顺序写回结果
+        try
+        {
+            ItemPtr item;
+            while (q_rec->pop(item))
+            {
+                if (rec && !item->crops.empty())
+                {
+                    ppocr_->rec(item->crops, item->result);
+                    ppocr_->recheck_cls(item->crops, item->result, item->inferred);
+                }
+                ocr_results[item->index].swap(item->result);
+            }
+        }
+        catch (...)
+        {
+            fail();
+        }
+
+        det_thread.join();
+        cls_thread.join();
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+        return ocr_results;
+    }
+
+    OCRPipeline::QueueDepth OCRPipeline::queue_depth() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        QueueDepth depth = {0, 0, 0, 0};
+        if (q_cls_)
+        {
+            depth.cls = q_cls_->size();
+            depth.cls_peak = q_cls_->peak();
+        }
+        if (q_rec_)
+        {
+            depth.rec = q_rec_->size();
+            depth.rec_peak = q_rec_->peak();
+        }
+        return depth;
+    }
+
+} // namespace PaddleOCR
@@ -14,14 +14,23 @@
 
 #include <include/ocr_rec.h>
 
+#include <future>
+
 namespace PaddleOCR
 {
 
     void CRNNRecognizer::Run(std::vector<cv::Mat> img_list,
                              std::vector<std::string> &rec_texts,
                              std::vector<float> &rec_text_scores,
-                             std::vector<double> &times)
+                             std::vector<double> &times,
+                             const RecBatchCallback &on_batch,
+                             const OCROptions *options)
     {
+        int batch_size = this->rec_batch_num_;
+        if (options && options->rec_batch_num > 0)
+        {
+            batch_size = std::min(batch_size, options->rec_batch_num);
+        }
         std::chrono::duration<float> preprocess_diff = std::chrono::duration<float>::zero();
         std::chrono::duration<float> inference_diff = std::chrono::duration<float>::zero();
         std::chrono::duration<float> postprocess_diff = std::chrono::duration<float>::zero();
@@ -34,93 +43,93 @@ namespace PaddleOCR
         }
         std::vector<int> indices = Utility::argsort(width_list);
 
-        for (int beg_img_no = 0; beg_img_no < img_num;
-             beg_img_no += this->rec_batch_num_)
+        InferTensor *input_t = this->predictor_->Input(0);
+        int imgH = this->rec_image_shape_[1];
+        int imgW = this->rec_image_shape_[2];
+
+        // 预处理从 beg_img_no 开始的一批：确定批次范围，缩放并归一化写入输入缓冲区，返回批次的结束位置。
+        // slot < 0 时写入输入张量（CPU下零拷贝），否则写入第 slot 个中转缓冲区，此时可在其他线程中执行
+        auto preprocess = [&](int beg_img_no, int slot) -> int
         {
             auto preprocess_start = std::chrono::steady_clock::now();
-            int end_img_no = std::min(img_num, beg_img_no + this->rec_batch_num_);
-            int batch_num = end_img_no - beg_img_no;
-            int imgH = this->rec_image_shape_[1];
-            int imgW = this->rec_image_shape_[2];
+            int end_img_no = std::min(img_num, beg_img_no + batch_size);
             float max_wh_ratio = imgW * 1.0 / imgH;
-            for (int ino = beg_img_no; ino < end_img_no; ino++)
+            if (!this->rec_width_buckets_.empty())
+            { // 宽度分桶：已按宽高比升序排列，批次在桶边界处截断，整批填充到桶宽度
+                int bucket = WidthBucket(img_list[indices[beg_img_no]]);
+                for (int ino = beg_img_no + 1; ino < end_img_no; ino++)
+                {
+                    if (WidthBucket(img_list[indices[ino]]) != bucket)
+                    {
+                        end_img_no = ino;
+                        break;
+                    }
+                }
+                max_wh_ratio = (bucket + 0.5f) / imgH; // +0.5 使缩放时 int(imgH * ratio) 恰好等于桶宽度
+            }
+            else
             {
-                int h = img_list[indices[ino]].rows;
-                int w = img_list[indices[ino]].cols;
-                float wh_ratio = w * 1.0 / h;
-                max_wh_ratio = std::max(max_wh_ratio, wh_ratio);
+                for (int ino = beg_img_no; ino < end_img_no; ino++)
+                {
+                    int h = img_list[indices[ino]].rows;
+                    int w = img_list[indices[ino]].cols;
+                    float wh_ratio = w * 1.0 / h;
+                    max_wh_ratio = std::max(max_wh_ratio, wh_ratio);
+                }
             }
+            int batch_num = end_img_no - beg_img_no;
 
             int batch_width = imgW;
-            std::vector<cv::Mat> norm_img_batch;
+            std::vector<cv::Mat> resize_img_batch;
             for (int ino = beg_img_no; ino < end_img_no; ino++)
             {
-                cv::Mat srcimg;
-                img_list[indices[ino]].copyTo(srcimg);
                 cv::Mat resize_img;
-                this->resize_op_.Run(srcimg, resize_img, max_wh_ratio,
+                this->resize_op_.Run(img_list[indices[ino]], resize_img, max_wh_ratio,
                                      this->use_tensorrt_, this->rec_image_shape_);
-                this->normalize_op_.Run(&resize_img, this->mean_, this->scale_,
-                                        this->is_scale_);
-                norm_img_batch.push_back(resize_img);
+                resize_img_batch.push_back(resize_img);
                 batch_width = std::max(resize_img.cols, batch_width);
             }
 
-            std::vector<float> input(batch_num * 3 * imgH * batch_width, 0.0f);
-            this->permute_op_.Run(norm_img_batch, input.data());
+            std::vector<int> shape = {batch_num, 3, imgH, batch_width};
+            float *input = slot < 0 ? this->arena_.Input(input_t, shape, !this->use_gpu_)
+                                    : this->arena_.Stage(slot, shape);
+            for (int i = 0; i < batch_num; i++)
+            {
+                this->norm_permute_op_.Run(resize_img_batch[i],
+                                           input + i * 3 * imgH * batch_width,
+                                           imgH, batch_width, this->mean_,
+                                           this->scale_, this->is_scale_);
+            }
             auto preprocess_end = std::chrono::steady_clock::now();
-            preprocess_diff += preprocess_end - preprocess_start;
-            // Inference.
-            auto input_names = this->predictor_->GetInputNames();
-            auto input_t = this->predictor_->GetInputHandle(input_names[0]);
-            input_t->Reshape({batch_num, 3, imgH, batch_width});
-            auto inference_start = std::chrono::steady_clock::now();
-            input_t->CopyFromCpu(input.data());
+            preprocess_diff += preprocess_end - preprocess_start; // 同一时刻只有一批在预处理
+            return end_img_no;
+        };
+
+        // 推理已提交输入的一批并解码
+        auto infer = [&](int beg_img_no, int end_img_no,
+                         const std::chrono::steady_clock::time_point &inference_start)
+        {
+            int batch_num = end_img_no - beg_img_no;
             this->predictor_->Run();
 
-            std::vector<float> predict_batch;
-            auto output_names = this->predictor_->GetOutputNames();
-            auto output_t = this->predictor_->GetOutputHandle(output_names[0]);
+            InferTensor *output_t = this->predictor_->Output(0);
             auto predict_shape = output_t->shape();
 
-            int out_num = std::accumulate(predict_shape.begin(), predict_shape.end(), 1,
-                                          std::multiplies<int>());
-            predict_batch.resize(out_num);
             // predict_batch is the result of Last FC with softmax
-            output_t->CopyToCpu(predict_batch.data());
+            int out_num = 0;
+            const float *predict_batch = this->arena_.Output(output_t, out_num);
             auto inference_end = std::chrono::steady_clock::now();
             inference_diff += inference_end - inference_start;
             // ctc decode
             auto postprocess_start = std::chrono::steady_clock::now();
+            int steps = predict_shape[1];
+            int classes = predict_shape[2];
+            // 各行互不相关，可按行并行解码
+#pragma omp parallel for num_threads(this->rec_decode_threads_) if (this->rec_decode_threads_ > 1 && predict_shape[0] > 1)
             for (int m = 0; m < predict_shape[0]; m++)
             {
                 std::string str_res;
-                int argmax_idx;
-                int last_index = 0;
-                float score = 0.f;
-                int count = 0;
-                float max_value = 0.0f;
-
-                for (int n = 0; n < predict_shape[1]; n++)
-                {
-                    // get idx
-                    argmax_idx = int(Utility::argmax(
-                        &predict_batch[(m * predict_shape[1] + n) * predict_shape[2]],
-                        &predict_batch[(m * predict_shape[1] + n + 1) * predict_shape[2]]));
-                    // get score
-                    max_value = float(*std::max_element(
-                        &predict_batch[(m * predict_shape[1] + n) * predict_shape[2]],
-                        &predict_batch[(m * predict_shape[1] + n + 1) * predict_shape[2]]));
-
-                    if (argmax_idx > 0 && (!(n > 0 && argmax_idx == last_index)))
-                    {
-                        score += max_value;
-                        count += 1;
-                        str_res += label_list_[argmax_idx];
-                    }
-                    last_index = argmax_idx;
-                }
-                score /= count;
+                float score = CTCDecode(predict_batch + size_t(m) * steps * classes, steps, classes, str_res);
                 if (std::isnan(score))
                 {
                     continue;
@@ -130,71 +139,132 @@ namespace PaddleOCR
             }
             auto postprocess_end = std::chrono::steady_clock::now();
             postprocess_diff += postprocess_end - postprocess_start;
-        }
-        times.push_back(double(preprocess_diff.count() * 1000));
-        times.push_back(double(inference_diff.count() * 1000));
-        times.push_back(double(postprocess_diff.count() * 1000));
-    }
+            if (on_batch)
+            {
+                on_batch(indices.data() + beg_img_no, batch_num);
+            }
+        };
 
-    void CRNNRecognizer::LoadModel(const std::string &model_dir)
-    {
-        paddle_infer::Config config;
-        config.SetModel(model_dir + "/inference.pdmodel",
-                        model_dir + "/inference.pdiparams");
-        if (this->use_gpu_)
-        {
-            config.EnableUseGpu(this->gpu_mem_, this->gpu_id_);
-            if (this->use_tensorrt_)
+        if (this->gpu_pipeline_ && img_num > 0)
+        { // 双缓冲：第k批提交到设备后，在后台线程预处理第k+1批，与第k批的推理、解码重叠
+            int slot = 0;
+            for (int beg_img_no = 0, end_img_no = preprocess(0, slot); beg_img_no < img_num;)
             {
-                auto precision = paddle_infer::Config::Precision::kFloat32;
-                if (this->precision_ == "fp16")
-                {
-                    precision = paddle_infer::Config::Precision::kHalf;
-                }
-                if (this->precision_ == "int8")
-                {
-                    precision = paddle_infer::Config::Precision::kInt8;
-                }
-                if (!Utility::PathExists("./trt_rec_shape.txt"))
+                auto inference_start = std::chrono::steady_clock::now();
+                this->arena_.Commit(input_t, slot);
+                slot ^= 1;
+                std::future<int> next;
+                if (end_img_no < img_num)
                 {
-                    config.CollectShapeRangeInfo("./trt_rec_shape.txt");
+                    next = std::async(std::launch::async, preprocess, end_img_no, slot);
                 }
-                else
+                infer(beg_img_no, end_img_no, inference_start);
+                beg_img_no = end_img_no;
+                if (next.valid())
                 {
-                    config.EnableTunedTensorRtDynamicShape("./trt_rec_shape.txt", true);
+                    end_img_no = next.get();
                 }
             }
         }
         else
         {
-            config.DisableGpu();
-            if (this->use_mkldnn_)
+            for (int beg_img_no = 0, end_img_no = 0; beg_img_no < img_num;
+                 beg_img_no = end_img_no)
             {
-                config.EnableMKLDNN();
-                // cache 10 different shapes for mkldnn to avoid memory leak
-                config.SetMkldnnCacheCapacity(10);
+                end_img_no = preprocess(beg_img_no, -1);
+                // Inference.
+                auto inference_start = std::chrono::steady_clock::now();
+                this->arena_.CommitInput(input_t);
+                infer(beg_img_no, end_img_no, inference_start);
             }
-            else
+        }
+        times.push_back(double(preprocess_diff.count() * 1000));
+        times.push_back(double(inference_diff.count() * 1000));
+        times.push_back(double(postprocess_diff.count() * 1000));
+    }
+
+    int CRNNRecognizer::WidthBucket(const cv::Mat &img) const
+    {
+        int imgH = this->rec_image_shape_[1];
+        int imgW = this->rec_image_shape_[2];
+        int width = std::max(imgW, int(ceilf(imgH * float(img.cols) / img.rows)));
+        for (size_t i = 0; i < this->rec_width_buckets_.size(); i++)
+        {
+            if (this->rec_width_buckets_[i] >= width)
             {
-                config.DisableMKLDNN();
+                return this->rec_width_buckets_[i];
             }
-            config.SetCpuMathLibraryNumThreads(this->cpu_math_library_num_threads_);
         }
+        int largest = this->rec_width_buckets_.back();
+        return (width + largest - 1) / largest * largest;
+    }
 
-        // get pass_builder object
-        auto pass_builder = config.pass_builder();
-        // delete "matmul_transpose_reshape_fuse_pass"
-        pass_builder->DeletePass("matmul_transpose_reshape_fuse_pass");
-        config.SwitchUseFeedFetchOps(false);
-        // true for multiple input
-        config.SwitchSpecifyInputNames(true);
-
-        config.SwitchIrOptim(true);
+    float CRNNRecognizer::CTCDecode(const float *probs, int steps, int classes,
+                                    std::string &text) const
+    {
+        // 第一遍：逐时间步求 argmax 与最大值（单次扫描），记录保留的字符下标
+        std::vector<int> kept;
+        kept.reserve(steps);
+        float score = 0.f;
+        size_t bytes = 0;
+        int last_index = 0;
+        const uint32_t *offsets = this->labels_->offsets();
+        for (int n = 0; n < steps; n++)
+        {
+            float max_value;
+            int argmax_idx = Utility::argmax_max(probs + size_t(n) * classes, classes, max_value);
+            if (argmax_idx > 0 && (!(n > 0 && argmax_idx == last_index)))
+            {
+                score += max_value;
+                kept.push_back(argmax_idx);
+                bytes += offsets[argmax_idx + 1] - offsets[argmax_idx];
+            }
+            last_index = argmax_idx;
+        }
+        // 第二遍：按偏移表一次性拼出UTF-8字符串
+        text.clear();
+        text.reserve(bytes);
+        const char *chars = this->labels_->chars();
+        for (size_t i = 0; i < kept.size(); i++)
+        {
+            uint32_t begin = offsets[kept[i]];
+            text.append(chars + begin, offsets[kept[i] + 1] - begin);
+        }
+        return score / kept.size(); // 与原实现一致：无字符时为 0/0，即NaN
+    }
 
-        config.EnableMemoryOptim();
-        config.DisableGlogInfo();
+    void CRNNRecognizer::LoadModel(const std::string &model_dir)
+    {
+        PredictorOptions options;
+        options.backend = this->backend_;
+        options.model_dir = model_dir;
+        options.use_gpu = this->use_gpu_;
+        options.gpu_id = this->gpu_id_;
+        options.gpu_mem = this->gpu_mem_;
+        options.cpu_threads = this->cpu_math_library_num_threads_;
+        options.use_mkldnn = this->use_mkldnn_;
+        // cache 10 different shapes for mkldnn to avoid memory leak
+        options.mkldnn_cache_capacity = 10;
+        options.precision = this->precision_;
+        options.use_tensorrt = this->use_tensorrt_;
+        options.trt_workspace = 1 << 20;
+        options.trt_max_batch = this->rec_batch_num_;
+        options.trt_min_subgraph = 15;
+        // 多语言识别模型各自收集形状；有优化缓存目录时放在该模型的缓存目录中
+        options.trt_shape_file = "./trt_rec_shape_" + Utility::basename(model_dir) + ".txt";
+        options.delete_passes.push_back("matmul_transpose_reshape_fuse_pass");
+        options.optim_cache_dir = this->optim_cache_dir_;
+        options.exit_on_error = this->exit_on_error_;
+        this->stream_ = CreateInferStream(this->use_gpu_ && this->gpu_pipeline_, options);
+        this->predictor_ = Predictor::Create(options);
+    }
 
-        this->predictor_ = paddle_infer::CreatePredictor(config);
+    CRNNRecognizer *CRNNRecognizer::Clone() const
+    {
+        CRNNRecognizer *other = new CRNNRecognizer(*this); // 复制参数与前后处理算子
+        // 推理实例的 Clone 共享权重，只新建中间张量等推理状态
+        other->predictor_ = ClonePredictor(this->predictor_, this->stream_, other->stream_);
+        return other;
     }
 
 } // namespace PaddleOCR
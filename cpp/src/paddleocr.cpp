@@ -13,7 +13,13 @@
 // limitations under the License.
 
 #include <include/args.h>
+#include <include/metrics.h>
 #include <include/paddleocr.h>
+#include <include/reading_order.h>
+#include <include/rec_registry.h>
+#include <include/trace.h>
+
+#include <sstream>
 
 #include "auto_log/autolog.h"
 
@@ -30,29 +36,74 @@ namespace PaddleOCR
                 FLAGS_cpu_threads, FLAGS_enable_mkldnn, FLAGS_limit_type,
                 FLAGS_limit_side_len, FLAGS_det_db_thresh, FLAGS_det_db_box_thresh,
                 FLAGS_det_db_unclip_ratio, FLAGS_det_db_score_mode, FLAGS_use_dilation,
-                FLAGS_use_tensorrt, FLAGS_precision));
+                FLAGS_use_tensorrt, stage_precision(FLAGS_det_precision), FLAGS_det_postprocess_threads,
+                FLAGS_det_tile_size, FLAGS_det_tile_overlap, FLAGS_optim_cache_dir,
+                FLAGS_gpu_pipeline, FLAGS_gpu_preprocess, FLAGS_det_backend));
+            this->detector_->SetAdaptive(FLAGS_det_adaptive, FLAGS_det_adaptive_side, FLAGS_det_adaptive_text_px,
+                                         FLAGS_det_adaptive_max_side, FLAGS_det_adaptive_roi);
         }
 
-        if (FLAGS_cls && FLAGS_use_angle_cls)
+        if ((FLAGS_cls || FLAGS_page_orient) && FLAGS_use_angle_cls)
         {
             this->classifier_.reset(new Classifier(
                 FLAGS_cls_model_dir, FLAGS_use_gpu, FLAGS_gpu_id, FLAGS_gpu_mem,
                 FLAGS_cpu_threads, FLAGS_enable_mkldnn, FLAGS_cls_thresh,
-                FLAGS_use_tensorrt, FLAGS_precision, FLAGS_cls_batch_num));
+                FLAGS_use_tensorrt, stage_precision(FLAGS_cls_precision), FLAGS_cls_batch_num,
+                FLAGS_optim_cache_dir, FLAGS_gpu_pipeline, FLAGS_cls_backend));
         }
         if (FLAGS_rec)
         {
             this->recognizer_.reset(new CRNNRecognizer(
                 FLAGS_rec_model_dir, FLAGS_use_gpu, FLAGS_gpu_id, FLAGS_gpu_mem,
                 FLAGS_cpu_threads, FLAGS_enable_mkldnn, FLAGS_rec_char_dict_path,
-                FLAGS_use_tensorrt, FLAGS_precision, FLAGS_rec_batch_num,
-                FLAGS_rec_img_h, FLAGS_rec_img_w));
+                FLAGS_use_tensorrt, stage_precision(FLAGS_rec_precision), FLAGS_rec_batch_num,
+                FLAGS_rec_img_h, FLAGS_rec_img_w, FLAGS_rec_decode_threads,
+                rec_width_buckets(), FLAGS_optim_cache_dir, FLAGS_gpu_pipeline, FLAGS_rec_backend));
+        }
+    }
+
+    PPOCR::PPOCR(const PPOCR &base)
+    {
+        if (base.detector_)
+        {
+            this->detector_.reset(base.detector_->Clone());
+        }
+        if (base.classifier_)
+        {
+            this->classifier_.reset(base.classifier_->Clone());
+        }
+        if (base.recognizer_)
+        {
+            this->recognizer_.reset(base.recognizer_->Clone());
         }
     }
 
+    // 在一次 ocr 调用期间使用 options（为空时沿用外层调用的参数），返回时恢复
+    class OptionsScope
+    {
+    public:
+        OptionsScope(OCROptions &current, const OCROptions *options) : current_(current), saved_(current)
+        {
+            if (options)
+                current_ = *options;
+        }
+        ~OptionsScope() { current_ = saved_; }
+
+    private:
+        OCROptions &current_;
+        OCROptions saved_;
+    };
+
+    double PPOCR::cls_thresh() const
+    {
+        return this->options_.cls_thresh >= 0 ? this->options_.cls_thresh : this->classifier_->cls_thresh;
+    }
+
     std::vector<std::vector<OCRPredictResult>> // 对一批Mat列表进行OCR
-    PPOCR::ocr(std::vector<cv::Mat> img_list, bool det, bool rec, bool cls)
+    PPOCR::ocr(std::vector<cv::Mat> img_list, bool det, bool rec, bool cls,
+               const OCROptions *options)
     {
+        OptionsScope scope(this->options_, options);
         std::vector<std::vector<OCRPredictResult>> ocr_results;
 
         if (!det)
@@ -60,16 +111,9 @@ namespace PaddleOCR
             std::vector<OCRPredictResult> ocr_result;
             ocr_result.resize(img_list.size());
             if (cls && this->classifier_)
-            {
+            { // 各图片互不相关，不做抽样
                 this->cls(img_list, ocr_result);
-                for (int i = 0; i < img_list.size(); i++)
-                {
-                    if (ocr_result[i].cls_label % 2 == 1 &&
-                        ocr_result[i].cls_score > this->classifier_->cls_thresh)
-                    {
-                        cv::rotate(img_list[i], img_list[i], 1);
-                    }
-                }
+                this->rotate_by_cls(img_list, ocr_result);
             }
             if (rec)
             {
@@ -82,6 +126,14 @@ namespace PaddleOCR
                 ocr_results.push_back(ocr_result_tmp);
             }
         }
+        else if (FLAGS_pipeline_queue > 0 && img_list.size() > 1)
+        { // det+cls+rec流水线：各阶段并行处理不同图片
+            if (!this->pipeline_)
+            {
+                this->pipeline_.reset(new OCRPipeline(this, FLAGS_pipeline_queue));
+            }
+            ocr_results = this->pipeline_->run(img_list, rec, cls);
+        }
         else
         { // 正常的det+cls+rec流程
             for (int i = 0; i < img_list.size(); ++i)
@@ -96,59 +148,212 @@ namespace PaddleOCR
 
     // 对单个Mat进行OCR
     std::vector<OCRPredictResult> PPOCR::ocr(cv::Mat img, bool det, bool rec,
-                                             bool cls)
+                                             bool cls, OCRObserver *observer,
+                                             const OCROptions *options)
     {
+        OptionsScope scope(this->options_, options);
 
         std::vector<OCRPredictResult> ocr_result;
         std::vector<cv::Mat> img_list;
         // det
         if (det)
         {
-            this->det(img, ocr_result); // 取det结果
-            // 按det结果，裁切图片
-            for (int j = 0; j < ocr_result.size(); j++)
-            {
-                cv::Mat crop_img;
-                crop_img = Utility::GetRotateCropImage(img, ocr_result[j].box);
-                img_list.push_back(crop_img);
-            }
+            int width = img.cols, height = img.rows;
+            int rotation = this->det_upright(img, ocr_result); // 取det结果，启用 page_orient 时 img 已转正
+            // 按det结果，裁切图片（det与rec之间推理线程空闲，借用同样数量的线程并行裁切）
+            StageTimer timer(Metrics::STAGE_CROP);
+            Utility::GetRotateCropImages(img, ocr_result, img_list, FLAGS_cpu_threads);
+            unrotate_boxes(ocr_result, rotation, width, height); // 碎图已裁切，文本框映射回原图坐标
         }
         else
         {
             // 创建一个box，大小与整张图片相同
-            std::vector<std::vector<int>> box = {{0, 0}, {img.cols - 1, 0}, {img.cols - 1, img.rows - 1}, {0, img.rows - 1}};
             OCRPredictResult res;
-            res.box = box;
+            res.box = Quad(0, 0, img.cols - 1, 0, img.cols - 1, img.rows - 1, 0, img.rows - 1);
             ocr_result.push_back(res);
             img_list.push_back(img);
         }
         // cls
+        std::vector<char> inferred; // 沿用抽样方向、未经分类的碎图
         if (cls && this->classifier_)
         {
-            this->cls(img_list, ocr_result);
-            for (int i = 0; i < img_list.size(); i++)
+            this->cls(img_list, ocr_result, det ? &inferred : nullptr);
+            this->rotate_by_cls(img_list, ocr_result);
+        }
+        if (observer && det)
+        {
+            observer->on_det(ocr_result);
+        }
+        // rec
+        if (rec)
+        {
+            this->rec(img_list, ocr_result, observer);
+            this->recheck_cls(img_list, ocr_result, inferred);
+        }
+        return ocr_result;
+    }
+
+    // 文本框的外接矩形
+    static cv::Rect box_rect(const Quad &box)
+    {
+        std::vector<int> b = Utility::xyxyxyxy2xyxy(box);
+        return cv::Rect(b[0], b[1], b[2] - b[0] + 1, b[3] - b[1] + 1);
+    }
+
+    // 合并相交的矩形，直到两两不相交
+    static void merge_rects(std::vector<cv::Rect> &rects)
+    {
+        bool merged = true;
+        while (merged)
+        {
+            merged = false;
+            for (size_t i = 0; i < rects.size() && !merged; i++)
+            {
+                for (size_t j = i + 1; j < rects.size(); j++)
+                {
+                    if ((rects[i] & rects[j]).area() > 0)
+                    {
+                        rects[i] |= rects[j];
+                        rects.erase(rects.begin() + j);
+                        merged = true;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    bool PPOCR::dirty_regions(const cv::Mat &img, std::vector<cv::Rect> &regions)
+    {
+        const int diff_thresh = 8;   // 像素任一通道差值超过它，视为变化（容忍轻微的压缩噪声）
+        const int pad = 8;           // 变化区域向外扩展的像素，给检测留出文字边缘
+        const int max_regions = 64;  // 区域过多时，逐个推理不如一次完整OCR
+        if (img.depth() != CV_8U)
+            return false;
+
+        // 一次遍历求变化掩膜
+        cv::Mat mask(img.rows, img.cols, CV_8UC1);
+        int cn = img.channels();
+        for (int y = 0; y < img.rows; y++)
+        {
+            const uchar *a = img.ptr<uchar>(y);
+            const uchar *b = this->prev_frame_.ptr<uchar>(y);
+            uchar *m = mask.ptr<uchar>(y);
+            for (int x = 0; x < img.cols; x++, a += cn, b += cn)
             {
-                if (ocr_result[i].cls_label % 2 == 1 &&
-                    ocr_result[i].cls_score > this->classifier_->cls_thresh)
+                uchar changed = 0;
+                for (int c = 0; c < cn; c++)
                 {
-                    cv::rotate(img_list[i], img_list[i], 1);
+                    if (std::abs(a[c] - b[c]) > diff_thresh)
+                        changed = 255;
                 }
+                m[x] = changed;
             }
         }
-        // rec
-        if (rec)
+        // 膨胀，把同一行中相邻的变化字符连成一片
+        cv::dilate(mask, mask, cv::getStructuringElement(cv::MORPH_RECT, cv::Size(15, 15)));
+        std::vector<std::vector<cv::Point>> contours;
+        cv::findContours(mask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+        if (int(contours.size()) > max_regions)
+            return false;
+
+        cv::Rect bounds(0, 0, img.cols, img.rows);
+        regions.clear();
+        for (size_t i = 0; i < contours.size(); i++)
+        {
+            cv::Rect r = cv::boundingRect(contours[i]);
+            r.x -= pad, r.y -= pad, r.width += 2 * pad, r.height += 2 * pad;
+            regions.push_back(r & bounds);
+        }
+        // 与变化区域相交的旧文本框整体重新识别：区域扩展到覆盖这些框，直到不再变化
+        std::vector<cv::Rect> old_rects;
+        for (size_t i = 0; i < this->prev_results_.size(); i++)
         {
-            this->rec(img_list, ocr_result);
+            old_rects.push_back(box_rect(this->prev_results_[i].box));
+        }
+        bool grown = true;
+        while (grown)
+        {
+            merge_rects(regions);
+            grown = false;
+            for (size_t i = 0; i < regions.size(); i++)
+            {
+                for (size_t k = 0; k < old_rects.size(); k++)
+                {
+                    cv::Rect r = regions[i] | old_rects[k];
+                    if ((regions[i] & old_rects[k]).area() > 0 && r.area() > regions[i].area())
+                    {
+                        regions[i] = r & bounds;
+                        grown = true;
+                    }
+                }
+            }
         }
+        // 变化面积超过一半时，完整OCR更快
+        double area = 0;
+        for (size_t i = 0; i < regions.size(); i++)
+            area += regions[i].area();
+        return area * 2 <= double(img.rows) * img.cols;
+    }
+
+    std::vector<OCRPredictResult> PPOCR::ocr_incremental(cv::Mat img, bool rec,
+                                                         bool cls, const OCROptions *options)
+    {
+        OptionsScope scope(this->options_, options);
+        std::vector<OCRPredictResult> ocr_result;
+        std::vector<cv::Rect> regions;
+        bool reuse = !this->prev_frame_.empty() && this->prev_frame_.size() == img.size() &&
+                     this->prev_frame_.type() == img.type() &&
+                     this->prev_rec_ == rec && this->prev_cls_ == cls &&
+                     this->prev_options_ == this->options_ &&
+                     dirty_regions(img, regions);
+        if (!reuse)
+        {
+            ocr_result = this->ocr(img, true, rec, cls);
+        }
+        else
+        {
+            // 沿用未受影响的旧文本框
+            for (size_t i = 0; i < this->prev_results_.size(); i++)
+            {
+                cv::Rect r = box_rect(this->prev_results_[i].box);
+                bool touched = false;
+                for (size_t k = 0; k < regions.size() && !touched; k++)
+                    touched = (r & regions[k]).area() > 0;
+                if (!touched)
+                    ocr_result.push_back(this->prev_results_[i]);
+            }
+            // 变化区域的视图单独走一遍 det+cls+rec，坐标平移回原图
+            for (size_t k = 0; k < regions.size(); k++)
+            {
+                std::vector<OCRPredictResult> part =
+                    this->ocr(img(regions[k]), true, rec, cls);
+                for (size_t i = 0; i < part.size(); i++)
+                {
+                    for (int m = 0; m < 4; m++)
+                    {
+                        part[i].box[m][0] += regions[k].x;
+                        part[i].box[m][1] += regions[k].y;
+                    }
+                    ocr_result.push_back(part[i]);
+                }
+            }
+            ReadingOrder::sort(ocr_result, FLAGS_text_group);
+        }
+        img.copyTo(this->prev_frame_); // 尺寸不变时复用已有缓冲区
+        this->prev_results_ = ocr_result;
+        this->prev_rec_ = rec;
+        this->prev_cls_ = cls;
+        this->prev_options_ = this->options_;
         return ocr_result;
     }
 
     void PPOCR::det(cv::Mat img, std::vector<OCRPredictResult> &ocr_results)
     {
-        std::vector<std::vector<std::vector<int>>> boxes;
+        std::vector<Quad> boxes;
         std::vector<double> det_times;
 
-        this->detector_->Run(img, boxes, det_times);
+        this->detector_->Run(img, boxes, det_times, &this->options_);
 
         for (int i = 0; i < boxes.size(); i++)
         {
@@ -156,47 +361,389 @@ namespace PaddleOCR
             res.box = boxes[i];
             ocr_results.push_back(res);
         }
-        // sort boex from top to bottom, from left to right
-        Utility::sorted_boxes(ocr_results);
+        // 按阅读顺序排序：从上到下分行，行内从左到右
+        ReadingOrder::sort(ocr_results, FLAGS_text_group);
         this->time_info_det[0] += det_times[0];
         this->time_info_det[1] += det_times[1];
         this->time_info_det[2] += det_times[2];
+        Metrics &metrics = Metrics::get();
+        metrics.observe(Metrics::STAGE_DET_PRE, det_times[0]);
+        metrics.observe(Metrics::STAGE_DET_INFER, det_times[1]);
+        metrics.observe(Metrics::STAGE_DET_POST, det_times[2]);
+        const char *stages[] = {Metrics::stage_name(Metrics::STAGE_DET_PRE), Metrics::stage_name(Metrics::STAGE_DET_INFER),
+                                Metrics::stage_name(Metrics::STAGE_DET_POST)};
+        Trace::record_sequence(stages, det_times.data(), 3);
+        metrics.observe_boxes(int(boxes.size()));
+    }
+
+    // 文本框的边长：宽为第0、1点间距，高为第1、2点间距
+    static void box_size(const Quad &box, float &w, float &h)
+    {
+        w = std::hypot(float(box[1][0] - box[0][0]), float(box[1][1] - box[0][1]));
+        h = std::hypot(float(box[2][0] - box[1][0]), float(box[2][1] - box[1][1]));
+    }
+
+    int PPOCR::det_upright(cv::Mat &img, std::vector<OCRPredictResult> &ocr_results)
+    {
+        const int trials = 8; // 参与方向投票的碎图数
+        this->det(img, ocr_results);
+        if (!FLAGS_page_orient || !this->classifier_ || ocr_results.empty())
+            return 0;
+        // 横竖：按长边长度加权，竖条占多数时整页多半转了90°或270°，先顺时针转90°重新检测
+        float portrait = 0, landscape = 0;
+        for (size_t i = 0; i < ocr_results.size(); i++)
+        {
+            float w, h;
+            box_size(ocr_results[i].box, w, h);
+            if (h > 1.5f * w)
+                portrait += h;
+            else if (w > 1.5f * h)
+                landscape += w;
+        }
+        int rotation = 0;
+        if (portrait > landscape)
+        {
+            cv::Mat rotated; // 不能原地旋转：img 与调用方共享像素
+            cv::rotate(img, rotated, cv::ROTATE_90_CLOCKWISE);
+            img = rotated;
+            rotation = 90;
+            ocr_results.clear();
+            this->det(img, ocr_results);
+        }
+        // 正反：取最长的几个横排长条做方向分类，按置信度投票
+        std::vector<std::pair<float, int>> lines;
+        for (size_t i = 0; i < ocr_results.size(); i++)
+        {
+            float w, h;
+            box_size(ocr_results[i].box, w, h);
+            if (w >= 2 * h)
+                lines.push_back(std::make_pair(w, int(i)));
+        }
+        int n = std::min(trials, int(lines.size()));
+        std::partial_sort(lines.begin(), lines.begin() + n, lines.end(),
+                          [](const std::pair<float, int> &a, const std::pair<float, int> &b)
+                          { return a.first > b.first; });
+        std::vector<cv::Mat> crops(n);
+        for (int k = 0; k < n; k++)
+            crops[k] = Utility::GetRotateCropImage(img, ocr_results[lines[k].second].box);
+        std::vector<OCRPredictResult> votes(n);
+        if (n > 0)
+            this->cls(crops, votes);
+        float upside_down = 0, upright = 0;
+        for (int k = 0; k < n; k++)
+            (votes[k].cls_label % 2 == 1 ? upside_down : upright) += votes[k].cls_score;
+        if (upside_down > upright)
+        { // 再转180°：文本框随之变换，各点顺序保持左上起
+            cv::Mat rotated;
+            cv::rotate(img, rotated, cv::ROTATE_180);
+            img = rotated;
+            rotation += 180;
+            for (size_t i = 0; i < ocr_results.size(); i++)
+            {
+                const Quad b = ocr_results[i].box;
+                for (int p = 0; p < 4; p++)
+                {
+                    ocr_results[i].box[p][0] = img.cols - 1 - b[(p + 2) % 4][0];
+                    ocr_results[i].box[p][1] = img.rows - 1 - b[(p + 2) % 4][1];
+                }
+            }
+            ReadingOrder::sort(ocr_results, FLAGS_text_group);
+        }
+        return rotation;
+    }
+
+    void PPOCR::unrotate_boxes(std::vector<OCRPredictResult> &ocr_results,
+                               int rotation, int width, int height)
+    {
+        if (rotation == 0)
+            return;
+        for (size_t i = 0; i < ocr_results.size(); i++)
+        {
+            for (int p = 0; p < 4; p++)
+            {
+                int u = ocr_results[i].box[p][0], v = ocr_results[i].box[p][1];
+                int &x = ocr_results[i].box[p][0], &y = ocr_results[i].box[p][1];
+                if (rotation == 90)
+                    x = v, y = height - 1 - u;
+                else if (rotation == 180)
+                    x = width - 1 - u, y = height - 1 - v;
+                else // 270
+                    x = width - 1 - v, y = u;
+            }
+        }
     }
 
     void PPOCR::rec(std::vector<cv::Mat> img_list,
-                    std::vector<OCRPredictResult> &ocr_results)
+                    std::vector<OCRPredictResult> &ocr_results,
+                    OCRObserver *observer)
     {
         std::vector<std::string> rec_texts(img_list.size(), "");
         std::vector<float> rec_text_scores(img_list.size(), 0);
         std::vector<double> rec_times;
-        this->recognizer_->Run(img_list, rec_texts, rec_text_scores, rec_times);
+        // 指定了语言时，从登记表借用该语言的识别器，调用结束时归还
+        std::shared_ptr<CRNNRecognizer> lang_recognizer;
+        if (!this->options_.lang.empty())
+        {
+            lang_recognizer = RecRegistry::get().acquire(this->options_.lang);
+            if (!lang_recognizer)
+            { // 模型加载失败，无法识别，所有碎图留空
+                for (size_t i = 0; i < ocr_results.size() && i < img_list.size(); i++)
+                {
+                    ocr_results[i].text.clear();
+                    ocr_results[i].score = 0;
+                }
+                return;
+            }
+        }
+        CRNNRecognizer *recognizer = lang_recognizer ? lang_recognizer.get() : this->recognizer_.get();
+        Trace::Clock::time_point rec_start = Trace::Clock::now();
+        bool batched = this->rec_batcher_ && !lang_recognizer;
+        if (batched) // 与其它请求合并批处理（批大小由批处理器决定，忽略 options_ 中的批大小）
+        {
+            this->rec_batcher_->Run(img_list, rec_texts, rec_text_scores, rec_times);
+        }
+        else if (observer) // 每批识别完成时，先写回本批结果并通知
+        {
+            recognizer->Run(img_list, rec_texts, rec_text_scores, rec_times,
+                                   [&](const int *indices, int count)
+                                   {
+                                       for (int k = 0; k < count; k++)
+                                       {
+                                           ocr_results[indices[k]].text = rec_texts[indices[k]];
+                                           ocr_results[indices[k]].score = rec_text_scores[indices[k]];
+                                       }
+                                       observer->on_rec(ocr_results, indices, count);
+                                   },
+                                   &this->options_);
+            observer = nullptr; // 已逐批通知
+        }
+        else
+        {
+            recognizer->Run(img_list, rec_texts, rec_text_scores, rec_times,
+                                   RecBatchCallback(), &this->options_);
+        }
         // output rec results
         for (int i = 0; i < rec_texts.size(); i++)
         {
             ocr_results[i].text = rec_texts[i];
             ocr_results[i].score = rec_text_scores[i];
         }
+        if (observer) // 合并批处理时，全部完成后一次通知
+        {
+            std::vector<int> indices(rec_texts.size());
+            for (int i = 0; i < (int)indices.size(); i++)
+                indices[i] = i;
+            observer->on_rec(ocr_results, indices.data(), (int)indices.size());
+        }
         this->time_info_rec[0] += rec_times[0];
         this->time_info_rec[1] += rec_times[1];
         this->time_info_rec[2] += rec_times[2];
+        Metrics &metrics = Metrics::get();
+        metrics.observe(Metrics::STAGE_REC_PRE, rec_times[0]);
+        metrics.observe(Metrics::STAGE_REC_INFER, rec_times[1]);
+        metrics.observe(Metrics::STAGE_REC_POST, rec_times[2]);
+        if (Trace::current())
+        { // 合批时各阶段耗时为整批的，多出的时间是等待合批与排在其它批之后
+            double wall = std::chrono::duration<double, std::milli>(Trace::Clock::now() - rec_start).count();
+            double ms[] = {std::max(0.0, wall - rec_times[0] - rec_times[1] - rec_times[2]),
+                           rec_times[0], rec_times[1], rec_times[2]};
+            const char *stages[] = {"rec_wait", Metrics::stage_name(Metrics::STAGE_REC_PRE),
+                                    Metrics::stage_name(Metrics::STAGE_REC_INFER), Metrics::stage_name(Metrics::STAGE_REC_POST)};
+            Trace::record_sequence(stages + (batched ? 0 : 1), ms + (batched ? 0 : 1), batched ? 4 : 3);
+        }
     }
 
     void PPOCR::cls(std::vector<cv::Mat> img_list,
-                    std::vector<OCRPredictResult> &ocr_results)
+                    std::vector<OCRPredictResult> &ocr_results,
+                    std::vector<char> *inferred)
+    {
+        // 对 indices 中的碎图进行分类
+        auto classify = [&](const std::vector<int> &indices)
+        {
+            if (indices.empty())
+                return;
+            std::vector<cv::Mat> imgs(indices.size());
+            for (size_t k = 0; k < indices.size(); k++)
+                imgs[k] = img_list[indices[k]];
+            std::vector<int> cls_labels(imgs.size(), 0);
+            std::vector<float> cls_scores(imgs.size(), 0);
+            std::vector<double> cls_times;
+            this->classifier_->Run(imgs, cls_labels, cls_scores, cls_times);
+            // output cls results
+            for (size_t k = 0; k < indices.size(); k++)
+            {
+                ocr_results[indices[k]].cls_label = cls_labels[k];
+                ocr_results[indices[k]].cls_score = cls_scores[k];
+            }
+            this->time_info_cls[0] += cls_times[0];
+            this->time_info_cls[1] += cls_times[1];
+            this->time_info_cls[2] += cls_times[2];
+            double cls_ms = cls_times[0] + cls_times[1] + cls_times[2];
+            Metrics::get().observe(Metrics::STAGE_CLS, cls_ms);
+            const char *stage = Metrics::stage_name(Metrics::STAGE_CLS);
+            Trace::record_sequence(&stage, &cls_ms, 1);
+        };
+
+        const int sample = FLAGS_cls_sample;
+        if (inferred)
+            inferred->assign(img_list.size(), 0);
+        std::vector<int> all(img_list.size());
+        for (int i = 0; i < (int)all.size(); i++)
+            all[i] = i;
+        if (!inferred || sample <= 0 || (int)img_list.size() <= sample)
+        {
+            classify(all);
+            return;
+        }
+        // 预筛：裁切时竖排文本已转为横向，宽度不小于3倍高度的长条只可能是0°或180°，方向由整页决定；
+        // 短小或近方形的碎图（单字、图标、竖排残片）方向不可靠，逐个分类
+        std::vector<int> must, lines;
+        for (int i = 0; i < (int)img_list.size(); i++)
+        {
+            if (img_list[i].cols >= 3 * img_list[i].rows)
+                lines.push_back(i);
+            else
+                must.push_back(i);
+        }
+        std::vector<int> sampled, skipped;
+        for (int k = 0, next = 0; k < (int)lines.size(); k++)
+        { // 在长条中等间隔抽样
+            if (next < sample && k >= next * (int)lines.size() / sample)
+            {
+                sampled.push_back(lines[k]);
+                next++;
+            }
+            else
+            {
+                skipped.push_back(lines[k]);
+            }
+        }
+        must.insert(must.end(), sampled.begin(), sampled.end());
+        classify(must);
+        if (skipped.empty())
+            return;
+        // 抽样结果方向一致且都高于阈值时，其余长条沿用该方向，置信度取抽样中的最低值
+        int label = ocr_results[sampled[0]].cls_label;
+        float score = 1.0f;
+        bool agree = true;
+        for (size_t k = 0; k < sampled.size() && agree; k++)
+        {
+            const OCRPredictResult &r = ocr_results[sampled[k]];
+            agree = r.cls_label == label && r.cls_score > this->cls_thresh();
+            score = std::min(score, r.cls_score);
+        }
+        if (!agree)
+        {
+            classify(skipped);
+            return;
+        }
+        for (size_t k = 0; k < skipped.size(); k++)
+        {
+            ocr_results[skipped[k]].cls_label = label;
+            ocr_results[skipped[k]].cls_score = score;
+            (*inferred)[skipped[k]] = 1;
+        }
+    }
+
+    void PPOCR::rotate_by_cls(std::vector<cv::Mat> &img_list,
+                              const std::vector<OCRPredictResult> &ocr_results)
     {
-        std::vector<int> cls_labels(img_list.size(), 0);
-        std::vector<float> cls_scores(img_list.size(), 0);
-        std::vector<double> cls_times;
-        this->classifier_->Run(img_list, cls_labels, cls_scores, cls_times);
-        // output cls results
-        for (int i = 0; i < cls_labels.size(); i++)
+        for (size_t i = 0; i < img_list.size(); i++)
         {
-            ocr_results[i].cls_label = cls_labels[i];
-            ocr_results[i].cls_score = cls_scores[i];
+            if (ocr_results[i].cls_label % 2 == 1 &&
+                ocr_results[i].cls_score > this->cls_thresh())
+            {
+                cv::rotate(img_list[i], img_list[i], 1);
+            }
+        }
+    }
+
+    void PPOCR::recheck_cls(const std::vector<cv::Mat> &img_list,
+                            std::vector<OCRPredictResult> &ocr_results,
+                            const std::vector<char> &inferred)
+    {
+        std::vector<int> indices;
+        for (size_t i = 0; i < inferred.size(); i++)
+        {
+            if (inferred[i] && ocr_results[i].score < FLAGS_cls_recheck_score)
+                indices.push_back(int(i));
+        }
+        if (indices.empty())
+            return;
+        std::vector<cv::Mat> flipped(indices.size());
+        for (size_t k = 0; k < indices.size(); k++)
+            cv::rotate(img_list[indices[k]], flipped[k], 1);
+        std::vector<OCRPredictResult> res(indices.size());
+        this->rec(flipped, res);
+        for (size_t k = 0; k < indices.size(); k++)
+        {
+            OCRPredictResult &r = ocr_results[indices[k]];
+            if (res[k].score > r.score)
+            { // 转180°后更可信，方向与沿用的相反
+                r.text.swap(res[k].text);
+                r.score = res[k].score;
+                r.cls_label = r.cls_label % 2 == 1 ? 0 : 1;
+            }
+        }
+    }
+
+    void PPOCR::warmup()
+    {
+        std::vector<double> times;
+        if (this->detector_)
+        {
+            // 检测：最小尺寸、正方形与横竖长条覆盖 limit_side_len 限制下的形状，启用分块时另加一个整块
+            int side = FLAGS_limit_side_len > 32 ? FLAGS_limit_side_len : 32;
+            std::vector<cv::Size> sizes = {cv::Size(32, 32), cv::Size(side, side),
+                                           cv::Size(side, side / 4), cv::Size(side / 4, side)};
+            if (FLAGS_det_tile_size > 0)
+            {
+                sizes.push_back(cv::Size(FLAGS_det_tile_size, FLAGS_det_tile_size));
+            }
+            if (FLAGS_det_adaptive)
+            { // 自适应检测的预检尺寸
+                sizes.push_back(cv::Size(FLAGS_det_adaptive_side, FLAGS_det_adaptive_side));
+            }
+            for (size_t i = 0; i < sizes.size(); i++)
+            {
+                cv::Mat img(sizes[i], CV_8UC3, cv::Scalar(255, 255, 255));
+                std::vector<Quad> boxes;
+                this->detector_->Run(img, boxes, times);
+            }
+        }
+        if (this->classifier_)
+        {
+            // 方向分类：输入尺寸固定，只需覆盖批大小
+            int batches[] = {1, FLAGS_cls_batch_num};
+            for (int b = 0; b < 2; b++)
+            {
+                std::vector<cv::Mat> crops(batches[b], cv::Mat(48, 192, CV_8UC3, cv::Scalar(255, 255, 255)));
+                std::vector<int> labels;
+                std::vector<float> scores;
+                this->classifier_->Run(crops, labels, scores, times);
+            }
+        }
+        if (this->recognizer_)
+        {
+            // 识别：每个宽度分桶各一批；未分桶时取模型宽度的1、2、4倍
+            std::vector<int> widths = this->recognizer_->width_buckets();
+            if (widths.empty())
+            {
+                widths = {FLAGS_rec_img_w, FLAGS_rec_img_w * 2, FLAGS_rec_img_w * 4};
+            }
+            int batches[] = {1, FLAGS_rec_batch_num};
+            for (size_t i = 0; i < widths.size(); i++)
+            {
+                for (int b = 0; b < 2; b++)
+                {
+                    std::vector<cv::Mat> crops(batches[b], cv::Mat(FLAGS_rec_img_h, widths[i], CV_8UC3,
+                                                                   cv::Scalar(255, 255, 255)));
+                    std::vector<std::string> texts;
+                    std::vector<float> scores;
+                    this->recognizer_->Run(crops, texts, scores, times);
+                }
+            }
         }
-        this->time_info_cls[0] += cls_times[0];
-        this->time_info_cls[1] += cls_times[1];
-        this->time_info_cls[2] += cls_times[2];
     }
 
     void PPOCR::reset_timer()
@@ -213,7 +760,7 @@ namespace PaddleOCR
         {
             AutoLogger autolog_det("ocr_det", FLAGS_use_gpu, FLAGS_use_tensorrt,
                                    FLAGS_enable_mkldnn, FLAGS_cpu_threads, 1, "dynamic",
-                                   FLAGS_precision, this->time_info_det, img_num);
+                                   stage_precision(FLAGS_det_precision), this->time_info_det, img_num);
             autolog_det.report();
         }
         if (this->time_info_rec[0] + this->time_info_rec[1] + this->time_info_rec[2] >
@@ -221,7 +768,7 @@ namespace PaddleOCR
         {
             AutoLogger autolog_rec("ocr_rec", FLAGS_use_gpu, FLAGS_use_tensorrt,
                                    FLAGS_enable_mkldnn, FLAGS_cpu_threads,
-                                   FLAGS_rec_batch_num, "dynamic", FLAGS_precision,
+                                   FLAGS_rec_batch_num, "dynamic", stage_precision(FLAGS_rec_precision),
                                    this->time_info_rec, img_num);
             autolog_rec.report();
         }
@@ -230,10 +777,16 @@ namespace PaddleOCR
         {
             AutoLogger autolog_cls("ocr_cls", FLAGS_use_gpu, FLAGS_use_tensorrt,
                                    FLAGS_enable_mkldnn, FLAGS_cpu_threads,
-                                   FLAGS_cls_batch_num, "dynamic", FLAGS_precision,
+                                   FLAGS_cls_batch_num, "dynamic", stage_precision(FLAGS_cls_precision),
                                    this->time_info_cls, img_num);
             autolog_cls.report();
         }
+        if (this->pipeline_)
+        {
+            OCRPipeline::QueueDepth depth = this->pipeline_->queue_depth();
+            std::cerr << "pipeline queue peak depth: cls " << depth.cls_peak
+                      << ", rec " << depth.rec_peak << " (capacity " << FLAGS_pipeline_queue << ")" << std::endl;
+        }
     }
 
 } // namespace PaddleOCR
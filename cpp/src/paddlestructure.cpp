@@ -17,6 +17,11 @@
 
 #include "auto_log/autolog.h"
 
+#include <array>
+#include <climits>
+#include <cmath>
+#include <future>
+
 namespace PaddleOCR
 {
 
@@ -28,7 +33,7 @@ namespace PaddleOCR
                 FLAGS_layout_model_dir, FLAGS_use_gpu, FLAGS_gpu_id, FLAGS_gpu_mem,
                 FLAGS_cpu_threads, FLAGS_enable_mkldnn, FLAGS_layout_dict_path,
                 FLAGS_use_tensorrt, FLAGS_precision, FLAGS_layout_score_threshold,
-                FLAGS_layout_nms_threshold));
+                FLAGS_layout_nms_threshold, FLAGS_layout_backend));
         }
         if (FLAGS_table)
         {
@@ -36,7 +41,19 @@ namespace PaddleOCR
                 FLAGS_table_model_dir, FLAGS_use_gpu, FLAGS_gpu_id, FLAGS_gpu_mem,
                 FLAGS_cpu_threads, FLAGS_enable_mkldnn, FLAGS_table_char_dict_path,
                 FLAGS_use_tensorrt, FLAGS_precision, FLAGS_table_batch_num,
-                FLAGS_table_max_len, FLAGS_merge_no_span_structure));
+                FLAGS_table_max_len, FLAGS_merge_no_span_structure, FLAGS_table_backend));
+        }
+    }
+
+    PaddleStructure::PaddleStructure(const PaddleStructure &base) : PPOCR(base)
+    {
+        if (base.layout_model_)
+        {
+            this->layout_model_.reset(base.layout_model_->Clone());
+        }
+        if (base.table_model_)
+        {
+            this->table_model_.reset(base.table_model_->Clone());
         }
     }
 
@@ -47,10 +64,15 @@ namespace PaddleOCR
         srcimg.copyTo(img);
 
         std::vector<StructurePredictResult> structure_results;
+        table = table && this->table_model_;
+        bool need_ocr = (table || ocr) && this->detector_ && this->recognizer_;
 
-        if (layout)
+        // 版面分析与整页文本检测使用各自的预测器，并行执行
+        std::future<void> layout_done;
+        if (layout && this->layout_model_)
         {
-            this->layout(img, structure_results);
+            layout_done = std::async(std::launch::async, [&]
+                                     { this->layout(img, structure_results); });
         }
         else
         {
@@ -61,18 +83,131 @@ namespace PaddleOCR
             res.box[3] = img.rows;
             structure_results.push_back(res);
         }
-        cv::Mat roi_img;
+        std::vector<OCRPredictResult> page_boxes;
+        if (need_ocr)
+        {
+            this->det(img, page_boxes);
+        }
+        if (layout_done.valid())
+        {
+            layout_done.get();
+        }
+
+        // 每个检测框归入其中心点所在的首个区域
+        std::vector<std::vector<int>> region_boxes(structure_results.size());
+        for (int k = 0; k < page_boxes.size(); k++)
+        {
+            const Quad &q = page_boxes[k].box;
+            float cx = (q[0][0] + q[1][0] + q[2][0] + q[3][0]) / 4.0f;
+            float cy = (q[0][1] + q[1][1] + q[2][1] + q[3][1]) / 4.0f;
+            for (int i = 0; i < structure_results.size(); i++)
+            {
+                const std::vector<float> &b = structure_results[i].box;
+                if (cx >= b[0] && cx < b[2] && cy >= b[1] && cy < b[3])
+                {
+                    region_boxes[i].push_back(k);
+                    break;
+                }
+            }
+        }
+
+        // 表格结构：全部表格区域一次送入表格模型，按 table_batch_num 分批
+        std::vector<int> table_regions;
+        std::vector<cv::Mat> table_imgs;
         for (int i = 0; i < structure_results.size(); i++)
         {
-            // crop image
-            roi_img = Utility::crop_image(img, structure_results[i].box);
             if (structure_results[i].type == "table" && table)
             {
-                this->table(roi_img, structure_results[i]);
+                table_regions.push_back(i);
+                table_imgs.push_back(Utility::crop_image(img, structure_results[i].box));
+            }
+        }
+        std::vector<std::vector<std::string>> structure_html_tags;
+        std::vector<std::vector<std::vector<int>>> structure_boxes;
+        if (!table_imgs.empty())
+        {
+            this->table(table_imgs, structure_html_tags, structure_boxes, structure_results, table_regions);
+        }
+
+        // 收集所有区域的文字碎图，合并为一次识别（共享rec批次）
+        std::vector<cv::Mat> crops;
+        std::vector<OCRPredictResult> crop_results;
+        std::vector<std::vector<int>> region_crops(structure_results.size()); // 各区域在 crops 中的下标
+        int expand_pixel = 3;
+        int t = 0; // 当前表格在 table_regions 中的序号
+        for (int i = 0; i < structure_results.size() && need_ocr; i++)
+        {
+            bool is_table = structure_results[i].type == "table" && table;
+            if (!is_table && !ocr)
+            {
+                continue;
+            }
+            int x0 = int(structure_results[i].box[0]);
+            int y0 = int(structure_results[i].box[1]);
+            for (int n = 0; n < region_boxes[i].size(); n++)
+            {
+                OCRPredictResult res = page_boxes[region_boxes[i][n]];
+                cv::Mat crop_img;
+                if (is_table)
+                { // 表格单元格：按外接矩形外扩后从表格区域裁切
+                    const cv::Mat &table_img = table_imgs[t];
+                    for (int p = 0; p < 4; p++)
+                    {
+                        res.box[p][0] -= x0;
+                        res.box[p][1] -= y0;
+                    }
+                    std::vector<int> ocr_box = Utility::xyxyxyxy2xyxy(res.box);
+                    ocr_box[0] = std::max(0, ocr_box[0] - expand_pixel);
+                    ocr_box[1] = std::max(0, ocr_box[1] - expand_pixel);
+                    ocr_box[2] = std::min(table_img.cols, ocr_box[2] + expand_pixel);
+                    ocr_box[3] = std::min(table_img.rows, ocr_box[3] + expand_pixel);
+                    if (ocr_box[2] <= ocr_box[0] || ocr_box[3] <= ocr_box[1])
+                    {
+                        continue;
+                    }
+                    crop_img = Utility::crop_image(table_imgs[t], ocr_box);
+                }
+                else
+                { // 文字区域：从整页按四边形裁切，结果的包围盒相对于区域左上角
+                    crop_img = Utility::GetRotateCropImage(img, res.box);
+                    for (int p = 0; p < 4; p++)
+                    {
+                        res.box[p][0] -= x0;
+                        res.box[p][1] -= y0;
+                    }
+                }
+                region_crops[i].push_back(int(crops.size()));
+                crops.push_back(crop_img);
+                crop_results.push_back(res);
+            }
+            if (is_table)
+            {
+                t++;
+            }
+        }
+        if (!crops.empty())
+        {
+            this->rec(crops, crop_results);
+        }
+
+        // 分发识别结果，重建表格
+        t = 0;
+        for (int i = 0; i < structure_results.size(); i++)
+        {
+            std::vector<OCRPredictResult> ocr_result;
+            for (int n = 0; n < region_crops[i].size(); n++)
+            {
+                ocr_result.push_back(crop_results[region_crops[i][n]]);
+            }
+            if (structure_results[i].type == "table" && table)
+            {
+                structure_results[i].html = this->rebuild_table(structure_html_tags[t], structure_boxes[t],
+                                                                ocr_result);
+                t++;
             }
             else if (ocr)
             {
-                structure_results[i].text_res = this->ocr(roi_img, true, true, false);
+                structure_results[i].text_res.swap(ocr_result);
             }
         }
 
@@ -90,16 +225,15 @@ namespace PaddleOCR
         this->time_info_layout[2] += layout_times[2];
     }
 
-    void PaddleStructure::table(cv::Mat img,
-                                StructurePredictResult &structure_result)
+    void PaddleStructure::table(std::vector<cv::Mat> &img_list,
+                                std::vector<std::vector<std::string>> &structure_html_tags,
+                                std::vector<std::vector<std::vector<int>>> &structure_boxes,
+                                std::vector<StructurePredictResult> &structure_results,
+                                const std::vector<int> &regions)
     {
         // predict structure
-        std::vector<std::vector<std::string>> structure_html_tags;
-        std::vector<float> structure_scores(1, 0);
-        std::vector<std::vector<std::vector<int>>> structure_boxes;
+        std::vector<float> structure_scores;
         std::vector<double> structure_times;
-        std::vector<cv::Mat> img_list;
-        img_list.push_back(img);
 
         this->table_model_->Run(img_list, structure_html_tags, structure_scores,
                                 structure_boxes, structure_times);
@@ -108,173 +242,278 @@ namespace PaddleOCR
         this->time_info_table[1] += structure_times[1];
         this->time_info_table[2] += structure_times[2];
 
-        std::vector<OCRPredictResult> ocr_result;
-        std::string html;
-        int expand_pixel = 3;
+        for (int i = 0; i < regions.size() && i < structure_boxes.size(); i++)
+        {
+            structure_results[regions[i]].cell_box = structure_boxes[i];
+            structure_results[regions[i]].html_score = structure_scores[i];
+        }
+    }
 
-        for (int i = 0; i < img_list.size(); i++)
+    // 两个矩形的角点距离，[x1,y1,x2,y2]
+    static float dis(const std::array<int, 4> &box1, const std::array<int, 4> &box2)
+    {
+        int x1_1 = box1[0];
+        int y1_1 = box1[1];
+        int x2_1 = box1[2];
+        int y2_1 = box1[3];
+
+        int x1_2 = box2[0];
+        int y1_2 = box2[1];
+        int x2_2 = box2[2];
+        int y2_2 = box2[3];
+
+        float dis =
+            abs(x1_2 - x1_1) + abs(y1_2 - y1_1) + abs(x2_2 - x2_1) + abs(y2_2 - y2_1);
+        float dis_2 = abs(x1_2 - x1_1) + abs(y1_2 - y1_1);
+        float dis_3 = abs(x2_2 - x2_1) + abs(y2_2 - y2_1);
+        return dis + std::min(dis_2, dis_3);
+    }
+
+    // 与 Utility::iou 相同，矩形为 [x1,y1,x2,y2]
+    static float rect_iou(const std::array<int, 4> &box1, const std::array<int, 4> &box2)
+    {
+        int area1 = std::max(0, box1[2] - box1[0]) * std::max(0, box1[3] - box1[1]);
+        int area2 = std::max(0, box2[2] - box2[0]) * std::max(0, box2[3] - box2[1]);
+        int x1 = std::max(box1[0], box2[0]);
+        int y1 = std::max(box1[1], box2[1]);
+        int x2 = std::min(box1[2], box2[2]);
+        int y2 = std::min(box1[3], box2[3]);
+        if (y1 >= y2 || x1 >= x2)
         {
-            // det
-            this->det(img_list[i], ocr_result);
-            // crop image
-            std::vector<cv::Mat> rec_img_list;
-            std::vector<int> ocr_box;
-            for (int j = 0; j < ocr_result.size(); j++)
-            {
-                ocr_box = Utility::xyxyxyxy2xyxy(ocr_result[j].box);
-                ocr_box[0] = std::max(0, ocr_box[0] - expand_pixel);
-                ocr_box[1] = std::max(0, ocr_box[1] - expand_pixel),
-                ocr_box[2] = std::min(img_list[i].cols, ocr_box[2] + expand_pixel);
-                ocr_box[3] = std::min(img_list[i].rows, ocr_box[3] + expand_pixel);
-
-                cv::Mat crop_img = Utility::crop_image(img_list[i], ocr_box);
-                rec_img_list.push_back(crop_img);
-            }
-            // rec
-            this->rec(rec_img_list, ocr_result);
-            // rebuild table
-            html = this->rebuild_table(structure_html_tags[i], structure_boxes[i],
-                                       ocr_result);
-            structure_result.html = html;
-            structure_result.cell_box = structure_boxes[i];
-            structure_result.html_score = structure_scores[i];
+            return 0.0;
         }
+        int intersect = (x2 - x1) * (y2 - y1);
+        return intersect / (area1 + area2 - intersect + 0.00000001);
     }
 
-    std::string
-    PaddleStructure::rebuild_table(std::vector<std::string> structure_html_tags,
-                                   std::vector<std::vector<int>> structure_boxes,
-                                   std::vector<OCRPredictResult> &ocr_result)
+    // 表格单元格的均匀网格索引：每个单元格登记到其矩形覆盖的所有网格中。
+    // 查找时先比较与文本框所在网格相交的单元格；都不相交时由近及远逐圈扩大，
+    // 直到更远的单元格的距离下界超过已找到的最小距离
+    class CellGrid
     {
-        // match text in same cell
-        std::vector<std::vector<std::string>> matched(structure_boxes.size(),
-                                                      std::vector<std::string>());
+    public:
+        explicit CellGrid(const std::vector<std::array<int, 4>> &cells) : cells_(cells)
+        {
+            if (cells.empty())
+            {
+                return;
+            }
+            x0_ = y0_ = INT_MAX;
+            int x1 = INT_MIN, y1 = INT_MIN;
+            for (size_t i = 0; i < cells.size(); i++)
+            {
+                x0_ = std::min(x0_, cells[i][0]);
+                y0_ = std::min(y0_, cells[i][1]);
+                x1 = std::max(x1, cells[i][2]);
+                y1 = std::max(y1, cells[i][3]);
+            }
+            // 网格边长：使网格数与单元格数相当
+            int n = std::max(1, int(std::sqrt(double(cells.size()))));
+            size_ = std::max(1, std::max(x1 - x0_, y1 - y0_) / n + 1);
+            cols_ = (x1 - x0_) / size_ + 1;
+            rows_ = (y1 - y0_) / size_ + 1;
+            buckets_.resize(size_t(cols_) * rows_);
+            for (int i = 0; i < int(cells.size()); i++)
+            {
+                for (int gy = row(cells[i][1]); gy <= row(cells[i][3]); gy++)
+                {
+                    for (int gx = col(cells[i][0]); gx <= col(cells[i][2]); gx++)
+                    {
+                        buckets_[size_t(gy) * cols_ + gx].push_back(i);
+                    }
+                }
+            }
+        }
 
-        std::vector<int> ocr_box;
-        std::vector<int> structure_box;
-        for (int i = 0; i < ocr_result.size(); i++)
+        // 与 box 最匹配的单元格：先比较 1-iou，再比较 dis，最后按下标。无单元格时返回-1
+        int match(const std::array<int, 4> &box) const
         {
-            ocr_box = Utility::xyxyxyxy2xyxy(ocr_result[i].box);
-            ocr_box[0] -= 1;
-            ocr_box[1] -= 1;
-            ocr_box[2] += 1;
-            ocr_box[3] += 1;
-            std::vector<std::vector<float>> dis_list(structure_boxes.size(),
-                                                     std::vector<float>(3, 100000.0));
-            for (int j = 0; j < structure_boxes.size(); j++)
+            if (cells_.empty())
+            {
+                return -1;
+            }
+            int gx0 = col(box[0]), gx1 = col(box[2]);
+            int gy0 = row(box[1]), gy1 = row(box[3]);
+            int best = -1;
+            float best_iou = 0, best_dis = 0; // best_iou 存放 1-iou
+            for (int r = 0;; r++)
             {
-                if (structure_boxes[i].size() == 8)
+                for (int gy = std::max(0, gy0 - r); gy <= std::min(rows_ - 1, gy1 + r); gy++)
+                {
+                    bool edge_row = gy == gy0 - r || gy == gy1 + r;
+                    // 第0圈访问文本框覆盖的全部网格；之后各圈只访问外围，中间行只访问两端
+                    int step = (r == 0 || edge_row) ? 1 : std::max(1, gx1 - gx0 + 2 * r);
+                    for (int gx = gx0 - r; gx <= gx1 + r; gx += step)
+                    {
+                        if (gx < 0 || gx >= cols_)
+                        {
+                            continue;
+                        }
+                        const std::vector<int> &bucket = buckets_[size_t(gy) * cols_ + gx];
+                        for (size_t k = 0; k < bucket.size(); k++)
+                        {
+                            int j = bucket[k];
+                            float d_iou = 1 - rect_iou(box, cells_[j]);
+                            float d_dis = dis(box, cells_[j]);
+                            if (best < 0 || d_iou < best_iou ||
+                                (d_iou == best_iou && (d_dis < best_dis || (d_dis == best_dis && j < best))))
+                            {
+                                best = j;
+                                best_iou = d_iou;
+                                best_dis = d_dis;
+                            }
+                        }
+                    }
+                }
+                // 相交的单元格都在第0圈
+                if (best >= 0 && best_iou < 1)
                 {
-                    structure_box = Utility::xyxyxyxy2xyxy(structure_boxes[j]);
+                    return best;
                 }
-                else
+                // 第r圈之外的单元格与文本框至少相隔 r 个网格，dis 至少为间隔的两倍
+                if (best >= 0 && best_dis < 2.0f * r * size_)
+                {
+                    return best;
+                }
+                if (gx0 - r <= 0 && gy0 - r <= 0 && gx1 + r >= cols_ - 1 && gy1 + r >= rows_ - 1)
                 {
-                    structure_box = structure_boxes[j];
+                    return best; // 已覆盖全部网格
                 }
-                dis_list[j][0] = this->dis(ocr_box, structure_box);
-                dis_list[j][1] = 1 - Utility::iou(ocr_box, structure_box);
-                dis_list[j][2] = j;
             }
-            // find min dis idx
-            std::sort(dis_list.begin(), dis_list.end(),
-                      PaddleStructure::comparison_dis);
-            matched[dis_list[0][2]].push_back(ocr_result[i].text);
+        }
+
+    private:
+        int col(int x) const { return std::min(cols_ - 1, std::max(0, (x - x0_) / size_)); }
+        int row(int y) const { return std::min(rows_ - 1, std::max(0, (y - y0_) / size_)); }
+
+        const std::vector<std::array<int, 4>> &cells_;
+        int x0_ = 0, y0_ = 0; // 网格原点
+        int size_ = 1;        // 网格边长
+        int cols_ = 0, rows_ = 0;
+        std::vector<std::vector<int>> buckets_; // 各网格中的单元格下标
+    };
+
+    std::string
+    PaddleStructure::rebuild_table(const std::vector<std::string> &structure_html_tags,
+                                   const std::vector<std::vector<int>> &structure_boxes,
+                                   const std::vector<OCRPredictResult> &ocr_result)
+    {
+        // 单元格统一为 [x1,y1,x2,y2]
+        std::vector<std::array<int, 4>> cells(structure_boxes.size());
+        for (size_t j = 0; j < structure_boxes.size(); j++)
+        {
+            const std::vector<int> &b = structure_boxes[j];
+            if (b.size() == 8)
+            {
+                cells[j][0] = std::min(std::min(b[0], b[2]), std::min(b[4], b[6]));
+                cells[j][1] = std::min(std::min(b[1], b[3]), std::min(b[5], b[7]));
+                cells[j][2] = std::max(std::max(b[0], b[2]), std::max(b[4], b[6]));
+                cells[j][3] = std::max(std::max(b[1], b[3]), std::max(b[5], b[7]));
+            }
+            else
+            {
+                cells[j] = {b[0], b[1], b[2], b[3]};
+            }
+        }
+        CellGrid grid(cells);
+
+        // match text in same cell，存放 ocr_result 中的下标
+        std::vector<std::vector<int>> matched(structure_boxes.size());
+        size_t text_size = 0;
+        for (int i = 0; i < ocr_result.size(); i++)
+        {
+            std::vector<int> b = Utility::xyxyxyxy2xyxy(ocr_result[i].box);
+            std::array<int, 4> ocr_box = {b[0] - 1, b[1] - 1, b[2] + 1, b[3] + 1};
+            int j = grid.match(ocr_box);
+            if (j >= 0)
+            {
+                matched[j].push_back(i);
+                text_size += ocr_result[i].text.size() + 1;
+            }
         }
 
         // get pred html
-        std::string html_str = "";
+        size_t tags_size = 0;
+        for (size_t i = 0; i < structure_html_tags.size(); i++)
+        {
+            tags_size += structure_html_tags[i].size();
+        }
+        std::string html_str;
+        html_str.reserve(tags_size + text_size + 16);
         int td_tag_idx = 0;
         for (int i = 0; i < structure_html_tags.size(); i++)
         {
-            if (structure_html_tags[i].find("</td>") != std::string::npos)
+            const std::string &tag = structure_html_tags[i];
+            if (tag.find("</td>") != std::string::npos)
             {
-                if (structure_html_tags[i].find("<td></td>") != std::string::npos)
+                bool empty_td = tag.find("<td></td>") != std::string::npos;
+                if (empty_td)
                 {
-                    html_str += "<td>";
+                    html_str.append("<td>");
                 }
-                if (matched[td_tag_idx].size() > 0)
+                static const std::vector<int> no_texts;
+                const std::vector<int> &texts = td_tag_idx < matched.size() ? matched[td_tag_idx] : no_texts;
+                if (texts.size() > 0)
                 {
                     bool b_with = false;
-                    if (matched[td_tag_idx][0].find("<b>") != std::string::npos &&
-                        matched[td_tag_idx].size() > 1)
+                    if (ocr_result[texts[0]].text.find("<b>") != std::string::npos &&
+                        texts.size() > 1)
                     {
                         b_with = true;
-                        html_str += "<b>";
+                        html_str.append("<b>");
                     }
-                    for (int j = 0; j < matched[td_tag_idx].size(); j++)
+                    for (int j = 0; j < texts.size(); j++)
                     {
-                        std::string content = matched[td_tag_idx][j];
-                        if (matched[td_tag_idx].size() > 1)
+                        const std::string &text = ocr_result[texts[j]].text;
+                        if (texts.size() == 1)
                         {
-                            // remove blank, <b> and </b>
-                            if (content.length() > 0 && content.at(0) == ' ')
-                            {
-                                content = content.substr(0);
-                            }
-                            if (content.length() > 2 && content.substr(0, 3) == "<b>")
-                            {
-                                content = content.substr(3);
-                            }
-                            if (content.length() > 4 &&
-                                content.substr(content.length() - 4) == "</b>")
-                            {
-                                content = content.substr(0, content.length() - 4);
-                            }
-                            if (content.empty())
-                            {
-                                continue;
-                            }
-                            // add blank
-                            if (j != matched[td_tag_idx].size() - 1 &&
-                                content.at(content.length() - 1) != ' ')
-                            {
-                                content += ' ';
-                            }
+                            html_str.append(text);
+                            continue;
+                        }
+                        // remove <b> and </b>
+                        size_t beg = 0, end = text.length();
+                        if (end > 2 && text.compare(0, 3, "<b>") == 0)
+                        {
+                            beg = 3;
+                        }
+                        if (end - beg > 4 && text.compare(end - 4, 4, "</b>") == 0)
+                        {
+                            end -= 4;
+                        }
+                        if (beg == end)
+                        {
+                            continue;
+                        }
+                        html_str.append(text, beg, end - beg);
+                        // add blank
+                        if (j != texts.size() - 1 && text[end - 1] != ' ')
+                        {
+                            html_str.push_back(' ');
                         }
-                        html_str += content;
                     }
                     if (b_with)
                     {
-                        html_str += "</b>";
+                        html_str.append("</b>");
                     }
                 }
-                if (structure_html_tags[i].find("<td></td>") != std::string::npos)
+                if (empty_td)
                 {
-                    html_str += "</td>";
+                    html_str.append("</td>");
                 }
                 else
                 {
-                    html_str += structure_html_tags[i];
+                    html_str.append(tag);
                 }
                 td_tag_idx += 1;
             }
             else
             {
-                html_str += structure_html_tags[i];
+                html_str.append(tag);
             }
         }
         return html_str;
     }
 
-    float PaddleStructure::dis(std::vector<int> &box1, std::vector<int> &box2)
-    {
-        int x1_1 = box1[0];
-        int y1_1 = box1[1];
-        int x2_1 = box1[2];
-        int y2_1 = box1[3];
-
-        int x1_2 = box2[0];
-        int y1_2 = box2[1];
-        int x2_2 = box2[2];
-        int y2_2 = box2[3];
-
-        float dis =
-            abs(x1_2 - x1_1) + abs(y1_2 - y1_1) + abs(x2_2 - x2_1) + abs(y2_2 - y2_1);
-        float dis_2 = abs(x1_2 - x1_1) + abs(y1_2 - y1_1);
-        float dis_3 = abs(x2_2 - x2_1) + abs(y2_2 - y2_1);
-        return dis + std::min(dis_2, dis_3);
-    }
-
     void PaddleStructure::reset_timer()
     {
         this->time_info_det = {0, 0, 0};
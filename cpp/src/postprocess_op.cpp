@@ -16,8 +16,8 @@
 
 namespace PaddleOCR {
 
-void DBPostProcessor::GetContourArea(const std::vector<std::vector<float>> &box,
-                                     float unclip_ratio, float &distance) {
+void DBPostProcessor::GetContourArea(const QuadF &box, float unclip_ratio,
+                                     float &distance) {
   int pts_num = 4;
   float area = 0.0f;
   float dist = 0.0f;
@@ -34,12 +34,32 @@ void DBPostProcessor::GetContourArea(const std::vector<std::vector<float>> &box,
   distance = area * unclip_ratio / dist;
 }
 
-cv::RotatedRect DBPostProcessor::UnClip(std::vector<std::vector<float>> box,
+cv::RotatedRect DBPostProcessor::UnClip(const QuadF &box,
                                         const float &unclip_ratio) {
   float distance = 1.0;
 
   GetContourArea(box, unclip_ratio, distance);
 
+  // 矩形（GetMiniBoxes 的输出）向外偏移 distance 后，最小外接矩形即为
+  // 同中心、同方向、各边加长 2*distance 的矩形，无需构造圆角多边形
+  float ex = box[1][0] - box[0][0], ey = box[1][1] - box[0][1];
+  float fx = box[2][0] - box[1][0], fy = box[2][1] - box[1][1];
+  float w = sqrtf(ex * ex + ey * ey), h = sqrtf(fx * fx + fy * fy);
+  bool is_rect = w > 0 && h > 0 && fabs(ex * fx + ey * fy) <= 1e-3f * w * h &&
+                 fabs(box[0][0] + box[2][0] - box[1][0] - box[3][0]) <= 1e-2f &&
+                 fabs(box[0][1] + box[2][1] - box[1][1] - box[3][1]) <= 1e-2f;
+  if (is_rect) {
+    cv::Point2f center((box[0][0] + box[2][0]) / 2, (box[0][1] + box[2][1]) / 2);
+    float angle = atan2f(ey, ex) * 180.0f / float(CV_PI);
+    return cv::RotatedRect(center,
+                           cv::Size2f(w + 2 * distance, h + 2 * distance),
+                           angle);
+  }
+  return UnClipPolygon(box, distance);
+}
+
+cv::RotatedRect DBPostProcessor::UnClipPolygon(const QuadF &box,
+                                               float distance) {
   ClipperLib::ClipperOffset offset;
   ClipperLib::Path p;
   p << ClipperLib::IntPoint(int(box[0][0]), int(box[0][1]))
@@ -79,13 +99,12 @@ float **DBPostProcessor::Mat2Vec(cv::Mat mat) {
   return array;
 }
 
-std::vector<std::vector<int>>
-DBPostProcessor::OrderPointsClockwise(std::vector<std::vector<int>> pts) {
-  std::vector<std::vector<int>> box = pts;
+Quad DBPostProcessor::OrderPointsClockwise(const Quad &pts) {
+  Quad box = pts;
   std::sort(box.begin(), box.end(), XsortInt);
 
-  std::vector<std::vector<int>> leftmost = {box[0], box[1]};
-  std::vector<std::vector<int>> rightmost = {box[2], box[3]};
+  std::array<int, 2> leftmost[2] = {box[0], box[1]};
+  std::array<int, 2> rightmost[2] = {box[2], box[3]};
 
   if (leftmost[0][1] > leftmost[1][1])
     std::swap(leftmost[0], leftmost[1]);
@@ -93,48 +112,42 @@ DBPostProcessor::OrderPointsClockwise(std::vector<std::vector<int>> pts) {
   if (rightmost[0][1] > rightmost[1][1])
     std::swap(rightmost[0], rightmost[1]);
 
-  std::vector<std::vector<int>> rect = {leftmost[0], rightmost[0], rightmost[1],
-                                        leftmost[1]};
+  Quad rect;
+  rect[0] = leftmost[0];
+  rect[1] = rightmost[0];
+  rect[2] = rightmost[1];
+  rect[3] = leftmost[1];
   return rect;
 }
 
-std::vector<std::vector<float>> DBPostProcessor::Mat2Vector(cv::Mat mat) {
-  std::vector<std::vector<float>> img_vec;
-  std::vector<float> tmp;
-
-  for (int i = 0; i < mat.rows; ++i) {
-    tmp.clear();
-    for (int j = 0; j < mat.cols; ++j) {
-      tmp.push_back(mat.at<float>(i, j));
-    }
-    img_vec.push_back(tmp);
-  }
-  return img_vec;
-}
-
-bool DBPostProcessor::XsortFp32(std::vector<float> a, std::vector<float> b) {
+bool DBPostProcessor::XsortFp32(const std::array<float, 2> &a,
+                                const std::array<float, 2> &b) {
   if (a[0] != b[0])
     return a[0] < b[0];
   return false;
 }
 
-bool DBPostProcessor::XsortInt(std::vector<int> a, std::vector<int> b) {
+bool DBPostProcessor::XsortInt(const std::array<int, 2> &a,
+                               const std::array<int, 2> &b) {
   if (a[0] != b[0])
     return a[0] < b[0];
   return false;
 }
 
-std::vector<std::vector<float>>
-DBPostProcessor::GetMiniBoxes(cv::RotatedRect box, float &ssid) {
+QuadF DBPostProcessor::GetMiniBoxes(cv::RotatedRect box, float &ssid) {
   ssid = std::max(box.size.width, box.size.height);
 
-  cv::Mat points;
-  cv::boxPoints(box, points);
+  cv::Point2f points[4];
+  box.points(points); // 与 cv::boxPoints 的点序一致
 
-  auto array = Mat2Vector(points);
+  QuadF array;
+  for (int i = 0; i < 4; i++) {
+    array[i][0] = points[i].x;
+    array[i][1] = points[i].y;
+  }
   std::sort(array.begin(), array.end(), XsortFp32);
 
-  std::vector<float> idx1 = array[0], idx2 = array[1], idx3 = array[2],
+  std::array<float, 2> idx1 = array[0], idx2 = array[1], idx3 = array[2],
                      idx4 = array[3];
   if (array[3][1] <= array[2][1]) {
     idx2 = array[3];
@@ -159,55 +172,55 @@ DBPostProcessor::GetMiniBoxes(cv::RotatedRect box, float &ssid) {
   return array;
 }
 
-float DBPostProcessor::PolygonScoreAcc(std::vector<cv::Point> contour,
-                                       cv::Mat pred) {
+// 在概率图的ROI视图上计算多边形内的平均分，不复制ROI。
+// pts 为相对ROI左上角的坐标，mask_buf 为调用方复用的掩膜缓冲区。
+// 概率图可为 CV_32F，或GPU后处理得到的 CV_8U（概率×255）
+static float MaskedMean(const cv::Mat &pred, int xmin, int xmax, int ymin,
+                        int ymax, const cv::Point *pts, int npts,
+                        std::vector<unsigned char> &mask_buf) {
+  int w = xmax - xmin + 1;
+  int h = ymax - ymin + 1;
+  if (mask_buf.size() < size_t(w) * h) {
+    mask_buf.resize(size_t(w) * h);
+  }
+  cv::Mat mask(h, w, CV_8UC1, mask_buf.data());
+  mask.setTo(cv::Scalar(0));
+  const cv::Point *ppt[1] = {pts};
+  int npt[] = {npts};
+  cv::fillPoly(mask, ppt, npt, 1, cv::Scalar(1));
+  double mean = cv::mean(pred(cv::Rect(xmin, ymin, w, h)), mask)[0];
+  return float(pred.depth() == CV_8U ? mean / 255 : mean);
+}
+
+float DBPostProcessor::PolygonScoreAcc(const std::vector<cv::Point> &contour,
+                                       const cv::Mat &pred,
+                                       std::vector<unsigned char> &mask_buf) {
   int width = pred.cols;
   int height = pred.rows;
-  std::vector<float> box_x;
-  std::vector<float> box_y;
-  for (int i = 0; i < contour.size(); ++i) {
-    box_x.push_back(contour[i].x);
-    box_y.push_back(contour[i].y);
+  int xmin = contour[0].x, xmax = contour[0].x;
+  int ymin = contour[0].y, ymax = contour[0].y;
+  for (int i = 1; i < contour.size(); ++i) {
+    xmin = _min(xmin, contour[i].x);
+    xmax = _max(xmax, contour[i].x);
+    ymin = _min(ymin, contour[i].y);
+    ymax = _max(ymax, contour[i].y);
   }
+  xmin = clamp(xmin, 0, width - 1);
+  xmax = clamp(xmax, 0, width - 1);
+  ymin = clamp(ymin, 0, height - 1);
+  ymax = clamp(ymax, 0, height - 1);
 
-  int xmin =
-      clamp(int(std::floor(*(std::min_element(box_x.begin(), box_x.end())))), 0,
-            width - 1);
-  int xmax =
-      clamp(int(std::ceil(*(std::max_element(box_x.begin(), box_x.end())))), 0,
-            width - 1);
-  int ymin =
-      clamp(int(std::floor(*(std::min_element(box_y.begin(), box_y.end())))), 0,
-            height - 1);
-  int ymax =
-      clamp(int(std::ceil(*(std::max_element(box_y.begin(), box_y.end())))), 0,
-            height - 1);
-
-  cv::Mat mask;
-  mask = cv::Mat::zeros(ymax - ymin + 1, xmax - xmin + 1, CV_8UC1);
-
-  cv::Point *rook_point = new cv::Point[contour.size()];
-
+  std::vector<cv::Point> rook_point(contour.size());
   for (int i = 0; i < contour.size(); ++i) {
-    rook_point[i] = cv::Point(int(box_x[i]) - xmin, int(box_y[i]) - ymin);
+    rook_point[i] = cv::Point(contour[i].x - xmin, contour[i].y - ymin);
   }
-  const cv::Point *ppt[1] = {rook_point};
-  int npt[] = {int(contour.size())};
-
-  cv::fillPoly(mask, ppt, npt, 1, cv::Scalar(1));
-
-  cv::Mat croppedImg;
-  pred(cv::Rect(xmin, ymin, xmax - xmin + 1, ymax - ymin + 1))
-      .copyTo(croppedImg);
-  float score = cv::mean(croppedImg, mask)[0];
-
-  delete[] rook_point;
-  return score;
+  return MaskedMean(pred, xmin, xmax, ymin, ymax, rook_point.data(),
+                    int(rook_point.size()), mask_buf);
 }
 
-float DBPostProcessor::BoxScoreFast(std::vector<std::vector<float>> box_array,
-                                    cv::Mat pred) {
-  auto array = box_array;
+float DBPostProcessor::BoxScoreFast(
+    const QuadF &array, const cv::Mat &pred,
+    std::vector<unsigned char> &mask_buf) {
   int width = pred.cols;
   int height = pred.rows;
 
@@ -223,29 +236,35 @@ float DBPostProcessor::BoxScoreFast(std::vector<std::vector<float>> box_array,
   int ymax = clamp(int(std::ceil(*(std::max_element(box_y, box_y + 4)))), 0,
                    height - 1);
 
-  cv::Mat mask;
-  mask = cv::Mat::zeros(ymax - ymin + 1, xmax - xmin + 1, CV_8UC1);
-
   cv::Point root_point[4];
   root_point[0] = cv::Point(int(array[0][0]) - xmin, int(array[0][1]) - ymin);
   root_point[1] = cv::Point(int(array[1][0]) - xmin, int(array[1][1]) - ymin);
   root_point[2] = cv::Point(int(array[2][0]) - xmin, int(array[2][1]) - ymin);
   root_point[3] = cv::Point(int(array[3][0]) - xmin, int(array[3][1]) - ymin);
-  const cv::Point *ppt[1] = {root_point};
-  int npt[] = {4};
-  cv::fillPoly(mask, ppt, npt, 1, cv::Scalar(1));
-
-  cv::Mat croppedImg;
-  pred(cv::Rect(xmin, ymin, xmax - xmin + 1, ymax - ymin + 1))
-      .copyTo(croppedImg);
+  return MaskedMean(pred, xmin, xmax, ymin, ymax, root_point, 4, mask_buf);
+}
 
-  auto score = cv::mean(croppedImg, mask)[0];
-  return score;
+void DBPostProcessor::Binarize(const cv::Mat &pred, double thresh,
+                               std::vector<unsigned char> &buf,
+                               cv::Mat &bitmap) {
+  int n = pred.rows * pred.cols;
+  if (buf.size() < size_t(n)) {
+    buf.resize(n);
+  }
+  // 与先量化为 uint8 再 cv::threshold 等价：uchar(p*255) > thresh*255
+  const float t = float(std::floor(thresh * 255));
+  const float *src = pred.ptr<float>(0);
+  unsigned char *dst = buf.data();
+  for (int i = 0; i < n; i++) {
+    dst[i] = float((unsigned char)(src[i] * 255)) > t ? 255 : 0;
+  }
+  bitmap = cv::Mat(pred.rows, pred.cols, CV_8UC1, dst);
 }
 
-std::vector<std::vector<std::vector<int>>> DBPostProcessor::BoxesFromBitmap(
+std::vector<Quad> DBPostProcessor::BoxesFromBitmap(
     const cv::Mat pred, const cv::Mat bitmap, const float &box_thresh,
-    const float &det_db_unclip_ratio, const std::string &det_db_score_mode) {
+    const float &det_db_unclip_ratio, const std::string &det_db_score_mode,
+    const int threads) {
   const int min_size = 3;
   const int max_candidates = 1000;
 
@@ -260,73 +279,85 @@ std::vector<std::vector<std::vector<int>>> DBPostProcessor::BoxesFromBitmap(
 
   int num_contours =
       contours.size() >= max_candidates ? max_candidates : contours.size();
+  bool slow = det_db_score_mode == "slow";
+
+  // 各候选框互不相关，可并行打分；结果按轮廓顺序收集，输出与串行一致
+  std::vector<Quad> candidates(num_contours); // 未通过筛选的保持为空框
+#pragma omp parallel num_threads(threads) if (threads > 1 && num_contours > 1)
+  {
+    std::vector<unsigned char> mask_buf; // 每个线程复用一块掩膜缓冲区
+#pragma omp for schedule(dynamic, 16)
+    for (int _i = 0; _i < num_contours; _i++) {
+      if (contours[_i].size() <= 2) {
+        continue;
+      }
+      float ssid;
+      cv::RotatedRect box = cv::minAreaRect(contours[_i]);
+      auto array = GetMiniBoxes(box, ssid);
 
-  std::vector<std::vector<std::vector<int>>> boxes;
+      auto box_for_unclip = array;
+      // end get_mini_box
 
-  for (int _i = 0; _i < num_contours; _i++) {
-    if (contours[_i].size() <= 2) {
-      continue;
-    }
-    float ssid;
-    cv::RotatedRect box = cv::minAreaRect(contours[_i]);
-    auto array = GetMiniBoxes(box, ssid);
-
-    auto box_for_unclip = array;
-    // end get_mini_box
+      if (ssid < min_size) {
+        continue;
+      }
 
-    if (ssid < min_size) {
-      continue;
-    }
+      float score;
+      if (slow)
+        /* compute using polygon*/
+        score = PolygonScoreAcc(contours[_i], pred, mask_buf);
+      else
+        score = BoxScoreFast(array, pred, mask_buf);
 
-    float score;
-    if (det_db_score_mode == "slow")
-      /* compute using polygon*/
-      score = PolygonScoreAcc(contours[_i], pred);
-    else
-      score = BoxScoreFast(array, pred);
+      if (score < box_thresh)
+        continue;
 
-    if (score < box_thresh)
-      continue;
+      // start for unclip
+      cv::RotatedRect points = UnClip(box_for_unclip, det_db_unclip_ratio);
+      if (points.size.height < 1.001 && points.size.width < 1.001) {
+        continue;
+      }
+      // end for unclip
 
-    // start for unclip
-    cv::RotatedRect points = UnClip(box_for_unclip, det_db_unclip_ratio);
-    if (points.size.height < 1.001 && points.size.width < 1.001) {
-      continue;
-    }
-    // end for unclip
+      cv::RotatedRect clipbox = points;
+      auto cliparray = GetMiniBoxes(clipbox, ssid);
 
-    cv::RotatedRect clipbox = points;
-    auto cliparray = GetMiniBoxes(clipbox, ssid);
+      if (ssid < min_size + 2)
+        continue;
 
-    if (ssid < min_size + 2)
-      continue;
+      int dest_width = pred.cols;
+      int dest_height = pred.rows;
+      Quad &intcliparray = candidates[_i];
+
+      for (int num_pt = 0; num_pt < 4; num_pt++) {
+        intcliparray[num_pt][0] =
+            int(clampf(roundf(cliparray[num_pt][0] / float(width) *
+                              float(dest_width)),
+                       0, float(dest_width)));
+        intcliparray[num_pt][1] =
+            int(clampf(roundf(cliparray[num_pt][1] / float(height) *
+                              float(dest_height)),
+                       0, float(dest_height)));
+      }
+    } // end for
+  }
 
-    int dest_width = pred.cols;
-    int dest_height = pred.rows;
-    std::vector<std::vector<int>> intcliparray;
-
-    for (int num_pt = 0; num_pt < 4; num_pt++) {
-      std::vector<int> a{int(clampf(roundf(cliparray[num_pt][0] / float(width) *
-                                           float(dest_width)),
-                                    0, float(dest_width))),
-                         int(clampf(roundf(cliparray[num_pt][1] /
-                                           float(height) * float(dest_height)),
-                                    0, float(dest_height)))};
-      intcliparray.push_back(a);
+  std::vector<Quad> boxes;
+  for (int _i = 0; _i < num_contours; _i++) {
+    if (!candidates[_i].empty()) {
+      boxes.push_back(candidates[_i]);
     }
-    boxes.push_back(intcliparray);
-
-  } // end for
+  }
   return boxes;
 }
 
-std::vector<std::vector<std::vector<int>>> DBPostProcessor::FilterTagDetRes(
-    std::vector<std::vector<std::vector<int>>> boxes, float ratio_h,
-    float ratio_w, cv::Mat srcimg) {
+std::vector<Quad> DBPostProcessor::FilterTagDetRes(std::vector<Quad> boxes,
+                                                   float ratio_h, float ratio_w,
+                                                   const cv::Mat &srcimg) {
   int oriimg_h = srcimg.rows;
   int oriimg_w = srcimg.cols;
 
-  std::vector<std::vector<std::vector<int>>> root_points;
+  std::vector<Quad> root_points;
   for (int n = 0; n < boxes.size(); n++) {
     boxes[n] = OrderPointsClockwise(boxes[n]);
     for (int m = 0; m < boxes[0].size(); m++) {
@@ -0,0 +1,305 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#include "include/predictor.h"
+#include "include/utility.h"
+
+#include "paddle_api.h"
+#include "paddle_inference_api.h"
+
+#include <iostream>
+
+namespace PaddleOCR
+{
+    // ==================== paddle 后端 ====================
+
+    class PaddleTensor : public InferTensor
+    {
+    public:
+        explicit PaddleTensor(std::unique_ptr<paddle_infer::Tensor> tensor) : tensor_(std::move(tensor)) {}
+
+        void Reshape(const std::vector<int> &shape) override { tensor_->Reshape(shape); }
+        std::vector<int> shape() const override { return tensor_->shape(); }
+        float *MutableCpuData() override { return tensor_->mutable_data<float>(paddle_infer::PlaceType::kCPU); }
+        void CopyFromCpu(const float *data) override { tensor_->CopyFromCpu(data); }
+        void CopyToCpu(float *data) override { tensor_->CopyToCpu(data); }
+
+        const float *CpuData(int &size) override
+        {
+            paddle_infer::PlaceType place;
+            float *data = tensor_->data<float>(&place, &size);
+            return place == paddle_infer::PlaceType::kCPU ? data : nullptr;
+        }
+
+        bool ShareDeviceData(float *data, const std::vector<int> &shape) override
+        {
+            tensor_->ShareExternalData<float>(data, shape, paddle_infer::PlaceType::kGPU);
+            return true;
+        }
+
+        const float *DeviceData(int &size) override
+        {
+            paddle_infer::PlaceType place;
+            float *data = tensor_->data<float>(&place, &size);
+            return place == paddle_infer::PlaceType::kGPU ? data : nullptr;
+        }
+
+    private:
+        std::unique_ptr<paddle_infer::Tensor> tensor_;
+    };
+
+    class PaddlePredictor : public Predictor
+    {
+    public:
+        explicit PaddlePredictor(std::shared_ptr<paddle_infer::Predictor> predictor)
+            : predictor_(predictor), input_names_(predictor->GetInputNames()),
+              output_names_(predictor->GetOutputNames()) {}
+
+        InferTensor *Input(int i) override
+        {
+            if (inputs_.size() < input_names_.size())
+            {
+                inputs_.resize(input_names_.size());
+            }
+            inputs_[i].reset(new PaddleTensor(predictor_->GetInputHandle(input_names_[i])));
+            return inputs_[i].get();
+        }
+
+        InferTensor *Output(int i) override
+        {
+            if (outputs_.size() < output_names_.size())
+            {
+                outputs_.resize(output_names_.size());
+            }
+            outputs_[i].reset(new PaddleTensor(predictor_->GetOutputHandle(output_names_[i])));
+            return outputs_[i].get();
+        }
+
+        int OutputCount() override { return int(output_names_.size()); }
+        bool Run() override { return predictor_->Run(); }
+
+        Predictor *Clone(void *stream) override
+        {
+            // paddle_infer 的 Clone 共享权重，只新建中间张量等推理状态
+            std::shared_ptr<paddle_infer::Predictor> other(stream ? predictor_->Clone(stream) : predictor_->Clone());
+            return new PaddlePredictor(other);
+        }
+
+        void ShrinkMemory() override
+        {
+            predictor_->ClearIntermediateTensor();
+            predictor_->TryShrinkMemory();
+        }
+
+    private:
+        std::shared_ptr<paddle_infer::Predictor> predictor_;
+        std::vector<std::string> input_names_;
+        std::vector<std::string> output_names_;
+        std::vector<std::unique_ptr<PaddleTensor>> inputs_;
+        std::vector<std::unique_ptr<PaddleTensor>> outputs_; // 版面、表格模型同时读取多个输出
+    };
+
+    std::shared_ptr<Predictor> CreatePaddlePredictor(const PredictorOptions &options)
+    {
+        const std::string &model_dir = options.model_dir;
+        paddle_infer::Config config;
+        if (Utility::PathExists(model_dir + "/inference.pdmodel") &&
+            Utility::PathExists(model_dir + "/inference.pdiparams"))
+        {
+            config.SetModel(model_dir + "/inference.pdmodel",
+                            model_dir + "/inference.pdiparams");
+        }
+        else if (Utility::PathExists(model_dir + "/model.pdmodel") &&
+                 Utility::PathExists(model_dir + "/model.pdiparams"))
+        {
+            config.SetModel(model_dir + "/model.pdmodel",
+                            model_dir + "/model.pdiparams");
+        }
+        else
+        {
+            std::cerr << "[ERROR] not find model.pdiparams or inference.pdiparams in "
+                      << model_dir << std::endl;
+            return nullptr;
+        }
+
+        // 优化缓存：首次启动时保存图优化后的模型，之后直接加载并跳过图优化。TensorRT下改为序列化引擎
+        bool ir_optim = true;
+        std::string cache_dir = Utility::OptimCacheDir(options.optim_cache_dir, model_dir, options.use_gpu,
+                                                       options.use_tensorrt, options.use_mkldnn, options.precision);
+        if (!cache_dir.empty())
+        {
+            config.SetOptimCacheDir(cache_dir);
+            if (!options.use_tensorrt)
+            {
+                std::string cached = Utility::pathjoin(cache_dir, "_optimized");
+                if (Utility::PathExists(cached + ".pdmodel") && Utility::PathExists(cached + ".pdiparams"))
+                {
+                    config.SetModel(cached + ".pdmodel", cached + ".pdiparams");
+                    ir_optim = false;
+                }
+                else
+                {
+                    config.EnableSaveOptimModel(true);
+                }
+            }
+        }
+
+        if (options.use_gpu)
+        {
+            config.EnableUseGpu(options.gpu_mem, options.gpu_id);
+            if (options.stream)
+            {
+                config.SetExecStream(options.stream);
+            }
+            if (options.use_tensorrt)
+            {
+                auto precision = paddle_infer::Config::Precision::kFloat32;
+                if (options.precision == "fp16")
+                {
+                    precision = paddle_infer::Config::Precision::kHalf;
+                }
+                if (options.precision == "int8")
+                {
+                    precision = paddle_infer::Config::Precision::kInt8;
+                }
+                config.EnableTensorRtEngine(options.trt_workspace, options.trt_max_batch, options.trt_min_subgraph,
+                                            precision, !cache_dir.empty(), false);
+                // 形状文件随模型而定：有优化缓存时放在按模型指纹区分的缓存目录中，模型更新后重新收集
+                std::string shape_file = options.trt_shape_file;
+                if (!cache_dir.empty())
+                {
+                    shape_file = Utility::pathjoin(cache_dir, Utility::basename(shape_file));
+                }
+                if (!Utility::PathExists(shape_file))
+                {
+                    config.CollectShapeRangeInfo(shape_file);
+                }
+                else
+                {
+                    config.EnableTunedTensorRtDynamicShape(shape_file, true);
+                }
+            }
+        }
+        else
+        {
+            config.DisableGpu();
+            if (options.use_mkldnn)
+            {
+                config.EnableMKLDNN();
+                if (options.mkldnn_cache_capacity > 0)
+                { // 限制缓存的形状数，避免输入形状多变时内存持续增长
+                    config.SetMkldnnCacheCapacity(options.mkldnn_cache_capacity);
+                }
+                if (options.precision == "bf16")
+                { // 需CPU支持 avx512_bf16 或 AMX
+                    config.EnableMkldnnBfloat16();
+                }
+                else if (options.precision == "int8")
+                { // 配合量化模型（如PaddleSlim导出）使用int8内核
+                    config.EnableMkldnnInt8();
+                }
+            }
+            else
+            {
+                config.DisableMKLDNN();
+            }
+            config.SetCpuMathLibraryNumThreads(options.cpu_threads);
+        }
+
+        if (!options.delete_passes.empty())
+        {
+            auto pass_builder = config.pass_builder();
+            for (const auto &pass : options.delete_passes)
+            {
+                pass_builder->DeletePass(pass);
+            }
+        }
+        // use zero_copy_run as default
+        config.SwitchUseFeedFetchOps(false);
+        // true for multiple input
+        config.SwitchSpecifyInputNames(true);
+
+        config.SwitchIrOptim(ir_optim);
+
+        config.EnableMemoryOptim();
+        config.DisableGlogInfo();
+
+        return std::make_shared<PaddlePredictor>(paddle_infer::CreatePredictor(config));
+    }
+
+    // ==================== 工厂 ====================
+
+    std::shared_ptr<Predictor> Predictor::Create(const PredictorOptions &options)
+    {
+        std::shared_ptr<Predictor> predictor;
+        if (!Available(options.backend.empty() ? "paddle" : options.backend))
+        {
+            std::cerr << "[ERROR] inference backend " << options.backend << " is not available ("
+                      << Backends() << ") for " << options.model_dir << std::endl;
+        }
+        else if (options.backend == "onnxruntime")
+        {
+            predictor = CreateOnnxRuntimePredictor(options);
+        }
+        else if (options.backend == "openvino")
+        {
+            predictor = CreateOpenVinoPredictor(options);
+        }
+        else
+        {
+            predictor = CreatePaddlePredictor(options);
+        }
+        if (!predictor && options.exit_on_error)
+        {
+            exit(1);
+        }
+        return predictor;
+    }
+
+    bool Predictor::Available(const std::string &backend)
+    {
+        if (backend == "paddle")
+        {
+            return true;
+        }
+#ifdef PPOCR_WITH_ONNXRUNTIME
+        if (backend == "onnxruntime")
+        {
+            return true;
+        }
+#endif
+#ifdef PPOCR_WITH_OPENVINO
+        if (backend == "openvino")
+        {
+            return true;
+        }
+#endif
+        return false;
+    }
+
+    std::string Predictor::Backends()
+    {
+        std::string out = "paddle";
+#ifdef PPOCR_WITH_ONNXRUNTIME
+        out += ", onnxruntime";
+#endif
+#ifdef PPOCR_WITH_OPENVINO
+        out += ", openvino";
+#endif
+        return out;
+    }
+
+#ifndef PPOCR_WITH_ONNXRUNTIME
+    std::shared_ptr<Predictor> CreateOnnxRuntimePredictor(const PredictorOptions &)
+    {
+        return nullptr;
+    }
+#endif
+
+#ifndef PPOCR_WITH_OPENVINO
+    std::shared_ptr<Predictor> CreateOpenVinoPredictor(const PredictorOptions &)
+    {
+        return nullptr;
+    }
+#endif
+} // namespace PaddleOCR
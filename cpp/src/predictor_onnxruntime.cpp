@@ -0,0 +1,234 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+// ==================== onnxruntime 后端 ====================
+// 需编译时开启 WITH_ONNXRUNTIME。模型为 paddle2onnx 导出的 inference.onnx，输入输出均为float。
+// Session::Run 可在多线程中并发调用，克隆时共享同一个会话（及权重），只新建输入输出状态
+
+#ifdef PPOCR_WITH_ONNXRUNTIME
+
+#include "include/predictor.h"
+#include "include/utility.h"
+
+#include <onnxruntime_cxx_api.h>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <numeric>
+
+#ifdef _WIN32
+#include <codecvt>
+#include <locale>
+#endif
+
+namespace PaddleOCR
+{
+    // 会话与其依赖的环境，克隆出的实例共享
+    struct OrtModel
+    {
+        std::shared_ptr<Ort::Env> env;
+        std::shared_ptr<Ort::Session> session;
+        std::vector<std::string> input_names;
+        std::vector<std::string> output_names;
+    };
+
+    // 输入：主机上的缓冲区，推理时包装为 Ort::Value，不再复制
+    class OrtInputTensor : public InferTensor
+    {
+    public:
+        void Reshape(const std::vector<int> &shape) override
+        {
+            shape_.assign(shape.begin(), shape.end());
+            size_t size = std::accumulate(shape.begin(), shape.end(), size_t(1), std::multiplies<size_t>());
+            data_.resize(size);
+        }
+        std::vector<int> shape() const override { return std::vector<int>(shape_.begin(), shape_.end()); }
+        float *MutableCpuData() override { return data_.data(); }
+        void CopyFromCpu(const float *data) override { std::copy(data, data + data_.size(), data_.begin()); }
+        void CopyToCpu(float *data) override { std::copy(data_.begin(), data_.end(), data); }
+        const float *CpuData(int &size) override
+        {
+            size = int(data_.size());
+            return data_.data();
+        }
+
+        Ort::Value Value(const Ort::MemoryInfo &memory_info)
+        {
+            return Ort::Value::CreateTensor<float>(memory_info, data_.data(), data_.size(),
+                                                   shape_.data(), shape_.size());
+        }
+
+    private:
+        std::vector<int64_t> shape_;
+        std::vector<float> data_;
+    };
+
+    // 输出：推理结果由 onnxruntime 在主机上分配，直接读取
+    class OrtOutputTensor : public InferTensor
+    {
+    public:
+        explicit OrtOutputTensor(Ort::Value *value) : value_(value) {}
+
+        void Reshape(const std::vector<int> &) override {}
+        std::vector<int> shape() const override
+        {
+            std::vector<int64_t> shape = value_->GetTensorTypeAndShapeInfo().GetShape();
+            return std::vector<int>(shape.begin(), shape.end());
+        }
+        void CopyFromCpu(const float *) override {}
+        void CopyToCpu(float *data) override
+        {
+            int size;
+            const float *src = CpuData(size);
+            std::memcpy(data, src, size_t(size) * sizeof(float));
+        }
+        const float *CpuData(int &size) override
+        {
+            size = int(value_->GetTensorTypeAndShapeInfo().GetElementCount());
+            return value_->GetTensorMutableData<float>();
+        }
+
+    private:
+        Ort::Value *value_;
+    };
+
+    class OrtPredictor : public Predictor
+    {
+    public:
+        explicit OrtPredictor(std::shared_ptr<OrtModel> model)
+            : model_(model), memory_info_(Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault)),
+              inputs_(model->input_names.size())
+        {
+            for (const auto &name : model_->input_names)
+            {
+                input_names_.push_back(name.c_str());
+            }
+            for (const auto &name : model_->output_names)
+            {
+                output_names_.push_back(name.c_str());
+            }
+        }
+
+        InferTensor *Input(int i) override { return &inputs_[i]; }
+
+        InferTensor *Output(int i) override
+        {
+            if (outputs_.size() < output_names_.size())
+            {
+                outputs_.resize(output_names_.size());
+            }
+            outputs_[i].reset(new OrtOutputTensor(&values_[i]));
+            return outputs_[i].get();
+        }
+
+        int OutputCount() override { return int(output_names_.size()); }
+
+        bool Run() override
+        {
+            std::vector<Ort::Value> inputs;
+            for (auto &input : inputs_)
+            {
+                inputs.push_back(input.Value(memory_info_));
+            }
+            // 出错时抛出 Ort::Exception（派生自 std::exception），与 paddle 推理出错时的处理一致
+            values_ = model_->session->Run(Ort::RunOptions{nullptr}, input_names_.data(), inputs.data(),
+                                           inputs.size(), output_names_.data(), output_names_.size());
+            return true;
+        }
+
+        Predictor *Clone(void *) override { return new OrtPredictor(model_); }
+
+        void ShrinkMemory() override
+        {
+            std::vector<Ort::Value>().swap(values_);
+            outputs_.clear();
+            for (auto &input : inputs_)
+            {
+                input.Reshape({0});
+            }
+        }
+
+    private:
+        std::shared_ptr<OrtModel> model_;
+        Ort::MemoryInfo memory_info_;
+        std::vector<const char *> input_names_;
+        std::vector<const char *> output_names_;
+        std::vector<OrtInputTensor> inputs_;
+        std::vector<Ort::Value> values_; // 上一次推理的输出
+        std::vector<std::unique_ptr<OrtOutputTensor>> outputs_;
+    };
+
+    std::shared_ptr<Predictor> CreateOnnxRuntimePredictor(const PredictorOptions &options)
+    {
+        std::string model_path = options.model_dir + "/inference.onnx";
+        if (!Utility::PathExists(model_path))
+        {
+            std::cerr << "[ERROR] not find inference.onnx in " << options.model_dir << std::endl;
+            return nullptr;
+        }
+        // 所有会话共用一个环境（日志与全局线程池）
+        static std::shared_ptr<Ort::Env> env = std::make_shared<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "PaddleOCR-json");
+
+        Ort::SessionOptions session_options;
+        session_options.SetIntraOpNumThreads(options.cpu_threads);
+        session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+        // 优化缓存：首次启动时保存图优化后的模型，之后直接加载并跳过图优化
+        std::string cache_dir = Utility::OptimCacheDir(options.optim_cache_dir, options.model_dir, options.use_gpu,
+                                                       false, false, options.precision);
+        if (!cache_dir.empty())
+        {
+            std::string cached = Utility::pathjoin(cache_dir, "_optimized.onnx");
+            if (Utility::PathExists(cached))
+            {
+                model_path = cached;
+                session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_DISABLE_ALL);
+            }
+            else
+            {
+#ifdef _WIN32
+                std::wstring cached_w = std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(cached);
+                session_options.SetOptimizedModelFilePath(cached_w.c_str());
+#else
+                session_options.SetOptimizedModelFilePath(cached.c_str());
+#endif
+            }
+        }
+        if (options.use_gpu)
+        {
+            OrtCUDAProviderOptions cuda_options;
+            cuda_options.device_id = options.gpu_id;
+            session_options.AppendExecutionProvider_CUDA(cuda_options);
+        }
+
+        auto model = std::make_shared<OrtModel>();
+        model->env = env;
+        try
+        {
+#ifdef _WIN32
+            std::wstring model_path_w = std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(model_path);
+            model->session = std::make_shared<Ort::Session>(*env, model_path_w.c_str(), session_options);
+#else
+            model->session = std::make_shared<Ort::Session>(*env, model_path.c_str(), session_options);
+#endif
+        }
+        catch (const Ort::Exception &e)
+        {
+            std::cerr << "[ERROR] onnxruntime failed to load " << model_path << ": " << e.what() << std::endl;
+            return nullptr;
+        }
+        Ort::AllocatorWithDefaultOptions allocator;
+        for (size_t i = 0; i < model->session->GetInputCount(); i++)
+        {
+            model->input_names.push_back(model->session->GetInputNameAllocated(i, allocator).get());
+        }
+        for (size_t i = 0; i < model->session->GetOutputCount(); i++)
+        {
+            model->output_names.push_back(model->session->GetOutputNameAllocated(i, allocator).get());
+        }
+        return std::make_shared<OrtPredictor>(model);
+    }
+} // namespace PaddleOCR
+
+#endif // PPOCR_WITH_ONNXRUNTIME
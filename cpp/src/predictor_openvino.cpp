@@ -0,0 +1,184 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+// ==================== openvino 后端 ====================
+// 需编译时开启 WITH_OPENVINO（OpenVINO 2022.1 以上的 ov:: API）。依次尝试 inference.xml（IR）、
+// inference.onnx、inference.pdmodel（OpenVINO 可直接读取 paddle 模型）。
+// 编译后的模型在多个 InferRequest 间共享，克隆时只新建 InferRequest
+
+#ifdef PPOCR_WITH_OPENVINO
+
+#include "include/predictor.h"
+#include "include/utility.h"
+
+#include <openvino/openvino.hpp>
+
+#include <cstring>
+#include <iostream>
+
+namespace PaddleOCR
+{
+    // 编译后的模型与其所属的 Core，克隆出的实例共享
+    struct OvModel
+    {
+        std::shared_ptr<ov::Core> core;
+        std::shared_ptr<ov::CompiledModel> compiled;
+    };
+
+    class OvTensor : public InferTensor
+    {
+    public:
+        OvTensor(ov::InferRequest *request, size_t index, bool input)
+            : request_(request), index_(index), input_(input) {}
+
+        void Reshape(const std::vector<int> &shape) override
+        {
+            ov::Shape ov_shape(shape.begin(), shape.end());
+            if (!tensor_ || tensor_.get_shape() != ov_shape)
+            { // 模型为动态形状，输入张量须由调用方按形状创建
+                tensor_ = ov::Tensor(ov::element::f32, ov_shape);
+                request_->set_input_tensor(index_, tensor_);
+            }
+        }
+        std::vector<int> shape() const override
+        {
+            ov::Shape shape = Get().get_shape();
+            return std::vector<int>(shape.begin(), shape.end());
+        }
+        float *MutableCpuData() override { return input_ ? tensor_.data<float>() : nullptr; }
+        void CopyFromCpu(const float *data) override
+        {
+            std::memcpy(tensor_.data<float>(), data, tensor_.get_byte_size());
+        }
+        void CopyToCpu(float *data) override
+        {
+            ov::Tensor tensor = Get();
+            std::memcpy(data, tensor.data<float>(), tensor.get_byte_size());
+        }
+        const float *CpuData(int &size) override
+        {
+            ov::Tensor tensor = Get();
+            size = int(tensor.get_size());
+            return tensor.data<float>();
+        }
+
+        void Release() { tensor_ = ov::Tensor(); }
+
+    private:
+        ov::Tensor Get() const
+        {
+            return input_ ? tensor_ : request_->get_output_tensor(index_);
+        }
+
+        ov::InferRequest *request_;
+        size_t index_;
+        bool input_;
+        ov::Tensor tensor_; // 输入张量；输出每次从 InferRequest 读取
+    };
+
+    class OvPredictor : public Predictor
+    {
+    public:
+        explicit OvPredictor(std::shared_ptr<OvModel> model)
+            : model_(model), request_(model->compiled->create_infer_request())
+        {
+            for (size_t i = 0; i < model_->compiled->inputs().size(); i++)
+            {
+                inputs_.emplace_back(new OvTensor(&request_, i, true));
+            }
+            for (size_t i = 0; i < model_->compiled->outputs().size(); i++)
+            {
+                outputs_.emplace_back(new OvTensor(&request_, i, false));
+            }
+        }
+
+        InferTensor *Input(int i) override { return inputs_[i].get(); }
+        InferTensor *Output(int i) override { return outputs_[i].get(); }
+        int OutputCount() override { return int(outputs_.size()); }
+
+        bool Run() override
+        {
+            request_.infer(); // 出错时抛出 ov::Exception（派生自 std::exception）
+            return true;
+        }
+
+        Predictor *Clone(void *) override { return new OvPredictor(model_); }
+
+        void ShrinkMemory() override
+        {
+            for (auto &input : inputs_)
+            {
+                input->Release();
+            }
+            request_ = model_->compiled->create_infer_request(); // 丢弃中间与输出张量
+        }
+
+    private:
+        std::shared_ptr<OvModel> model_;
+        ov::InferRequest request_;
+        std::vector<std::unique_ptr<OvTensor>> inputs_;
+        std::vector<std::unique_ptr<OvTensor>> outputs_;
+    };
+
+    std::shared_ptr<Predictor> CreateOpenVinoPredictor(const PredictorOptions &options)
+    {
+        const std::string &model_dir = options.model_dir;
+        std::string model_path;
+        for (const char *name : {"/inference.xml", "/inference.onnx", "/inference.pdmodel", "/model.pdmodel"})
+        {
+            if (Utility::PathExists(model_dir + name))
+            {
+                model_path = model_dir + name;
+                break;
+            }
+        }
+        if (model_path.empty())
+        {
+            std::cerr << "[ERROR] not find inference.xml, inference.onnx or inference.pdmodel in "
+                      << model_dir << std::endl;
+            return nullptr;
+        }
+
+        auto model = std::make_shared<OvModel>();
+        model->core = std::make_shared<ov::Core>();
+        std::string device = options.use_gpu ? "GPU." + std::to_string(options.gpu_id) : "CPU";
+        ov::AnyMap config;
+        if (!options.use_gpu)
+        {
+            config.emplace(ov::inference_num_threads(options.cpu_threads));
+        }
+        // int8 需使用量化后的模型（如NNCF导出），此处不设置推理精度
+        if (options.precision == "bf16")
+        {
+            config.emplace(ov::hint::inference_precision(ov::element::bf16));
+        }
+        else if (options.precision == "fp16")
+        {
+            config.emplace(ov::hint::inference_precision(ov::element::f16));
+        }
+        else if (options.precision == "fp32")
+        {
+            config.emplace(ov::hint::inference_precision(ov::element::f32));
+        }
+        // 优化缓存：OpenVINO 自行缓存编译结果
+        std::string cache_dir = Utility::OptimCacheDir(options.optim_cache_dir, model_dir, options.use_gpu,
+                                                       false, false, options.precision);
+        if (!cache_dir.empty())
+        {
+            model->core->set_property(ov::cache_dir(cache_dir));
+        }
+        try
+        {
+            model->compiled = std::make_shared<ov::CompiledModel>(
+                model->core->compile_model(model->core->read_model(model_path), device, config));
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "[ERROR] openvino failed to load " << model_path << ": " << e.what() << std::endl;
+            return nullptr;
+        }
+        return std::make_shared<OvPredictor>(model);
+    }
+} // namespace PaddleOCR
+
+#endif // PPOCR_WITH_OPENVINO
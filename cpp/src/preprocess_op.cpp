@@ -37,6 +37,52 @@ void PermuteBatch::Run(const std::vector<cv::Mat> imgs, float *data) {
   }
 }
 
+void NormalizePermute::Run(const cv::Mat &im, float *data, const int dst_h,
+                           const int dst_w, const std::vector<float> &mean,
+                           const std::vector<float> &scale,
+                           const bool is_scale) {
+  int rh = im.rows;
+  int rw = im.cols;
+  size_t plane = size_t(dst_h) * dst_w;
+  if (im.type() != CV_8UC3) {
+    // 其它类型：退回 Normalize + 逐通道拷贝
+    cv::Mat norm_img = im.clone();
+    Normalize().Run(&norm_img, mean, scale, is_scale);
+    for (int i = 0; i < norm_img.channels(); ++i) {
+      cv::extractChannel(norm_img,
+                         cv::Mat(rh, rw, CV_32FC1, data + i * plane,
+                                 dst_w * sizeof(float)),
+                         i);
+    }
+    return;
+  }
+  // 输入只有256种取值，按通道预先算好归一化结果，每个像素只需查表
+  double e = 1.0;
+  if (is_scale) {
+    e /= 255.0;
+  }
+  float lut[3][256];
+  for (int c = 0; c < 3; ++c) {
+    for (int v = 0; v < 256; ++v) {
+      lut[c][v] = float(float(v * e) * scale[c] + (0.0 - mean[c]) * scale[c]);
+    }
+  }
+  const float *lut0 = lut[0];
+  const float *lut1 = lut[1];
+  const float *lut2 = lut[2];
+  for (int y = 0; y < rh; ++y) {
+    const uchar *src = im.ptr<uchar>(y);
+    float *d0 = data + size_t(y) * dst_w;
+    float *d1 = d0 + plane;
+    float *d2 = d1 + plane;
+    for (int x = 0; x < rw; ++x, src += 3) {
+      d0[x] = lut0[src[0]];
+      d1[x] = lut1[src[1]];
+      d2[x] = lut2[src[2]];
+    }
+  }
+}
+
 void Normalize::Run(cv::Mat *im, const std::vector<float> &mean,
                     const std::vector<float> &scale, const bool is_scale) {
   double e = 1.0;
@@ -58,6 +104,17 @@ void ResizeImgType0::Run(const cv::Mat &img, cv::Mat &resize_img,
                          float &ratio_h, float &ratio_w, bool use_tensorrt) {
   int w = img.cols;
   int h = img.rows;
+  int resize_h, resize_w;
+  TargetSize(h, w, limit_type, limit_side_len, resize_h, resize_w);
+
+  cv::resize(img, resize_img, cv::Size(resize_w, resize_h));
+  ratio_h = float(resize_h) / float(h);
+  ratio_w = float(resize_w) / float(w);
+}
+
+void ResizeImgType0::TargetSize(int h, int w, const std::string &limit_type,
+                                int limit_side_len, int &resize_h,
+                                int &resize_w) {
   float ratio = 1.f;
   if (limit_type == "min") {
     int min_wh = std::min(h, w);
@@ -79,15 +136,11 @@ void ResizeImgType0::Run(const cv::Mat &img, cv::Mat &resize_img,
     }
   }
 
-  int resize_h = int(float(h) * ratio);
-  int resize_w = int(float(w) * ratio);
+  resize_h = int(float(h) * ratio);
+  resize_w = int(float(w) * ratio);
 
   resize_h = std::max(int(round(float(resize_h) / 32) * 32), 32);
   resize_w = std::max(int(round(float(resize_w) / 32) * 32), 32);
-
-  cv::resize(img, resize_img, cv::Size(resize_w, resize_h));
-  ratio_h = float(resize_h) / float(h);
-  ratio_w = float(resize_w) / float(w);
 }
 
 void CrnnResizeImg::Run(const cv::Mat &img, cv::Mat &resize_img, float wh_ratio,
@@ -0,0 +1,300 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#include "include/reading_order.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace PaddleOCR
+{
+    typedef ReadingOrder::BBox BBox;
+
+    static const float PI = 3.14159265f;
+    static const float ANGLE_THRESHOLD = 3 * PI / 180; // 整页旋转小于该角度时不做旋转
+    static const float PARA_TH = 1.2f;                 // 段落判断中，行高用作对比的阈值
+    static const float ANGLE_ASPECT = 2.0f;            // 长短边之比达到该值的文本框才参与估计旋转角
+
+    namespace
+    {
+        // 由若干行组成的段落
+        struct Paragraph
+        {
+            int first, last; // 首行与末行
+            float space;     // 段内平均行距
+            bool has_space;  // 是否已有行距（多于一行）
+        };
+    }
+
+    static float height(const BBox &b)
+    {
+        return std::max(1.0f, b[3] - b[1]);
+    }
+
+    // 文本框长边的角度，归一化到 [-pi/2, pi/2) 附近。
+    // 接近正方形的框（如单个字符）长边方向不可靠，返回false
+    static bool box_angle(const Quad &box, float &angle)
+    {
+        float w = std::hypot(float(box[1][0] - box[0][0]), float(box[1][1] - box[0][1]));
+        float h = std::hypot(float(box[2][0] - box[1][0]), float(box[2][1] - box[1][1]));
+        if (std::max(w, h) < std::min(w, h) * ANGLE_ASPECT)
+        {
+            return false;
+        }
+        float a = w < h ? std::atan2(float(box[2][1] - box[1][1]), float(box[2][0] - box[1][0]))
+                        : std::atan2(float(box[1][1] - box[0][1]), float(box[1][0] - box[0][0]));
+        if (a < -PI / 2 + ANGLE_THRESHOLD)
+        {
+            a += PI;
+        }
+        else if (a >= PI / 2 + ANGLE_THRESHOLD)
+        {
+            a -= PI;
+        }
+        angle = a;
+        return true;
+    }
+
+    std::vector<BBox> ReadingOrder::normalized_bboxes(const std::vector<OCRPredictResult> &results)
+    {
+        int n = int(results.size());
+        std::vector<BBox> bboxes(n);
+        if (n == 0)
+        {
+            return bboxes;
+        }
+        // 估计整页旋转角，取长条文本框的中位数，没有时视为不旋转
+        std::vector<float> angles;
+        angles.reserve(n);
+        for (int i = 0; i < n; i++)
+        {
+            float a;
+            if (box_angle(results[i].box, a))
+            {
+                angles.push_back(a);
+            }
+        }
+        float angle = 0;
+        if (!angles.empty())
+        {
+            size_t mid = angles.size() / 2;
+            std::nth_element(angles.begin(), angles.begin() + mid, angles.end());
+            angle = angles[mid];
+        }
+        bool rotate = std::fabs(angle) > ANGLE_THRESHOLD;
+        float cos_a = std::cos(-angle), sin_a = std::sin(-angle);
+        for (int i = 0; i < n; i++)
+        {
+            const Quad &q = results[i].box;
+            BBox &b = bboxes[i];
+            for (int p = 0; p < 4; p++)
+            {
+                float x = float(q[p][0]), y = float(q[p][1]);
+                if (rotate)
+                {
+                    float rx = cos_a * x - sin_a * y;
+                    y = sin_a * x + cos_a * y;
+                    x = rx;
+                }
+                if (p == 0)
+                {
+                    b = {x, y, x, y};
+                }
+                b[0] = std::min(b[0], x), b[2] = std::max(b[2], x);
+                b[1] = std::min(b[1], y), b[3] = std::max(b[3], y);
+            }
+        }
+        return bboxes;
+    }
+
+    // 只有一行的段 paras[i]，符合条件时并入上一段作为末句，或下一段 paras[next] 作为首句。并入后 first 置为-1
+    static void merge_single(const std::vector<BBox> &rows, std::vector<Paragraph> &paras, int i, int next)
+    {
+        const BBox &s = rows[paras[i].first];
+        bool up = false, down = false;
+        float up_gap = 0, down_gap = 0;
+        if (i > 0)
+        { // 上段末尾：左对齐，右不超出，行距够小
+            const Paragraph &p = paras[i - 1];
+            const BBox &u = rows[p.last];
+            up = std::fabs(u[0] - s[0]) <= height(u) * PARA_TH && s[2] <= u[2] + height(u) * PARA_TH;
+            up_gap = s[1] - u[3];
+            if (p.has_space && up_gap > p.space + height(u) * 0.5f)
+            {
+                up = false;
+            }
+        }
+        if (next >= 0)
+        { // 下段开头：左对齐或缩进，右对齐（下段单行时右可超出）
+            const Paragraph &p = paras[next];
+            const BBox &d = rows[p.first];
+            if (d[0] - height(d) * PARA_TH <= s[0] && s[0] <= d[0] + height(d) * (1 + PARA_TH))
+            {
+                down = p.last > p.first ? std::fabs(d[2] - s[2]) <= height(d) * PARA_TH
+                                        : d[2] - height(d) * PARA_TH < s[2];
+            }
+            down_gap = d[1] - s[3];
+            if (p.has_space && down_gap > p.space + height(d) * 0.5f)
+            {
+                down = false;
+            }
+        }
+        if (up && down)
+        { // 都符合时选择垂直距离更近的
+            up = up_gap < down_gap;
+            down = !up;
+        }
+        if (up)
+        {
+            paras[i - 1].last = paras[i].last;
+            paras[i].first = -1;
+        }
+        else if (down)
+        {
+            paras[next].first = paras[i].first;
+            paras[i].first = -1;
+        }
+    }
+
+    std::vector<int> ReadingOrder::paragraphs(const std::vector<BBox> &rows)
+    {
+        std::vector<int> para_of_row(rows.size(), 0);
+        if (rows.empty())
+        {
+            return para_of_row;
+        }
+        std::vector<Paragraph> paras;
+        Paragraph cur = {0, 0, 0, false};
+        float pl = rows[0][0], pr = rows[0][2], ph = height(rows[0]), pb = rows[0][3];
+        for (int i = 1; i < int(rows.size()); i++)
+        {
+            const BBox &L = rows[i];
+            float space = L[1] - pb;
+            if (std::fabs(pl - L[0]) <= ph * PARA_TH && std::fabs(pr - L[2]) <= ph * PARA_TH &&
+                (!cur.has_space || space < cur.space + ph * 0.5f))
+            { // 左右边缘对齐、行距不大：同一段
+                pl = (pl + L[0]) / 2;
+                pr = (pr + L[2]) / 2;
+                ph = (ph + height(L)) / 2;
+                cur.space = cur.has_space ? (cur.space + space) / 2 : space;
+                cur.has_space = true;
+                cur.last = i;
+            }
+            else
+            {
+                paras.push_back(cur);
+                cur = {i, i, 0, false};
+                pl = L[0], pr = L[2], ph = height(L);
+            }
+            pb = L[3];
+        }
+        paras.push_back(cur);
+
+        // 只有一行的段，并入上一段或下一段。first 为-1表示已并入别的段
+        int next = -1; // 当前段之后最近的未并入的段
+        for (int i = int(paras.size()) - 1; i >= 0; i--)
+        {
+            if (paras[i].first == paras[i].last)
+            {
+                merge_single(rows, paras, i, next);
+            }
+            if (paras[i].first >= 0)
+            {
+                next = i;
+            }
+        }
+
+        int index = 0;
+        for (size_t i = 0; i < paras.size(); i++)
+        {
+            if (paras[i].first < 0)
+            {
+                continue;
+            }
+            for (int k = paras[i].first; k <= paras[i].last; k++)
+            {
+                para_of_row[k] = index;
+            }
+            index++;
+        }
+        return para_of_row;
+    }
+
+    void ReadingOrder::sort(std::vector<OCRPredictResult> &results, bool group)
+    {
+        int n = int(results.size());
+        if (n == 0)
+        {
+            return;
+        }
+        std::vector<BBox> bounds = normalized_bboxes(results);
+
+        // 按y中心扫描分行：与当前行的y中心相差不超过两者较小行高的一半时归入该行
+        std::vector<int> order(n);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](int a, int b)
+                  { return bounds[a][1] + bounds[a][3] < bounds[b][1] + bounds[b][3]; });
+        std::vector<int> line_of(n);
+        int line = -1, count = 0;
+        float cy = 0, lh = 0; // 当前行的平均y中心与行高
+        for (int k = 0; k < n; k++)
+        {
+            const BBox &b = bounds[order[k]];
+            float yc = (b[1] + b[3]) / 2, h = height(b);
+            if (line < 0 || std::fabs(yc - cy) > 0.5f * std::min(h, lh))
+            {
+                line++;
+                cy = yc, lh = h, count = 1;
+            }
+            else
+            {
+                count++;
+                cy += (yc - cy) / count;
+                lh += (h - lh) / count;
+            }
+            line_of[order[k]] = line;
+        }
+
+        // 行间按行号，行内按x排序
+        std::sort(order.begin(), order.end(), [&](int a, int b)
+                  {
+            if (line_of[a] != line_of[b])
+                return line_of[a] < line_of[b];
+            return bounds[a][0] < bounds[b][0]; });
+        std::vector<OCRPredictResult> sorted(n);
+        for (int k = 0; k < n; k++)
+        {
+            sorted[k] = std::move(results[order[k]]);
+        }
+        results.swap(sorted);
+        if (!group)
+        {
+            return;
+        }
+
+        // 各行的外接矩形，用于段落划分
+        std::vector<BBox> lines(line + 1);
+        for (int k = 0; k < n; k++)
+        {
+            const BBox &b = bounds[order[k]];
+            int l = line_of[order[k]];
+            if (k == 0 || l != line_of[order[k - 1]])
+            {
+                lines[l] = b;
+            }
+            else
+            {
+                lines[l][0] = std::min(lines[l][0], b[0]), lines[l][2] = std::max(lines[l][2], b[2]);
+                lines[l][1] = std::min(lines[l][1], b[1]), lines[l][3] = std::max(lines[l][3], b[3]);
+            }
+        }
+        std::vector<int> para_of_line = paragraphs(lines);
+        for (int k = 0; k < n; k++)
+        {
+            results[k].line = line_of[order[k]];
+            results[k].paragraph = para_of_line[line_of[order[k]]];
+        }
+    }
+
+} // namespace PaddleOCR
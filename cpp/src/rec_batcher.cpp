@@ -0,0 +1,101 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#include "include/rec_batcher.h"
+
+#include <chrono>
+
+namespace PaddleOCR
+{
+    RecBatcher::RecBatcher(CRNNRecognizer *recognizer, int window_ms, int max_crops)
+        : recognizer_(recognizer), window_ms_(window_ms), max_crops_(max_crops)
+    {
+        thread_ = std::thread(&RecBatcher::worker, this);
+    }
+
+    RecBatcher::~RecBatcher()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        job_cond_.notify_all();
+        thread_.join();
+    }
+
+    void RecBatcher::Run(const std::vector<cv::Mat> &img_list,
+                         std::vector<std::string> &rec_texts,
+                         std::vector<float> &rec_text_scores,
+                         std::vector<double> &times)
+    {
+        if (img_list.empty())
+        {
+            times.assign(3, 0.0);
+            return;
+        }
+        Job job = {&img_list, &rec_texts, &rec_text_scores, &times, false};
+        std::unique_lock<std::mutex> lock(mutex_);
+        pending_.push_back(&job);
+        pending_crops_ += static_cast<int>(img_list.size());
+        job_cond_.notify_one();
+        done_cond_.wait(lock, [&job]
+                        { return job.done; });
+    }
+
+    void RecBatcher::worker()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true)
+        {
+            job_cond_.wait(lock, [this]
+                           { return stop_ || !pending_.empty(); });
+            if (pending_.empty()) // stop_ 且无剩余请求
+            {
+                return;
+            }
+            // 收集窗口：等到窗口结束，或碎图数已凑满
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(window_ms_);
+            job_cond_.wait_until(lock, deadline, [this]
+                                 { return stop_ || pending_crops_ >= max_crops_; });
+
+            std::vector<Job *> jobs(pending_.begin(), pending_.end());
+            pending_.clear();
+            pending_crops_ = 0;
+            lock.unlock();
+
+            // 合并所有请求的碎图
+            std::vector<cv::Mat> img_list;
+            for (size_t i = 0; i < jobs.size(); i++)
+            {
+                img_list.insert(img_list.end(), jobs[i]->img_list->begin(), jobs[i]->img_list->end());
+            }
+            std::vector<std::string> rec_texts(img_list.size(), "");
+            std::vector<float> rec_text_scores(img_list.size(), 0);
+            std::vector<double> rec_times;
+            try
+            {
+                recognizer_->Run(img_list, rec_texts, rec_text_scores, rec_times);
+            }
+            catch (...) // 出错时各请求得到空结果，不让调用方永久阻塞
+            {
+                rec_times.assign(3, 0.0);
+            }
+
+            // 分发结果
+            lock.lock();
+            size_t offset = 0;
+            for (size_t i = 0; i < jobs.size(); i++)
+            {
+                Job *job = jobs[i];
+                size_t n = job->img_list->size();
+                std::copy(rec_texts.begin() + offset, rec_texts.begin() + offset + n, job->rec_texts->begin());
+                std::copy(rec_text_scores.begin() + offset, rec_text_scores.begin() + offset + n, job->rec_text_scores->begin());
+                *job->times = rec_times;
+                job->done = true;
+                offset += n;
+            }
+            done_cond_.notify_all();
+        }
+    }
+
+} // namespace PaddleOCR
@@ -0,0 +1,299 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#include "include/rec_registry.h"
+#include "include/args.h"
+#include "include/logger.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <include/dirent.h>
+#else
+#include <dirent.h>
+#endif
+
+namespace PaddleOCR
+{
+    RecRegistry &RecRegistry::get()
+    {
+        static RecRegistry registry;
+        return registry;
+    }
+
+    // 读取语言配置文件中与识别模型相关的键，其余键（det、cls等）忽略。格式与 read_config 相同
+    static std::string read_profile(RecRegistry::Profile &profile, const std::string &models_path)
+    {
+        std::ifstream infile(profile.config_path);
+        if (!infile)
+        {
+            return "rec_languages: cannot open [" + profile.config_path + "]. ";
+        }
+        // 配置文件缺少的尺寸取参数的默认值，而不是启动参数（后者可能是为另一个语言设置的）
+        profile.img_h = atoi(google::GetCommandLineFlagInfoOrDie("rec_img_h").default_value.c_str());
+        profile.img_w = atoi(google::GetCommandLineFlagInfoOrDie("rec_img_w").default_value.c_str());
+        std::string line;
+        while (getline(infile, line))
+        {
+            size_t split = line.find_first_of(" =");
+            if (line.empty() || line[0] == '#' || split == 0 || split == std::string::npos || split + 1 >= line.size())
+                continue;
+            std::string key = line.substr(0, split);
+            std::string value = line.substr(split + 1);
+            value.erase(value.find_last_not_of(" \t\r") + 1);
+            prepend_models(models_path, value);
+            if (key == "rec_model_dir")
+                profile.model_dir = value;
+            else if (key == "rec_char_dict_path")
+                profile.dict_path = value;
+            else if (key == "rec_img_h")
+                profile.img_h = atoi(value.c_str());
+            else if (key == "rec_img_w")
+                profile.img_w = atoi(value.c_str());
+        }
+        std::string msg;
+        if (profile.model_dir.empty() || !Utility::PathExists(profile.model_dir))
+        {
+            msg += "rec_languages: rec_model_dir [" + profile.model_dir + "] of " + profile.name + " does not exist. ";
+        }
+        if (profile.dict_path.empty() || !Utility::PathExists(profile.dict_path))
+        {
+            msg += "rec_languages: rec_char_dict_path [" + profile.dict_path + "] of " + profile.name + " does not exist. ";
+        }
+        if (profile.img_h <= 0 || profile.img_w <= 0)
+        {
+            msg += "rec_languages: invalid rec_img_h/rec_img_w of " + profile.name + ". ";
+        }
+        return msg;
+    }
+
+    std::string RecRegistry::configure(const std::string &spec, const std::string &models_path,
+                                       size_t budget_bytes)
+    {
+        std::vector<Profile> profiles;
+        if (spec == "auto")
+        { // 模型库目录下的 config_<lang>.txt
+            DIR *dir = opendir(models_path.c_str());
+            if (!dir)
+            {
+                return "rec_languages: cannot open models_path [" + models_path + "]. ";
+            }
+            while (struct dirent *entry = readdir(dir))
+            {
+                std::string file = entry->d_name;
+                if (file.size() > 11 && file.compare(0, 7, "config_") == 0 &&
+                    file.compare(file.size() - 4, 4, ".txt") == 0)
+                {
+                    Profile p;
+                    p.name = file.substr(7, file.size() - 11);
+                    p.config_path = Utility::pathjoin(models_path, file);
+                    profiles.push_back(p);
+                }
+            }
+            closedir(dir);
+            if (profiles.empty())
+            {
+                return "rec_languages: no config_<lang>.txt in [" + models_path + "]. ";
+            }
+        }
+        else
+        {
+            std::stringstream ss(spec);
+            std::string item;
+            while (std::getline(ss, item, ';'))
+            {
+                item.erase(0, item.find_first_not_of(" \t"));
+                item.erase(item.find_last_not_of(" \t") + 1);
+                if (item.empty())
+                    continue;
+                Profile p;
+                size_t eq = item.find('=');
+                p.name = item.substr(0, eq);
+                p.config_path = eq == std::string::npos ? Utility::pathjoin(models_path, "config_" + p.name + ".txt")
+                                                        : item.substr(eq + 1);
+                if (p.name.empty() || p.config_path.empty())
+                {
+                    return "rec_languages: invalid entry " + item + ". ";
+                }
+                profiles.push_back(p);
+            }
+        }
+        std::string msg;
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &p : profiles)
+        {
+            std::string error = read_profile(p, models_path);
+            if (!error.empty())
+            {
+                msg += error;
+                continue;
+            }
+            Entry &e = entries_[p.name];
+            e.profile = p;
+            e.lru = lru_.end();
+        }
+        budget_bytes_ = budget_bytes;
+        return msg;
+    }
+
+    bool RecRegistry::has(const std::string &lang) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_.count(lang) > 0;
+    }
+
+    std::vector<std::string> RecRegistry::languages() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<std::string> out;
+        for (const auto &e : entries_)
+        {
+            out.push_back(e.first);
+        }
+        return out;
+    }
+
+    std::vector<std::string> RecRegistry::loaded() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<std::string> out;
+        for (const auto &e : entries_)
+        {
+            if (e.second.base)
+                out.push_back(e.first);
+        }
+        return out;
+    }
+
+    std::shared_ptr<CRNNRecognizer> RecRegistry::acquire(const std::string &lang)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto it = entries_.find(lang);
+        if (it == entries_.end())
+        {
+            return nullptr;
+        }
+        Entry &e = it->second;
+        loaded_.wait(lock, [&e]
+                     { return !e.loading; });
+        if (!e.base)
+        { // 首次使用：在锁外加载，不阻塞其它语言的借用与归还
+            e.loading = true;
+            lock.unlock();
+            OCR_LOG_INFO("Loading rec model of " << lang << " from " << e.profile.model_dir);
+            std::unique_ptr<CRNNRecognizer> base(load(e.profile));
+            size_t bytes = weight_bytes(e.profile.model_dir);
+            lock.lock();
+            e.loading = false;
+            loaded_.notify_all();
+            if (!base || !base->predictor_)
+            {
+                OCR_LOG_ERROR("Failed to load rec model of " << lang);
+                return nullptr;
+            }
+            e.base = std::move(base);
+            e.bytes = bytes;
+            total_bytes_ += bytes;
+            lru_.push_front(lang);
+            e.lru = lru_.begin();
+            evict(lang);
+        }
+        else
+        {
+            lru_.splice(lru_.begin(), lru_, e.lru);
+        }
+
+        CRNNRecognizer *recognizer;
+        if (!e.idle.empty())
+        {
+            recognizer = e.idle.back().release();
+            e.idle.pop_back();
+        }
+        else
+        { // 并发借用同一语言时，按需克隆（共享权重）
+            recognizer = e.base->Clone();
+        }
+        e.leased++;
+        std::string name = lang;
+        return std::shared_ptr<CRNNRecognizer>(recognizer, [this, name](CRNNRecognizer *r)
+                                               { release(name, r); });
+    }
+
+    bool RecRegistry::ready(const std::string &lang)
+    {
+        return acquire(lang) != nullptr; // 借出的实例随即归还，留作下次借用
+    }
+
+    void RecRegistry::release(const std::string &lang, CRNNRecognizer *recognizer)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Entry &e = entries_[lang]; // 借出期间不会卸载，也不会删除登记
+        e.idle.emplace_back(recognizer);
+        e.leased--;
+        evict(""); // 此前因借用而未能卸载的语言，现在可能可以卸载
+    }
+
+    void RecRegistry::evict(const std::string &keep)
+    {
+        if (budget_bytes_ == 0)
+        {
+            return;
+        }
+        for (auto it = lru_.end(); total_bytes_ > budget_bytes_ && it != lru_.begin();)
+        {
+            --it; // 从最久未用的一端起
+            Entry &e = entries_[*it];
+            if (*it == keep || e.leased > 0)
+            {
+                continue;
+            }
+            OCR_LOG_INFO("Unloading rec model of " << *it << " (rec_memory_mb exceeded)");
+            e.idle.clear();
+            e.base.reset();
+            total_bytes_ -= e.bytes;
+            e.bytes = 0;
+            e.lru = lru_.end();
+            it = lru_.erase(it);
+        }
+        if (total_bytes_ > budget_bytes_)
+        {
+            OCR_LOG_DEBUG("rec models use " << (total_bytes_ >> 20) << "MB, over rec_memory_mb, all in use");
+        }
+    }
+
+    CRNNRecognizer *RecRegistry::load(const Profile &p)
+    {
+        // 按需加载失败时只让本次请求报错，不退出进程
+        if (!Utility::PathExists(p.dict_path))
+        {
+            OCR_LOG_ERROR("no such label file: " << p.dict_path);
+            return nullptr;
+        }
+        // 宽度分桶、批大小、精度与后端等沿用启动参数，只有模型、字典与输入尺寸随语言不同
+        return new CRNNRecognizer(
+            p.model_dir, FLAGS_use_gpu, FLAGS_gpu_id, FLAGS_gpu_mem,
+            FLAGS_cpu_threads, FLAGS_enable_mkldnn, p.dict_path,
+            FLAGS_use_tensorrt, stage_precision(FLAGS_rec_precision), FLAGS_rec_batch_num,
+            p.img_h, p.img_w, FLAGS_rec_decode_threads,
+            rec_width_buckets(), FLAGS_optim_cache_dir, FLAGS_gpu_pipeline, FLAGS_rec_backend, false);
+    }
+
+    size_t RecRegistry::weight_bytes(const std::string &model_dir)
+    {
+        // 以权重文件的大小估算常驻内存，不含推理时的中间缓冲区（借用结束后各实例按需收缩）
+        const char *files[] = {"inference.pdiparams", "model.pdiparams", "inference.onnx", "inference.bin"};
+        size_t bytes = 0;
+        for (const char *name : files)
+        {
+            std::ifstream file(model_dir + "/" + name, std::ios::binary | std::ios::ate);
+            if (file)
+            {
+                bytes = std::max(bytes, size_t(file.tellg()));
+            }
+        }
+        return bytes;
+    }
+
+} // namespace PaddleOCR
@@ -0,0 +1,115 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#include "include/reply_encoding.h"
+#include "include/args.h"
+#include "include/nlohmann/json.hpp"
+
+namespace PaddleOCR
+{
+    ReplyFormat reply_format(const httplib::Request &req)
+    {
+        if (req.has_param("format"))
+        {
+            const std::string &f = req.get_param_value("format");
+            return f == "json" ? FORMAT_JSON : f == "msgpack" ? FORMAT_MSGPACK : f == "cbor" ? FORMAT_CBOR : FORMAT_INVALID;
+        }
+        const std::string accept = req.get_header_value("Accept");
+        if (accept.find("application/msgpack") != std::string::npos || accept.find("application/x-msgpack") != std::string::npos)
+            return FORMAT_MSGPACK;
+        if (accept.find("application/cbor") != std::string::npos)
+            return FORMAT_CBOR;
+        return FORMAT_JSON;
+    }
+
+    bool flag_param(const httplib::Request &req, const char *name)
+    {
+        return req.has_param(name) && req.get_param_value(name) != "0" && req.get_param_value(name) != "false";
+    }
+
+    bool reply_param(const std::string &key)
+    {
+        return key == "format" || key == "compact" || key == "omit_cls" || key == "timing";
+    }
+
+    // 递归处理结果树：各种接口（单图、批量数组、文档各页、版面的 text_res）中的文本框都在 box 键下
+    static void compact_tree(nlohmann::json &j, bool flat_box, bool omit_cls)
+    {
+        if (j.is_array())
+        {
+            for (auto &e : j)
+                compact_tree(e, flat_box, omit_cls);
+            return;
+        }
+        if (!j.is_object())
+        {
+            return;
+        }
+        if (omit_cls)
+        {
+            j.erase("cls_label");
+            j.erase("cls_score");
+        }
+        for (auto it = j.begin(); it != j.end(); ++it)
+        {
+            nlohmann::json &v = it.value();
+            if (flat_box && it.key() == "box" && v.is_array() && !v.empty() && v[0].is_array())
+            { // 版面区域的 box 本就是 [x1,y1,x2,y2]，不受影响
+                nlohmann::json flat = nlohmann::json::array();
+                for (const auto &point : v)
+                    for (const auto &c : point)
+                        flat.push_back(c);
+                v.swap(flat);
+            }
+            else
+            {
+                compact_tree(v, flat_box, omit_cls);
+            }
+        }
+    }
+
+    void encode_reply(const httplib::Request &req, httplib::Response &res)
+    {
+        ReplyFormat format = reply_format(req);
+        bool flat_box = flag_param(req, "compact"), omit_cls = flag_param(req, "omit_cls");
+        if ((format != FORMAT_MSGPACK && format != FORMAT_CBOR && !flat_box && !omit_cls) || res.body.empty() ||
+            res.get_header_value("Content-Type") != "application/json")
+        { // 流式回复（NDJSON）的正文为空，不转换
+            return;
+        }
+        // 需重新解析整个回复（约为生成json的耗时），换来更小的回复与客户端更快的解析
+        nlohmann::json j = nlohmann::json::parse(res.body, nullptr, false);
+        if (j.is_discarded())
+        {
+            return;
+        }
+        compact_tree(j, flat_box, omit_cls);
+        if (format == FORMAT_MSGPACK)
+        {
+            std::vector<uint8_t> bin = nlohmann::json::to_msgpack(j);
+            res.set_content(std::string(bin.begin(), bin.end()), "application/msgpack");
+        }
+        else if (format == FORMAT_CBOR)
+        {
+            std::vector<uint8_t> bin = nlohmann::json::to_cbor(j);
+            res.set_content(std::string(bin.begin(), bin.end()), "application/cbor");
+        }
+        else
+        {
+            res.set_content(j.dump(-1, ' ', FLAGS_ensure_ascii, nlohmann::json::error_handler_t::replace), "application/json");
+        }
+    }
+
+    bool reject_reply_format(const httplib::Request &req, httplib::Response &res)
+    {
+        if (reply_format(req) != FORMAT_INVALID)
+        {
+            return false;
+        }
+        res.status = 400;
+        res.set_content(nlohmann::json({{"code", 400}, {"error", "format should be json, msgpack or cbor"}}).dump(),
+                        "application/json");
+        return true;
+    }
+
+} // namespace PaddleOCR
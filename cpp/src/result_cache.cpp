@@ -0,0 +1,192 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#include "include/result_cache.h"
+
+#include <cstring>
+
+namespace PaddleOCR
+{
+    // ==================== xxHash64 ====================
+    // 参考 https://github.com/Cyan4973/xxHash ，每次处理32字节，速度接近内存带宽
+
+    static const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+    static const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+    static const uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+    static const uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+    static const uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+    static inline uint64_t rotl64(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+    static inline uint64_t read64(const uint8_t *p)
+    {
+        uint64_t v;
+        memcpy(&v, p, 8); // 不要求对齐
+        return v;
+    }
+
+    static inline uint32_t read32(const uint8_t *p)
+    {
+        uint32_t v;
+        memcpy(&v, p, 4);
+        return v;
+    }
+
+    static inline uint64_t xxh_round(uint64_t acc, uint64_t input)
+    {
+        acc += input * PRIME64_2;
+        acc = rotl64(acc, 31);
+        return acc * PRIME64_1;
+    }
+
+    static inline uint64_t xxh_merge(uint64_t acc, uint64_t val)
+    {
+        acc ^= xxh_round(0, val);
+        return acc * PRIME64_1 + PRIME64_4;
+    }
+
+    static uint64_t xxhash64(const void *data, size_t len, uint64_t seed)
+    {
+        const uint8_t *p = (const uint8_t *)data;
+        const uint8_t *end = p + len;
+        uint64_t h;
+        if (len >= 32)
+        {
+            uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+            uint64_t v2 = seed + PRIME64_2;
+            uint64_t v3 = seed;
+            uint64_t v4 = seed - PRIME64_1;
+            const uint8_t *limit = end - 32;
+            do
+            {
+                v1 = xxh_round(v1, read64(p));
+                v2 = xxh_round(v2, read64(p + 8));
+                v3 = xxh_round(v3, read64(p + 16));
+                v4 = xxh_round(v4, read64(p + 24));
+                p += 32;
+            } while (p <= limit);
+            h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+            h = xxh_merge(h, v1);
+            h = xxh_merge(h, v2);
+            h = xxh_merge(h, v3);
+            h = xxh_merge(h, v4);
+        }
+        else
+        {
+            h = seed + PRIME64_5;
+        }
+        h += (uint64_t)len;
+        for (; p + 8 <= end; p += 8)
+        {
+            h ^= xxh_round(0, read64(p));
+            h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+        }
+        if (p + 4 <= end)
+        {
+            h ^= (uint64_t)read32(p) * PRIME64_1;
+            h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+            p += 4;
+        }
+        for (; p < end; p++)
+        {
+            h ^= (*p) * PRIME64_5;
+            h = rotl64(h, 11) * PRIME64_1;
+        }
+        h ^= h >> 33;
+        h *= PRIME64_2;
+        h ^= h >> 29;
+        h *= PRIME64_3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    // ==================== 缓存 ====================
+
+    ResultCache::ResultCache(size_t max_bytes) : max_bytes_(max_bytes) {}
+
+    uint64_t ResultCache::key(const cv::Mat &img, bool det, bool cls, bool rec, const std::string &parser,
+                              const OCROptions *options)
+    {
+        // 尺寸、类型与选项作为种子，避免内容相同但形状不同的图片冲突
+        uint64_t seed = xxhash64(&img.rows, sizeof(img.rows), 0);
+        seed = xxhash64(&img.cols, sizeof(img.cols), seed);
+        int type = img.type() | (det << 16) | (cls << 17) | (rec << 18);
+        seed = xxhash64(&type, sizeof(type), seed);
+        seed = xxhash64(parser.data(), parser.size(), seed);
+        // 请求的参数覆盖：阶段开关已计入 type，此处计入阈值、尺寸限制、ROI与解码倍数（后两者决定结果坐标的映射）。未传入时按默认值计，与传入默认值的键相同
+        const OCROptions &o = options ? *options : OCROptions();
+        double numbers[] = {double(o.limit_side_len), o.det_db_thresh, o.det_db_box_thresh,
+                            o.det_db_unclip_ratio, o.cls_thresh, double(o.rec_batch_num),
+                            double(o.roi_x), double(o.roi_y), double(o.roi_w), double(o.roi_h),
+                            double(o.decode_scale), double(o.det_adaptive)};
+        seed = xxhash64(numbers, sizeof(numbers), seed);
+        seed = xxhash64(o.limit_type.data(), o.limit_type.size(), seed);
+        seed = xxhash64(o.det_db_score_mode.data(), o.det_db_score_mode.size(), seed);
+        seed = xxhash64(o.lang.data(), o.lang.size(), seed);
+        size_t row_bytes = img.cols * img.elemSize();
+        if (img.isContinuous()) // 连续内存一次哈希
+        {
+            return xxhash64(img.data, row_bytes * img.rows, seed);
+        }
+        for (int y = 0; y < img.rows; y++) // 有行填充（如ROI、共享内存的 stride），逐行串联
+        {
+            seed = xxhash64(img.ptr(y), row_bytes, seed);
+        }
+        return seed;
+    }
+
+    size_t ResultCache::entry_bytes(const Entry &e)
+    {
+        // 结果字符串，加上链表节点与索引的大致开销
+        return e.json.capacity() + sizeof(Entry) + 64;
+    }
+
+    bool ResultCache::get(uint64_t key, std::string &json)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it == index_.end())
+        {
+            misses_++;
+            return false;
+        }
+        lru_.splice(lru_.begin(), lru_, it->second); // 移到表头
+        json = it->second->json;
+        hits_++;
+        return true;
+    }
+
+    void ResultCache::put(uint64_t key, const std::string &json)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it != index_.end()) // 并发请求了同一张图，已由其它引擎存入
+        {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            return;
+        }
+        Entry entry = {key, json};
+        size_t size = entry_bytes(entry);
+        if (size > max_bytes_) // 单个结果超过上限，不缓存
+        {
+            return;
+        }
+        while (bytes_ + size > max_bytes_ && !lru_.empty()) // 淘汰最久未用
+        {
+            bytes_ -= entry_bytes(lru_.back());
+            index_.erase(lru_.back().key);
+            lru_.pop_back();
+        }
+        lru_.push_front(std::move(entry));
+        index_[key] = lru_.begin();
+        bytes_ += size;
+    }
+
+    ResultCache::Stats ResultCache::stats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Stats s = {hits_, misses_, lru_.size(), bytes_};
+        return s;
+    }
+
+} // namespace PaddleOCR
@@ -0,0 +1,448 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#include "include/router.h"
+#include "include/args.h"
+#include "include/logger.h"
+#include "include/nlohmann/json.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+namespace PaddleOCR
+{
+    // 转交给后端的请求头：准入控制的优先级、租户与截止时间，回复格式与请求追踪
+    static const char *FORWARD_HEADERS[] = {"X-Priority", "X-Tenant", "X-Request-Timeout-Ms", "Accept", "traceparent"};
+
+    static std::string error_json(int code, const std::string &message)
+    {
+        return nlohmann::json({{"code", code}, {"error", message}}).dump();
+    }
+
+    Router::Router(int port, const std::string &backends) : port_(port)
+    {
+        std::stringstream ss(backends);
+        std::string item;
+        while (std::getline(ss, item, ';'))
+        {
+            size_t colon = item.rfind(':');
+            if (item.empty() || colon == std::string::npos)
+                continue;
+            Backend b;
+            b.host = item.substr(0, colon);
+            b.port = atoi(item.c_str() + colon + 1);
+            backends_.push_back(b);
+        }
+
+        const char *forwarded[] = {"/api/ocr", "/api/ocr/base64", "/api/det", "/api/rec", "/api/structure"};
+        for (const char *path : forwarded)
+        {
+            server_.Post(path, [this](const httplib::Request &req, httplib::Response &res)
+                         { handle_forward(req, res); });
+        }
+        server_.Post("/api/ocr/batch", [this](const httplib::Request &req, httplib::Response &res)
+                     { handle_batch(req, res); });
+        server_.Get("/api/health", [this](const httplib::Request &req, httplib::Response &res)
+                    { handle_health(req, res); });
+        // 转发期间线程阻塞在后端的回复上，线程数按排队上限留足
+        size_t threads = size_t(FLAGS_server_queue_max) + 8 + backends_.size() * 4;
+        server_.new_task_queue = [threads]
+        { return new httplib::ThreadPool(threads, threads); };
+    }
+
+    int Router::run()
+    {
+        std::thread poller(&Router::poll, this);
+        std::cout << "Router listening on 0.0.0.0:" << port_ << ", backends:";
+        for (size_t i = 0; i < backends_.size(); i++)
+        {
+            std::cout << " " << backends_[i].host << ":" << backends_[i].port;
+        }
+        std::cout << std::endl;
+        server_.listen("0.0.0.0", port_);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        stop_cv_.notify_all();
+        poller.join();
+        return 0;
+    }
+
+    void Router::poll()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_)
+        {
+            for (size_t i = 0; i < backends_.size(); i++)
+            {
+                std::string host = backends_[i].host;
+                int port = backends_[i].port;
+                lock.unlock();
+                httplib::Client client(host, port);
+                client.set_connection_timeout(1);
+                client.set_read_timeout(2);
+                httplib::Result result = client.Get("/api/health");
+                nlohmann::json health;
+                if (result)
+                {
+                    health = nlohmann::json::parse(result->body, nullptr, false);
+                }
+                lock.lock();
+                Backend &b = backends_[i];
+                bool up = result && health.is_object();
+                if (up != b.up)
+                {
+                    OCR_LOG_INFO("Backend " << host << ":" << port << (up ? " up" : " down"));
+                }
+                b.up = up;
+                b.sent = 0;
+                if (!up)
+                {
+                    continue;
+                }
+                b.engines = std::max(1, health.value("engines", 1));
+                const nlohmann::json admission = health.value("admission", nlohmann::json::object());
+                b.reported = admission.value("inflight", 0) + admission.value("queued", 0);
+                b.languages.clear();
+                b.loaded.clear();
+                for (const auto &lang : health.value("rec_languages", nlohmann::json::array()))
+                {
+                    if (lang.is_string())
+                        b.languages.insert(lang.get<std::string>());
+                }
+                for (const auto &lang : health.value("rec_loaded", nlohmann::json::array()))
+                {
+                    if (lang.is_string())
+                        b.loaded.insert(lang.get<std::string>());
+                }
+            }
+            stop_cv_.wait_for(lock, std::chrono::milliseconds(FLAGS_router_poll_ms), [this]
+                              { return stopping_; });
+        }
+    }
+
+    double Router::cost(const Backend &b, const std::string &lang) const
+    {
+        int load = b.reported + b.sent;
+        if (!lang.empty() && !b.loaded.count(lang))
+        {
+            load++;
+        }
+        return double(load) / b.engines;
+    }
+
+    int Router::pick(const std::string &lang, const std::vector<char> &tried)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        int best = -1;
+        double best_cost = 0;
+        for (size_t i = 0; i < backends_.size(); i++)
+        {
+            const Backend &b = backends_[i];
+            if (tried[i] || !b.up || (!lang.empty() && !b.languages.count(lang)))
+                continue;
+            double c = cost(b, lang);
+            if (best < 0 || c < best_cost)
+            {
+                best = int(i);
+                best_cost = c;
+            }
+        }
+        return best;
+    }
+
+    std::vector<std::pair<int, size_t>> Router::shard(const std::string &lang, size_t count)
+    {
+        std::vector<std::pair<double, int>> candidates;
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < backends_.size(); i++)
+        {
+            const Backend &b = backends_[i];
+            if (b.up && (lang.empty() || b.languages.count(lang)))
+                candidates.push_back(std::make_pair(cost(b, lang), int(i)));
+        }
+        std::sort(candidates.begin(), candidates.end());
+        // 只拆给与最空闲者相差不到一个满载引擎的后端：明显更忙的后端分到图片，反而拖慢整个批量
+        std::vector<std::pair<int, size_t>> out;
+        int engines = 0;
+        for (size_t k = 0; k < candidates.size() && out.size() < count; k++)
+        {
+            if (candidates[k].first > candidates[0].first + 1)
+                break;
+            out.push_back(std::make_pair(candidates[k].second, size_t(0)));
+            engines += backends_[candidates[k].second].engines;
+        }
+        size_t assigned = 0;
+        for (size_t k = 0; k < out.size(); k++)
+        {
+            size_t n = k + 1 == out.size() ? count - assigned
+                                           : std::max<size_t>(1, count * backends_[out[k].first].engines / engines);
+            n = std::min(n, count - assigned - (out.size() - k - 1)); // 给后面的后端每个至少留一张
+            out[k].second = n;
+            assigned += n;
+        }
+        return out;
+    }
+
+    void Router::begin(int index)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        backends_[index].sent++;
+        backends_[index].outstanding++;
+    }
+
+    void Router::end(int index, bool reachable)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Backend &b = backends_[index];
+        b.outstanding--;
+        if (!reachable && b.up)
+        {
+            b.up = false;
+            OCR_LOG_WARN("Backend " << b.host << ":" << b.port << " unreachable");
+        }
+    }
+
+    bool Router::send(int index, const httplib::Request &req, const std::string &body,
+                      const httplib::UploadFormDataItems *items, httplib::Response &res)
+    {
+        std::string host;
+        int port;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            host = backends_[index].host;
+            port = backends_[index].port;
+        }
+        httplib::Client client(host, port);
+        client.set_connection_timeout(2);
+        client.set_read_timeout(std::chrono::milliseconds(FLAGS_router_timeout_ms));
+        client.set_write_timeout(std::chrono::milliseconds(FLAGS_router_timeout_ms));
+        httplib::Headers headers;
+        for (const char *name : FORWARD_HEADERS)
+        {
+            if (req.has_header(name))
+                headers.emplace(name, req.get_header_value(name));
+        }
+        std::string path = httplib::append_query_params(req.path, req.params);
+        httplib::Result result = items ? client.Post(path, headers, *items)
+                                       : client.Post(path, headers, body, req.get_header_value("Content-Type"));
+        if (!result)
+        {
+            return false;
+        }
+        res.status = result->status;
+        if (result->has_header("Retry-After"))
+        {
+            res.set_header("Retry-After", result->get_header_value("Retry-After"));
+        }
+        res.set_content(result->body, result->get_header_value("Content-Type"));
+        return true;
+    }
+
+    void Router::dispatch(const httplib::Request &req, const std::string &lang, const std::string &body,
+                          const httplib::UploadFormDataItems *items, httplib::Response &res, int preferred)
+    {
+        std::vector<char> tried(backends_.size(), 0);
+        bool answered = false;
+        while (true)
+        {
+            int index = preferred;
+            preferred = -1;
+            if (index < 0)
+            {
+                index = pick(lang, tried);
+            }
+            if (index < 0)
+            {
+                break;
+            }
+            tried[index] = 1;
+            begin(index);
+            bool reachable = send(index, req, body, items, res);
+            end(index, reachable);
+            if (reachable)
+            {
+                answered = true;
+                if (res.status != 503) // 繁忙时换一个后端，否则原样回复（包括后端的4xx）
+                    return;
+            }
+        }
+        if (!answered)
+        {
+            res.status = 503;
+            res.set_header("Retry-After", "1");
+            res.set_content(error_json(503, lang.empty() ? "No backend available"
+                                                         : "No backend available for lang " + lang),
+                            "application/json");
+        }
+    }
+
+    // 请求的识别语言：URL参数、表单字段，或json请求体中的 lang
+    static std::string request_lang(const httplib::Request &req, const nlohmann::json *body)
+    {
+        if (req.has_param("lang"))
+            return req.get_param_value("lang");
+        if (req.form.has_field("lang"))
+            return req.form.get_field("lang");
+        if (body && body->is_object())
+            return body->value("lang", std::string());
+        return std::string();
+    }
+
+    // multipart 请求在 httplib 中已拆为字段与文件，转发时重新组装
+    static void form_items(const httplib::Request &req, httplib::UploadFormDataItems &items, bool with_images)
+    {
+        for (const auto &field : req.form.fields)
+        {
+            items.push_back(httplib::UploadFormData{field.first, field.second.content, "", ""});
+        }
+        for (const auto &file : req.form.files)
+        {
+            if (with_images || file.first != "image")
+                items.push_back(httplib::UploadFormData{file.first, file.second.content, file.second.filename,
+                                                        file.second.content_type});
+        }
+    }
+
+    void Router::handle_forward(const httplib::Request &req, httplib::Response &res)
+    {
+        if (req.is_multipart_form_data())
+        {
+            httplib::UploadFormDataItems items;
+            form_items(req, items, true);
+            dispatch(req, request_lang(req, nullptr), std::string(), &items, res);
+            return;
+        }
+        // 只在正文提到 lang 时才解析（正文多为大段base64）
+        nlohmann::json body;
+        if (req.body.find("\"lang\"") != std::string::npos)
+        {
+            body = nlohmann::json::parse(req.body, nullptr, false);
+        }
+        dispatch(req, request_lang(req, &body), req.body, nullptr, res);
+    }
+
+    void Router::handle_batch(const httplib::Request &req, httplib::Response &res)
+    {
+        // NDJSON 流式回复按完成顺序、带下标，不拆分
+        bool stream = req.has_param("stream") && req.get_param_value("stream") != "0" &&
+                      req.get_param_value("stream") != "false";
+        // MessagePack/CBOR 回复无法按json数组合并，也不拆分
+        std::string accept = req.get_header_value("Accept");
+        stream = stream || (req.has_param("format") && req.get_param_value("format") != "json") ||
+                 accept.find("msgpack") != std::string::npos || accept.find("cbor") != std::string::npos;
+        bool multipart = req.is_multipart_form_data();
+        nlohmann::json body;
+        size_t count = 0;
+        if (multipart)
+        {
+            count = req.form.get_file_count("image");
+        }
+        else
+        {
+            body = nlohmann::json::parse(req.body, nullptr, false);
+            if (body.is_object() && body.contains("images") && body["images"].is_array())
+                count = body["images"].size();
+        }
+        std::string lang = request_lang(req, multipart ? nullptr : &body);
+        std::vector<std::pair<int, size_t>> shards = stream || count < 2 ? std::vector<std::pair<int, size_t>>()
+                                                                         : shard(lang, count);
+        if (shards.size() < 2)
+        { // 流式、只有一张图片、请求有误（交给后端报告）或只有一个可用后端：整体转发
+            httplib::UploadFormDataItems items;
+            if (multipart)
+                form_items(req, items, true);
+            dispatch(req, lang, req.body, multipart ? &items : nullptr, res);
+            return;
+        }
+        OCR_LOG_DEBUG("Batch of " << count << " images sharded to " << shards.size() << " backends");
+        std::vector<httplib::Response> parts(shards.size());
+        std::vector<std::thread> threads;
+        std::vector<httplib::FormData> files = multipart ? req.form.get_files("image") : std::vector<httplib::FormData>();
+        size_t begin_index = 0;
+        for (size_t k = 0; k < shards.size(); k++)
+        {
+            size_t first = begin_index, n = shards[k].second;
+            begin_index += n;
+            int preferred = shards[k].first;
+            threads.emplace_back([&, first, n, preferred, k]
+                                 {
+                if (multipart)
+                {
+                    httplib::UploadFormDataItems items;
+                    form_items(req, items, false);
+                    for (size_t i = first; i < first + n; i++)
+                        items.push_back(httplib::UploadFormData{"image", files[i].content, files[i].filename,
+                                                                files[i].content_type});
+                    dispatch(req, lang, std::string(), &items, parts[k], preferred);
+                }
+                else
+                {
+                    nlohmann::json sub = nlohmann::json::object();
+                    for (auto it = body.begin(); it != body.end(); ++it)
+                    {
+                        if (it.key() != "images")
+                            sub[it.key()] = it.value();
+                    }
+                    const nlohmann::json &images = body["images"];
+                    sub["images"] = nlohmann::json(images.begin() + first, images.begin() + first + n);
+                    dispatch(req, lang, sub.dump(), nullptr, parts[k], preferred);
+                } });
+        }
+        for (auto &t : threads)
+        {
+            t.join();
+        }
+        // 合并各分片的结果数组；任一分片失败时回复该分片的错误
+        std::string merged = "[";
+        for (size_t k = 0; k < parts.size(); k++)
+        {
+            const std::string &part = parts[k].body;
+            if (parts[k].status != 200 || part.size() < 2 || part.front() != '[' || part.back() != ']')
+            {
+                res.status = parts[k].status == 200 ? 502 : parts[k].status;
+                res.set_content(parts[k].status == 200 ? error_json(502, "Invalid batch reply from backend") : part,
+                                "application/json");
+                return;
+            }
+            if (part.size() > 2)
+            {
+                if (merged.size() > 1)
+                    merged += ",";
+                merged.append(part, 1, part.size() - 2);
+            }
+        }
+        merged += "]";
+        res.set_content(merged, "application/json");
+    }
+
+    void Router::handle_health(const httplib::Request &req, httplib::Response &res)
+    {
+        nlohmann::json list = nlohmann::json::array();
+        int up = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const Backend &b : backends_)
+            {
+                up += b.up;
+                list.push_back({{"backend", b.host + ":" + std::to_string(b.port)},
+                                {"up", b.up},
+                                {"engines", b.engines},
+                                {"load", b.reported + b.sent},
+                                {"outstanding", b.outstanding},
+                                {"rec_languages", b.languages},
+                                {"rec_loaded", b.loaded}});
+            }
+        }
+        nlohmann::json response = {
+            {"status", up > 0 ? "ok" : "unavailable"},
+            {"backends", list},
+            {"backends_up", up}};
+        res.status = up > 0 ? 200 : 503;
+        res.set_content(response.dump(), "application/json");
+    }
+
+} // namespace PaddleOCR
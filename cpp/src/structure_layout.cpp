@@ -31,21 +31,18 @@ namespace PaddleOCR
         // preprocess
         auto preprocess_start = std::chrono::steady_clock::now();
 
-        cv::Mat srcimg;
-        img.copyTo(srcimg);
         cv::Mat resize_img;
-        this->resize_op_.Run(srcimg, resize_img, 800, 608);
-        this->normalize_op_.Run(&resize_img, this->mean_, this->scale_,
-                                this->is_scale_);
+        this->resize_op_.Run(img, resize_img, 800, 608);
 
         std::vector<float> input(1 * 3 * resize_img.rows * resize_img.cols, 0.0f);
-        this->permute_op_.Run(&resize_img, input.data());
+        this->norm_permute_op_.Run(resize_img, input.data(), resize_img.rows,
+                                   resize_img.cols, this->mean_, this->scale_,
+                                   this->is_scale_);
         auto preprocess_end = std::chrono::steady_clock::now();
         preprocess_diff += preprocess_end - preprocess_start;
 
         // inference.
-        auto input_names = this->predictor_->GetInputNames();
-        auto input_t = this->predictor_->GetInputHandle(input_names[0]);
+        InferTensor *input_t = this->predictor_->Input(0);
         input_t->Reshape({1, 3, resize_img.rows, resize_img.cols});
         auto inference_start = std::chrono::steady_clock::now();
         input_t->CopyFromCpu(input.data());
@@ -55,10 +52,10 @@ namespace PaddleOCR
         // Get output tensor
         std::vector<std::vector<float>> out_tensor_list;
         std::vector<std::vector<int>> output_shape_list;
-        auto output_names = this->predictor_->GetOutputNames();
-        for (int j = 0; j < output_names.size(); j++)
+        int output_count = this->predictor_->OutputCount();
+        for (int j = 0; j < output_count; j++)
         {
-            auto output_tensor = this->predictor_->GetOutputHandle(output_names[j]);
+            InferTensor *output_tensor = this->predictor_->Output(j);
             std::vector<int> output_shape = output_tensor->shape();
             int out_num = std::accumulate(output_shape.begin(), output_shape.end(), 1,
                                           std::multiplies<int>());
@@ -85,7 +82,7 @@ namespace PaddleOCR
                 break;
             }
         }
-        std::vector<int> ori_shape = {srcimg.rows, srcimg.cols};
+        std::vector<int> ori_shape = {img.rows, img.cols};
         std::vector<int> resize_shape = {resize_img.rows, resize_img.cols};
         this->post_processor_.Run(result, out_tensor_list, ori_shape, resize_shape,
                                   reg_max);
@@ -100,75 +97,29 @@ namespace PaddleOCR
 
     void StructureLayoutRecognizer::LoadModel(const std::string &model_dir)
     {
-        paddle_infer::Config config;
-        if (Utility::PathExists(model_dir + "/inference.pdmodel") &&
-            Utility::PathExists(model_dir + "/inference.pdiparams"))
-        {
-            config.SetModel(model_dir + "/inference.pdmodel",
-                            model_dir + "/inference.pdiparams");
-        }
-        else if (Utility::PathExists(model_dir + "/model.pdmodel") &&
-                 Utility::PathExists(model_dir + "/model.pdiparams"))
-        {
-            config.SetModel(model_dir + "/model.pdmodel",
-                            model_dir + "/model.pdiparams");
-        }
-        else
-        {
-            std::cerr << "[ERROR] not find model.pdiparams or inference.pdiparams in "
-                      << model_dir << std::endl;
-            exit(1);
-        }
-
-        if (this->use_gpu_)
-        {
-            config.EnableUseGpu(this->gpu_mem_, this->gpu_id_);
-            if (this->use_tensorrt_)
-            {
-                auto precision = paddle_infer::Config::Precision::kFloat32;
-                if (this->precision_ == "fp16")
-                {
-                    precision = paddle_infer::Config::Precision::kHalf;
-                }
-                if (this->precision_ == "int8")
-                {
-                    precision = paddle_infer::Config::Precision::kInt8;
-                }
-                config.EnableTensorRtEngine(1 << 20, 10, 3, precision, false, false);
-                if (!Utility::PathExists("./trt_layout_shape.txt"))
-                {
-                    config.CollectShapeRangeInfo("./trt_layout_shape.txt");
-                }
-                else
-                {
-                    config.EnableTunedTensorRtDynamicShape("./trt_layout_shape.txt", true);
-                }
-            }
-        }
-        else
-        {
-            config.DisableGpu();
-            if (this->use_mkldnn_)
-            {
-                config.EnableMKLDNN();
-            }
-            else
-            {
-                config.DisableMKLDNN();
-            }
-            config.SetCpuMathLibraryNumThreads(this->cpu_math_library_num_threads_);
-        }
-
-        // false for zero copy tensor
-        config.SwitchUseFeedFetchOps(false);
-        // true for multiple input
-        config.SwitchSpecifyInputNames(true);
-
-        config.SwitchIrOptim(true);
-
-        config.EnableMemoryOptim();
-        config.DisableGlogInfo();
+        PredictorOptions options;
+        options.backend = this->backend_;
+        options.model_dir = model_dir;
+        options.use_gpu = this->use_gpu_;
+        options.gpu_id = this->gpu_id_;
+        options.gpu_mem = this->gpu_mem_;
+        options.cpu_threads = this->cpu_math_library_num_threads_;
+        options.use_mkldnn = this->use_mkldnn_;
+        options.precision = this->precision_;
+        options.use_tensorrt = this->use_tensorrt_;
+        options.trt_workspace = 1 << 20;
+        options.trt_max_batch = 10;
+        options.trt_min_subgraph = 3;
+        options.trt_shape_file = "./trt_layout_shape.txt";
+
+        this->predictor_ = Predictor::Create(options);
+    }
 
-        this->predictor_ = paddle_infer::CreatePredictor(config);
+    StructureLayoutRecognizer *StructureLayoutRecognizer::Clone() const
+    {
+        StructureLayoutRecognizer *other = new StructureLayoutRecognizer(*this); // 复制参数与前后处理算子
+        // 推理实例的 Clone 共享权重，只新建中间张量等推理状态
+        other->predictor_ = std::shared_ptr<Predictor>(this->predictor_->Clone(nullptr));
+        return other;
     }
 } // namespace PaddleOCR
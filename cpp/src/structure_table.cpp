@@ -39,40 +39,33 @@ namespace PaddleOCR
             auto preprocess_start = std::chrono::steady_clock::now();
             int end_img_no = std::min(img_num, beg_img_no + this->table_batch_num_);
             int batch_num = end_img_no - beg_img_no;
-            std::vector<cv::Mat> norm_img_batch;
             std::vector<int> width_list;
             std::vector<int> height_list;
+            // 归一化后的图片直接写入输入缓冲区，右下方填充部分保持为0
+            int image_size = 3 * this->table_max_len_ * this->table_max_len_;
+            std::vector<float> input(batch_num * image_size, 0.0f);
             for (int ino = beg_img_no; ino < end_img_no; ino++)
             {
-                cv::Mat srcimg;
-                img_list[ino].copyTo(srcimg);
                 cv::Mat resize_img;
-                cv::Mat pad_img;
-                this->resize_op_.Run(srcimg, resize_img, this->table_max_len_);
-                this->normalize_op_.Run(&resize_img, this->mean_, this->scale_,
-                                        this->is_scale_);
-                this->pad_op_.Run(resize_img, pad_img, this->table_max_len_);
-                norm_img_batch.push_back(pad_img);
-                width_list.push_back(srcimg.cols);
-                height_list.push_back(srcimg.rows);
+                this->resize_op_.Run(img_list[ino], resize_img, this->table_max_len_);
+                this->norm_permute_op_.Run(resize_img,
+                                           input.data() + (ino - beg_img_no) * image_size,
+                                           this->table_max_len_, this->table_max_len_,
+                                           this->mean_, this->scale_, this->is_scale_);
+                width_list.push_back(img_list[ino].cols);
+                height_list.push_back(img_list[ino].rows);
             }
-
-            std::vector<float> input(
-                batch_num * 3 * this->table_max_len_ * this->table_max_len_, 0.0f);
-            this->permute_op_.Run(norm_img_batch, input.data());
             auto preprocess_end = std::chrono::steady_clock::now();
             preprocess_diff += preprocess_end - preprocess_start;
             // inference.
-            auto input_names = this->predictor_->GetInputNames();
-            auto input_t = this->predictor_->GetInputHandle(input_names[0]);
+            InferTensor *input_t = this->predictor_->Input(0);
             input_t->Reshape(
                 {batch_num, 3, this->table_max_len_, this->table_max_len_});
             auto inference_start = std::chrono::steady_clock::now();
             input_t->CopyFromCpu(input.data());
             this->predictor_->Run();
-            auto output_names = this->predictor_->GetOutputNames();
-            auto output_tensor0 = this->predictor_->GetOutputHandle(output_names[0]);
-            auto output_tensor1 = this->predictor_->GetOutputHandle(output_names[1]);
+            InferTensor *output_tensor0 = this->predictor_->Output(0);
+            InferTensor *output_tensor1 = this->predictor_->Output(1);
             std::vector<int> predict_shape0 = output_tensor0->shape();
             std::vector<int> predict_shape1 = output_tensor1->shape();
 
@@ -124,59 +117,29 @@ namespace PaddleOCR
 
     void StructureTableRecognizer::LoadModel(const std::string &model_dir)
     {
-        paddle_infer::Config config;
-        config.SetModel(model_dir + "/inference.pdmodel",
-                        model_dir + "/inference.pdiparams");
-
-        if (this->use_gpu_)
-        {
-            config.EnableUseGpu(this->gpu_mem_, this->gpu_id_);
-            if (this->use_tensorrt_)
-            {
-                auto precision = paddle_infer::Config::Precision::kFloat32;
-                if (this->precision_ == "fp16")
-                {
-                    precision = paddle_infer::Config::Precision::kHalf;
-                }
-                if (this->precision_ == "int8")
-                {
-                    precision = paddle_infer::Config::Precision::kInt8;
-                }
-                config.EnableTensorRtEngine(1 << 20, 10, 3, precision, false, false);
-                if (!Utility::PathExists("./trt_table_shape.txt"))
-                {
-                    config.CollectShapeRangeInfo("./trt_table_shape.txt");
-                }
-                else
-                {
-                    config.EnableTunedTensorRtDynamicShape("./trt_table_shape.txt", true);
-                }
-            }
-        }
-        else
-        {
-            config.DisableGpu();
-            if (this->use_mkldnn_)
-            {
-                config.EnableMKLDNN();
-            }
-            else
-            {
-                config.DisableMKLDNN();
-            }
-            config.SetCpuMathLibraryNumThreads(this->cpu_math_library_num_threads_);
-        }
+        PredictorOptions options;
+        options.backend = this->backend_;
+        options.model_dir = model_dir;
+        options.use_gpu = this->use_gpu_;
+        options.gpu_id = this->gpu_id_;
+        options.gpu_mem = this->gpu_mem_;
+        options.cpu_threads = this->cpu_math_library_num_threads_;
+        options.use_mkldnn = this->use_mkldnn_;
+        options.precision = this->precision_;
+        options.use_tensorrt = this->use_tensorrt_;
+        options.trt_workspace = 1 << 20;
+        options.trt_max_batch = 10;
+        options.trt_min_subgraph = 3;
+        options.trt_shape_file = "./trt_table_shape.txt";
 
-        // false for zero copy tensor
-        config.SwitchUseFeedFetchOps(false);
-        // true for multiple input
-        config.SwitchSpecifyInputNames(true);
-
-        config.SwitchIrOptim(true);
-
-        config.EnableMemoryOptim();
-        config.DisableGlogInfo();
+        this->predictor_ = Predictor::Create(options);
+    }
 
-        this->predictor_ = paddle_infer::CreatePredictor(config);
+    StructureTableRecognizer *StructureTableRecognizer::Clone() const
+    {
+        StructureTableRecognizer *other = new StructureTableRecognizer(*this); // 复制参数与前后处理算子
+        // 推理实例的 Clone 共享权重，只新建中间张量等推理状态
+        other->predictor_ = std::shared_ptr<Predictor>(this->predictor_->Clone(nullptr));
+        return other;
     }
 } // namespace PaddleOCR
@@ -0,0 +1,588 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#include "include/supervisor.h"
+#include "include/args.h"
+#include "include/base64.h"
+#include "include/document.h"
+#include "include/logger.h"
+#include "include/nlohmann/json.hpp"
+#include "include/reply_encoding.h"
+#include "include/task.h" // 二进制帧格式
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace PaddleOCR
+{
+    static const int START_TIMEOUT_S = 600;          // 工作进程启动（加载模型、构建TensorRT引擎）的时限
+    static const size_t MAX_UPLOAD = 10 * 1024 * 1024; // 与HTTP服务器相同的上传大小上限
+
+    Supervisor::Supervisor(int port, int workers, const std::vector<std::string> &worker_args)
+        : port_(port), worker_args_(worker_args), workers_(size_t(std::max(1, workers)))
+    {
+#ifndef _WIN32
+        char path[4096];
+        ssize_t n = readlink("/proc/self/exe", path, sizeof(path) - 1);
+        exe_ = n > 0 ? std::string(path, size_t(n)) : std::string();
+        signal(SIGPIPE, SIG_IGN); // 向已退出的工作进程写入时返回错误，而不是终止本进程
+#endif
+
+        server_.set_default_headers({{"Vary", "Accept, Accept-Encoding"}});
+        // 回复格式参数不合法时在读取正文之前回复400，与HTTP服务器相同
+        server_.set_pre_routing_handler([](const httplib::Request &req, httplib::Response &res)
+                                        { return req.method == "POST" && reject_reply_format(req, res)
+                                                     ? httplib::Server::HandlerResponse::Handled
+                                                     : httplib::Server::HandlerResponse::Unhandled; });
+        server_.Get("/api/health", [this](const httplib::Request &req, httplib::Response &res)
+                    { handle_health(req, res); encode_reply(req, res); });
+        server_.Post("/api/ocr", [this](const httplib::Request &req, httplib::Response &res)
+                     { handle_upload(req, res); encode_reply(req, res); });
+        server_.Post("/api/ocr/base64", [this](const httplib::Request &req, httplib::Response &res)
+                     { handle_base64(req, res); encode_reply(req, res); });
+
+        // 请求在 acquire 中排队等待空闲的工作进程，线程数与HTTP服务器的准入上限相当
+        size_t threads = workers_.size() + size_t(FLAGS_server_queue_max) + 8;
+        server_.new_task_queue = [threads]
+        { return new httplib::ThreadPool(threads, threads); };
+    }
+
+    Supervisor::~Supervisor()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        dead_.notify_all();
+        idle_.notify_all();
+        for (size_t i = 0; i < workers_.size(); i++)
+        {
+            terminate(workers_[i]);
+        }
+    }
+
+    int Supervisor::run()
+    {
+#ifdef _WIN32
+        std::cerr << "[ERROR] supervisor mode is only available on Linux." << std::endl;
+        return 1;
+#else
+        if (exe_.empty())
+        {
+            std::cerr << "[ERROR] supervisor: cannot locate the executable." << std::endl;
+            return 1;
+        }
+        std::cout << "Starting " << workers_.size() << " OCR worker processes..." << std::endl;
+        // 在主线程中 fork：工作进程的 PDEATHSIG 随 fork 它的线程触发，不能由临时线程启动。
+        // 之后各工作进程并行加载模型，由临时线程分别等待
+        std::vector<std::thread> starters;
+        for (size_t i = 0; i < workers_.size(); i++)
+        {
+            Worker &w = workers_[i];
+            if (!launch(w))
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                w.state = WORKER_DEAD;
+                continue;
+            }
+            starters.emplace_back([this, &w]
+                                  {
+                bool ok = wait_ready(w);
+                std::lock_guard<std::mutex> lock(mutex_);
+                w.state = ok ? WORKER_IDLE : WORKER_DEAD; });
+        }
+        for (auto &t : starters)
+        {
+            t.join();
+        }
+        int ready = 0;
+        for (size_t i = 0; i < workers_.size(); i++)
+        {
+            ready += workers_[i].state == WORKER_IDLE;
+        }
+        if (ready == 0)
+        {
+            std::cerr << "[ERROR] supervisor: no OCR worker started." << std::endl;
+            return 1;
+        }
+        std::thread keeper_thread(&Supervisor::keeper, this);
+        std::cout << ready << "/" << workers_.size() << " OCR workers ready" << std::endl;
+        std::cout << "Supervisor listening on 0.0.0.0:" << port_ << std::endl;
+        std::cout << "  POST http://localhost:" << port_ << "/api/ocr         - Upload image for OCR" << std::endl;
+        std::cout << "  POST http://localhost:" << port_ << "/api/ocr/base64  - Submit base64 encoded image" << std::endl;
+        std::cout << "  GET  http://localhost:" << port_ << "/api/health      - Worker status" << std::endl;
+        server_.listen("0.0.0.0", port_);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        dead_.notify_all();
+        keeper_thread.join();
+        return 0;
+#endif
+    }
+
+    // 多页文档有多行回复，合成数组；单图为一行，原样返回
+    static std::string join_lines(const std::vector<std::string> &lines)
+    {
+        if (lines.size() == 1)
+        {
+            return lines[0];
+        }
+        std::string out = "[";
+        for (size_t i = 0; i < lines.size(); i++)
+        {
+            if (i > 0)
+                out += ",";
+            out += lines[i];
+        }
+        return out + "]";
+    }
+
+    static std::string error_json(int code, const std::string &message)
+    {
+        return nlohmann::json({{"code", code}, {"error", message}}).dump();
+    }
+
+    // 请求中可以转交给工作进程的键：排除读图（image、image_path 等由本进程决定）、退出与流式等指令，
+    // 以及由本进程处理的回复编码参数
+    static bool forwarded_key(const std::string &key)
+    {
+        return key.compare(0, 5, "image") != 0 && key != "exit" && key != "stream" && key != "id" &&
+               !reply_param(key);
+    }
+
+    void Supervisor::handle_upload(const httplib::Request &req, httplib::Response &res)
+    {
+        if (!req.form.has_file("image"))
+        {
+            res.status = 400;
+            res.set_content(error_json(400, "No image file provided. Use 'image' field in form data."), "application/json");
+            return;
+        }
+        const std::string &content = req.form.get_file("image").content;
+        if (content.size() > MAX_UPLOAD)
+        {
+            res.status = 413;
+            res.set_content(error_json(413, "File size exceeds 10MB limit"), "application/json");
+            return;
+        }
+        // 排版解析方案与参数覆盖：取自表单字段与URL参数（后者优先），值能解析为json时按解析结果
+        nlohmann::json fields = nlohmann::json::object();
+        auto add = [&fields](const std::string &key, const std::string &text)
+        {
+            if (!forwarded_key(key))
+                return;
+            nlohmann::json value = nlohmann::json::parse(text, nullptr, false);
+            fields[key] = value.is_discarded() ? nlohmann::json(text) : value;
+        };
+        for (const auto &field : req.form.fields)
+        {
+            add(field.first, field.second.content);
+        }
+        for (const auto &param : req.params)
+        {
+            add(param.first, param.second);
+        }
+        std::string request;
+        // 二进制帧在工作进程中按单张图片解码，PDF与多页TIFF须以json指令转交，才会逐页识别
+        bool document = Document::is_pdf(content.data(), content.size()) ||
+                        Document::is_tiff(content.data(), content.size());
+        if (fields.empty() && !document)
+        { // 无参数：二进制帧，不做base64
+            char head[FRAME_HEADER_SIZE] = {0};
+            memcpy(head, FRAME_MAGIC, 4);
+            head[4] = char(FRAME_VERSION);
+            head[5] = char(FRAME_FORMAT_ENCODED);
+            uint32_t length = uint32_t(content.size());
+            for (int i = 0; i < 4; i++)
+            {
+                head[20 + i] = char((length >> (8 * i)) & 0xFF);
+            }
+            request.reserve(FRAME_HEADER_SIZE + content.size());
+            request.append(head, FRAME_HEADER_SIZE).append(content);
+        }
+        else
+        {
+            fields["image_base64"] = base64_encode(reinterpret_cast<const unsigned char *>(content.data()), content.size());
+            request = fields.dump() + "\n";
+        }
+        int status;
+        std::string body = dispatch(request, status);
+        res.status = status;
+        res.set_content(body, "application/json");
+    }
+
+    void Supervisor::handle_base64(const httplib::Request &req, httplib::Response &res)
+    {
+        nlohmann::json body = nlohmann::json::parse(req.body, nullptr, false);
+        if (!body.is_object() || !body.contains("image") || !body["image"].is_string())
+        {
+            res.status = 400;
+            res.set_content(error_json(400, "Missing 'image' field in JSON body"), "application/json");
+            return;
+        }
+        nlohmann::json command = nlohmann::json::object();
+        for (auto it = body.begin(); it != body.end(); ++it)
+        {
+            if (forwarded_key(it.key()))
+                command[it.key()] = std::move(it.value());
+        }
+        for (const auto &param : req.params)
+        {
+            if (!forwarded_key(param.first))
+                continue;
+            nlohmann::json value = nlohmann::json::parse(param.second, nullptr, false);
+            command[param.first] = value.is_discarded() ? nlohmann::json(param.second) : value;
+        }
+        command["image_base64"] = std::move(body["image"]);
+        int status;
+        std::string reply = dispatch(command.dump() + "\n", status);
+        res.status = status;
+        res.set_content(reply, "application/json");
+    }
+
+    void Supervisor::handle_health(const httplib::Request &req, httplib::Response &res)
+    {
+        int ready = 0, busy = 0, restarts = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t i = 0; i < workers_.size(); i++)
+            {
+                ready += workers_[i].state == WORKER_IDLE;
+                busy += workers_[i].state == WORKER_BUSY;
+                restarts += workers_[i].restarts;
+            }
+        }
+        nlohmann::json response = {
+            {"status", ready + busy > 0 ? "ok" : "unavailable"},
+            {"workers", workers_.size()},
+            {"workers_idle", ready},
+            {"workers_busy", busy},
+            {"restarts", restarts}};
+        res.status = ready + busy > 0 ? 200 : 503;
+        res.set_content(response.dump(), "application/json");
+    }
+
+    std::string Supervisor::dispatch(const std::string &request, int &status)
+    {
+        for (int attempt = 0;; attempt++)
+        {
+            std::chrono::milliseconds timeout(FLAGS_supervisor_timeout_ms);
+            int index = acquire(Clock::now() + timeout); // 排队与执行各自计时
+            if (index < 0)
+            {
+                status = 503;
+                return error_json(503, "No OCR worker available");
+            }
+            Worker &worker = workers_[index];
+            std::vector<std::string> lines;
+            Exchange result = exchange(worker, request, lines, Clock::now() + timeout);
+            release(index, result == EXCHANGE_OK);
+            if (result == EXCHANGE_OK)
+            {
+                status = 200;
+                return join_lines(lines);
+            }
+            if (result == EXCHANGE_TIMEOUT)
+            { // 卡死的请求不重试，以免拖垮其它工作进程
+                OCR_LOG_WARN("OCR worker " << index << " timed out, restarting");
+                status = 504;
+                return error_json(504, "OCR worker timed out");
+            }
+            OCR_LOG_WARN("OCR worker " << index << " crashed (attempt " << attempt + 1 << "), restarting");
+            if (attempt >= FLAGS_supervisor_retries)
+            { // 多半是这张图片本身使推理库崩溃
+                status = 502;
+                return error_json(502, "OCR worker crashed while processing the image");
+            }
+        }
+    }
+
+    int Supervisor::acquire(Clock::time_point deadline)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        int index = -1;
+        idle_.wait_until(lock, deadline, [this, &index]
+                         {
+            for (size_t i = 0; i < workers_.size(); i++)
+            {
+                if (workers_[i].state == WORKER_IDLE)
+                {
+                    index = int(i);
+                    return true;
+                }
+            }
+            return stopping_; });
+        if (index >= 0)
+        {
+            workers_[index].state = WORKER_BUSY;
+        }
+        return index;
+    }
+
+    void Supervisor::release(int index, bool healthy)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            workers_[index].state = healthy ? WORKER_IDLE : WORKER_DEAD;
+        }
+        if (healthy)
+            idle_.notify_one();
+        else
+            dead_.notify_one();
+    }
+
+    void Supervisor::keeper()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true)
+        {
+            int index = -1;
+            dead_.wait(lock, [this, &index]
+                       {
+                for (size_t i = 0; i < workers_.size(); i++)
+                {
+                    if (workers_[i].state == WORKER_DEAD)
+                    {
+                        index = int(i);
+                        return true;
+                    }
+                }
+                return stopping_; });
+            if (stopping_)
+            {
+                return;
+            }
+            Worker &w = workers_[index];
+            w.state = WORKER_STARTING;
+            w.restarts++;
+            lock.unlock();
+            terminate(w);
+            bool ok = spawn(w);
+            if (!ok)
+            {
+                std::this_thread::sleep_for(std::chrono::seconds(1)); // 启动失败（如内存不足）时稍后再试
+            }
+            lock.lock();
+            w.state = ok ? WORKER_IDLE : WORKER_DEAD;
+            if (ok)
+            {
+                OCR_LOG_INFO("OCR worker " << index << " restarted");
+                idle_.notify_one();
+            }
+        }
+    }
+
+    bool Supervisor::spawn(Worker &worker)
+    {
+        return launch(worker) && wait_ready(worker);
+    }
+
+#ifndef _WIN32
+    bool Supervisor::launch(Worker &worker)
+    {
+        // O_CLOEXEC：并行启动的其它工作进程不继承这两对管道，否则某个工作进程退出后管道仍不会断开
+        int to_child[2], from_child[2];
+        if (pipe2(to_child, O_CLOEXEC) != 0)
+        {
+            return false;
+        }
+        if (pipe2(from_child, O_CLOEXEC) != 0)
+        {
+            close(to_child[0]);
+            close(to_child[1]);
+            return false;
+        }
+        // fork 之后、exec 之前只能做异步信号安全的调用，参数表先准备好
+        std::vector<char *> argv;
+        argv.push_back(const_cast<char *>(exe_.c_str()));
+        for (size_t i = 0; i < worker_args_.size(); i++)
+        {
+            argv.push_back(const_cast<char *>(worker_args_[i].c_str()));
+        }
+        argv.push_back(nullptr);
+        pid_t parent = getpid();
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            prctl(PR_SET_PDEATHSIG, SIGKILL); // 本进程（确切地说是 fork 所在的线程）退出时，工作进程随之退出
+            if (getppid() != parent)
+            { // 设置之前本进程已退出
+                _exit(1);
+            }
+            dup2(to_child[0], STDIN_FILENO); // dup2 得到的描述符不带 O_CLOEXEC，exec 后保留
+            dup2(from_child[1], STDOUT_FILENO);
+            close(to_child[0]);
+            close(to_child[1]);
+            close(from_child[0]);
+            close(from_child[1]);
+            execv(exe_.c_str(), argv.data());
+            _exit(127);
+        }
+        close(to_child[0]);
+        close(from_child[1]);
+        if (pid < 0)
+        {
+            close(to_child[1]);
+            close(from_child[0]);
+            return false;
+        }
+        fcntl(to_child[1], F_SETFL, O_NONBLOCK);
+        fcntl(from_child[0], F_SETFL, O_NONBLOCK);
+        worker.pid = int(pid);
+        worker.in_fd = to_child[1];
+        worker.out_fd = from_child[0];
+        worker.pending.clear();
+        return true;
+    }
+
+    bool Supervisor::wait_ready(Worker &worker)
+    {
+        // 与其它调用方相同：读到初始化完成的提示即可开始发送请求
+        pid_t pid = pid_t(worker.pid);
+        Clock::time_point deadline = Clock::now() + std::chrono::seconds(START_TIMEOUT_S);
+        std::string line;
+        bool eof = false;
+        while (read_line(worker, line, deadline, eof))
+        {
+            if (line.find("OCR init completed.") != std::string::npos)
+            {
+                OCR_LOG_INFO("OCR worker pid " << pid << " ready");
+                return true;
+            }
+        }
+        OCR_LOG_ERROR("OCR worker pid " << pid << (eof ? " exited" : " timed out") << " during startup");
+        terminate(worker);
+        return false;
+    }
+
+    void Supervisor::terminate(Worker &worker)
+    {
+        if (worker.in_fd >= 0)
+            close(worker.in_fd);
+        if (worker.out_fd >= 0)
+            close(worker.out_fd);
+        worker.in_fd = worker.out_fd = -1;
+        if (worker.pid > 0)
+        {
+            kill(pid_t(worker.pid), SIGKILL);
+            waitpid(pid_t(worker.pid), nullptr, 0);
+        }
+        worker.pid = -1;
+        worker.pending.clear();
+    }
+
+    // 等待 fd 可读/可写，直到截止时间。超时返回false
+    static bool wait_fd(int fd, short events, std::chrono::steady_clock::time_point deadline)
+    {
+        long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           deadline - std::chrono::steady_clock::now())
+                           .count();
+        if (ms <= 0)
+        {
+            return false;
+        }
+        struct pollfd p;
+        p.fd = fd;
+        p.events = events;
+        p.revents = 0;
+        int n = poll(&p, 1, int(std::min(ms, 1000LL * 3600)));
+        return n > 0;
+    }
+
+    bool Supervisor::read_line(Worker &worker, std::string &line, Clock::time_point deadline, bool &eof)
+    {
+        char buf[65536];
+        while (true)
+        {
+            size_t newline = worker.pending.find('\n');
+            if (newline != std::string::npos)
+            {
+                line.assign(worker.pending, 0, newline);
+                worker.pending.erase(0, newline + 1);
+                return true;
+            }
+            ssize_t n = read(worker.out_fd, buf, sizeof(buf));
+            if (n > 0)
+            {
+                worker.pending.append(buf, size_t(n));
+                continue;
+            }
+            if (n == 0 || (errno != EAGAIN && errno != EINTR))
+            {
+                eof = true;
+                return false;
+            }
+            if (!wait_fd(worker.out_fd, POLLIN, deadline))
+            {
+                return false;
+            }
+        }
+    }
+
+    Supervisor::Exchange Supervisor::exchange(Worker &worker, const std::string &request,
+                                              std::vector<std::string> &lines, Clock::time_point deadline)
+    {
+        // 请求后紧跟一条空指令：它的回复带有唯一的id，读到它即表示本请求的回复（单图一行，多页文档每页一行）已全部读完
+        std::string marker;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            marker = "\"#sv-" + std::to_string(++sequence_) + "\"";
+        }
+        std::string out = request + "{\"id\":" + marker + "}\n";
+        std::string end_prefix = "{\"id\":" + marker;
+        size_t written = 0;
+        while (written < out.size())
+        {
+            ssize_t n = write(worker.in_fd, out.data() + written, out.size() - written);
+            if (n > 0)
+            {
+                written += size_t(n);
+                continue;
+            }
+            if (n < 0 && errno != EAGAIN && errno != EINTR)
+            {
+                return EXCHANGE_CRASHED;
+            }
+            if (!wait_fd(worker.in_fd, POLLOUT, deadline))
+            {
+                return EXCHANGE_TIMEOUT;
+            }
+        }
+        std::string line;
+        bool eof = false;
+        while (read_line(worker, line, deadline, eof))
+        {
+            if (line.compare(0, end_prefix.size(), end_prefix) == 0)
+            {
+                return EXCHANGE_OK;
+            }
+            lines.push_back(line);
+        }
+        return eof ? EXCHANGE_CRASHED : EXCHANGE_TIMEOUT;
+    }
+#else
+    bool Supervisor::launch(Worker &worker) { return false; }
+    bool Supervisor::wait_ready(Worker &worker) { return false; }
+    void Supervisor::terminate(Worker &worker) {}
+    bool Supervisor::read_line(Worker &worker, std::string &line, Clock::time_point deadline, bool &eof) { return false; }
+    Supervisor::Exchange Supervisor::exchange(Worker &worker, const std::string &request,
+                                              std::vector<std::string> &lines, Clock::time_point deadline)
+    {
+        return EXCHANGE_CRASHED;
+    }
+#endif
+
+} // namespace PaddleOCR
@@ -1,15 +1,25 @@
 
+#include <climits>
+#include <cstring>
 #include <exception>
 #include <regex>
 
 #include "include/paddleocr.h"
+#include "include/paddlestructure.h"
 #include "include/args.h"
 #include "include/task.h"
 #include "include/base64.h" // base64库
+#include "include/logger.h"
+#include "include/metrics.h"
+#include "include/rec_registry.h"
+#include "include/tbpu.h"
+#include "include/video_ocr.h"
 
 // htonl 函数
 #if defined(_WIN32)
 #include <windows.h>
+#include <io.h>    // _setmode
+#include <fcntl.h> // _O_BINARY
 #else // Linux, Mac
 #include <arpa/inet.h>
 #endif
@@ -18,239 +28,1291 @@ namespace PaddleOCR
 {
     // ==================== 工具 ====================
 
-    // json对象转字符串
-    std::string Task::json_dump(nlohmann::json j)
+    // 取出写完的json。字符串含无效UTF-8时写入失败，与原先 json 序列化失败时一样回复错误状态
+    std::string Task::json_finish(const JsonWriter &writer, std::string &out)
     {
+        if (!writer.ok())
+        {
+            out.clear();
+            JsonWriter error(out, FLAGS_ensure_ascii);
+            error.begin_object().key("code").value(CODE_ERR_JSON_DUMP).key("data").value(MSG_ERR_JSON_DUMP).end_object();
+        }
+        return std::move(out);
+    }
+
+    // 设置状态
+    void Task::set_state(int code, std::string msg)
+    {
+        t_code = code;
+        t_msg = msg;
+    }
+
+    // 获取状态json字符串
+    std::string Task::get_state_json(int code, std::string msg)
+    {
+        if (code == CODE_INIT && msg.empty())
+        { // 留空，填充当前状态
+            code = t_code;
+            msg = t_msg;
+        }
+        std::string out;
+        JsonWriter j(out, FLAGS_ensure_ascii);
+        j.begin_object().key("code").value(code).key("data").value(msg).end_object();
+        return json_finish(j, out);
+    }
+
+    // 将OCR结果转换为json字符串
+    std::string Task::get_ocr_result_json(const std::vector<OCRPredictResult> &ocr_result)
+    {
+        return get_ocr_result_json(ocr_result, FLAGS_det, FLAGS_rec);
+    }
+
+    // 直接写出json文本，键按字母序，与原先经 nlohmann::json 序列化的结果相同
+    std::string Task::get_ocr_result_json(const std::vector<OCRPredictResult> &ocr_result, bool det, bool rec)
+    {
+        StageTimer timer(Metrics::STAGE_JSON);
+        std::string out;
+        out.reserve(json_reserve);
+        JsonWriter j(out, FLAGS_ensure_ascii);
+        j.begin_object().key("code").value(100).key("data").begin_array();
+        bool isEmpty = true;
+        for (size_t i = 0; i < ocr_result.size(); i++)
+        {
+            const OCRPredictResult &r = ocr_result[i];
+            // 无包围盒（各点为-1）。开了det仍无包围盒，跳过本组；未开det，输出空包围盒
+            if (r.box.empty() && det)
+            {
+                continue;
+            }
+            // 启用了rec仍没有文字，跳过本组
+            if (rec && (r.score <= 0 || r.text.empty()))
+            {
+                continue;
+            }
+            j.begin_object();
+            // 启用了排版解析时，写入区块序号与结尾间隔符
+            if (r.block != -1)
+            {
+                j.key("block").value(r.block);
+            }
+            j.key("box").value(r.box);
+            // 如果启用了cls，则cls_label有实际值，那么写入方向分类相关参数
+            if (r.cls_label != -1)
+            {
+                j.key("cls_label").value(r.cls_label); // 方向标签，0表示顺时针0°或90°，1表示180°或270°
+                j.key("cls_score").value(r.cls_score); // 方向标签置信度，越接近1越可信
+            }
+            if (!r.end.empty())
+            {
+                j.key("end").value(r.end);
+            }
+            // 启用了 text_group 时，写入阅读顺序中的行号与段落号
+            if (r.line != -1)
+            {
+                j.key("line").value(r.line);
+                j.key("para").value(r.paragraph);
+            }
+            j.key("score").value(r.score).key("text").value(r.text);
+            j.end_object();
+            isEmpty = false;
+        }
+        j.end_array().end_object();
+        // 结果1：识别成功，无文字（rec未检出）
+        if (isEmpty)
+        {
+            return "";
+        }
+        // 结果2：识别成功，有文字
+        json_reserve = out.size();
+        return json_finish(j, out);
+    }
+
+    // 将版面与表格识别结果转换为json字符串。每个区域一项：表格带 html 与 cell_box，其它区域带 res（OCR结果）
+    std::string Task::get_structure_result_json(const std::vector<StructurePredictResult> &structure_result)
+    {
+        StageTimer timer(Metrics::STAGE_JSON);
+        if (structure_result.empty())
+        {
+            return "";
+        }
+        std::string out;
+        out.reserve(json_reserve);
+        JsonWriter j(out, FLAGS_ensure_ascii);
+        j.begin_object().key("code").value(CODE_OK).key("data").begin_array();
+        for (size_t i = 0; i < structure_result.size(); i++)
+        {
+            const StructurePredictResult &r = structure_result[i];
+            j.begin_object().key("box").begin_array(); // 区域 [x1,y1,x2,y2]
+            for (float v : r.box)
+            {
+                j.value(v);
+            }
+            j.end_array();
+            if (!r.html.empty())
+            { // 表格：单元格框相对于区域左上角
+                j.key("cell_box").begin_array();
+                for (const auto &cell : r.cell_box)
+                {
+                    j.begin_array();
+                    for (int v : cell)
+                    {
+                        j.value(v);
+                    }
+                    j.end_array();
+                }
+                j.end_array();
+                j.key("html").value(r.html).key("html_score").value(r.html_score);
+            }
+            else
+            { // 文字区域：包围盒相对于区域左上角，跳过没有文字的文本框
+                j.key("res").begin_array();
+                for (size_t k = 0; k < r.text_res.size(); k++)
+                {
+                    const OCRPredictResult &t = r.text_res[k];
+                    if (t.score <= 0 || t.text.empty())
+                    {
+                        continue;
+                    }
+                    j.begin_object().key("box").value(t.box).key("score").value(t.score).key("text").value(t.text).end_object();
+                }
+                j.end_array();
+            }
+            j.key("score").value(r.confidence).key("type").value(r.type).end_object();
+        }
+        j.end_array().end_object();
+        json_reserve = out.size();
+        return json_finish(j, out);
+    }
+
+    // 本轮请求带有id、或为批量任务中的一项时，将其插入到回复json的首个键
+    std::string Task::tag_reply(const std::string &reply, int index)
+    {
+        if ((t_id.empty() && index < 0) || reply.size() < 2 || reply[0] != '{')
+        {
+            return reply;
+        }
+        std::string head = "{";
+        if (!t_id.empty())
+        {
+            head += "\"id\":" + t_id + ",";
+        }
+        if (index >= 0)
+        {
+            head += "\"index\":" + std::to_string(index) + ",";
+        }
+        if (reply[1] == '}')
+        {
+            head.pop_back(); // 去掉多余的逗号
+        }
+        return head + reply.substr(1);
+    }
+
+    // 取json值的字符串内容。字符串值直接返回引用，不复制；其它类型转为文本存入 buf
+    static const std::string &json_str(const nlohmann::json &value, std::string &buf)
+    {
+        if (value.is_string())
+        {
+            return value.get_ref<const std::string &>();
+        }
+        buf = value.dump();
+        return buf;
+    }
+
+    // 缩小解码的倍数：缩小后（ROI的）长边仍不小于检测的 limit_side_len，检测输入的尺寸不变。
+    // 只用于长边限制：短边限制在图片较小时放大，缩小解码会改变检测输入；分块检测按原图分辨率切块。
+    // 自适应检测的分辨率要看过预检才知道，按其上限 det_adaptive_max_side 计
+    static int decode_reduce_factor(const void *data, size_t size, const OCROptions &options)
+    {
+        bool adaptive = options.det_adaptive >= 0 ? options.det_adaptive > 0
+                                                  : FLAGS_det_adaptive && options.limit_side_len <= 0 && options.limit_type.empty();
+        const std::string &limit_type = adaptive ? "max" : options.limit_type.empty() ? FLAGS_limit_type : options.limit_type;
+        if (FLAGS_decode_reduce < 2 || !FLAGS_det || !options.det || FLAGS_det_tile_size > 0 || limit_type != "max")
+        {
+            return 1;
+        }
+        int width, height;
+        if (!Utility::jpeg_size(data, size, width, height)) // 只有JPEG能在解码时按DCT系数缩小
+        {
+            return 1;
+        }
+        // ROI按长边计，不受EXIF方向（解码后才旋转）影响
+        int side = options.roi_w > 0 ? std::max(options.roi_w, options.roi_h) : std::max(width, height);
+        int limit = adaptive ? FLAGS_det_adaptive_max_side
+                             : options.limit_side_len > 0 ? options.limit_side_len : FLAGS_limit_side_len;
+        int factor = 1;
+        while (factor * 2 <= FLAGS_decode_reduce && side / (factor * 2) >= limit)
+        {
+            factor *= 2;
+        }
+        return factor;
+    }
+
+    cv::Mat Task::imdecode_for_ocr(const void *data, size_t size, OCROptions &options)
+    {
+        static const int flags[] = {cv::IMREAD_COLOR, cv::IMREAD_REDUCED_COLOR_2, 0, cv::IMREAD_REDUCED_COLOR_4,
+                                    0, 0, 0, cv::IMREAD_REDUCED_COLOR_8};
+        int factor = decode_reduce_factor(data, size, options);
+        cv::Mat img = Utility::imdecode_buffer(data, size, flags[factor - 1]);
+        options.decode_scale = img.empty() ? 1 : factor;
+        return img;
+    }
+
+    bool Task::apply_roi(cv::Mat &img, const OCROptions &options)
+    {
+        if (options.roi_w <= 0)
+        {
+            return true;
+        }
+        // ROI为原图坐标，换算到（缩小）解码后的图片上，超出图片的部分截掉
+        int s = options.decode_scale;
+        cv::Rect rect(options.roi_x / s, options.roi_y / s, (options.roi_w + s - 1) / s, (options.roi_h + s - 1) / s);
+        rect &= cv::Rect(0, 0, img.cols, img.rows);
+        if (rect.width < 1 || rect.height < 1)
+        {
+            return false;
+        }
+        img = img(rect);
+        return true;
+    }
+
+    // 解码后图片上的点映射回原图：加上ROI在解码后图片上的起点，再按解码倍数放大
+    static void to_source(Quad &box, const OCROptions &options)
+    {
+        int s = options.decode_scale;
+        int x = options.roi_w > 0 ? options.roi_x / s : 0;
+        int y = options.roi_w > 0 ? options.roi_y / s : 0;
+        for (auto &pt : box)
+        {
+            pt[0] = (pt[0] + x) * s;
+            pt[1] = (pt[1] + y) * s;
+        }
+    }
+
+    void Task::map_to_source(std::vector<OCRPredictResult> &results, const OCROptions &options)
+    {
+        if (options.decode_scale == 1 && options.roi_w <= 0)
+        {
+            return;
+        }
+        for (auto &r : results)
+        {
+            if (!r.box.empty())
+            {
+                to_source(r.box, options);
+            }
+        }
+    }
+
+    int Task::open_document(const void *data, size_t size, const OCROptions &options,
+                            std::shared_ptr<Document> &doc, cv::Mat &first, std::string &msg)
+    {
+        doc.reset();
+        first = cv::Mat();
+        bool pdf = Document::is_pdf(data, size);
+        if (pdf && !Document::pdf_supported())
+        {
+            msg = MSG_ERR_DOC_PDF;
+            return CODE_ERR_DOC_PDF;
+        }
+        doc.reset(Document::open(data, size, options.limit_side_len > 0 ? options.limit_side_len : FLAGS_limit_side_len));
+        if (!doc)
+        {
+            if (pdf)
+            {
+                msg = MSG_ERR_DOC_RENDER(0);
+                return CODE_ERR_DOC_RENDER;
+            }
+            return CODE_INIT; // 普通图片
+        }
+        int pages = doc->pages();
+        if (pages > FLAGS_doc_max_pages)
+        {
+            doc.reset();
+            msg = MSG_ERR_DOC_PAGES(pages);
+            return CODE_ERR_DOC_PAGES;
+        }
+        first = doc->render(0);
+        if (first.empty())
+        {
+            doc.reset();
+            msg = MSG_ERR_DOC_RENDER(0);
+            return CODE_ERR_DOC_RENDER;
+        }
+        if (pages == 1) // 单页：与普通图片的任务相同
+        {
+            doc.reset();
+        }
+        return CODE_INIT;
+    }
+
+    cv::Mat Task::imdecode(const void *data, size_t size, int flag)
+    {
+        if (decode_options && flag == cv::IMREAD_COLOR)
+        {
+            cv::Mat first;
+            std::string msg;
+            int code = open_document(data, size, *decode_options, t_document, first, msg);
+            if (code != CODE_INIT)
+            {
+                set_state(code, msg);
+                return cv::Mat();
+            }
+            if (!first.empty()) // 文档的首页，其余页面在 run_document 中读取
+            {
+                return first;
+            }
+            return imdecode_for_ocr(data, size, *decode_options);
+        }
+        return Utility::imdecode_buffer(data, size, flag);
+    }
+
+    // 输入base64编码的字符串，返回Mat
+    cv::Mat Task::imread_base64(const std::string &b64str, int flag)
+    {
+        size_t size; // 解码后的字节数
+        try
+        {
+            // 直接解码到复用的缓冲区，不产生中间字符串
+            size = base64_decoded_size(b64str.data(), b64str.size());
+            if (decode_buffer.size() < size)
+            {
+                decode_buffer.resize(size);
+            }
+            size = base64_decode_into(b64str.data(), b64str.size(), decode_buffer.data());
+        }
+        catch (...)
+        {
+            set_state(CODE_ERR_BASE64_DECODE, MSG_ERR_BASE64_DECODE); // 报告状态：解析失败
+            return cv::Mat();
+        }
+        try
+        {
+            cv::Mat img = imdecode(decode_buffer.data(), size, flag);
+            if (img.empty() && t_code == CODE_INIT) // imdecode 未报告更具体的错误（如文档页数超限）
+            {
+                set_state(CODE_ERR_BASE64_IM_DECODE, MSG_ERR_BASE64_IM_DECODE); // 报告状态：转Mat失败
+            }
+            return img;
+        }
+        catch (...)
+        {
+            set_state(CODE_ERR_BASE64_IM_DECODE, MSG_ERR_BASE64_IM_DECODE); // 报告状态：转Mat失败
+            return cv::Mat();
+        }
+    }
+
+    // 读取小端序 uint32
+    static uint32_t read_u32le(const char *p)
+    {
+        const unsigned char *u = reinterpret_cast<const unsigned char *>(p);
+        return uint32_t(u[0]) | (uint32_t(u[1]) << 8) | (uint32_t(u[2]) << 16) | (uint32_t(u[3]) << 24);
+    }
+
+    // 像素格式：检查尺寸、行跨度与负载长度是否匹配
+    static bool frame_pixels_valid(const FrameHeader &header)
+    {
+        uint64_t channels = header.format == FRAME_FORMAT_BGR ? 3 : (header.format == FRAME_FORMAT_BGRA ? 4 : 1);
+        uint64_t row = header.width * channels;
+        uint64_t stride = header.stride ? header.stride : row;
+        return header.width > 0 && header.height > 0 && header.width <= INT_MAX && header.height <= INT_MAX &&
+               stride >= row && header.length >= stride * (header.height - 1) + row;
+    }
+
+    // 解析二进制帧头。data 至少包含 FRAME_HEADER_SIZE 字节
+    bool Task::parse_frame_header(const char *data, FrameHeader &header)
+    {
+        if (memcmp(data, FRAME_MAGIC, 4) != 0)
+        {
+            set_state(CODE_ERR_FRAME_HEADER, MSG_ERR_FRAME_HEADER);
+            return false;
+        }
+        header.version = uint8_t(data[4]);
+        header.format = uint8_t(data[5]);
+        header.options = uint8_t(data[6]);
+        header.width = read_u32le(data + 8);
+        header.height = read_u32le(data + 12);
+        header.stride = read_u32le(data + 16);
+        header.length = read_u32le(data + 20);
+        if (header.version != FRAME_VERSION || header.format > FRAME_FORMAT_GRAY)
+        {
+            set_state(CODE_ERR_FRAME_HEADER, MSG_ERR_FRAME_HEADER);
+            return false;
+        }
+        if (header.format != FRAME_FORMAT_ENCODED && !frame_pixels_valid(header))
+        {
+            set_state(CODE_ERR_FRAME_HEADER, MSG_ERR_FRAME_HEADER);
+            return false;
+        }
+        if (header.length > max_request_bytes()) // 长度来自客户端，先检查再分配缓冲区
+        {
+            set_state(CODE_ERR_FRAME_SIZE, MSG_ERR_FRAME_SIZE(header.length));
+            return false;
+        }
+        return true;
+    }
+
+    // 从json读取共享内存中的像素。键：shm_name, offset, w, h, stride, format
+    // 像素直接包装共享内存，不复制；客户端须在收到回复后才能改写这块内存
+    cv::Mat Task::imread_shm(const nlohmann::json &j)
+    {
+        const std::string &name = j.at("shm_name").get_ref<const std::string &>();
+        FrameHeader header;
+        header.version = FRAME_VERSION;
+        header.options = 0;
+        header.format = FRAME_FORMAT_BGR;
+        if (j.contains("format"))
+        { // 格式可以是 "BGR"/"BGRA"/"GRAY"，或二进制帧的格式代码
+            const nlohmann::json &f = j.at("format");
+            if (f.is_string())
+            {
+                const std::string &s = f.get_ref<const std::string &>();
+                header.format = (s == "BGR" || s == "bgr")     ? FRAME_FORMAT_BGR
+                                : (s == "BGRA" || s == "bgra") ? FRAME_FORMAT_BGRA
+                                : (s == "GRAY" || s == "gray") ? FRAME_FORMAT_GRAY
+                                                               : FRAME_FORMAT_ENCODED;
+            }
+            else
+            {
+                int code = f.get<int>();
+                header.format = (code >= FRAME_FORMAT_BGR && code <= FRAME_FORMAT_GRAY) ? uint8_t(code) : FRAME_FORMAT_ENCODED;
+            }
+        }
+        int64_t offset = j.value("offset", int64_t(0));
+        int64_t w = j.at("w").get<int64_t>();
+        int64_t h = j.at("h").get<int64_t>();
+        int64_t stride = j.value("stride", int64_t(0));
+        if (header.format == FRAME_FORMAT_ENCODED || offset < 0 || stride < 0 ||
+            w <= 0 || h <= 0 || w > INT_MAX || h > INT_MAX || stride > UINT32_MAX)
+        { // 只支持像素格式
+            set_state(CODE_ERR_SHM_PARAM, MSG_ERR_SHM_PARAM(name));
+            return cv::Mat();
+        }
+        size_t size = 0;
+        const char *base = shm_map(name, size);
+        if (!base)
+        {
+            set_state(CODE_ERR_SHM_OPEN, MSG_ERR_SHM_OPEN(name));
+            return cv::Mat();
+        }
+        header.width = uint32_t(w);
+        header.height = uint32_t(h);
+        header.stride = uint32_t(stride);
+        header.length = uint32_t(std::min<uint64_t>(size > uint64_t(offset) ? size - offset : 0, UINT32_MAX));
+        if (uint64_t(offset) >= size || !frame_pixels_valid(header))
+        { // 图片超出共享内存范围
+            set_state(CODE_ERR_SHM_PARAM, MSG_ERR_SHM_PARAM(name));
+            return cv::Mat();
+        }
+        return imread_frame(header, base + offset);
+    }
+
+    // 从二进制帧负载读图。像素格式直接包装负载内存，不复制；调用方须保证OCR结束前负载有效
+    cv::Mat Task::imread_frame(const FrameHeader &header, const char *payload)
+    {
+        void *data = const_cast<char *>(payload);
+        cv::Mat img;
         try
         {
-            std::string str = j.dump(-1, ' ', FLAGS_ensure_ascii);
-            return str;
+            switch (header.format)
+            {
+            case FRAME_FORMAT_ENCODED:
+                img = imdecode(payload, header.length, cv::IMREAD_COLOR);
+                break;
+            case FRAME_FORMAT_BGR:
+                img = cv::Mat(int(header.height), int(header.width), CV_8UC3, data,
+                              header.stride ? size_t(header.stride) : cv::Mat::AUTO_STEP);
+                break;
+            case FRAME_FORMAT_BGRA:
+                cv::cvtColor(cv::Mat(int(header.height), int(header.width), CV_8UC4, data,
+                                     header.stride ? size_t(header.stride) : cv::Mat::AUTO_STEP),
+                             img, cv::COLOR_BGRA2BGR);
+                break;
+            case FRAME_FORMAT_GRAY:
+                cv::cvtColor(cv::Mat(int(header.height), int(header.width), CV_8UC1, data,
+                                     header.stride ? size_t(header.stride) : cv::Mat::AUTO_STEP),
+                             img, cv::COLOR_GRAY2BGR);
+                break;
+            }
+        }
+        catch (...)
+        {
+            img = cv::Mat();
+        }
+        if (img.empty())
+        {
+            set_state(CODE_ERR_FRAME_DECODE, MSG_ERR_FRAME_DECODE); // 报告状态：解码失败
+        }
+        return img;
+    }
+
+    // 输入json字符串，解析并读取Mat
+    cv::Mat Task::imread_json(std::string &str_in)
+    {
+#ifdef ENABLE_REMOTE_EXIT
+        if (str_in == "exit")
+        { // 退出指令
+            is_exit = true;
+            return cv::Mat();
+        }
+#endif
+        t_id.clear();
+        t_stream = false;
+        t_structure = structure_engine() != nullptr;
+        t_parser.clear();
+        t_options = OCROptions();
+        t_image_path.clear();
+        t_document.reset();
+        batch_imgs.clear();
+        batch_errors.clear();
+        // 解析为json对象
+        auto j = nlohmann::json();
+        try
+        {
+            j = nlohmann::json::parse(str_in); // 转json对象
+        }
+        catch (...)
+        {
+            set_state(CODE_ERR_JSON_PARSE, MSG_ERR_JSON_PARSE); // 报告状态：解析失败
+            return cv::Mat();
+        }
+        if (!j.is_object())
+        {
+            set_state(CODE_ERR_NO_TASK, MSG_ERR_NO_TASK); // 报告状态：未发现有效任务
+            return cv::Mat();
+        }
+#ifdef ENABLE_REMOTE_EXIT
+        if (j.contains("exit"))
+        { // 退出指令
+            is_exit = true;
+            return cv::Mat();
+        }
+#endif
+        auto id = j.find("id");
+        if (id != j.end())
+        { // 任务ID，回复时原样带回
+            t_id = id->dump(-1, ' ', FLAGS_ensure_ascii);
+        }
+        auto stream = j.find("stream");
+        if (stream != j.end() && stream->is_boolean())
+        { // 流式输出中间结果
+            t_stream = stream->get<bool>();
+        }
+        auto structure = j.find("structure");
+        if (structure != j.end() && structure->is_boolean() && structure_engine())
+        { // type=structure 时可设为false，只做普通OCR
+            t_structure = structure->get<bool>();
+        }
+        auto parser = j.find("parser");
+        if (parser != j.end() && parser->is_string())
+        { // 排版解析方案
+            t_parser = parser->get<std::string>();
+            if (!t_parser.empty() && !Tbpu::valid(t_parser))
+            {
+                set_state(CODE_ERR_PARSER, MSG_ERR_PARSER(t_parser));
+                return cv::Mat();
+            }
+        }
+        std::string option_key;
+        if (!parse_options(j, t_options, option_key))
+        { // 阈值、尺寸限制与阶段开关，只对本轮任务生效
+            set_state(CODE_ERR_OPTION, MSG_ERR_OPTION(option_key));
+            return cv::Mat();
+        }
+        auto images = j.find("images");
+        if (images != j.end() && images->is_array())
+        { // 批量任务：数组的每一项与单图任务的写法相同，如 {"image_path": "..."}
+            for (size_t i = 0; i < images->size(); i++)
+            {
+                set_state();
+                bool found = false;
+                cv::Mat img = imread_json(images->at(i), found);
+                if (!found)
+                {
+                    set_state(CODE_ERR_NO_TASK, MSG_ERR_NO_TASK);
+                }
+                batch_imgs.push_back(img);
+                batch_errors.push_back(img.empty() ? get_state_json() : ""); // 读图失败的项，记录其错误回复
+            }
+            set_state();
+            if (batch_imgs.empty())
+            {
+                set_state(CODE_ERR_NO_TASK, MSG_ERR_NO_TASK);
+            }
+            return cv::Mat();
+        }
+        bool is_image_found = false; // 当前是否已找到图片
+        decode_options = t_structure ? nullptr : &t_options; // 单图OCR任务：可按检测尺寸缩小解码
+        cv::Mat img = imread_json(j, is_image_found);
+        decode_options = nullptr;
+        if (!is_image_found)
+        {
+            set_state(CODE_ERR_NO_TASK, MSG_ERR_NO_TASK); // 报告状态：未发现有效任务
+        }
+        return img;
+    }
+
+    cv::Mat Task::imread_json(const nlohmann::json &j, bool &is_image_found)
+    {
+        StageTimer timer(Metrics::STAGE_DECODE);
+        cv::Mat img;
+        if (!j.is_object())
+        {
+            return img;
+        }
+        for (auto &el : j.items())
+        { // 遍历键值
+            try
+            {
+                std::string buf; // 非字符串值的文本形式
+                // 提取图片
+                if (el.key() == "image_base64")
+                {                                                  // base64字符串
+                    t_image_path = "base64";                       // 设置图片路径标记，以便于无文字时的信息输出
+                    img = imread_base64(json_str(el.value(), buf)); // 读取图片，直接引用json中的字符串
+                    is_image_found = true;
+                }
+#ifdef ENABLE_JSON_IMAGE_PATH
+                else if (el.key() == "image_path")
+                { // 图片路径
+                    t_image_path = json_str(el.value(), buf);
+                    img = imread_u8(t_image_path); // 读取图片
+                    is_image_found = true;
+                }
+#endif
+#ifdef ENABLE_JSON_SHM
+                else if (el.key() == "shm_name")
+                {                              // 共享内存中的像素
+                    t_image_path = "shm";     // 设置图片路径标记
+                    img = imread_shm(j);
+                    is_image_found = true;
+                }
+#endif
+            }
+            catch (...)
+            {                                                                         // 安全起见，出现未知异常时结束本轮任务
+                set_state(CODE_ERR_JSON_PARSE_KEY, MSG_ERR_JSON_PARSE_KEY(el.key())); // 报告状态：解析键失败
+                return cv::Mat();
+            }
+            if (is_image_found)
+            {
+                break;
+            }
+        }
+        if (!img.empty() && !check_image_size(img))
+        {
+            return cv::Mat();
+        }
+        if (!img.empty() && !t_structure && !apply_roi(img, t_options))
+        {
+            set_state(CODE_ERR_OPTION, MSG_ERR_OPTION(std::string("roi")));
+            return cv::Mat();
+        }
+        return img;
+    }
+
+    // ==================== 任务流程 ====================
+
+    // 流式输出的观察者：把各阶段的中间结果格式化为一行json。
+    // 检测阶段 {"code":100,"stage":"det","data":[{"index":0,"box":...},...]}，
+    // 识别阶段 {"code":100,"stage":"rec","data":[{"index":0,"text":...,"score":...},...]}，
+    // index 为文本框在检测阶段中的下标。识别阶段与最终结果一样，跳过没有文字的文本框
+    class StreamObserver : public OCRObserver
+    {
+    public:
+        StreamObserver(const std::function<void(const std::string &)> &emit, const OCROptions *options)
+            : emit_(emit), options_(options) {}
+
+        void on_det(const std::vector<OCRPredictResult> &results) override
+        {
+            line_.clear();
+            JsonWriter j(line_, FLAGS_ensure_ascii);
+            j.begin_object().key("code").value(CODE_OK).key("data").begin_array();
+            for (size_t i = 0; i < results.size(); i++)
+            {
+                Quad box = results[i].box;
+                if (options_ && !box.empty())
+                {
+                    to_source(box, *options_);
+                }
+                j.begin_object().key("box").value(box);
+                if (results[i].cls_label != -1)
+                {
+                    j.key("cls_label").value(results[i].cls_label);
+                    j.key("cls_score").value(results[i].cls_score);
+                }
+                j.key("index").value(i).end_object();
+            }
+            j.end_array().key("stage").value("det").end_object();
+            emit(j);
+        }
+
+        void on_rec(const std::vector<OCRPredictResult> &results, const int *indices, int count) override
+        {
+            line_.clear();
+            JsonWriter j(line_, FLAGS_ensure_ascii);
+            j.begin_object().key("code").value(CODE_OK).key("data").begin_array();
+            bool empty = true;
+            for (int k = 0; k < count; k++)
+            {
+                const OCRPredictResult &r = results[indices[k]];
+                if (r.score <= 0 || r.text.empty())
+                {
+                    continue;
+                }
+                j.begin_object().key("index").value(indices[k]).key("score").value(r.score).key("text").value(r.text).end_object();
+                empty = false;
+            }
+            j.end_array().key("stage").value("rec").end_object();
+            if (!empty)
+            {
+                emit(j);
+            }
+        }
+
+    private:
+        void emit(const JsonWriter &j)
+        {
+            if (j.ok()) // 中间结果写入失败时跳过，最终结果仍会回复
+            {
+                emit_(line_);
+            }
+        }
+
+        std::string line_; // 当前一行中间结果，各阶段复用
+        const std::function<void(const std::string &)> &emit_;
+        const OCROptions *options_; // 框坐标映射回原图所用的解码倍数与ROI，可为空
+    };
+
+    // 本次使用的排版解析方案：未指定时使用 tbpu_parser 参数
+    static const std::string &use_parser(const std::string &parser)
+    {
+        return parser.empty() ? FLAGS_tbpu_parser : parser;
+    }
+
+    // 本次请求执行的阶段：启动时已启用，且请求中未关闭
+    static void request_stages(const OCROptions &options, bool &det, bool &cls, bool &rec)
+    {
+        det = FLAGS_det && options.det;
+        cls = FLAGS_cls && options.cls;
+        rec = FLAGS_rec && options.rec;
+    }
+
+    // 以下读取请求中的一个参数键：键不存在时不变；类型或取值无效时返回false，并把键名写入 bad
+
+    static bool option_number(const nlohmann::json &j, const char *key, double lo, double hi, double &out,
+                              std::string &bad)
+    {
+        auto it = j.find(key);
+        if (it == j.end())
+        {
+            return true;
+        }
+        if (!it->is_number() || it->get<double>() < lo || it->get<double>() > hi)
+        {
+            bad = key;
+            return false;
+        }
+        out = it->get<double>();
+        return true;
+    }
+
+    static bool option_int(const nlohmann::json &j, const char *key, int lo, int hi, int &out, std::string &bad)
+    {
+        auto it = j.find(key);
+        if (it == j.end())
+        {
+            return true;
+        }
+        if (!it->is_number_integer() || it->get<int64_t>() < lo || it->get<int64_t>() > hi)
+        {
+            bad = key;
+            return false;
+        }
+        out = int(it->get<int64_t>());
+        return true;
+    }
+
+    // 字符串键，须为 a、b 之一
+    static bool option_choice(const nlohmann::json &j, const char *key, const char *a, const char *b,
+                              std::string &out, std::string &bad)
+    {
+        auto it = j.find(key);
+        if (it == j.end())
+        {
+            return true;
+        }
+        if (!it->is_string() || (*it != a && *it != b))
+        {
+            bad = key;
+            return false;
+        }
+        out = it->get<std::string>();
+        return true;
+    }
+
+    static bool option_bool(const nlohmann::json &j, const char *key, bool &out, std::string &bad)
+    {
+        auto it = j.find(key);
+        if (it == j.end())
+        {
+            return true;
+        }
+        if (!it->is_boolean())
+        {
+            bad = key;
+            return false;
+        }
+        out = it->get<bool>();
+        return true;
+    }
+
+    // 三态开关：true/false 写为1/0，未给出时保持原值（-1为沿用启动参数）
+    static bool option_switch(const nlohmann::json &j, const char *key, int &out, std::string &bad)
+    {
+        bool value = false;
+        if (!j.contains(key))
+        {
+            return true;
+        }
+        if (!option_bool(j, key, value, bad))
+        {
+            return false;
+        }
+        out = value ? 1 : 0;
+        return true;
+    }
+
+    // 识别语言，须已在 rec_languages 中登记，且模型能够加载。空字符串为启动参数的识别模型
+    static bool option_lang(const nlohmann::json &j, std::string &out, std::string &bad)
+    {
+        auto it = j.find("lang");
+        if (it == j.end())
+        {
+            return true;
+        }
+        if (!it->is_string() || (*it != "" && !(RecRegistry::get().has(it->get<std::string>()) &&
+                                                RecRegistry::get().ready(it->get<std::string>()))))
+        {
+            bad = "lang";
+            return false;
+        }
+        out = it->get<std::string>();
+        return true;
+    }
+
+    // ROI：[x, y, 宽, 高]，原图坐标
+    static bool option_roi(const nlohmann::json &j, OCROptions &o, std::string &bad)
+    {
+        auto it = j.find("roi");
+        if (it == j.end())
+        {
+            return true;
+        }
+        int v[4];
+        bool ok = it->is_array() && it->size() == 4;
+        for (size_t i = 0; ok && i < 4; i++)
+        {
+            const nlohmann::json &e = (*it)[i];
+            ok = e.is_number_integer() && e.get<int64_t>() >= (i < 2 ? 0 : 1) && e.get<int64_t>() <= 1000000;
+            v[i] = ok ? int(e.get<int64_t>()) : 0;
+        }
+        if (!ok)
+        {
+            bad = "roi";
+            return false;
+        }
+        o.roi_x = v[0], o.roi_y = v[1], o.roi_w = v[2], o.roi_h = v[3];
+        return true;
+    }
+
+    bool Task::parse_options(const nlohmann::json &j, OCROptions &options, std::string &key)
+    {
+        OCROptions o = options; // 全部有效时才生效
+        bool ok = option_bool(j, "det", o.det, key) &&
+                  option_bool(j, "cls", o.cls, key) &&
+                  option_bool(j, "rec", o.rec, key) &&
+                  option_choice(j, "limit_type", "max", "min", o.limit_type, key) &&
+                  option_int(j, "limit_side_len", 32, 10000, o.limit_side_len, key) &&
+                  option_number(j, "det_db_thresh", 0, 1, o.det_db_thresh, key) &&
+                  option_number(j, "det_db_box_thresh", 0, 1, o.det_db_box_thresh, key) &&
+                  option_number(j, "det_db_unclip_ratio", 0.1, 10, o.det_db_unclip_ratio, key) &&
+                  option_choice(j, "det_db_score_mode", "fast", "slow", o.det_db_score_mode, key) &&
+                  option_switch(j, "det_adaptive", o.det_adaptive, key) &&
+                  option_number(j, "cls_thresh", 0, 1, o.cls_thresh, key) &&
+                  option_int(j, "rec_batch_num", 1, FLAGS_rec_batch_num, o.rec_batch_num, key) &&
+                  option_lang(j, o.lang, key) &&
+                  option_roi(j, o, key);
+        if (ok)
+        {
+            options = o;
+        }
+        return ok;
+    }
+
+    std::string Task::ocr_json_stream(cv::Mat &img, bool det, bool cls, bool rec,
+                                      const std::function<void(const std::string &)> &emit,
+                                      const std::string &parser, const OCROptions *options)
+    {
+        StreamObserver observer(emit, options);
+        std::vector<OCRPredictResult> res_ocr = ppocr->ocr(img, det, rec, cls, &observer, options);
+        if (options)
+        {
+            map_to_source(res_ocr, *options);
+        }
+        Tbpu::run(use_parser(parser), res_ocr); // 中间结果不做排版解析，只作用于最终结果
+        return get_ocr_result_json(res_ocr, det, rec);
+    }
+
+    std::string Task::ocr_json(cv::Mat &img, bool det, bool cls, bool rec, const std::string &parser,
+                               const OCROptions *options)
+    {
+        uint64_t key = 0;
+        std::string res_json;
+        if (result_cache)
+        {
+            key = ResultCache::key(img, det, cls, rec, use_parser(parser), options);
+            if (result_cache->get(key, res_json)) // 命中，跳过推理
+            {
+                return res_json;
+            }
+        }
+        std::vector<OCRPredictResult> res_ocr = (FLAGS_incremental_ocr && det)
+                                                    ? ppocr->ocr_incremental(img, rec, cls, options)
+                                                    : ppocr->ocr(img, det, rec, cls, nullptr, options);
+        if (options)
+        {
+            map_to_source(res_ocr, *options);
+        }
+        Tbpu::run(use_parser(parser), res_ocr);
+        res_json = get_ocr_result_json(res_ocr, det, rec);
+        if (result_cache)
+        {
+            result_cache->put(key, res_json);
+        }
+        return res_json;
+    }
+
+    std::string Task::run_ocr(std::string str_in)
+    {
+        cv::Mat img = imread_json(str_in);
+        if (is_exit)
+        { // 退出
+            return "";
+        }
+        if (!batch_imgs.empty())
+        { // 批量任务
+            return run_ocr_batch();
+        }
+        if (img.empty())
+        { // 读图失败
+            return tag_reply(get_state_json());
+        }
+        if (t_document)
+        { // 多页文档
+            return run_document(img);
+        }
+        // 执行OCR
+        bool det, cls, rec;
+        request_stages(t_options, det, cls, rec);
+        std::string res_json;
+        std::string partials; // 无输出方式时，先于最终结果回复的中间结果
+        if (t_structure)
+        { // 版面与表格识别，不支持流式
+            res_json = structure_json(img);
+        }
+        else if (t_stream)
+        {
+            res_json = ocr_json_stream(img, det, cls, rec, [&](const std::string &line)
+                                       {
+                if (stream_sink)
+                    stream_sink(tag_reply(line));
+                else
+                    partials += tag_reply(line) + "\n"; }, t_parser, &t_options);
+        }
+        else
+        {
+            res_json = ocr_json(img, det, cls, rec, t_parser, &t_options);
         }
-        catch (...)
+        // 结果1：识别成功，无文字（rec未检出）
+        if (res_json.empty())
         {
-            nlohmann::json j2;
-            j2["code"] = CODE_ERR_JSON_DUMP;
-            j2["data"] = MSG_ERR_JSON_DUMP;
-            std::string str = j2.dump(-1, ' ', FLAGS_ensure_ascii);
-            return str;
+            return partials + tag_reply(get_state_json(CODE_OK_NONE, MSG_OK_NONE(t_image_path)));
         }
-    }
-
-    // 设置状态
-    void Task::set_state(int code, std::string msg)
-    {
-        t_code = code;
-        t_msg = msg;
-    }
-
-    // 获取状态json字符串
-    std::string Task::get_state_json(int code, std::string msg)
-    {
-        nlohmann::json j;
-        if (code == CODE_INIT && msg.empty())
-        { // 留空，填充当前状态
-            code = t_code;
-            msg = t_msg;
+        // 结果2：识别成功，有文字
+        else
+        {
+            return partials + tag_reply(res_json);
         }
-        j["code"] = code;
-        j["data"] = msg;
-        return json_dump(j);
     }
 
-    // 将OCR结果转换为json字符串
-    std::string Task::get_ocr_result_json(const std::vector<OCRPredictResult> &ocr_result)
+    // 执行批量任务。每张图片回复一行，带有其在数组中的下标 index
+    std::string Task::run_ocr_batch()
     {
-        nlohmann::json outJ;
-        outJ["code"] = 100;
-        outJ["data"] = nlohmann::json::array();
-        bool isEmpty = true;
-        for (int i = 0; i < ocr_result.size(); i++)
+        std::vector<cv::Mat> imgs;
+        std::vector<size_t> indices; // imgs 中各图片在数组中的下标
+        for (size_t i = 0; i < batch_imgs.size(); i++)
         {
-            nlohmann::json j;
-            j["text"] = ocr_result[i].text;
-            j["score"] = ocr_result[i].score;
-            std::vector<std::vector<int>> b = ocr_result[i].box;
-            // 无包围盒
-            if (b.empty())
+            if (batch_errors[i].empty())
             {
-                if (FLAGS_det) // 开了det仍无包围盒，跳过本组
-                    continue;
-                else // 未开det，填充空包围盒
-                    for (int bi = 0; bi < 4; bi++)
-                        b.push_back(std::vector<int>{-1, -1});
+                imgs.push_back(batch_imgs[i]);
+                indices.push_back(i);
             }
-            // 启用了rec仍没有文字，跳过本组
-            if (FLAGS_rec && (j["score"] <= 0 || j["text"] == ""))
+        }
+        std::vector<std::string> results;
+        if (t_structure)
+        {
+            for (size_t k = 0; k < imgs.size(); k++)
             {
-                continue;
+                results.push_back(run_structure_mat(imgs[k]));
+            }
+        }
+        else
+        {
+            results = run_ocr_mats(imgs, t_parser, t_options);
+        }
+        for (size_t k = 0; k < indices.size(); k++)
+        {
+            batch_errors[indices[k]].swap(results[k]);
+        }
+        std::string replies;
+        for (size_t i = 0; i < batch_errors.size(); i++)
+        {
+            if (i > 0)
+            {
+                replies += "\n";
+            }
+            replies += tag_reply(batch_errors[i], int(i));
+        }
+        batch_imgs.clear();
+        batch_errors.clear();
+        return replies;
+    }
+
+    // 执行多页文档任务。每页回复一行，带有页码 index（从0起）。有流式输出方式时，每页完成即写出，
+    // 最后一页作为本轮的回复返回
+    std::string Task::run_document(cv::Mat first)
+    {
+        std::shared_ptr<Document> doc;
+        doc.swap(t_document);
+        std::string replies;
+        run_ocr_document(doc, first, t_parser, t_options, [&](int index, const std::string &reply)
+                         {
+            std::string line = tag_reply(reply, index);
+            if (stream_sink)
+            {
+                if (!replies.empty())
+                    stream_sink(replies);
+                replies.swap(line);
             }
             else
             {
-                j["box"] = {{b[0][0], b[0][1]}, {b[1][0], b[1][1]}, {b[2][0], b[2][1]}, {b[3][0], b[3][1]}};
+                if (!replies.empty())
+                    replies += "\n";
+                replies += line;
+            } });
+        return replies;
+    }
+
+    void Task::run_ocr_document(const std::shared_ptr<Document> &doc, cv::Mat first, const std::string &parser,
+                                const OCROptions &options, const std::function<void(int, const std::string &)> &on_page)
+    {
+        // 每次取几页一起识别：启用流水线时各阶段并行处理这几页，否则逐页
+        size_t chunk = FLAGS_pipeline_queue > 0 ? size_t(FLAGS_pipeline_queue) + 1 : 1;
+        PageReader reader(doc, first.empty() ? 0 : 1, FLAGS_doc_threads, int(chunk) + FLAGS_doc_threads);
+        std::vector<int> indices;         // 本次各页的页码
+        std::vector<cv::Mat> imgs;        // 本次待识别的页面
+        std::vector<std::string> replies; // 本次各页的回复，待识别的页面为空
+        if (!first.empty())
+        {
+            indices.push_back(0);
+            imgs.push_back(first);
+            replies.push_back("");
+        }
+        bool more = true;
+        while (more || !indices.empty())
+        {
+            cv::Mat page;
+            int index;
+            while (indices.size() < chunk && (more = reader.next(page, index)))
+            {
+                indices.push_back(index);
+                replies.push_back("");
+                if (page.empty())
+                    replies.back() = get_state_json(CODE_ERR_DOC_RENDER, MSG_ERR_DOC_RENDER(index));
+                else if (!MemoryGovernor::admit(page))
+                    replies.back() = get_state_json(CODE_ERR_IMAGE_SIZE, MSG_ERR_IMAGE_SIZE(page.cols, page.rows));
+                else if (!apply_roi(page, options))
+                    replies.back() = get_state_json(CODE_ERR_OPTION, MSG_ERR_OPTION(std::string("roi")));
+                else
+                    imgs.push_back(page);
             }
-            // 如果启用了cls，则cls_label有实际值，那么写入方向分类相关参数
-            if (ocr_result[i].cls_label != -1)
+            std::vector<std::string> results = run_ocr_mats(imgs, parser, options);
+            for (size_t k = 0, r = 0; k < indices.size(); k++)
             {
-                j["cls_label"] = ocr_result[i].cls_label; // 方向标签，0表示顺时针0°或90°，1表示180°或270°
-                j["cls_score"] = ocr_result[i].cls_score; // 方向标签置信度，越接近1越可信
+                on_page(indices[k], replies[k].empty() ? results[r++] : replies[k]);
             }
+            indices.clear();
+            imgs.clear();
+            replies.clear();
+        }
+    }
 
-            outJ["data"].push_back(j);
-            isEmpty = false;
+    // 执行一个二进制帧任务
+    std::string Task::run_ocr_frame(const FrameHeader &header, const char *payload)
+    {
+        t_image_path = "frame"; // 设置图片路径标记，以便于无文字时的信息输出
+        cv::Mat img;
+        {
+            StageTimer timer(Metrics::STAGE_DECODE);
+            img = imread_frame(header, payload);
+        }
+        if (!img.empty() && !check_image_size(img))
+        {
+            img = cv::Mat();
+        }
+        if (img.empty())
+        { // 读图失败
+            return get_state_json();
+        }
+        bool det = FLAGS_det, cls = FLAGS_cls, rec = FLAGS_rec;
+        if (header.options & FRAME_OPT_OVERRIDE)
+        { // 本帧指定的任务选项
+            det = (header.options & FRAME_OPT_DET) != 0;
+            cls = (header.options & FRAME_OPT_CLS) != 0;
+            rec = (header.options & FRAME_OPT_REC) != 0;
         }
+        // 执行OCR
+        std::string res_json = ocr_json(img, det, cls, rec);
         // 结果1：识别成功，无文字（rec未检出）
-        if (isEmpty)
+        if (res_json.empty())
         {
-            return "";
+            return get_state_json(CODE_OK_NONE, MSG_OK_NONE(t_image_path));
         }
         // 结果2：识别成功，有文字
-        return json_dump(outJ);
+        return res_json;
     }
 
-    // 输入base64编码的字符串，返回Mat
-    cv::Mat Task::imread_base64(std::string &b64str, int flag)
+    // 一次传入多张图片进行OCR，返回各图片的json字符串。启用流水线时，各阶段并行处理不同图片
+    std::vector<std::string> Task::run_ocr_mats(std::vector<cv::Mat> imgs, const std::string &parser,
+                                                const OCROptions &options)
     {
-        std::string decoded_string;
-        try
+        std::vector<std::string> replies(imgs.size());
+        if (imgs.empty())
         {
-            decoded_string = base64_decode(b64str);
+            return replies;
         }
-        catch (...)
+        if (!parser.empty() && !Tbpu::valid(parser))
         {
-            set_state(CODE_ERR_BASE64_DECODE, MSG_ERR_BASE64_DECODE); // 报告状态：解析失败
-            return cv::Mat();
+            replies.assign(imgs.size(), get_state_json(CODE_ERR_PARSER, MSG_ERR_PARSER(parser)));
+            return replies;
         }
-        try
+        bool det, cls, rec;
+        request_stages(options, det, cls, rec);
+        std::vector<std::vector<OCRPredictResult>> res_ocr = ppocr->ocr(imgs, det, rec, cls, &options);
+        for (size_t i = 0; i < res_ocr.size() && i < replies.size(); i++)
         {
-            std::vector<uchar> data(decoded_string.begin(), decoded_string.end());
-            cv::Mat img = cv::imdecode(data, flag);
-            if (img.empty())
+            map_to_source(res_ocr[i], options);
+            Tbpu::run(use_parser(parser), res_ocr[i]);
+            replies[i] = get_ocr_result_json(res_ocr[i], det, rec);
+            if (replies[i].empty()) // 无文字
             {
-                set_state(CODE_ERR_BASE64_IM_DECODE, MSG_ERR_BASE64_IM_DECODE); // 报告状态：转Mat失败
+                replies[i] = get_state_json(CODE_OK_NONE, "No text found in image");
             }
-            return img;
-        }
-        catch (...)
-        {
-            set_state(CODE_ERR_BASE64_IM_DECODE, MSG_ERR_BASE64_IM_DECODE); // 报告状态：转Mat失败
-            return cv::Mat();
         }
+        return replies;
     }
 
-    // 输入json字符串，解析并读取Mat
-    cv::Mat Task::imread_json(std::string &str_in)
+    std::string Task::run_rec_mats(std::vector<cv::Mat> imgs, const OCROptions &options)
     {
-#ifdef ENABLE_REMOTE_EXIT
-        if (str_in == "exit")
-        { // 退出指令
-            is_exit = true;
-            return cv::Mat();
-        }
-#endif
-        cv::Mat img;
-        bool is_image_found = false; // 当前是否已找到图片
-        std::string logstr = "";
-        // 解析为json对象
-        auto j = nlohmann::json();
-        try
+        bool det, cls, rec;
+        request_stages(options, det, cls, rec);
+        if (!rec)
         {
-            j = nlohmann::json::parse(str_in); // 转json对象
+            return get_state_json(CODE_ERR_OPTION, MSG_ERR_OPTION(std::string("rec")));
         }
-        catch (...)
+        // 不经 det 的多图OCR：方向分类与识别各自对全部图片分批推理
+        std::vector<std::vector<OCRPredictResult>> res_ocr = ppocr->ocr(imgs, false, true, cls, &options);
+        StageTimer timer(Metrics::STAGE_JSON);
+        std::string out;
+        JsonWriter j(out, FLAGS_ensure_ascii);
+        j.begin_object().key("code").value(CODE_OK).key("data").begin_array();
+        for (size_t i = 0; i < res_ocr.size(); i++)
         {
-            set_state(CODE_ERR_JSON_PARSE, MSG_ERR_JSON_PARSE); // 报告状态：解析失败
-            return cv::Mat();
-        }
-        for (auto &el : j.items())
-        { // 遍历键值
-#ifdef ENABLE_REMOTE_EXIT
-            if (el.key() == "exit")
-            { // 退出指令
-                is_exit = true;
-                return cv::Mat();
-            }
-#endif
-            try
+            j.begin_object();
+            if (!res_ocr[i].empty())
             {
-                std::string value = to_string(el.value());
-                int vallen = value.length();
-                if (vallen > 2 && value[0] == '\"' && value[vallen - 1] == '\"')
-                {
-                    value = value.substr(1, vallen - 2); // 删去nlohmann字符串的两端引号
-                }
-                // 提取图片
-                if (!is_image_found)
+                const OCRPredictResult &r = res_ocr[i][0];
+                if (r.cls_label != -1)
                 {
-                    if (el.key() == "image_base64")
-                    {                                // base64字符串
-                        FLAGS_image_path = "base64"; // 设置图片路径标记，以便于无文字时的信息输出
-                        img = imread_base64(value);  // 读取图片
-                        is_image_found = true;
-                    }
-#ifdef ENABLE_JSON_IMAGE_PATH
-                    else if (el.key() == "image_path")
-                    { // 图片路径
-                        FLAGS_image_path = value;
-                        img = imread_u8(value); // 读取图片
-                        is_image_found = true;
-                    }
-#endif
+                    j.key("cls_label").value(r.cls_label).key("cls_score").value(r.cls_score);
                 }
-                // else {} // TODO: 其它参数热更新
-            }
-            catch (...)
-            {                                                                         // 安全起见，出现未知异常时结束本轮任务
-                set_state(CODE_ERR_JSON_PARSE_KEY, MSG_ERR_JSON_PARSE_KEY(el.key())); // 报告状态：解析键失败
-                return cv::Mat();
+                j.key("score").value(r.score > 0 ? r.score : 0.0f).key("text").value(r.score > 0 ? r.text : std::string());
             }
+            j.end_object();
         }
-        if (!is_image_found)
+        j.end_array().end_object();
+        return json_finish(j, out);
+    }
+
+    // 流式：各阶段的中间结果先经由 emit 输出，返回最终结果json字符串（用于HTTP服务器）
+    std::string Task::run_ocr_mat(cv::Mat img, const std::function<void(const std::string &)> &emit,
+                                  const std::string &parser, const OCROptions &options)
+    {
+        if (img.empty())
+        { // 图片为空
+            return get_state_json(CODE_ERR_BASE64_IM_DECODE, "Invalid image data");
+        }
+        if (!parser.empty() && !Tbpu::valid(parser))
         {
-            set_state(CODE_ERR_NO_TASK, MSG_ERR_NO_TASK); // 报告状态：未发现有效任务
+            return get_state_json(CODE_ERR_PARSER, MSG_ERR_PARSER(parser));
         }
-        return img;
+        bool det, cls, rec;
+        request_stages(options, det, cls, rec);
+        std::string res_json = ocr_json_stream(img, det, cls, rec, emit, parser, &options);
+        if (res_json.empty())
+        {
+            return get_state_json(CODE_OK_NONE, "No text found in image");
+        }
+        return res_json;
     }
 
-    // ==================== 任务流程 ====================
+    std::string Task::structure_json(cv::Mat &img)
+    {
+        std::vector<StructurePredictResult> res = structure_engine()->structure(
+            img, FLAGS_layout, FLAGS_table, FLAGS_det && FLAGS_rec);
+        return get_structure_result_json(res);
+    }
 
-    std::string Task::run_ocr(std::string str_in)
+    // 直接传入cv::Mat进行版面与表格识别，返回json字符串（用于HTTP服务器）
+    std::string Task::run_structure_mat(cv::Mat img)
     {
-        cv::Mat img = imread_json(str_in);
-        if (is_exit)
-        { // 退出
-            return "";
-        }
         if (img.empty())
-        { // 读图失败
-            return get_state_json();
+        { // 图片为空
+            return get_state_json(CODE_ERR_BASE64_IM_DECODE, "Invalid image data");
         }
-        // 执行OCR
-        std::vector<OCRPredictResult> res_ocr = ppocr->ocr(img, FLAGS_det, FLAGS_rec, FLAGS_cls);
-        // 获取结果
-        std::string res_json = get_ocr_result_json(res_ocr);
-        // 结果1：识别成功，无文字（rec未检出）
+        std::string res_json = structure_json(img);
         if (res_json.empty())
         {
-            return get_state_json(CODE_OK_NONE, MSG_OK_NONE(FLAGS_image_path));
-        }
-        // 结果2：识别成功，有文字
-        else
-        {
-            return res_json;
+            return get_state_json(CODE_OK_NONE, "No region found in image");
         }
+        return res_json;
     }
 
     // 直接传入cv::Mat进行OCR，返回json字符串（用于HTTP服务器）
-    std::string Task::run_ocr_mat(cv::Mat img)
+    std::string Task::run_ocr_mat(cv::Mat img, const std::string &parser, const OCROptions &options)
     {
         if (img.empty())
         { // 图片为空
             return get_state_json(CODE_ERR_BASE64_IM_DECODE, "Invalid image data");
         }
+        if (!parser.empty() && !Tbpu::valid(parser))
+        {
+            return get_state_json(CODE_ERR_PARSER, MSG_ERR_PARSER(parser));
+        }
         // 执行OCR
-        std::vector<OCRPredictResult> res_ocr = ppocr->ocr(img, FLAGS_det, FLAGS_rec, FLAGS_cls);
-        // 获取结果
-        std::string res_json = get_ocr_result_json(res_ocr);
+        bool det, cls, rec;
+        request_stages(options, det, cls, rec);
+        std::string res_json = ocr_json(img, det, cls, rec, parser, &options);
         // 结果1：识别成功，无文字（rec未检出）
         if (res_json.empty())
         {
@@ -266,81 +1328,144 @@ namespace PaddleOCR
     void Task::init_engine()
     {
         auto init_start = std::chrono::steady_clock::now();
-        this->ppocr.reset(new PPOCR()); // 创建引擎实例，管理权移交给智能指针 ppocr
+        if (FLAGS_type == "structure")
+        {
+            this->ppocr.reset(new PaddleStructure()); // 版面与表格识别引擎，同时可做普通OCR
+        }
+        else
+        {
+            this->ppocr.reset(new PPOCR()); // 创建引擎实例，管理权移交给智能指针 ppocr
+        }
+        if (FLAGS_result_cache_mb > 0)
+        {
+            this->result_cache.reset(new ResultCache(size_t(FLAGS_result_cache_mb) << 20));
+        }
         auto init_end = std::chrono::steady_clock::now();
         std::chrono::duration<double> duration = init_end - init_start;
         std::cerr << "OCR init time: " << duration.count() << "s" << std::endl;
+        warmup_engine();
+    }
+
+    void Task::init_engine(const Task &base)
+    {
+        auto init_start = std::chrono::steady_clock::now();
+        if (base.structure_engine())
+        {
+            this->ppocr.reset(new PaddleStructure(*base.structure_engine()));
+        }
+        else
+        {
+            this->ppocr.reset(new PPOCR(*base.ppocr)); // 克隆引擎实例，共享模型权重
+        }
+        this->result_cache = base.result_cache;    // 共享结果缓存
+        auto init_end = std::chrono::steady_clock::now();
+        std::chrono::duration<double> duration = init_end - init_start;
+        std::cerr << "OCR clone time: " << duration.count() << "s" << std::endl;
+        warmup_engine();
+    }
+
+    PaddleStructure *Task::structure_engine() const
+    {
+        return dynamic_cast<PaddleStructure *>(ppocr.get());
+    }
+
+    void Task::warmup_engine()
+    {
+        if (!FLAGS_warmup)
+        {
+            return;
+        }
+        auto warmup_start = std::chrono::steady_clock::now();
+        this->ppocr->warmup();
+        auto warmup_end = std::chrono::steady_clock::now();
+        std::chrono::duration<double> duration = warmup_end - warmup_start;
+        std::cerr << "OCR warmup time: " << duration.count() << "s" << std::endl;
     }
 
-    void Task::memory_check_cleanup()
+    Task::~Task()
     {
-        /*int mem1 = Task::get_memory_mb();
-        auto time1 = std::chrono::steady_clock::now();
+        shm_unmap();
+    }
+
+    void Task::release_memory()
+    {
+        std::vector<uchar>().swap(decode_buffer); // 释放读图缓冲区
+        shm_unmap();                              // 解除共享内存映射，下次请求时重新打开
+        // 调用 det cls rec 实例的内存清理方法
         if (this->ppocr->detector_)
         {
-            this->ppocr->detector_->predictor_->ClearIntermediateTensor();
-            this->ppocr->detector_->predictor_->TryShrinkMemory();
+            this->ppocr->detector_->predictor_->ShrinkMemory();
+            this->ppocr->detector_->arena_.Release();
+            this->ppocr->detector_->ReleaseDevice();
         }
         if (this->ppocr->classifier_)
         {
-            this->ppocr->classifier_->predictor_->ClearIntermediateTensor();
-            this->ppocr->classifier_->predictor_->TryShrinkMemory();
+            this->ppocr->classifier_->predictor_->ShrinkMemory();
+            this->ppocr->classifier_->arena_.Release();
         }
         if (this->ppocr->recognizer_)
         {
-            this->ppocr->recognizer_->predictor_->ClearIntermediateTensor();
-            this->ppocr->recognizer_->predictor_->TryShrinkMemory();
+            this->ppocr->recognizer_->predictor_->ShrinkMemory();
+            this->ppocr->recognizer_->arena_.Release();
         }
-        int mem2 = Task::get_memory_mb();
-        auto time2 = std::chrono::steady_clock::now();
-        std::chrono::duration<double> time_change = time2 - time1;
-        std::cerr << "memory cleanup: " << mem1 << "->" << mem2 << "MB, time: " << time_change.count() << "s" << std::endl;
-        return;*/
-        auto cleanup_start = std::chrono::steady_clock::now();
-        if (FLAGS_cpu_mem <= 0) // 无限制
+    }
+
+    std::string Task::memory_report() const
+    {
+        std::string out;
+        auto add = [&out](const char *name, const TensorArena &arena)
         {
-            return;
-        }
-        int mem = Task::get_memory_mb(); // 当前内存占用
-        if (mem <= 0)                    // 获取失败
+            std::string shape = arena.PeakShape();
+            if (!shape.empty())
+                out += (out.empty() ? "" : ", ") + std::string(name) + " " + shape;
+        };
+        if (this->ppocr->detector_)
+            add("det", this->ppocr->detector_->arena_);
+        if (this->ppocr->classifier_)
+            add("cls", this->ppocr->classifier_->arena_);
+        if (this->ppocr->recognizer_)
+            add("rec", this->ppocr->recognizer_->arena_);
+        return out.empty() ? "none" : out;
+    }
+
+    void Task::start_governor()
+    {
+        if (FLAGS_cpu_mem <= 0) // 无限制
         {
             return;
         }
-        // 达到上限，进行清理
-        if (mem >= FLAGS_cpu_mem)
-        { 
-            // Task::init_engine();
-            // 调用 det cls rec 实例的内存清理方法
-			if (this->ppocr->detector_)
-			{
-				this->ppocr->detector_->predictor_->ClearIntermediateTensor();
-				this->ppocr->detector_->predictor_->TryShrinkMemory();
-			}
-            if (this->ppocr->classifier_)
+        // 只有一个引擎：正在处理请求时 try_lock 失败，留到下次轮询
+        governor.reset(new MemoryGovernor(
+            1, [this](std::vector<bool> &released)
             {
-                this->ppocr->classifier_->predictor_->ClearIntermediateTensor();
-                this->ppocr->classifier_->predictor_->TryShrinkMemory();
-            }
-            if (this->ppocr->recognizer_)
-            {
-                this->ppocr->recognizer_->predictor_->ClearIntermediateTensor();
-                this->ppocr->recognizer_->predictor_->TryShrinkMemory();
-            }
-            auto cleanup_end = std::chrono::steady_clock::now();
-            std::chrono::duration<double> duration = cleanup_end - cleanup_start;
-            int mem2 = Task::get_memory_mb(); // 当前内存占用
-            std::cerr << "memory cleanup: " << mem << "->" << mem2 << "MB, time: " << duration.count() << "s" << std::endl;
-            // Task::init_engine();
-        }
-        else
+                std::unique_lock<std::mutex> lock(run_mutex, std::try_to_lock);
+                if (!lock.owns_lock())
+                    return 0;
+                release_memory();
+                released[0] = true;
+                return 1; },
+            [this]
+            { return memory_report(); }));
+    }
+
+    bool Task::check_image_size(const cv::Mat &img)
+    {
+        if (MemoryGovernor::admit(img))
         {
-            std::cerr << "memory used: " << mem << std::endl;
+            return true;
         }
+        set_state(CODE_ERR_IMAGE_SIZE, MSG_ERR_IMAGE_SIZE(img.cols, img.rows));
+        return false;
     }
 
-    // 入口
     int Task::ocr()
     {
+        // 离线批量模式：引擎池中的各引擎自行加载，本实例不加载
+        if (!FLAGS_batch.empty())
+        {
+            std::cout << "OCR batch mode. Input: " << FLAGS_batch << ", output: " << FLAGS_batch_output << std::endl;
+            return batch_mode();
+        }
         Task::init_engine(); // 初始化引擎
         int flag;
 
@@ -348,8 +1473,14 @@ namespace PaddleOCR
         std::cout << "OCR clipboard enbaled." << std::endl;
 #endif
 
+        // 视频OCR模式
+        if (!FLAGS_video.empty())
+        {
+            std::cout << "OCR video mode. Source: " << FLAGS_video << std::endl;
+            flag = 0;
+        }
         // 单张图片识别模式
-        if (!FLAGS_image_path.empty())
+        else if (!FLAGS_image_path.empty())
         {
             std::cout << "OCR single image mode. Path: " << FLAGS_image_path << std::endl;
             flag = 1;
@@ -367,9 +1498,15 @@ namespace PaddleOCR
             flag = 3;
         }
         std::cout << "OCR init completed." << std::endl;
+        if (flag > 1)
+        {
+            start_governor();
+        }
 
         switch (flag)
         {
+        case 0:
+            return video_mode();
         case 1:
             return single_image_mode();
         case 2:
@@ -380,6 +1517,18 @@ namespace PaddleOCR
         return 0;
     }
 
+    // 视频OCR模式：每个事件输出一行json，视频结束后退出
+    int Task::video_mode()
+    {
+        VideoOCR video(*ppocr, [](const std::string &line)
+                       { std::cout << line << std::endl; });
+        if (!video.run(FLAGS_video, FLAGS_cls, FLAGS_rec))
+        {
+            std::cout << get_state_json(CODE_ERR_VIDEO_OPEN, MSG_ERR_VIDEO_OPEN(FLAGS_video)) << std::endl;
+        }
+        return 0;
+    }
+
     // 单张图片识别模式
     int Task::single_image_mode()
     {
@@ -391,9 +1540,8 @@ namespace PaddleOCR
             return 0;
         }
         // 执行OCR
-        std::vector<OCRPredictResult> res_ocr = ppocr->ocr(img, FLAGS_det, FLAGS_rec, FLAGS_cls);
-        // 获取结果
-        std::string res_json = get_ocr_result_json(res_ocr);
+        std::string res_json = structure_engine() ? structure_json(img)
+                                                  : ocr_json(img, FLAGS_det, FLAGS_cls, FLAGS_rec);
         // 结果1：识别成功，无文字（rec未检出）
         if (res_json.empty())
         {
@@ -410,28 +1558,160 @@ namespace PaddleOCR
     // 匿名管道模式
     int Task::anonymous_pipe_mode()
     {
+#ifdef _WIN32
+        // 二进制帧要求 stdin 不做换行符转换
+        _setmode(_fileno(stdin), _O_BINARY);
+#endif
+        std::vector<char> frame_buffer; // 二进制帧负载缓冲区，只增不减
+        stream_sink = [](const std::string &line)
+        { std::cout << line << std::endl; }; // 流式中间结果立即写出
         while (1)
         {
             set_state(); // 初始化状态
-            // 读取一行输入
-            std::string str_in;
-            getline(std::cin, str_in);
-            // 获取ocr结果并输出
-            std::string str_out = run_ocr(str_in);
+            std::string str_out;
+            int next = std::cin.peek();
+            if (next == EOF)
+            { // stdin 已关闭（调用方退出或重启本进程），不再有请求
+                return 0;
+            }
+            if (next == (unsigned char)FRAME_MAGIC[0])
+            { // 二进制帧
+                char head[FRAME_HEADER_SIZE];
+                FrameHeader header;
+                if (!std::cin.read(head, FRAME_HEADER_SIZE))
+                {
+                    str_out = get_state_json(CODE_ERR_FRAME_INCOMPLETE, MSG_ERR_FRAME_INCOMPLETE);
+                }
+                else if (!parse_frame_header(head, header))
+                {
+                    str_out = get_state_json();
+                    if (t_code == CODE_ERR_FRAME_SIZE) // 帧头完好：跳过负载，之后的请求仍可正常读取
+                        std::cin.ignore(std::streamsize(header.length));
+                }
+                else
+                {
+                    if (frame_buffer.size() < header.length)
+                        frame_buffer.resize(header.length);
+                    if (!std::cin.read(frame_buffer.data(), header.length))
+                        str_out = get_state_json(CODE_ERR_FRAME_INCOMPLETE, MSG_ERR_FRAME_INCOMPLETE);
+                    else
+                    {
+                        std::lock_guard<std::mutex> lock(run_mutex); // 处理期间不做内存清理
+                        str_out = run_ocr_frame(header, frame_buffer.data());
+                    }
+                }
+            }
+            else
+            {
+                // 读取一行输入
+                std::string str_in;
+                getline(std::cin, str_in);
+                if (!str_in.empty() && str_in.back() == '\r')
+                    str_in.pop_back(); // 二进制模式下，去掉 \r\n 中的 \r
+                // 获取ocr结果
+                std::lock_guard<std::mutex> lock(run_mutex); // 处理期间不做内存清理
+                str_out = run_ocr(str_in);
+            }
             if (is_exit)
             { // 退出
                 return 0;
             }
             // 回传结果
             std::cout << str_out << std::endl;
-            // 检查、清理内存
-            Task::memory_check_cleanup();
         }
         return 0;
     }
 
     // 套接字服务器模式，在平台内定义
 
+    size_t Task::max_request_bytes()
+    {
+        return size_t(FLAGS_max_request_mb) << 20;
+    }
+
+    // 套接字连接的请求分帧：从接收缓冲区中取出以 \n 或 \0 结尾的完整请求，逐个执行OCR，
+    // 返回待发送的回复（每条以 \n 结尾）。eof 为true表示对方已关闭写端，剩余不完整数据也当作一条请求。
+    // 未结束的请求超过 max_request_bytes 时回复错误并置 eof：不再接收，回复发完后关闭连接
+    std::string Task::socket_handle(std::string &buffer, bool &eof)
+    {
+        std::lock_guard<std::mutex> lock(run_mutex); // 处理期间不做内存清理
+        std::string replies;
+        size_t begin = 0;
+        while (!is_exit && begin < buffer.size())
+        {
+            if (buffer[begin] == FRAME_MAGIC[0])
+            { // 二进制帧
+                size_t avail = buffer.size() - begin;
+                FrameHeader header;
+                if (avail < FRAME_HEADER_SIZE)
+                {
+                    if (!eof)
+                        break; // 等待完整帧头
+                    replies += get_state_json(CODE_ERR_FRAME_INCOMPLETE, MSG_ERR_FRAME_INCOMPLETE) + '\n';
+                    begin = buffer.size();
+                    break;
+                }
+                set_state(); // 初始化状态
+                if (!parse_frame_header(buffer.data() + begin, header))
+                { // 帧头错误后无法定位下一条请求，丢弃剩余数据
+                    replies += get_state_json() + '\n';
+                    begin = buffer.size();
+                    if (t_code == CODE_ERR_FRAME_SIZE) // 超长负载仍在到来，关闭连接而不是继续接收
+                        eof = true;
+                    break;
+                }
+                size_t frame_size = FRAME_HEADER_SIZE + size_t(header.length);
+                if (avail < frame_size)
+                {
+                    if (!eof)
+                    {
+                        buffer.reserve(begin + frame_size); // 一次性预留，避免接收大负载时反复扩容
+                        break;
+                    }
+                    replies += get_state_json(CODE_ERR_FRAME_INCOMPLETE, MSG_ERR_FRAME_INCOMPLETE) + '\n';
+                    begin = buffer.size();
+                    break;
+                }
+                OCR_LOG_DEBUG("Get frame. Length: " << header.length);
+                std::string str_out = run_ocr_frame(header, buffer.data() + begin + FRAME_HEADER_SIZE);
+                OCR_LOG_DEBUG(str_out);
+                replies += str_out;
+                replies += '\n';
+                begin += frame_size;
+                continue;
+            }
+            size_t end = buffer.find_first_of(std::string("\n\0", 2), begin);
+            if (end == std::string::npos)
+            {
+                if (!eof || begin >= buffer.size())
+                    break;
+                end = buffer.size(); // 连接关闭前的最后一条请求（兼容不带末尾符的旧客户端）
+            }
+            if (end > begin) // 跳过空行
+            {
+                OCR_LOG_DEBUG("Get string. Length: " << end - begin);
+                set_state(); // 初始化状态
+                std::string str_out = run_ocr(buffer.substr(begin, end - begin));
+                if (is_exit)
+                    break;
+                OCR_LOG_DEBUG(str_out);
+                replies += str_out;
+                replies += '\n';
+            }
+            begin = end + 1;
+        }
+        buffer.erase(0, begin < buffer.size() ? begin : buffer.size());
+        // 剩余的是未结束的请求：帧的长度已在帧头中检查，这里只会是过长的一行
+        if (!eof && buffer.size() > FRAME_HEADER_SIZE + max_request_bytes())
+        {
+            replies += get_state_json(CODE_ERR_REQUEST_SIZE, MSG_ERR_REQUEST_SIZE) + '\n';
+            buffer.clear();
+            buffer.shrink_to_fit();
+            eof = true;
+        }
+        return replies;
+    }
+
     // 其他函数
 
     // ipv4 地址转 uint32_t
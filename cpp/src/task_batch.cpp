@@ -0,0 +1,373 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+// 离线批量模式：识别目录或文件列表中的全部图片，结果按输入顺序逐行写入NDJSON文件，
+// 定期写检查点，中断后以相同参数重新运行即从检查点续跑
+
+#include "include/task.h"
+#include "include/args.h"
+#include "include/engine_pool.h"
+#include "include/logger.h"
+#include "include/utility.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <thread>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <share.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace PaddleOCR
+{
+    static const int BATCH_REPORT_SEC = 5;     // 进度输出间隔
+    static const int BATCH_CHECKPOINT_MS = 1000; // 检查点写入间隔
+
+    // 目录中收录的图片扩展名（不区分大小写），其它文件跳过
+    static bool is_image_file(const std::string &path)
+    {
+        static const char *EXTS[] = {".jpg", ".jpeg", ".png", ".bmp", ".tif", ".tiff", ".webp", ".jp2", ".pbm", ".pgm", ".ppm"};
+        size_t dot = path.rfind('.');
+        if (dot == std::string::npos)
+            return false;
+        std::string ext = path.substr(dot);
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        for (const char *e : EXTS)
+        {
+            if (ext == e)
+                return true;
+        }
+        return false;
+    }
+
+    // 读取输入：目录（不递归）按路径排序，使续跑时顺序不变；文件列表为每行一个路径，跳过空行与 # 开头的行
+    static bool batch_inputs(const std::string &source, std::vector<std::string> &inputs)
+    {
+        if (Utility::IsDir(source))
+        {
+            std::vector<std::string> files;
+            Utility::GetAllFiles(source.c_str(), files);
+            for (size_t i = 0; i < files.size(); i++)
+            {
+                if (is_image_file(files[i]))
+                    inputs.push_back(files[i]);
+            }
+            std::sort(inputs.begin(), inputs.end());
+            return true;
+        }
+        std::ifstream in(source);
+        if (!in)
+        {
+            return false;
+        }
+        std::string line;
+        while (std::getline(in, line))
+        {
+            if (!line.empty() && line[line.size() - 1] == '\r')
+                line.erase(line.size() - 1);
+            if (!line.empty() && line[0] != '#')
+                inputs.push_back(line);
+        }
+        return true;
+    }
+
+    // 检查点：已按序写完的图片数、此时输出文件的长度，以及最后一张图片的路径（续跑时核对输入是否变化）
+    struct BatchCheckpoint
+    {
+        size_t done = 0;
+        long long offset = 0;
+        std::string last;
+    };
+
+    static bool read_checkpoint(const std::string &path, BatchCheckpoint &ckpt)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+        {
+            return false;
+        }
+        std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        nlohmann::json j = nlohmann::json::parse(text, nullptr, false);
+        if (!j.is_object())
+        {
+            return false;
+        }
+        ckpt.done = j.value("done", (size_t)0);
+        ckpt.offset = j.value("offset", 0LL);
+        ckpt.last = j.value("last", std::string());
+        return true;
+    }
+
+    // 先写临时文件再改名，中途中断时旧的检查点仍完整
+    static bool write_checkpoint(const std::string &path, const BatchCheckpoint &ckpt, size_t total)
+    {
+        std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            nlohmann::json j = {{"done", ckpt.done}, {"offset", ckpt.offset}, {"last", ckpt.last}, {"total", total}};
+            out << j.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+            if (!out)
+                return false;
+        }
+#ifdef _WIN32
+        std::remove(path.c_str()); // Windows 下 rename 不覆盖已有文件
+#endif
+        return std::rename(tmp.c_str(), path.c_str()) == 0;
+    }
+
+    // 输出文件截断到检查点记录的长度，丢弃检查点之后写出的行（中断时可能只写了半行）
+    static bool truncate_file(const std::string &path, long long size)
+    {
+#ifdef _WIN32
+        int fd = -1;
+        if (_sopen_s(&fd, path.c_str(), _O_RDWR | _O_BINARY, _SH_DENYNO, _S_IREAD | _S_IWRITE) != 0)
+            return false;
+        bool ok = _chsize_s(fd, size) == 0;
+        _close(fd);
+        return ok;
+#else
+        return truncate(path.c_str(), (off_t)size) == 0;
+#endif
+    }
+
+    // 结果行中回复json的状态码，用于统计失败的图片
+    static int reply_code(const std::string &line)
+    {
+        static const char KEY[] = "\"result\":{\"code\":";
+        size_t pos = line.find(KEY);
+        return pos == std::string::npos ? 0 : atoi(line.c_str() + pos + sizeof(KEY) - 1);
+    }
+
+    int Task::batch_mode()
+    {
+        std::vector<std::string> inputs;
+        if (!batch_inputs(FLAGS_batch, inputs))
+        {
+            std::cerr << "[ERROR] Failed to read batch input: " << FLAGS_batch << std::endl;
+            return 1;
+        }
+        const size_t total = inputs.size();
+        const std::string ckpt_path = FLAGS_batch_output + ".ckpt";
+
+        // 续跑：核对检查点与输入，截断输出
+        BatchCheckpoint ckpt;
+        if (read_checkpoint(ckpt_path, ckpt))
+        {
+            if (ckpt.done > total || (ckpt.done > 0 && inputs[ckpt.done - 1] != ckpt.last))
+            {
+                std::cerr << "[ERROR] Batch input changed since checkpoint " << ckpt_path
+                          << ", delete it and the output to start over." << std::endl;
+                return 1;
+            }
+            if (!truncate_file(FLAGS_batch_output, ckpt.offset))
+            {
+                std::cerr << "[ERROR] Failed to truncate batch output: " << FLAGS_batch_output << std::endl;
+                return 1;
+            }
+            std::cout << "OCR batch resuming from checkpoint: " << ckpt.done << "/" << total << std::endl;
+        }
+        else
+        {
+            ckpt = BatchCheckpoint();
+        }
+        std::ofstream out(FLAGS_batch_output, std::ios::binary | (ckpt.done > 0 ? std::ios::app : std::ios::trunc));
+        if (!out)
+        {
+            std::cerr << "[ERROR] Failed to open batch output: " << FLAGS_batch_output << std::endl;
+            return 1;
+        }
+        out.seekp(0, std::ios::end);
+        if (ckpt.done >= total)
+        {
+            std::cout << "OCR batch already completed: " << total << " images." << std::endl;
+            return 0;
+        }
+
+        // 每个工作线程独占一个引擎，按块领取连续的图片，块内经由多图流水线识别
+        EnginePool pool(FLAGS_batch_workers);
+        std::cout << "OCR init completed." << std::endl;
+        std::cout << "OCR batch: " << total - ckpt.done << " of " << total << " images, "
+                  << FLAGS_batch_workers << " workers." << std::endl;
+
+        const size_t chunk = (size_t)FLAGS_batch_chunk;
+        const size_t window = chunk * (size_t)FLAGS_batch_workers * 4; // 领先于写出位置的图片数上限，限制缓存的结果
+        std::mutex mutex;
+        std::condition_variable ready;   // 有块完成
+        std::condition_variable written; // 写出位置前进
+        std::map<size_t, std::vector<std::string>> results; // 块起点 -> 各图片的结果行，等待按序写出
+        size_t write_pos = ckpt.done;
+        std::atomic<size_t> next(ckpt.done);
+        std::string error;
+
+        auto work = [&]()
+        {
+            EnginePool::Lease engine = pool.acquire();
+            Task &task = *engine;
+            while (true)
+            {
+                size_t begin = next.fetch_add(chunk);
+                if (begin >= total)
+                    break;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    written.wait(lock, [&]
+                                 { return begin < write_pos + window || !error.empty(); });
+                    if (!error.empty())
+                        break;
+                }
+                size_t end = std::min(begin + chunk, total);
+                std::vector<std::string> replies(end - begin);
+                try
+                {
+                    // 读图失败的图片直接得到错误回复，其余一次交给引擎
+                    std::vector<cv::Mat> imgs;
+                    std::vector<size_t> slots;
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        task.set_state();
+                        cv::Mat img = task.imread_u8(inputs[i]);
+                        task.t_document.reset(); // 多页TIFF只识别首页
+                        if (img.empty())
+                        {
+                            replies[i - begin] = task.get_state_json();
+                        }
+                        else if (task.structure_engine())
+                        {
+                            replies[i - begin] = task.run_structure_mat(img);
+                        }
+                        else
+                        {
+                            imgs.push_back(img);
+                            slots.push_back(i - begin);
+                        }
+                    }
+                    std::vector<std::string> ocr = task.run_ocr_mats(imgs);
+                    for (size_t k = 0; k < ocr.size(); k++)
+                        replies[slots[k]] = ocr[k];
+                }
+                catch (const std::exception &e)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    error = e.what();
+                    ready.notify_all();
+                    written.notify_all();
+                    break;
+                }
+                // 每行：{"index":下标,"path":路径,"result":结果json}
+                for (size_t i = begin; i < end; i++)
+                {
+                    std::string line;
+                    JsonWriter j(line, FLAGS_ensure_ascii);
+                    j.begin_object().key("index").value(i).key("path").value(inputs[i]);
+                    j.key("result").raw(replies[i - begin]).end_object();
+                    if (!j.ok()) // 路径不是有效的UTF-8
+                    {
+                        line.clear();
+                        JsonWriter k(line, FLAGS_ensure_ascii);
+                        k.begin_object().key("index").value(i).key("result").raw(replies[i - begin]).end_object();
+                    }
+                    replies[i - begin].swap(line);
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                results[begin].swap(replies);
+                ready.notify_all();
+            }
+        };
+        std::vector<std::thread> threads;
+        for (int i = 0; i < FLAGS_batch_workers; i++)
+        {
+            threads.emplace_back(work);
+        }
+
+        // 当前线程按输入顺序写出，定期写检查点、输出进度
+        typedef std::chrono::steady_clock Clock;
+        Clock::time_point start = Clock::now(), last_report = start, last_ckpt = start;
+        const size_t resumed = write_pos;
+        size_t report_pos = write_pos, failed = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (write_pos < total && error.empty())
+        {
+            ready.wait_for(lock, std::chrono::milliseconds(200), [&]
+                           { return results.count(write_pos) || !error.empty(); });
+            while (results.count(write_pos))
+            {
+                std::vector<std::string> lines;
+                lines.swap(results[write_pos]);
+                results.erase(write_pos);
+                size_t first = write_pos;
+                lock.unlock();
+                for (size_t k = 0; k < lines.size(); k++)
+                {
+                    out << lines[k] << '\n';
+                    int code = reply_code(lines[k]);
+                    failed += code != CODE_OK && code != CODE_OK_NONE;
+                }
+                lock.lock();
+                write_pos = first + lines.size();
+                written.notify_all();
+            }
+            Clock::time_point now = Clock::now();
+            bool finished = write_pos >= total;
+            if (finished || now - last_ckpt >= std::chrono::milliseconds(BATCH_CHECKPOINT_MS))
+            {
+                out.flush();
+                if (!out)
+                {
+                    error = "write failed: " + FLAGS_batch_output;
+                    written.notify_all();
+                    break;
+                }
+                ckpt.done = write_pos;
+                ckpt.offset = (long long)out.tellp();
+                ckpt.last = write_pos > 0 ? inputs[write_pos - 1] : std::string();
+                if (!write_checkpoint(ckpt_path, ckpt, total))
+                {
+                    OCR_LOG_WARN("Failed to write batch checkpoint: " << ckpt_path);
+                }
+                last_ckpt = now;
+            }
+            if (finished || now - last_report >= std::chrono::seconds(BATCH_REPORT_SEC))
+            {
+                // 最近一段的速率，与本次运行以来的平均速率（ETA按后者估计）
+                double elapsed = std::chrono::duration<double>(now - start).count();
+                double recent = std::chrono::duration<double>(now - last_report).count();
+                double rate = recent > 0 ? (write_pos - report_pos) / recent : 0;
+                double avg = elapsed > 0 ? (write_pos - resumed) / elapsed : 0;
+                std::cout << "OCR batch: " << write_pos << "/" << total << " images, " << rate << " img/s (avg "
+                          << avg << "), " << failed << " failed";
+                if (avg > 0 && !finished)
+                {
+                    long long eta = (long long)((total - write_pos) / avg);
+                    std::cout << ", ETA " << eta / 3600 << "h" << eta / 60 % 60 << "m" << eta % 60 << "s";
+                }
+                std::cout << std::endl;
+                report_pos = write_pos;
+                last_report = now;
+            }
+        }
+        lock.unlock();
+        for (size_t i = 0; i < threads.size(); i++)
+        {
+            threads[i].join();
+        }
+        if (!error.empty())
+        {
+            std::cerr << "[ERROR] OCR batch stopped at " << write_pos << "/" << total << ": " << error << std::endl;
+            return 1;
+        }
+        std::cout << "OCR batch completed: " << total << " images, " << failed << " failed in this run." << std::endl;
+        return 0;
+    }
+
+} // namespace PaddleOCR
@@ -8,12 +8,21 @@
 #include "include/paddleocr.h"
 #include "include/args.h"
 #include "include/task.h"
+#include "include/logger.h"
 
 // 套接字
 #include <unistd.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
 #include <arpa/inet.h>
+#include <fcntl.h>
+// 文件映射
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <map>
+#include <vector>
 // 内存管理
 #include <fstream>
 #include <string>
@@ -21,8 +30,26 @@
 #undef INVALID_SOCKET
 #define INVALID_SOCKET -1
 
+#define SOCKET_RECV_BUFFER 65536 // 套接字接收缓冲区大小
+#define SOCKET_MAX_EVENTS 64     // 单次 epoll_wait 最多处理的事件数
+
 namespace PaddleOCR
 {
+    // 套接字连接状态
+    struct SocketConn
+    {
+        std::string in;   // 已接收、尚未处理的数据
+        std::string out;  // 待发送的回复
+        bool eof = false; // 对方已关闭写端
+    };
+
+    // 将套接字设为非阻塞
+    static void set_nonblocking(int fd)
+    {
+        int flags = fcntl(fd, F_GETFL, 0);
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    }
+
     // 获取当前内存占用。返回整数，单位MB。失败时返回-1。
     int Task::get_memory_mb()
     {
@@ -64,55 +91,55 @@ namespace PaddleOCR
     }
 
     // 代替cv imread，接收utf-8字符串传入，返回Mat。
+    // 文件以只读方式映射到内存后直接解码，不经过额外的读缓冲区。
     cv::Mat Task::imread_u8(std::string pathU8, int flag)
     {
-        std::ifstream fileInput;
-        size_t fileLength;
-        char *buffer;
-
-        // 尝试将pathU8读取到内存
-        try
+        int fd = open(pathU8.c_str(), O_RDONLY);
+        if (fd < 0)
         {
-            fileInput.open(pathU8, std::ios::binary);
-            // 路径不存在且无法输出
-            if (!fileInput)
-            {
+            if (errno == ENOENT || errno == ENOTDIR) // 路径不存在
                 set_state(CODE_ERR_PATH_EXIST, MSG_ERR_PATH_EXIST(pathU8));
-                return cv::Mat();
-            }
-
-            // 获取文件大小并将文件读到内存
-            fileInput.seekg(0, fileInput.end);
-            fileLength = fileInput.tellg();
-            fileInput.seekg(0, fileInput.beg);
-            buffer = new char[fileLength];
-            fileInput.read(buffer, fileLength);
-
-            // 无法读取
-            if (!fileInput)
-            {
+            else // 存在但无法打开
                 set_state(CODE_ERR_PATH_READ, MSG_ERR_PATH_READ(pathU8));
-                return cv::Mat();
-            }
+            return cv::Mat();
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+        {
+            set_state(CODE_ERR_PATH_READ, MSG_ERR_PATH_READ(pathU8));
+            close(fd);
+            return cv::Mat();
         }
-        catch (std::exception &err)
+        size_t fileLength = static_cast<size_t>(st.st_size);
+        if (fileLength == 0) // 空文件无法映射，也不可能解码
+        {
+            set_state(CODE_ERR_PATH_DECODE, MSG_ERR_PATH_DECODE(pathU8));
+            close(fd);
+            return cv::Mat();
+        }
+        void *data = mmap(NULL, fileLength, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); // 映射建立后即可关闭文件描述符
+        if (data == MAP_FAILED)
         {
-            // 文件打开失败或者是读取失败，这里默认是读取失败
             set_state(CODE_ERR_PATH_READ, MSG_ERR_PATH_READ(pathU8));
             return cv::Mat();
         }
+        madvise(data, fileLength, MADV_SEQUENTIAL);
 
-        // 解码内存数据，变成cv::Mat数据
-        cv::_InputArray array(buffer, fileLength);
-        cv::Mat image = cv::imdecode(array, flag);
-        // 释放buffer空间必须放在 cv::imdecode() 之后，
-        // 因为 cv::_InputArray() 并不会复制buffer内的元素，
-        // 而 cv::imdecode() 在解码时会新开辟一块内存并复制解码后的数据
-        delete[] buffer;
-        fileInput.close();
+        // 解码映射内存。cv::imdecode() 会新开辟一块内存存放解码结果，之后即可解除映射
+        cv::Mat image;
+        try
+        {
+            image = imdecode(data, fileLength, flag);
+        }
+        catch (...)
+        {
+            image = cv::Mat();
+        }
+        munmap(data, fileLength);
 
         // 解码失败
-        if (image.empty())
+        if (image.empty() && t_code == CODE_INIT)
         {
             set_state(CODE_ERR_PATH_DECODE, MSG_ERR_PATH_DECODE(pathU8));
             return cv::Mat();
@@ -121,6 +148,56 @@ namespace PaddleOCR
         return image;
     }
 
+    // 映射 POSIX 命名共享内存。每次请求都重新 shm_open 并比较 inode 与大小，
+    // 客户端重建同名共享内存后也能映射到新的内容；未变化时复用已有映射。
+    const char *Task::shm_map(const std::string &name, size_t &size)
+    {
+        std::string path = (!name.empty() && name[0] == '/') ? name : "/" + name; // shm_open 要求以 / 开头，Python 返回的名称不带 /
+        int fd = shm_open(path.c_str(), O_RDONLY, 0);
+        if (fd < 0)
+        {
+            return nullptr;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0)
+        {
+            close(fd);
+            return nullptr;
+        }
+        if (shm_addr && name == shm_name && shm_ino == (unsigned long)st.st_ino && shm_size == size_t(st.st_size))
+        { // 同一块共享内存，复用映射
+            close(fd);
+            size = shm_size;
+            return static_cast<const char *>(shm_addr);
+        }
+        shm_unmap();
+        void *addr = mmap(NULL, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        close(fd); // 映射建立后即可关闭文件描述符
+        if (addr == MAP_FAILED)
+        {
+            return nullptr;
+        }
+        shm_name = name;
+        shm_addr = addr;
+        shm_size = size_t(st.st_size);
+        shm_ino = (unsigned long)st.st_ino;
+        size = shm_size;
+        return static_cast<const char *>(shm_addr);
+    }
+
+    // 解除当前共享内存映射
+    void Task::shm_unmap()
+    {
+        if (shm_addr)
+        {
+            munmap(shm_addr, shm_size);
+        }
+        shm_name.clear();
+        shm_addr = nullptr;
+        shm_size = 0;
+        shm_ino = 0;
+    }
+
     int Task::socket_mode()
     {
         // 创建套接字，协议族为TCP/IP
@@ -154,8 +231,8 @@ namespace PaddleOCR
             return -1;
         }
 
-        // 将套接字socketFd设为监听状态，只允许1个客户端排队连接
-        if (listen(socketFd, 1) == INVALID_SOCKET)
+        // 将套接字socketFd设为监听状态
+        if (listen(socketFd, SOMAXCONN) == INVALID_SOCKET)
         {
             std::cerr << "Failed to set listen." << std::endl;
             close(socketFd);
@@ -176,82 +253,148 @@ namespace PaddleOCR
         char *serverIp = inet_ntoa(socketAddr.sin_addr);
         std::cout << "Socket init completed. " << serverIp << ":" << serverPort << std::endl;
 
-        // 循环等待接收连接
-        while (true)
+        // 创建epoll实例，监听服务端套接字与所有客户端连接
+        set_nonblocking(socketFd);
+        int epollFd = epoll_create1(0);
+        if (epollFd == INVALID_SOCKET)
         {
-            // 接受连接请求
-            struct sockaddr_in clientAddr;
-            socklen_t clientAddrLen = sizeof(clientAddr);
-            int clientFd = accept(socketFd, (sockaddr *)&clientAddr, &clientAddrLen);
-            if (clientFd == INVALID_SOCKET)
-            {
-                std::cerr << "Failed to accept connection." << std::endl;
-                continue;
-            }
-
-            // 获取客户端实际ip和端口
-            char *clientIp = inet_ntoa(clientAddr.sin_addr);
-            int clientPort = ntohs(clientAddr.sin_port);
-            std::cerr << "Client connected. IP address: " << clientIp << ":" << clientPort << std::endl;
-
-            // 接收任意长度数据
-            std::string strIn; // 接收数据存放处
-            char buffer[1024]; // 缓冲区
-            int bytesRecv = 0;
-            while (true)
-            {
-                bytesRecv = recv(clientFd, buffer, sizeof(buffer), 0);
-
-                // 没收到数据，可能客户端断开连接或连接错误
-                if (bytesRecv <= 0)
-                    break;
-
-                // 将本次接收到的数据追加到存放处末尾
-                strIn.append(buffer, bytesRecv);
-
-                // 到达末尾符，认为数据已全部接收完毕
-                if (buffer[bytesRecv - 1] == '\0' || buffer[bytesRecv - 1] == '\n')
-                    break;
-            }
-
-            if (bytesRecv == 0) // 客户端正常断开连接 (end of file)
-            {
-                std::cerr << "Client has gracefully shutdown the socket." << std::endl;
-            }
-            else if (bytesRecv < 0) // 连接错误
+            std::cerr << "Failed to create epoll." << std::endl;
+            close(socketFd);
+            return -1;
+        }
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = socketFd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, socketFd, &ev);
+
+        // 每个连接的收发缓冲区。连接保持打开，可连续发送多条以 \n 结尾的请求
+        std::map<int, SocketConn> conns;
+        std::vector<char> buffer(SOCKET_RECV_BUFFER); // 接收缓冲区
+        struct epoll_event events[SOCKET_MAX_EVENTS];
+
+        // 事件循环
+        while (!is_exit)
+        {
+            int n = epoll_wait(epollFd, events, SOCKET_MAX_EVENTS, -1);
+            if (n < 0)
             {
-                std::cerr << "Failed to receive data, error code: " << errno << std::endl;
-                close(clientFd);
-                continue;
+                if (errno == EINTR)
+                    continue;
+                std::cerr << "Failed to wait epoll, error code: " << errno << std::endl;
+                break;
             }
-            std::cerr << "Get string. Length: " << strIn.length() << std::endl;
-
-            // =============== OCR开始 ===============
-            set_state(); // 初始化状态
-            // 获取ocr结果
-            std::string strOut = run_ocr(strIn);
-            // 接收到退出指令，关闭连接，退出主循环，結束服务器
-            if (is_exit)
+            for (int i = 0; i < n && !is_exit; i++)
             {
-                close(clientFd);
-                break;
+                int fd = events[i].data.fd;
+                // 新连接
+                if (fd == socketFd)
+                {
+                    while (true)
+                    {
+                        struct sockaddr_in clientAddr;
+                        socklen_t clientAddrLen = sizeof(clientAddr);
+                        int clientFd = accept(socketFd, (sockaddr *)&clientAddr, &clientAddrLen);
+                        if (clientFd == INVALID_SOCKET)
+                        {
+                            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                                OCR_LOG_WARN("Failed to accept connection.");
+                            break;
+                        }
+                        set_nonblocking(clientFd);
+                        ev.events = EPOLLIN;
+                        ev.data.fd = clientFd;
+                        epoll_ctl(epollFd, EPOLL_CTL_ADD, clientFd, &ev);
+                        conns[clientFd] = SocketConn();
+                        // 获取客户端实际ip和端口
+                        char *clientIp = inet_ntoa(clientAddr.sin_addr);
+                        int clientPort = ntohs(clientAddr.sin_port);
+                        OCR_LOG_INFO("Client connected. IP address: " << clientIp << ":" << clientPort);
+                    }
+                    continue;
+                }
+
+                SocketConn &conn = conns[fd];
+                bool failed = false;
+                // 可读：接收全部可用数据，并执行其中的完整请求
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                {
+                    // 接收缓冲区超过请求上限时暂停接收，先处理已有的完整请求（水平触发，剩余数据稍后再读）
+                    size_t max_in = FRAME_HEADER_SIZE + max_request_bytes();
+                    while (!conn.eof && conn.in.size() <= max_in)
+                    {
+                        ssize_t bytesRecv = recv(fd, buffer.data(), buffer.size(), 0);
+                        if (bytesRecv > 0)
+                        {
+                            conn.in.append(buffer.data(), bytesRecv);
+                        }
+                        else if (bytesRecv == 0) // 客户端关闭写端 (end of file)
+                        {
+                            OCR_LOG_INFO("Client has gracefully shutdown the socket.");
+                            conn.eof = true;
+                        }
+                        else
+                        {
+                            if (errno == EINTR)
+                                continue;
+                            if (errno != EAGAIN && errno != EWOULDBLOCK) // 连接错误
+                            {
+                                OCR_LOG_WARN("Failed to receive data, error code: " << errno);
+                                failed = true;
+                            }
+                            break;
+                        }
+                    }
+                    if (!failed)
+                    {
+                        // =============== OCR ===============
+                        conn.out += socket_handle(conn.in, conn.eof);
+                        // 接收到退出指令，退出主循环，結束服务器
+                        if (is_exit)
+                            break;
+                    }
+                }
+                // 发送缓冲区中的回复，发不完则等待可写事件
+                while (!failed && !conn.out.empty())
+                {
+                    ssize_t bytesSent = send(fd, conn.out.data(), conn.out.size(), MSG_NOSIGNAL);
+                    if (bytesSent > 0)
+                    {
+                        conn.out.erase(0, bytesSent);
+                    }
+                    else if (bytesSent < 0 && errno == EINTR)
+                    {
+                        continue;
+                    }
+                    else
+                    {
+                        if (bytesSent == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+                        {
+                            OCR_LOG_WARN("Failed to send data.");
+                            failed = true;
+                        }
+                        break;
+                    }
+                }
+                // 关闭连接：出错，或对方已关闭且回复已发完
+                if (failed || (conn.eof && conn.out.empty()))
+                {
+                    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
+                    close(fd);
+                    conns.erase(fd);
+                    continue;
+                }
+                ev.events = (conn.eof ? 0 : EPOLLIN) | (conn.out.empty() ? 0 : EPOLLOUT);
+                ev.data.fd = fd;
+                epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev);
             }
-            // =============== OCR完毕 ===============
-
-            // 发送数据
-            std::cerr << strOut << std::endl;
-            int bytesSent = send(clientFd, strOut.c_str(), strlen(strOut.c_str()), 0);
-            // 没有发送出数据 | 发送出0字节
-            if (bytesSent <= 0)
-                std::cerr << "Failed to send data." << std::endl;
-
-            // 关闭连接
-            close(clientFd);
-            // 检查、清理内存
-            Task::memory_check_cleanup();
         }
 
-        // 关闭套接字
+        // 关闭所有连接与套接字
+        for (std::map<int, SocketConn>::iterator it = conns.begin(); it != conns.end(); ++it)
+        {
+            close(it->first);
+        }
+        close(epollFd);
         close(socketFd);
 
         return 0;
@@ -6,7 +6,9 @@
 #include "include/paddleocr.h"
 #include "include/args.h"
 #include "include/task.h"
+#include "include/logger.h"
 // 剪贴板和套接字
+#include <winsock2.h> // 须在 windows.h 之前，提供 WSAPoll
 #include <windows.h>
 #include <psapi.h> // 内存管理
 // 编码转换
@@ -14,9 +16,19 @@
 std::wstring_convert<std::codecvt_utf8<wchar_t>> conv_Ustr_Wstr; // string utf-8 与 wstring utf-16 的双向转换器
 // 套接字
 #pragma comment(lib, "ws2_32.lib")
+#include <vector>
+
+#define SOCKET_RECV_BUFFER 65536 // 套接字接收缓冲区大小
 
 namespace PaddleOCR
 {
+    // 套接字连接状态
+    struct SocketConn
+    {
+        std::string in;   // 已接收、尚未处理的数据
+        std::string out;  // 待发送的回复
+        bool eof = false; // 对方已关闭写端
+    };
 
     // ==================== 工具函数 ====================
 
@@ -91,23 +103,45 @@ namespace PaddleOCR
             set_state(CODE_ERR_PATH_EXIST, MSG_ERR_PATH_EXIST(pathU8)); // 报告状态：路径不存在且无法输出
             return cv::Mat();
         }
-        FILE *fp = _wfopen((wchar_t *)pathW.c_str(), L"rb"); // wpath强制类型转换到whar_t，尝试打开文件
-        if (!fp)
+        // 以只读方式打开文件，并映射到内存后直接解码，不经过额外的读缓冲区
+        HANDLE hFile = CreateFileW(pathW.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                                   OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (hFile == INVALID_HANDLE_VALUE)
         {                                                             // 打开失败
             set_state(CODE_ERR_PATH_READ, MSG_ERR_PATH_READ(pathU8)); // 报告状态：无法读取
             return cv::Mat();
         }
-        // 将文件读到内存
-        fseek(fp, 0, SEEK_END);                // 设置流 fp 的文件位置为 SEEK_END 文件的末尾
-        long sz = ftell(fp);                   // 获取流 fp 的当前文件位置，即总大小（字节）
-        char *buf = new char[sz];              // 存放文件字节内容
-        fseek(fp, 0, SEEK_SET);                // 设置流 fp 的文件位置为 SEEK_SET 文件的开头
-        long n = fread(buf, 1, sz, fp);        // 从给定流 fp 读取数据到 buf 所指向的数组中，返回成功读取的元素总数
-        cv::_InputArray arr(buf, sz);          // 转换为OpenCV数组
-        cv::Mat img = cv::imdecode(arr, flag); // 解码内存数据，变成cv::Mat数据
-        delete[] buf;                          // 释放buf空间
-        fclose(fp);                            // 关闭文件
-        if (img.empty())
+        LARGE_INTEGER sz;
+        if (!GetFileSizeEx(hFile, &sz) || sz.QuadPart <= 0)
+        { // 获取大小失败，或空文件（无法映射，也不可能解码）
+            CloseHandle(hFile);
+            set_state(CODE_ERR_PATH_DECODE, MSG_ERR_PATH_DECODE(pathU8)); // 报告状态：解码失败
+            return cv::Mat();
+        }
+        HANDLE hMap = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+        void *data = hMap ? MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0) : NULL;
+        if (!data)
+        {
+            if (hMap)
+                CloseHandle(hMap);
+            CloseHandle(hFile);
+            set_state(CODE_ERR_PATH_READ, MSG_ERR_PATH_READ(pathU8)); // 报告状态：无法读取
+            return cv::Mat();
+        }
+        // 解码映射内存。cv::imdecode() 会新开辟一块内存存放解码结果，之后即可解除映射
+        cv::Mat img;
+        try
+        {
+            img = imdecode(data, static_cast<size_t>(sz.QuadPart), flag);
+        }
+        catch (...)
+        {
+            img = cv::Mat();
+        }
+        UnmapViewOfFile(data);
+        CloseHandle(hMap);
+        CloseHandle(hFile);
+        if (img.empty() && t_code == CODE_INIT)
         {
             set_state(CODE_ERR_PATH_DECODE, MSG_ERR_PATH_DECODE(pathU8)); // 报告状态：解码失败
         }
@@ -256,6 +290,64 @@ namespace PaddleOCR
     }
 #endif
 
+    // 映射命名共享内存（CreateFileMapping 创建的映射对象）。
+    // 本进程持有映射对象句柄期间，客户端以同名创建只会打开同一对象，因此同名请求直接复用映射。
+    const char *Task::shm_map(const std::string &name, size_t &size)
+    {
+        if (shm_addr && name == shm_name)
+        {
+            size = shm_size;
+            return static_cast<const char *>(shm_addr);
+        }
+        shm_unmap();
+        std::wstring nameW;
+        try
+        {
+            nameW = conv_Ustr_Wstr.from_bytes(name);
+        }
+        catch (...)
+        {
+            return nullptr;
+        }
+        HANDLE hMap = OpenFileMappingW(FILE_MAP_READ, FALSE, nameW.c_str());
+        if (hMap == NULL)
+        {
+            return nullptr;
+        }
+        void *addr = MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+        MEMORY_BASIC_INFORMATION info;
+        if (addr == NULL || VirtualQuery(addr, &info, sizeof(info)) == 0)
+        {
+            if (addr)
+                UnmapViewOfFile(addr);
+            CloseHandle(hMap);
+            return nullptr;
+        }
+        shm_name = name;
+        shm_addr = addr;
+        shm_size = info.RegionSize; // 映射视图的大小，按页对齐
+        shm_handle = hMap;
+        size = shm_size;
+        return static_cast<const char *>(shm_addr);
+    }
+
+    // 解除当前共享内存映射
+    void Task::shm_unmap()
+    {
+        if (shm_addr)
+        {
+            UnmapViewOfFile(shm_addr);
+        }
+        if (shm_handle)
+        {
+            CloseHandle(static_cast<HANDLE>(shm_handle));
+        }
+        shm_name.clear();
+        shm_addr = nullptr;
+        shm_size = 0;
+        shm_handle = nullptr;
+    }
+
     // 套接字模式
     int Task::socket_mode()
     {
@@ -295,8 +387,8 @@ namespace PaddleOCR
             WSACleanup();
             return -1;
         }
-        // 将套接字server_fd设为监听状态，只允许1个客户端排队连接
-        if (listen(server_fd, 1) == SOCKET_ERROR)
+        // 将套接字server_fd设为监听状态
+        if (listen(server_fd, SOMAXCONN) == SOCKET_ERROR)
         {
             std::cerr << "Failed to set listen." << std::endl;
             closesocket(server_fd);
@@ -318,77 +410,133 @@ namespace PaddleOCR
         // int server_port = ntohs(addr.sin_port);
         std::cout << "Socket init completed. " << server_ip << ":" << server_port << std::endl;
 
-        // 循环等待接收连接
-        while (true)
+        // 服务端套接字与所有客户端连接都设为非阻塞，由 WSAPoll 统一等待事件
+        u_long non_blocking = 1;
+        ioctlsocket(server_fd, FIONBIO, &non_blocking);
+        std::vector<WSAPOLLFD> fds(1); // fds[0] 为服务端套接字，其后与 conns 一一对应
+        fds[0].fd = server_fd;
+        fds[0].events = POLLRDNORM;
+        std::vector<SocketConn> conns(1); // 每个连接的收发缓冲区，conns[0] 占位
+        std::vector<char> buffer(SOCKET_RECV_BUFFER); // 接收缓冲区
+
+        // 事件循环
+        while (!is_exit)
         {
-            // 接受连接请求
-            struct sockaddr_in client_addr;
-            int client_addr_len = sizeof(client_addr);
-            SOCKET client_fd = accept(server_fd, (sockaddr *)&client_addr, &client_addr_len);
-            if (client_fd == INVALID_SOCKET)
+            for (size_t i = 1; i < fds.size(); i++)
+            { // 有待发送数据时才关注可写事件
+                fds[i].events = (conns[i].eof ? 0 : POLLRDNORM) | (conns[i].out.empty() ? 0 : POLLWRNORM);
+                fds[i].revents = 0;
+            }
+            fds[0].revents = 0;
+            if (WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), -1) == SOCKET_ERROR)
             {
-                std::cerr << "Failed to accept connection." << std::endl;
-                continue;
+                std::cerr << "Failed to poll sockets, error code: " << WSAGetLastError() << std::endl;
+                break;
             }
-            // 获取客户端实际ip和端口
-            char *client_ip = inet_ntoa(client_addr.sin_addr);
-            int client_port = ntohs(client_addr.sin_port);
-            std::cerr << "Client connected. IP address: " << client_ip << ":" << client_port << std::endl;
-
-            // 接收任意长度数据
-            std::string str_in; // 接收数据存放处
-            char buffer[1024];  // 缓冲区
-            int n = 0;
-            while (true)
+            // 处理已有连接
+            for (size_t i = 1; i < fds.size() && !is_exit; i++)
             {
-                n = recv(client_fd, buffer, sizeof(buffer), 0);
-                if (n <= 0)
-                { // 可能客户端断开连接或连接错误
-                    break;
+                if (fds[i].revents == 0)
+                    continue;
+                SOCKET client_fd = fds[i].fd;
+                SocketConn &conn = conns[i];
+                bool failed = false;
+                // 可读：接收全部可用数据，并执行其中的完整请求
+                if (fds[i].revents & (POLLRDNORM | POLLHUP | POLLERR))
+                {
+                    // 接收缓冲区超过请求上限时暂停接收，先处理已有的完整请求（水平触发，剩余数据稍后再读）
+                    size_t max_in = FRAME_HEADER_SIZE + max_request_bytes();
+                    while (!conn.eof && conn.in.size() <= max_in)
+                    {
+                        int n = recv(client_fd, buffer.data(), static_cast<int>(buffer.size()), 0);
+                        if (n > 0)
+                        {
+                            conn.in.append(buffer.data(), n);
+                        }
+                        else if (n == 0) // 客户端关闭写端 (end of file)
+                        {
+                            OCR_LOG_INFO("Client has gracefully shutdown the socket.");
+                            conn.eof = true;
+                        }
+                        else
+                        {
+                            int err = WSAGetLastError();
+                            if (err != WSAEWOULDBLOCK) // 连接错误
+                            {
+                                OCR_LOG_WARN("Failed to receive data, error code: " << err);
+                                failed = true;
+                            }
+                            break;
+                        }
+                    }
+                    if (!failed)
+                    {
+                        // =============== OCR ===============
+                        conn.out += socket_handle(conn.in, conn.eof);
+                        if (is_exit) // 退出
+                            break;
+                    }
                 }
-                str_in.append(buffer, n); // 将本次接收到的数据追加到存放处末尾
-                if (buffer[n - 1] == '\0' || buffer[n - 1] == '\n')
-                { // 到达末尾符，认为数据已全部接收完毕
-                    break;
+                // 发送缓冲区中的回复，发不完则等待可写事件
+                while (!failed && !conn.out.empty())
+                {
+                    int m = send(client_fd, conn.out.data(), static_cast<int>(conn.out.size()), 0);
+                    if (m > 0)
+                    {
+                        conn.out.erase(0, m);
+                    }
+                    else
+                    {
+                        if (m == 0 || WSAGetLastError() != WSAEWOULDBLOCK)
+                        {
+                            OCR_LOG_WARN("Failed to send data.");
+                            failed = true;
+                        }
+                        break;
+                    }
+                }
+                // 关闭连接：出错，或对方已关闭且回复已发完
+                if (failed || (conn.eof && conn.out.empty()))
+                {
+                    closesocket(client_fd);
+                    fds.erase(fds.begin() + i);
+                    conns.erase(conns.begin() + i);
+                    i--;
                 }
             }
-
-            if (n == 0) // 客户端正常断开连接 (end of file)
-            {
-                std::cerr << "Client has gracefully shutdown the socket." << std::endl;
-            }
-            else if (n < 0) // 连接错误
-            {
-                std::cerr << "Failed to receive data, error code: " << n << std::endl;
-                closesocket(client_fd);
-                continue;
-            }
-            std::cerr << "Get string. Length: " << str_in.length() << std::endl;
-
-            // =============== OCR开始 ===============
-            set_state(); // 初始化状态
-            // 获取ocr结果
-            std::string str_out = run_ocr(str_in);
-            if (is_exit)
-            { // 退出
-                // 关闭连接
-                closesocket(client_fd);
-                break;
-            }
-            // =============== OCR完毕 ===============
-
-            // 发送数据
-            std::cerr << str_out << std::endl;
-            int m = send(client_fd, str_out.c_str(), strlen(str_out.c_str()), 0);
-            if (m <= 0)
+            // 新连接
+            if (!is_exit && (fds[0].revents & POLLRDNORM))
             {
-                std::cerr << "Failed to send data." << std::endl;
+                while (true)
+                {
+                    struct sockaddr_in client_addr;
+                    int client_addr_len = sizeof(client_addr);
+                    SOCKET client_fd = accept(server_fd, (sockaddr *)&client_addr, &client_addr_len);
+                    if (client_fd == INVALID_SOCKET)
+                    {
+                        if (WSAGetLastError() != WSAEWOULDBLOCK)
+                            OCR_LOG_WARN("Failed to accept connection.");
+                        break;
+                    }
+                    ioctlsocket(client_fd, FIONBIO, &non_blocking);
+                    WSAPOLLFD pfd;
+                    pfd.fd = client_fd;
+                    pfd.events = POLLRDNORM;
+                    pfd.revents = 0;
+                    fds.push_back(pfd);
+                    conns.push_back(SocketConn());
+                    // 获取客户端实际ip和端口
+                    char *client_ip = inet_ntoa(client_addr.sin_addr);
+                    int client_port = ntohs(client_addr.sin_port);
+                    OCR_LOG_INFO("Client connected. IP address: " << client_ip << ":" << client_port);
+                }
             }
+        }
 
-            // 关闭连接
-            closesocket(client_fd);
-            // 检查、清理内存
-            Task::memory_check_cleanup();
+        // 关闭所有连接
+        for (size_t i = 1; i < fds.size(); i++)
+        {
+            closesocket(fds[i].fd);
         }
 
         // 关闭套接字
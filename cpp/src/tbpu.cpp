@@ -0,0 +1,687 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#include "include/tbpu.h"
+#include "include/reading_order.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+
+namespace PaddleOCR
+{
+    typedef ReadingOrder::BBox BBox;
+
+    // ==================== 上下句间隔符 ====================
+
+    // utf-8 字符串的首字符码点，空串返回0
+    static uint32_t first_char(const std::string &s)
+    {
+        if (s.empty())
+        {
+            return 0;
+        }
+        unsigned char c = s[0];
+        int len = c < 0x80 ? 1 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+        uint32_t cp = len == 1 ? c : c & (0x3F >> (len - 1));
+        for (int i = 1; i < len && i < int(s.size()); i++)
+        {
+            cp = (cp << 6) | (s[i] & 0x3F);
+        }
+        return cp;
+    }
+
+    // utf-8 字符串的尾字符码点，空串返回0
+    static uint32_t last_char(const std::string &s)
+    {
+        size_t i = s.size();
+        while (i > 0 && (s[i - 1] & 0xC0) == 0x80)
+        {
+            i--;
+        }
+        return i > 0 ? first_char(s.substr(i - 1)) : 0;
+    }
+
+    // 中文、日文、韩文字符及全角符号
+    static bool is_cjk(uint32_t c)
+    {
+        return (c >= 0x4E00 && c <= 0x9FFF) ||                     // 中文
+               (c >= 0x3040 && c <= 0x30FF) ||                     // 日文
+               (c >= 0x1100 && c <= 0x11FF) ||                     // 韩文
+               (c >= 0x3130 && c <= 0x318F) ||                     // 韩文兼容字母
+               (c >= 0xAC00 && c <= 0xD7AF) ||                     // 韩文音节
+               (c >= 0x3000 && c <= 0x303F) ||                     // 中文符号和标点
+               (c >= 0xFE30 && c <= 0xFE4F) ||                     // 中文兼容形式标点
+               (c >= 0xFF00 && c <= 0xFFEF);                       // 半角和全角形式字符
+    }
+
+    // 标点符号（Unicode P 类）。覆盖ASCII、拉丁补充、通用标点与常见的全角标点
+    static bool is_punct(uint32_t c)
+    {
+        if (c < 0x80)
+        {
+            return c == '!' || c == '"' || c == '#' || c == '%' || c == '&' || c == '\'' ||
+                   c == '(' || c == ')' || c == '*' || c == ',' || c == '-' || c == '.' ||
+                   c == '/' || c == ':' || c == ';' || c == '?' || c == '@' || c == '[' ||
+                   c == '\\' || c == ']' || c == '_' || c == '{' || c == '}';
+        }
+        return c == 0xA1 || c == 0xA7 || c == 0xAB || c == 0xB6 || c == 0xB7 || c == 0xBB || c == 0xBF ||
+               (c >= 0x2010 && c <= 0x2027) || (c >= 0x2030 && c <= 0x2043) ||
+               (c >= 0x2045 && c <= 0x2051) || (c >= 0x2053 && c <= 0x205E) ||
+               (c >= 0x3001 && c <= 0x3003) || (c >= 0x3008 && c <= 0x3011) ||
+               (c >= 0x3014 && c <= 0x301F) || c == 0x30FB ||
+               (c >= 0xFE10 && c <= 0xFE19) || (c >= 0xFE30 && c <= 0xFE4F) ||
+               (c >= 0xFE50 && c <= 0xFE6B) ||
+               (c >= 0xFF01 && c <= 0xFF03) || (c >= 0xFF05 && c <= 0xFF0A) ||
+               (c >= 0xFF0C && c <= 0xFF0F) || c == 0xFF1A || c == 0xFF1B || c == 0xFF1F ||
+               c == 0xFF20 || (c >= 0xFF3B && c <= 0xFF3D) || c == 0xFF3F || c == 0xFF5B ||
+               c == 0xFF5D || (c >= 0xFF5F && c <= 0xFF65);
+    }
+
+    // 传入前句尾字符和后句首字符，返回分隔符
+    static const char *word_separator(uint32_t letter1, uint32_t letter2)
+    {
+        if (is_cjk(letter1) && is_cjk(letter2))
+        {
+            return "";
+        }
+        if (letter1 == '-') // 前文为连字符
+        {
+            return "";
+        }
+        if (is_punct(letter2)) // 后文为标点符号
+        {
+            return "";
+        }
+        return " "; // 其它正常情况加空格
+    }
+
+    static const char *word_separator(const std::string &text1, const std::string &text2)
+    {
+        return word_separator(last_char(text1), first_char(text2));
+    }
+
+    // ==================== 段内分析 ====================
+
+    // 对同一区块内的文本块（按 items 的下标）进行自然段分析，写入结尾间隔符：段内为上下句间隔符，段尾为换行
+    static void paragraph_parse(std::vector<OCRPredictResult> &results, const std::vector<BBox> &bboxes,
+                                std::vector<int> items)
+    {
+        if (items.empty())
+        {
+            return;
+        }
+        std::stable_sort(items.begin(), items.end(), [&](int a, int b)
+                         { return bboxes[a][1] < bboxes[b][1]; });
+        std::vector<BBox> rows(items.size());
+        for (size_t k = 0; k < items.size(); k++)
+        {
+            rows[k] = bboxes[items[k]];
+        }
+        std::vector<int> para = ReadingOrder::paragraphs(rows);
+        for (size_t k = 0; k < items.size(); k++)
+        {
+            OCRPredictResult &r = results[items[k]];
+            if (k + 1 < items.size() && para[k + 1] == para[k])
+            {
+                r.end = word_separator(r.text, results[items[k + 1]].text);
+            }
+            else
+            {
+                r.end = "\n";
+            }
+        }
+    }
+
+    // ==================== 间隙树 ====================
+    // 对多栏文本按人类阅读顺序排序（GapTree_Sort_Algorithm）。
+    // 自上而下逐行扫描，同一位置在连续多行中的间隙组成竖切线，竖切线把页面划分为区块，
+    // 区块按位置关系组成布局树，前序遍历即为阅读顺序
+
+    namespace
+    {
+        struct Gap
+        {
+            float l, r; // 左右边缘
+            int start;  // 起始行号
+        };
+
+        struct Cut
+        {
+            float l, r;     // 左右边缘
+            int start, end; // 起止行号
+        };
+
+        struct Node
+        {
+            float x_left, x_right;
+            int r_top, r_bottom;        // 顶部与底部的行号
+            std::vector<int> units;     // 区块内的文本块
+            std::vector<int> children;  // 子节点，有序
+        };
+    }
+
+    // 使用本行的间隙 gaps2 更新考察中的间隙 gaps1，gaps1 中被彻底移除的项存入 removed
+    static std::vector<Gap> update_gaps(const std::vector<Gap> &gaps1, const std::vector<Gap> &gaps2,
+                                        std::vector<Gap> &removed)
+    {
+        std::vector<bool> keep1(gaps1.size(), false), add2(gaps2.size(), true);
+        std::vector<Gap> updated;
+        for (size_t i1 = 0; i1 < gaps1.size(); i1++)
+        {
+            for (size_t i2 = 0; i2 < gaps2.size(); i2++)
+            {
+                float inter_l = std::max(gaps1[i1].l, gaps2[i2].l);
+                float inter_r = std::min(gaps1[i1].r, gaps2[i2].r);
+                if (inter_l <= inter_r)
+                { // 交集有效，更新 gap1 的左右边缘
+                    updated.push_back({inter_l, inter_r, gaps1[i1].start});
+                    keep1[i1] = true;
+                    add2[i2] = false;
+                }
+            }
+        }
+        for (size_t i2 = 0; i2 < gaps2.size(); i2++)
+        {
+            if (add2[i2])
+            {
+                updated.push_back(gaps2[i2]);
+            }
+        }
+        for (size_t i1 = 0; i1 < gaps1.size(); i1++)
+        {
+            if (!keep1[i1])
+            {
+                removed.push_back(gaps1[i1]);
+            }
+        }
+        return updated;
+    }
+
+    // 对 items（按顶部从上到下排列）排序，返回区块序列，每个区块为从上到下的 items 元素
+    static std::vector<std::vector<int>> gap_tree(const std::vector<BBox> &bboxes, const std::vector<int> &items)
+    {
+        std::vector<std::vector<int>> blocks;
+        if (items.empty())
+        {
+            return blocks;
+        }
+        float page_l = bboxes[items[0]][0], page_r = bboxes[items[0]][2];
+        for (size_t i = 0; i < items.size(); i++)
+        {
+            page_l = std::min(page_l, bboxes[items[i]][0]);
+            page_r = std::max(page_r, bboxes[items[i]][2]);
+        }
+        page_l -= 1; // 保证页面左右边缘不与文本块重叠
+        page_r += 1;
+
+        // ========== 求行和竖切线 ==========
+        std::vector<std::vector<int>> rows; // 每行的文本块，从左到右
+        std::vector<Cut> cuts;              // 生成完毕的竖切线
+        std::vector<Gap> gaps;              // 考察中的间隙
+        int n = int(items.size());
+        for (int ui = 0; ui < n; ui++)
+        {
+            int row_index = int(rows.size());
+            float u_bottom = bboxes[items[ui]][3]; // 当前行最顶部的块的底部
+            std::vector<int> row(1, items[ui]);
+            for (int i = ui + 1; i < n && bboxes[items[i]][1] <= u_bottom; i++)
+            {
+                row.push_back(items[i]);
+                ui = i;
+            }
+            std::stable_sort(row.begin(), row.end(), [&](int a, int b)
+                             { return bboxes[a][0] < bboxes[b][0] ||
+                                      (bboxes[a][0] == bboxes[b][0] && bboxes[a][2] < bboxes[b][2]); });
+            // 当前行的间隙
+            std::vector<Gap> row_gaps;
+            float search_start = page_l;
+            for (size_t k = 0; k < row.size(); k++)
+            {
+                float l = bboxes[row[k]][0], r = bboxes[row[k]][2];
+                if (l > search_start)
+                {
+                    row_gaps.push_back({search_start, l, row_index});
+                }
+                if (r > search_start)
+                {
+                    search_start = r;
+                }
+            }
+            row_gaps.push_back({search_start, page_r, row_index});
+            // 更新考察中的间隙，被移除的间隙成为竖切线
+            std::vector<Gap> removed;
+            gaps = update_gaps(gaps, row_gaps, removed);
+            for (size_t k = 0; k < removed.size(); k++)
+            {
+                cuts.push_back({removed[k].l, removed[k].r, removed[k].start, row_index - 1});
+            }
+            rows.push_back(row);
+        }
+        for (size_t k = 0; k < gaps.size(); k++)
+        { // 剩余的间隙延伸到最后一行
+            cuts.push_back({gaps[k].l, gaps[k].r, gaps[k].start, int(rows.size()) - 1});
+        }
+        std::stable_sort(cuts.begin(), cuts.end(), [](const Cut &a, const Cut &b)
+                         { return a.l < b.l; });
+
+        // ========== 求布局树 ==========
+        // 每行被竖切线切开的间隙，从左到右
+        std::vector<std::vector<std::pair<float, float>>> rows_gaps(rows.size());
+        for (size_t c = 0; c < cuts.size(); c++)
+        {
+            for (int r = cuts[c].start; r <= cuts[c].end; r++)
+            {
+                rows_gaps[r].push_back(std::make_pair(cuts[c].l, cuts[c].r));
+            }
+        }
+        std::vector<Node> nodes(1); // nodes[0] 为根节点
+        nodes[0].x_left = cuts.front().l - 1;
+        nodes[0].x_right = cuts.back().r + 1;
+        nodes[0].r_top = nodes[0].r_bottom = -1;
+        std::vector<int> completed(1, 0); // 已经结束的节点
+        std::vector<int> now;             // 正在考虑的节点
+
+        // 结束一个节点：在已结束的节点中，寻找垂直投影包含其右界、底部在其之上的最低节点，取最右者为父节点
+        auto complete = [&](int k)
+        {
+            float node_r = nodes[k].x_right - 2;
+            int parent = -1;
+            for (size_t c = 0; c < completed.size(); c++)
+            {
+                const Node &p = nodes[completed[c]];
+                if (node_r < p.x_left || node_r > p.x_right + 0.0001f || p.r_bottom >= nodes[k].r_top)
+                {
+                    continue;
+                }
+                if (parent < 0 || p.r_bottom > nodes[parent].r_bottom ||
+                    (p.r_bottom == nodes[parent].r_bottom && p.x_right > nodes[parent].x_right))
+                {
+                    parent = completed[c];
+                }
+            }
+            nodes[parent < 0 ? 0 : parent].children.push_back(k);
+            completed.push_back(k);
+        };
+
+        for (int r_i = 0; r_i < int(rows.size()); r_i++)
+        {
+            const std::vector<std::pair<float, float>> &row_gaps = rows_gaps[r_i];
+            // 检查正在考虑的节点能否延续到本行：左右边缘都被间隙延续，且下方没有间隙打断
+            std::vector<int> next_now;
+            for (size_t k = 0; k < now.size(); k++)
+            {
+                Node &node = nodes[now[k]];
+                bool l_flag = false, r_flag = false, completed_flag = false;
+                for (size_t g = 0; g < row_gaps.size(); g++)
+                {
+                    if (row_gaps[g].second == node.x_left)
+                    {
+                        l_flag = true;
+                    }
+                    if (row_gaps[g].first == node.x_right)
+                    {
+                        r_flag = true;
+                    }
+                    if ((node.x_left < row_gaps[g].first && row_gaps[g].first < node.x_right) ||
+                        (node.x_left < row_gaps[g].second && row_gaps[g].second < node.x_right))
+                    {
+                        completed_flag = true;
+                        break;
+                    }
+                }
+                if (completed_flag || !l_flag || !r_flag)
+                {
+                    complete(now[k]);
+                }
+                else
+                {
+                    node.r_bottom = r_i;
+                    next_now.push_back(now[k]);
+                }
+            }
+            now.swap(next_now);
+
+            // 从左到右，将文本块加入对应列的节点
+            const std::vector<int> &row = rows[r_i];
+            size_t u_i = 0, g_i = 0;
+            while (u_i < row.size() && g_i + 1 < row_gaps.size())
+            {
+                float x_l = row_gaps[g_i].second, x_r = row_gaps[g_i + 1].first; // 块所在区间
+                if (bboxes[row[u_i]][0] + 0.0001f > x_r)
+                { // 块比右间隙更右，进入下一个区间
+                    g_i++;
+                    continue;
+                }
+                int found = -1;
+                for (size_t k = 0; k < now.size(); k++)
+                {
+                    if (nodes[now[k]].x_left == x_l && nodes[now[k]].x_right == x_r)
+                    {
+                        found = now[k];
+                        break;
+                    }
+                }
+                if (found < 0)
+                { // 创建新的节点
+                    Node node;
+                    node.x_left = x_l;
+                    node.x_right = x_r;
+                    node.r_top = node.r_bottom = r_i;
+                    found = int(nodes.size());
+                    nodes.push_back(node);
+                    now.push_back(found);
+                }
+                nodes[found].units.push_back(row[u_i]);
+                u_i++;
+            }
+        }
+        for (size_t k = 0; k < now.size(); k++)
+        {
+            complete(now[k]);
+        }
+        for (size_t k = 0; k < nodes.size(); k++)
+        {
+            std::stable_sort(nodes[k].children.begin(), nodes[k].children.end(), [&](int a, int b)
+                             { return nodes[a].x_left < nodes[b].x_left; });
+            std::stable_sort(nodes[k].units.begin(), nodes[k].units.end(), [&](int a, int b)
+                             { return bboxes[a][1] < bboxes[b][1]; });
+        }
+
+        // ========== 前序遍历布局树 ==========
+        std::vector<int> stack(1, 0);
+        while (!stack.empty())
+        {
+            int k = stack.back();
+            stack.pop_back();
+            if (!nodes[k].units.empty())
+            {
+                blocks.push_back(nodes[k].units);
+            }
+            stack.insert(stack.end(), nodes[k].children.rbegin(), nodes[k].children.rend());
+        }
+        // 兜底：未能归入任何区块的文本块（浮点边界的极端情况）单独成为最后一个区块，保证不丢失结果
+        std::vector<bool> placed(bboxes.size(), false);
+        for (size_t k = 0; k < blocks.size(); k++)
+        {
+            for (size_t i = 0; i < blocks[k].size(); i++)
+            {
+                placed[blocks[k][i]] = true;
+            }
+        }
+        std::vector<int> rest;
+        for (size_t i = 0; i < items.size(); i++)
+        {
+            if (!placed[items[i]])
+            {
+                rest.push_back(items[i]);
+            }
+        }
+        if (!rest.empty())
+        {
+            blocks.push_back(rest);
+        }
+        return blocks;
+    }
+
+    // ==================== 单栏分行 ====================
+
+    // 从文本块中找出所有行：从最左的块出发，向右寻找高度相近、垂直位置重叠的块。
+    // 写入行内的间隔符与行尾换行，返回从上到下的各行，每行为从左到右的文本块
+    static std::vector<std::vector<int>> get_lines(std::vector<OCRPredictResult> &results, const std::vector<BBox> &bboxes,
+                                                   std::vector<int> items)
+    {
+        std::stable_sort(items.begin(), items.end(), [&](int a, int b)
+                         { return bboxes[a][0] < bboxes[b][0]; });
+        std::vector<bool> used(items.size(), false);
+        std::vector<std::vector<int>> lines;
+        for (size_t i1 = 0; i1 < items.size(); i1++)
+        {
+            if (used[i1])
+            {
+                continue;
+            }
+            used[i1] = true;
+            const BBox &b1 = bboxes[items[i1]];
+            float top1 = b1[1], bottom1 = b1[3], r1 = b1[2];
+            float h1 = bottom1 - top1;
+            std::vector<int> line(1, items[i1]);
+            for (size_t i2 = i1 + 1; i2 < items.size(); i2++)
+            {
+                if (used[i2])
+                {
+                    continue;
+                }
+                const BBox &b2 = bboxes[items[i2]];
+                float h2 = b2[3] - b2[1];
+                if (b2[0] < r1 - h1) // 左侧太前
+                {
+                    continue;
+                }
+                if (b2[1] < top1 - h1 * 0.5f || b2[3] > bottom1 + h1 * 0.5f) // 垂直距离太远
+                {
+                    continue;
+                }
+                if (std::fabs(h1 - h2) > std::min(h1, h2) * 0.5f) // 行高差距过大
+                {
+                    continue;
+                }
+                line.push_back(items[i2]);
+                used[i2] = true;
+                r1 = b2[2];
+            }
+            // 同一行内相邻文本块的间隔符，水平间隙太大时为空格
+            for (size_t k = 0; k + 1 < line.size(); k++)
+            {
+                const BBox &a = bboxes[line[k]], &b = bboxes[line[k + 1]];
+                float h = ((a[3] - a[1]) + (b[3] - b[1])) * 0.5f;
+                if (b[0] - a[2] > h * 1.5f)
+                {
+                    results[line[k]].end = " ";
+                }
+                else
+                {
+                    results[line[k]].end = word_separator(results[line[k]].text, results[line[k + 1]].text);
+                }
+            }
+            results[line.back()].end = "\n";
+            lines.push_back(line);
+        }
+        std::stable_sort(lines.begin(), lines.end(), [&](const std::vector<int> &a, const std::vector<int> &b)
+                         { return bboxes[a[0]][1] < bboxes[b[0]][1]; });
+        return lines;
+    }
+
+    // 单栏-代码段：合并一行中的文本块，按间距补充空格
+    static OCRPredictResult merge_line(const std::vector<OCRPredictResult> &results, const std::vector<int> &line)
+    {
+        OCRPredictResult a = results[line[0]];
+        Quad &ba = a.box;
+        float ha = float(ba[3][1] - ba[0][1]); // 行高
+        float score = a.score;
+        for (size_t i = 1; i < line.size(); i++)
+        {
+            const OCRPredictResult &b = results[line[i]];
+            const Quad &bb = b.box;
+            ha = (ha + bb[3][1] - bb[0][1]) / 2;
+            int space = 0;
+            if (bb[0][0] > ba[1][0] && ha > 0)
+            {
+                space = int(std::round((bb[0][0] - ba[1][0]) / ha));
+            }
+            for (int s = 0; s < space; s++)
+            {
+                a.text += "  ";
+            }
+            a.text += b.text;
+            // 合并包围盒
+            int y_top = std::min(std::min(ba[0][1], ba[1][1]), std::min(bb[0][1], bb[1][1]));
+            int y_bottom = std::max(std::max(ba[2][1], ba[3][1]), std::max(bb[2][1], bb[3][1]));
+            int x_left = std::min(std::min(ba[0][0], ba[3][0]), std::min(bb[0][0], bb[3][0]));
+            int x_right = std::max(std::max(ba[1][0], ba[2][0]), std::max(bb[1][0], bb[2][0]));
+            ba = Quad(x_left, y_top, x_right, y_top, x_right, y_bottom, x_left, y_bottom);
+            score += b.score;
+        }
+        a.score = score / line.size();
+        a.end = "\n";
+        return a;
+    }
+
+    // 单栏-代码段：按句首的x分出缩进层级，为每行补充空格，包围盒左侧对齐
+    static void indent(std::vector<OCRPredictResult> &lines)
+    {
+        if (lines.empty())
+        {
+            return;
+        }
+        float lh = 0; // 平均行高
+        int x_min = lines[0].box[0][0], x_max = x_min;
+        for (size_t i = 0; i < lines.size(); i++)
+        {
+            lh += lines[i].box[3][1] - lines[i].box[0][1];
+            x_min = std::min(x_min, lines[i].box[0][0]);
+            x_max = std::max(x_max, lines[i].box[0][0]);
+        }
+        lh = std::max(1.0f, lh / lines.size());
+        for (size_t i = 0; i < lines.size(); i++)
+        {
+            Quad &b = lines[i].box;
+            // 层级点为 x_min + k*lh (< x_max)，取小于 x+lh/2 的层级点个数减一
+            float x = b[0][0] + lh / 2;
+            int points = int(std::ceil((std::min(x, float(x_max)) - x_min) / lh));
+            int level = std::max(0, points - 1);
+            lines[i].text = std::string(2 * level, ' ') + lines[i].text;
+            b[0][0] = b[3][0] = x_min;
+        }
+    }
+
+    // ==================== 调用接口 ====================
+
+    bool Tbpu::valid(const std::string &parser)
+    {
+        static const char *names[] = {"none", "multi_para", "multi_line", "multi_none",
+                                      "single_para", "single_line", "single_none", "single_code"};
+        for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+        {
+            if (parser == names[i])
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Tbpu::run(const std::string &parser, std::vector<OCRPredictResult> &results)
+    {
+        if (parser.empty() || results.empty())
+        {
+            return;
+        }
+        if (parser == "none")
+        { // 不做处理，结尾间隔符为换行
+            for (size_t i = 0; i < results.size(); i++)
+            {
+                results[i].end = "\n";
+            }
+            return;
+        }
+        // 预处理：转正后的外接矩形，按顶部从上到下
+        std::vector<BBox> bboxes = ReadingOrder::normalized_bboxes(results);
+        std::vector<int> items(results.size());
+        std::iota(items.begin(), items.end(), 0);
+        std::stable_sort(items.begin(), items.end(), [&](int a, int b)
+                         { return bboxes[a][1] < bboxes[b][1]; });
+
+        std::vector<int> order; // 处理后的顺序
+        if (parser.compare(0, 6, "multi_") == 0)
+        {
+            std::vector<std::vector<int>> blocks = gap_tree(bboxes, items);
+            for (size_t k = 0; k < blocks.size(); k++)
+            {
+                if (parser == "multi_para")
+                {
+                    paragraph_parse(results, bboxes, blocks[k]);
+                }
+                for (size_t i = 0; i < blocks[k].size(); i++)
+                {
+                    results[blocks[k][i]].block = int(k);
+                    order.push_back(blocks[k][i]);
+                }
+            }
+            for (size_t i = 0; i < order.size(); i++)
+            {
+                OCRPredictResult &r = results[order[i]];
+                if (parser == "multi_line" || i + 1 == order.size())
+                {
+                    r.end = "\n";
+                }
+                else if (parser == "multi_none")
+                {
+                    r.end = word_separator(r.text, results[order[i + 1]].text);
+                }
+            }
+        }
+        else
+        {
+            std::vector<std::vector<int>> lines = get_lines(results, bboxes, items);
+            if (parser == "single_code")
+            { // 每行合并为一个文本块
+                std::vector<OCRPredictResult> merged;
+                for (size_t k = 0; k < lines.size(); k++)
+                {
+                    merged.push_back(merge_line(results, lines[k]));
+                }
+                indent(merged);
+                results.swap(merged);
+                return;
+            }
+            if (parser == "single_para")
+            { // 以行为单位进行自然段分析，写入每行最后一个块的间隔符
+                std::vector<BBox> line_boxes(lines.size());
+                std::vector<OCRPredictResult> heads(lines.size()); // 每行首尾文字，用于判断间隔符
+                for (size_t k = 0; k < lines.size(); k++)
+                {
+                    BBox b = bboxes[lines[k][0]];
+                    for (size_t i = 1; i < lines[k].size(); i++)
+                    {
+                        const BBox &bb = bboxes[lines[k][i]];
+                        b[1] = std::min(b[1], bb[1]);
+                        b[2] = std::max(b[2], bb[2]);
+                        b[3] = std::max(b[3], bb[3]);
+                    }
+                    line_boxes[k] = b;
+                    heads[k].text = results[lines[k].front()].text.substr(0, 4) + results[lines[k].back()].text;
+                }
+                std::vector<int> all(lines.size());
+                std::iota(all.begin(), all.end(), 0);
+                paragraph_parse(heads, line_boxes, all);
+                for (size_t k = 0; k < lines.size(); k++)
+                {
+                    results[lines[k].back()].end = heads[k].end;
+                }
+            }
+            for (size_t k = 0; k < lines.size(); k++)
+            {
+                order.insert(order.end(), lines[k].begin(), lines[k].end());
+            }
+            if (parser == "single_none")
+            { // 换行改为上下句间隔符
+                for (size_t i = 0; i + 1 < order.size(); i++)
+                {
+                    if (results[order[i]].end == "\n")
+                    {
+                        results[order[i]].end = word_separator(results[order[i]].text, results[order[i + 1]].text);
+                    }
+                }
+            }
+        }
+        std::vector<OCRPredictResult> sorted(order.size());
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            sorted[i] = std::move(results[order[i]]);
+        }
+        results.swap(sorted);
+    }
+
+} // namespace PaddleOCR
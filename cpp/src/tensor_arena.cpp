@@ -0,0 +1,201 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#include "include/tensor_arena.h"
+#include "include/utility.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <numeric>
+
+#ifdef PPOCR_WITH_CUDA
+#include <cuda_runtime_api.h>
+#endif
+
+namespace PaddleOCR
+{
+    float *TensorArena::HostBuffer::Reserve(size_t size, bool pinned)
+    {
+        if (capacity_ >= size && data_)
+        {
+            return data_;
+        }
+        Free();
+        size_t bytes = (size ? size : 1) * sizeof(float);
+#ifdef PPOCR_WITH_CUDA
+        if (pinned && cudaHostAlloc(reinterpret_cast<void **>(&data_), bytes, cudaHostAllocDefault) == cudaSuccess)
+        {
+            pinned_ = true;
+        }
+        else
+#endif
+        { // 锁页内存分配失败（如超过系统限制）时退回普通内存
+            data_ = static_cast<float *>(malloc(bytes));
+            if (!data_)
+            {
+                throw std::bad_alloc();
+            }
+        }
+        capacity_ = size;
+        return data_;
+    }
+
+    void TensorArena::HostBuffer::Free()
+    {
+        if (!data_)
+        {
+            return;
+        }
+#ifdef PPOCR_WITH_CUDA
+        if (pinned_)
+        {
+            cudaFreeHost(data_);
+        }
+        else
+#endif
+        {
+            free(data_);
+        }
+        data_ = nullptr;
+        capacity_ = 0;
+        pinned_ = false;
+    }
+
+    void TensorArena::SetPinned(bool pinned)
+    {
+        pinned_ = pinned;
+    }
+
+    void TensorArena::Track(const std::vector<int> &shape, size_t size)
+    {
+        if (size > peak_size_.load(std::memory_order_relaxed))
+        {
+            for (int i = 0; i < MAX_DIMS; i++)
+            {
+                peak_shape_[i].store(i < int(shape.size()) ? shape[i] : 0, std::memory_order_relaxed);
+            }
+            peak_size_.store(size, std::memory_order_relaxed);
+        }
+    }
+
+    float *TensorArena::Input(InferTensor *tensor, const std::vector<int> &shape, bool zero_copy)
+    {
+        size_t size = std::accumulate(shape.begin(), shape.end(), size_t(1), std::multiplies<size_t>());
+        tensor->Reshape(shape);
+        Track(shape, size);
+        float *data = zero_copy ? tensor->MutableCpuData() : nullptr;
+        zero_copy_ = data != nullptr; // 后端不支持零拷贝时退回主机缓冲区
+        if (!zero_copy_)
+        {
+            data = input_.Reserve(size, pinned_);
+        }
+        std::fill(data, data + size, 0.0f); // 预处理只写图片区域，填充区域须为0
+        return data;
+    }
+
+    void TensorArena::CommitInput(InferTensor *tensor)
+    {
+        if (!zero_copy_)
+        {
+            tensor->CopyFromCpu(input_.data());
+        }
+    }
+
+    float *TensorArena::Stage(int slot, const std::vector<int> &shape)
+    {
+        size_t size = std::accumulate(shape.begin(), shape.end(), size_t(1), std::multiplies<size_t>());
+        Track(shape, size);
+        staged_shape_[slot] = shape;
+        float *data = staging_[slot].Reserve(size, pinned_);
+        std::fill(data, data + size, 0.0f);
+        return data;
+    }
+
+    void TensorArena::Commit(InferTensor *tensor, int slot)
+    {
+        tensor->Reshape(staged_shape_[slot]);
+        tensor->CopyFromCpu(staging_[slot].data());
+    }
+
+    const float *TensorArena::Output(InferTensor *tensor, int &size)
+    {
+        const float *data = tensor->CpuData(size);
+        if (data)
+        {
+            return data;
+        }
+        // 输出在设备上，复制到主机缓冲区
+        std::vector<int> shape = tensor->shape();
+        size = std::accumulate(shape.begin(), shape.end(), 1, std::multiplies<int>());
+        float *out = output_.Reserve(size_t(size), pinned_);
+        tensor->CopyToCpu(out);
+        return out;
+    }
+
+    std::vector<unsigned char> &TensorArena::Scratch(size_t size)
+    {
+        if (scratch_.size() < size)
+        {
+            scratch_.resize(size);
+        }
+        return scratch_;
+    }
+
+    void TensorArena::Release()
+    {
+        input_.Free();
+        output_.Free();
+        staging_[0].Free();
+        staging_[1].Free();
+        std::vector<unsigned char>().swap(scratch_);
+        peak_size_.store(0, std::memory_order_relaxed);
+    }
+
+    std::string TensorArena::PeakShape() const
+    {
+        if (peak_size_.load(std::memory_order_relaxed) == 0)
+        {
+            return "";
+        }
+        std::string out;
+        for (int i = 0; i < MAX_DIMS; i++)
+        {
+            int dim = peak_shape_[i].load(std::memory_order_relaxed);
+            if (dim <= 0)
+            {
+                break;
+            }
+            out += (out.empty() ? "" : "x") + std::to_string(dim);
+        }
+        return out;
+    }
+
+    std::shared_ptr<void> CreateInferStream(bool enabled, PredictorOptions &options)
+    {
+        std::shared_ptr<void> stream;
+        if (enabled)
+        {
+            stream = Utility::CreateCudaStream();
+            options.stream = stream.get();
+        }
+        return stream;
+    }
+
+    std::shared_ptr<Predictor> ClonePredictor(const std::shared_ptr<Predictor> &predictor,
+                                              const std::shared_ptr<void> &stream,
+                                              std::shared_ptr<void> &clone_stream)
+    {
+        clone_stream.reset();
+        if (stream)
+        {
+            clone_stream = Utility::CreateCudaStream();
+            if (!clone_stream)
+            {
+                clone_stream = stream;
+            }
+        }
+        return std::shared_ptr<Predictor>(predictor->Clone(clone_stream.get()));
+    }
+} // namespace PaddleOCR
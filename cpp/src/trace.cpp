@@ -0,0 +1,237 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#include "include/trace.h"
+#include "include/args.h"
+#include "include/json_writer.h"
+#include "include/nlohmann/json.hpp"
+
+#include <atomic>
+#include <random>
+
+namespace PaddleOCR
+{
+    static thread_local Trace *t_current = nullptr;
+
+    // 线程序号：按首次记录区间的先后编号
+    static int thread_index()
+    {
+        static std::atomic<int> next(1);
+        static thread_local int index = next.fetch_add(1);
+        return index;
+    }
+
+    static std::string random_hex(int digits)
+    {
+        static thread_local std::random_device device;
+        static thread_local std::mt19937_64 rng(uint64_t(device()) ^
+                                                uint64_t(std::chrono::steady_clock::now().time_since_epoch().count()));
+        static const char *HEX = "0123456789abcdef";
+        std::string out;
+        while ((int)out.size() < digits)
+        {
+            uint64_t bits = rng();
+            for (int i = 0; i < 16 && (int)out.size() < digits; i++, bits >>= 4)
+                out += HEX[bits & 15];
+        }
+        return out;
+    }
+
+    // 小写十六进制且不全为0
+    static bool valid_id(const std::string &s, size_t pos, size_t digits)
+    {
+        bool nonzero = false;
+        for (size_t i = pos; i < pos + digits; i++)
+        {
+            char c = s[i];
+            if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f')))
+                return false;
+            nonzero |= c != '0';
+        }
+        return nonzero;
+    }
+
+    Trace::Trace(const std::string &traceparent, const std::string &name)
+        : span_id_(random_hex(16)), flags_("01"), name_(name), start_(Clock::now()), end_(start_),
+          thread_(thread_index()), wall_start_(std::chrono::system_clock::now())
+    {
+        // version-traceid-parentid-flags，如 00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01
+        const std::string &p = traceparent;
+        if (p.size() >= 55 && p[2] == '-' && p[35] == '-' && p[52] == '-' && p.compare(0, 2, "ff") != 0 &&
+            valid_id(p, 36, 16) && valid_id(p, 3, 32) && (p.size() == 55 || p[55] == '-'))
+        {
+            trace_id_ = p.substr(3, 32);
+            parent_id_ = p.substr(36, 16);
+            flags_ = p.substr(53, 2);
+        }
+        else
+        {
+            trace_id_ = random_hex(32);
+        }
+    }
+
+    std::string Trace::traceresponse() const
+    {
+        return "00-" + trace_id_ + "-" + span_id_ + "-" + flags_;
+    }
+
+    void Trace::add(const char *name, Clock::time_point start, Clock::time_point end)
+    {
+        Span span = {name, start, end, thread_index()};
+        std::lock_guard<std::mutex> lock(mutex_);
+        spans_.push_back(span);
+    }
+
+    void Trace::finish()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        end_ = Clock::now();
+    }
+
+    static double to_ms(Trace::Clock::duration d)
+    {
+        return std::chrono::duration<double, std::milli>(d).count();
+    }
+
+    std::string Trace::timing_json() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // 同名阶段（多张图片、多批识别）累加，按首次出现的先后排列
+        std::vector<std::pair<const char *, double>> stages;
+        for (const Span &s : spans_)
+        {
+            size_t k = 0;
+            while (k < stages.size() && std::string(stages[k].first) != s.name)
+                k++;
+            if (k == stages.size())
+                stages.push_back(std::make_pair(s.name, 0.0));
+            stages[k].second += to_ms(s.end - s.start);
+        }
+        std::string out;
+        JsonWriter j(out, true);
+        j.begin_object().key("stages").begin_object();
+        for (size_t k = 0; k < stages.size(); k++)
+        {
+            j.key(stages[k].first).value(stages[k].second);
+        }
+        j.end_object().key("total_ms").value(to_ms(end_ - start_)).key("trace_id").value(trace_id_).end_object();
+        return out;
+    }
+
+    std::string Trace::chrome_json() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto us = [this](Clock::time_point t)
+        { return std::chrono::duration<double, std::micro>(t - start_).count(); };
+        nlohmann::json events = nlohmann::json::array();
+        events.push_back({{"name", name_}, {"ph", "X"}, {"ts", 0}, {"dur", us(end_)}, {"pid", 1}, {"tid", thread_},
+                          {"args", {{"trace_id", trace_id_}, {"span_id", span_id_}}}});
+        for (const Span &s : spans_)
+        {
+            events.push_back({{"name", s.name}, {"ph", "X"}, {"ts", us(s.start)}, {"dur", us(s.end) - us(s.start)},
+                              {"pid", 1}, {"tid", s.thread}});
+        }
+        nlohmann::json trace = {{"traceEvents", events}, {"displayTimeUnit", "ms"}};
+        return trace.dump();
+    }
+
+    std::string Trace::otlp_json() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        long long wall_ns = (long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                wall_start_.time_since_epoch())
+                                .count();
+        auto unix_ns = [&](Clock::time_point t)
+        { return std::to_string(wall_ns + (long long)std::chrono::duration_cast<std::chrono::nanoseconds>(t - start_).count()); };
+        nlohmann::json spans = nlohmann::json::array();
+        nlohmann::json root = {{"traceId", trace_id_}, {"spanId", span_id_}, {"name", name_}, {"kind", 2}, // SPAN_KIND_SERVER
+                               {"startTimeUnixNano", unix_ns(start_)}, {"endTimeUnixNano", unix_ns(end_)}};
+        if (!parent_id_.empty())
+            root["parentSpanId"] = parent_id_;
+        spans.push_back(root);
+        for (const Span &s : spans_)
+        {
+            spans.push_back({{"traceId", trace_id_}, {"spanId", random_hex(16)}, {"parentSpanId", span_id_},
+                             {"name", s.name}, {"kind", 1}, // SPAN_KIND_INTERNAL
+                             {"startTimeUnixNano", unix_ns(s.start)}, {"endTimeUnixNano", unix_ns(s.end)},
+                             {"attributes", {{{"key", "thread.id"}, {"value", {{"intValue", std::to_string(s.thread)}}}}}}});
+        }
+        nlohmann::json resource = {{"attributes", {{{"key", "service.name"}, {"value", {{"stringValue", "PaddleOCR-json"}}}}}}};
+        nlohmann::json request = {
+            {"resourceSpans", {{{"resource", resource}, {"scopeSpans", {{{"scope", {{"name", "PaddleOCR-json"}}}, {"spans", spans}}}}}}}};
+        return request.dump();
+    }
+
+    Trace *Trace::current()
+    {
+        return t_current;
+    }
+
+    Trace *Trace::set_current(Trace *trace)
+    {
+        Trace *prev = t_current;
+        t_current = trace;
+        return prev;
+    }
+
+    void Trace::record(const char *name, Clock::time_point start, Clock::time_point end)
+    {
+        if (t_current)
+        {
+            t_current->add(name, start, end);
+        }
+    }
+
+    void Trace::record_sequence(const char *const *names, const double *ms, int count)
+    {
+        if (!t_current)
+        {
+            return;
+        }
+        Clock::time_point end = Clock::now();
+        double total = 0;
+        for (int i = 0; i < count; i++)
+            total += ms[i];
+        Clock::time_point t = end - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(total));
+        for (int i = 0; i < count; i++)
+        {
+            Clock::time_point next = i + 1 == count ? end
+                                                   : t + std::chrono::duration_cast<Clock::duration>(
+                                                             std::chrono::duration<double, std::milli>(ms[i]));
+            t_current->add(names[i], t, next);
+            t = next;
+        }
+    }
+
+    TraceStore &TraceStore::get()
+    {
+        static TraceStore store;
+        return store;
+    }
+
+    void TraceStore::put(const std::shared_ptr<Trace> &trace)
+    {
+        if (FLAGS_trace_keep <= 0)
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        traces_.push_back(trace);
+        while ((int)traces_.size() > FLAGS_trace_keep)
+        {
+            traces_.pop_front();
+        }
+    }
+
+    std::shared_ptr<Trace> TraceStore::find(const std::string &trace_id) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = traces_.rbegin(); it != traces_.rend(); ++it)
+        {
+            if ((*it)->trace_id() == trace_id)
+                return *it;
+        }
+        return std::shared_ptr<Trace>();
+    }
+
+} // namespace PaddleOCR
@@ -25,10 +25,19 @@
 #endif
 
 #include <include/utility.h>
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <functional>
+#include <memory>
 #include <iostream>
 #include <ostream>
 #include <vector>
 
+#ifdef PPOCR_WITH_CUDA
+#include <cuda_runtime_api.h>
+#endif
+
 
 namespace PaddleOCR
 {
@@ -161,11 +170,31 @@ namespace PaddleOCR
 
     // 获取旋转裁剪图像
     cv::Mat Utility::GetRotateCropImage(const cv::Mat &srcimage,
-                                        std::vector<std::vector<int>> box)
+                                        const Quad &box)
     {
-        cv::Mat image;
-        srcimage.copyTo(image);
-        std::vector<std::vector<int>> points = box;
+        // 快速路径：轴对齐的矩形框（左上、右上、右下、左下），透视变换退化为平移，直接取ROI
+        if (box[0][1] == box[1][1] && box[2][1] == box[3][1] &&
+            box[0][0] == box[3][0] && box[1][0] == box[2][0] &&
+            box[1][0] > box[0][0] && box[3][1] > box[0][1])
+        {
+            cv::Rect rect(box[0][0], box[0][1], box[1][0] - box[0][0], box[3][1] - box[0][1]);
+            if ((rect & cv::Rect(0, 0, srcimage.cols, srcimage.rows)) == rect)
+            {
+                // 复制一份，后续方向矫正会原地旋转碎图，不能改动原图
+                cv::Mat dst_img = srcimage(rect).clone();
+                if (float(dst_img.rows) >= float(dst_img.cols) * 1.5)
+                {
+                    cv::Mat srcCopy;
+                    cv::transpose(dst_img, srcCopy);
+                    cv::flip(srcCopy, srcCopy, 0);
+                    return srcCopy;
+                }
+                return dst_img;
+            }
+        }
+
+        const cv::Mat &image = srcimage; // 只读，直接在原图上取ROI，不复制整图
+        Quad points = box;
 
         int x_collect[4] = {box[0][0], box[1][0], box[2][0], box[3][0]};
         int y_collect[4] = {box[0][1], box[1][1], box[2][1], box[3][1]};
@@ -174,8 +203,7 @@ namespace PaddleOCR
         int top = int(*std::min_element(y_collect, y_collect + 4));
         int bottom = int(*std::max_element(y_collect, y_collect + 4));
 
-        cv::Mat img_crop;
-        image(cv::Rect(left, top, right - left, bottom - top)).copyTo(img_crop);
+        cv::Mat img_crop = image(cv::Rect(left, top, right - left, bottom - top));
 
         for (int i = 0; i < points.size(); i++)
         {
@@ -220,6 +248,64 @@ namespace PaddleOCR
         }
     }
 
+    // 一次遍历求最大值与下标。4路独立比较，减少循环间的数据依赖，便于编译器流水化
+    int Utility::argmax_max(const float *data, int n, float &max_value)
+    {
+        if (n <= 0)
+        {
+            max_value = 0.f;
+            return 0;
+        }
+        int idx[4] = {0, 0, 0, 0};
+        float val[4] = {data[0], data[0], data[0], data[0]};
+        int i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            for (int k = 0; k < 4; k++)
+            {
+                if (data[i + k] > val[k])
+                {
+                    val[k] = data[i + k];
+                    idx[k] = i + k;
+                }
+            }
+        }
+        for (; i < n; i++)
+        {
+            if (data[i] > val[0])
+            {
+                val[0] = data[i];
+                idx[0] = i;
+            }
+        }
+        // 合并各路：取最大值，相同时取较小的下标，与 std::max_element 一致
+        int best = 0;
+        for (int k = 1; k < 4; k++)
+        {
+            if (val[k] > val[best] || (val[k] == val[best] && idx[k] < idx[best]))
+            {
+                best = k;
+            }
+        }
+        max_value = val[best];
+        return idx[best];
+    }
+
+    // 按OCR结果的框批量裁切。碎图之间互不相关，框较多时并行处理
+    void Utility::GetRotateCropImages(const cv::Mat &srcimage,
+                                      const std::vector<OCRPredictResult> &ocr_result,
+                                      std::vector<cv::Mat> &crops, int threads)
+    {
+        int num = int(ocr_result.size());
+        size_t base = crops.size();
+        crops.resize(base + num);
+#pragma omp parallel for schedule(dynamic, 4) num_threads(threads) if (threads > 1 && num >= 8)
+        for (int j = 0; j < num; j++)
+        {
+            crops[base + j] = GetRotateCropImage(srcimage, ocr_result[j].box);
+        }
+    }
+
     // 排序
     std::vector<int> Utility::argsort(const std::vector<float> &array)
     {
@@ -369,6 +455,17 @@ namespace PaddleOCR
 #endif // !_WIN32
     }
 
+    bool Utility::IsDir(const std::string &path)
+    {
+#ifdef _WIN32
+        struct _stat buffer;
+        return _stat(path.c_str(), &buffer) == 0 && (buffer.st_mode & _S_IFDIR);
+#else
+        struct stat buffer;
+        return stat(path.c_str(), &buffer) == 0 && S_ISDIR(buffer.st_mode);
+#endif // !_WIN32
+    }
+
     void Utility::CreateDir(const std::string &path)
     {
 #ifdef _WIN32
@@ -378,14 +475,89 @@ namespace PaddleOCR
 #endif // !_WIN32
     }
 
+    // 模型目录的指纹：完整路径以及目录下各文件的名称、大小与修改时间，按文件名排序后取散列。
+    // 模型文件被替换后指纹随之改变，不会误用旧的优化结果
+    static std::string model_stamp(const std::string &model_dir)
+    {
+        std::vector<std::string> entries;
+        DIR *dir = opendir(model_dir.c_str());
+        if (dir)
+        {
+            struct dirent *ent;
+            while ((ent = readdir(dir)) != NULL)
+            {
+                std::string path = model_dir + SEP + ent->d_name;
+#ifdef _WIN32
+                struct _stat64 st;
+                if (_stat64(path.c_str(), &st) != 0 || !(st.st_mode & _S_IFREG))
+                    continue;
+#else
+                struct stat st;
+                if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+                    continue;
+#endif
+                entries.push_back(std::string(ent->d_name) + "|" + std::to_string((long long)st.st_size) +
+                                  "|" + std::to_string((long long)st.st_mtime));
+            }
+            closedir(dir);
+        }
+        std::sort(entries.begin(), entries.end());
+        std::string key = model_dir;
+        for (const std::string &e : entries)
+        {
+            key += '\n';
+            key += e;
+        }
+        char hash[24];
+        snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)std::hash<std::string>()(key));
+        return hash;
+    }
+
+    std::string Utility::OptimCacheDir(const std::string &cache_root, const std::string &model_dir,
+                                       bool use_gpu, bool use_tensorrt, bool use_mkldnn,
+                                       const std::string &precision)
+    {
+        if (cache_root.empty())
+        {
+            return "";
+        }
+        // 设备、加速库与精度不同时，优化结果不能通用，分开存放
+        std::string tag = std::string(use_gpu ? (use_tensorrt ? "trt" : "gpu") : (use_mkldnn ? "mkldnn" : "cpu")) +
+                          "_" + precision;
+        // 目录名带上模型指纹：同名的不同模型互不覆盖，模型更新后重新生成。旧指纹的目录不再使用，可手动删除
+        std::string dir = pathjoin(cache_root, basename(model_dir) + "_" + tag + "_" + model_stamp(model_dir));
+        if (!PathExists(cache_root))
+        {
+            CreateDir(cache_root);
+        }
+        if (!PathExists(dir))
+        {
+            CreateDir(dir);
+        }
+        return dir;
+    }
+
+    std::shared_ptr<void> Utility::CreateCudaStream()
+    {
+#ifdef PPOCR_WITH_CUDA
+        cudaStream_t stream = nullptr;
+        if (cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking) == cudaSuccess)
+        {
+            return std::shared_ptr<void>(stream, [](void *s)
+                                         { cudaStreamDestroy(static_cast<cudaStream_t>(s)); });
+        }
+#endif
+        return std::shared_ptr<void>();
+    }
+
     void Utility::print_result(const std::vector<OCRPredictResult> &ocr_result)
     {
         for (int i = 0; i < ocr_result.size(); i++)
         {
             std::cout << i << "\t";
             // det
-            std::vector<std::vector<int>> boxes = ocr_result[i].box;
-            if (boxes.size() > 0)
+            const Quad &boxes = ocr_result[i].box;
+            if (!boxes.empty())
             {
                 std::cout << "det boxes: [";
                 for (int n = 0; n < boxes.size(); n++)
@@ -415,6 +587,66 @@ namespace PaddleOCR
         }
     }
 
+    cv::Mat Utility::imdecode_buffer(const void *data, size_t size, int flag)
+    {
+        if (data == nullptr || size == 0 || size > size_t(INT_MAX))
+        {
+            return cv::Mat();
+        }
+        cv::Mat buf(1, static_cast<int>(size), CV_8UC1, const_cast<void *>(data));
+        return cv::imdecode(buf, flag);
+    }
+
+    bool Utility::jpeg_size(const void *data, size_t size, int &width, int &height)
+    {
+        const unsigned char *p = static_cast<const unsigned char *>(data);
+        if (p == nullptr || size < 4 || p[0] != 0xFF || p[1] != 0xD8)
+        {
+            return false;
+        }
+        size_t i = 2;
+        while (i + 4 <= size)
+        {
+            if (p[i] != 0xFF)
+            {
+                return false;
+            }
+            unsigned char marker = p[i + 1];
+            if (marker == 0xFF) // 填充字节
+            {
+                i++;
+                continue;
+            }
+            if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) // 无长度的标记
+            {
+                i += 2;
+                continue;
+            }
+            if (marker == 0xD9 || marker == 0xDA) // 图像结束或扫描开始之前没有SOF
+            {
+                return false;
+            }
+            size_t length = (size_t(p[i + 2]) << 8) | p[i + 3];
+            if (length < 2)
+            {
+                return false;
+            }
+            // SOF0~SOF15，除去同一区间的 DHT(C4)、JPG(C8)、DAC(CC)。段内：精度1字节，高2字节，宽2字节
+            if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+            {
+                if (i + 9 > size)
+                {
+                    return false;
+                }
+                height = (p[i + 5] << 8) | p[i + 6];
+                width = (p[i + 7] << 8) | p[i + 8];
+                return width > 0 && height > 0;
+            }
+            i += 2 + length;
+        }
+        return false;
+    }
+
     cv::Mat Utility::crop_image(cv::Mat &img, const std::vector<int> &box)
     {
         cv::Mat crop_im;
@@ -440,26 +672,7 @@ namespace PaddleOCR
         return crop_image(img, box_int);
     }
 
-    void Utility::sorted_boxes(std::vector<OCRPredictResult> &ocr_result)
-    {
-        std::sort(ocr_result.begin(), ocr_result.end(), Utility::comparison_box);
-        if (ocr_result.size() > 0)
-        {
-            for (int i = 0; i < ocr_result.size() - 1; i++)
-            {
-                for (int j = i; j >= 0; j--)
-                {
-                    if (abs(ocr_result[j + 1].box[0][1] - ocr_result[j].box[0][1]) < 10 &&
-                        (ocr_result[j + 1].box[0][0] < ocr_result[j].box[0][0]))
-                    {
-                        std::swap(ocr_result[i], ocr_result[i + 1]);
-                    }
-                }
-            }
-        }
-    }
-
-    std::vector<int> Utility::xyxyxyxy2xyxy(std::vector<std::vector<int>> &box)
+    std::vector<int> Utility::xyxyxyxy2xyxy(const Quad &box)
     {
         int x_collect[4] = {box[0][0], box[1][0], box[2][0], box[3][0]};
         int y_collect[4] = {box[0][1], box[1][1], box[2][1], box[3][1]};
@@ -0,0 +1,220 @@
+// PaddleOCR-json
+// https://github.com/hiroi-sora/PaddleOCR-json
+
+#include "include/video_ocr.h"
+#include "include/args.h"
+#include "include/json_writer.h"
+#include "include/logger.h"
+
+#include <chrono>
+#include <cstdlib>
+
+#include "opencv2/imgproc.hpp"
+#ifdef PPOCR_WITH_VIDEO
+#include "opencv2/videoio.hpp"
+#endif
+
+namespace PaddleOCR
+{
+    static const double MATCH_IOU = 0.5; // 外接矩形的交并比不低于它时，视为同一处文字
+
+    VideoOCR::VideoOCR(PPOCR &engine, const std::function<void(const std::string &)> &emit)
+        : engine_(engine), emit_(emit) {}
+
+    std::bitset<256> VideoOCR::frame_hash(const cv::Mat &img)
+    {
+        // 先缩小再转灰度，转换只涉及272个像素
+        cv::Mat small, gray;
+        cv::resize(img, small, cv::Size(17, 16), 0, 0, cv::INTER_AREA);
+        if (small.channels() == 3)
+            cv::cvtColor(small, gray, cv::COLOR_BGR2GRAY);
+        else if (small.channels() == 4)
+            cv::cvtColor(small, gray, cv::COLOR_BGRA2GRAY);
+        else
+            gray = small;
+        std::bitset<256> hash;
+        for (int y = 0; y < 16; y++)
+        {
+            const uchar *row = gray.ptr<uchar>(y);
+            for (int x = 0; x < 16; x++)
+            {
+                hash[y * 16 + x] = row[x] > row[x + 1];
+            }
+        }
+        return hash;
+    }
+
+    bool VideoOCR::run(const std::string &source, bool cls, bool rec)
+    {
+#ifdef PPOCR_WITH_VIDEO
+        cv::VideoCapture capture;
+        char *end = nullptr;
+        long camera = strtol(source.c_str(), &end, 10);
+        bool opened = (*end == '\0' && !source.empty()) ? capture.open(int(camera)) : capture.open(source);
+        if (!opened || !capture.isOpened())
+        {
+            return false;
+        }
+        OCR_LOG_INFO("Video opened: " << source << ", fps " << capture.get(cv::CAP_PROP_FPS));
+
+        const double interval = FLAGS_video_fps > 0 ? 1000.0 / FLAGS_video_fps : 0; // 抽帧间隔，毫秒
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        bool wall_clock = false; // 摄像头与部分网络流没有可用的时间戳，改用读帧时的时间
+        double last_pos = -1, next_ms = 0;
+        long long time_ms = 0, frames = 0, ocr_frames = 0, skipped = 0;
+        std::bitset<256> prev_hash;
+        bool has_prev = false;
+        cv::Mat frame;
+        while (capture.grab()) // 只解码，不抽取的帧不做颜色转换与复制
+        {
+            frames++;
+            double pos = wall_clock ? -1 : capture.get(cv::CAP_PROP_POS_MSEC);
+            if (!wall_clock && frames > 1 && pos <= last_pos)
+            {
+                wall_clock = true;
+                OCR_LOG_DEBUG("Video has no usable timestamps, using wall clock");
+            }
+            last_pos = pos;
+            time_ms = wall_clock ? (long long)std::chrono::duration_cast<std::chrono::milliseconds>(
+                                       std::chrono::steady_clock::now() - start)
+                                       .count()
+                                 : (long long)pos;
+            if (time_ms < next_ms)
+            {
+                continue;
+            }
+            next_ms += interval;
+            if (next_ms <= time_ms) // 落后（解码慢或时间戳跳跃）时不补抽
+            {
+                next_ms = time_ms + interval;
+            }
+            if (!capture.retrieve(frame) || frame.empty())
+            {
+                continue;
+            }
+            if (FLAGS_video_hash_dist >= 0)
+            {
+                std::bitset<256> hash = frame_hash(frame);
+                // 与上一识别帧（而非上一抽取帧）比较，缓慢的渐变累积起来仍会触发识别
+                if (has_prev && int((hash ^ prev_hash).count()) <= FLAGS_video_hash_dist)
+                {
+                    skipped++;
+                    continue;
+                }
+                prev_hash = hash;
+                has_prev = true;
+            }
+            // 增量OCR：只对与上一识别帧相比变化的区域重新检测与识别，其余文本框沿用上次的文字
+            update(engine_.ocr_incremental(frame, rec, cls), rec, time_ms);
+            ocr_frames++;
+        }
+        // 视频结束：仍在画面中的文字视为消失
+        for (size_t i = 0; i < tracks_.size(); i++)
+        {
+            emit_event("disappear", tracks_[i], time_ms);
+        }
+        tracks_.clear();
+        std::string out;
+        JsonWriter j(out, FLAGS_ensure_ascii);
+        j.begin_object().key("event").value("end").key("frames").value(frames).key("ocr_frames").value(ocr_frames);
+        j.key("skipped").value(skipped).key("time_ms").value(time_ms).end_object();
+        emit_(out);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void VideoOCR::update(const std::vector<OCRPredictResult> &results, bool rec, long long time_ms)
+    {
+        size_t old_count = tracks_.size();
+        std::vector<char> matched(old_count, 0);
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const OCRPredictResult &r = results[i];
+            if (rec && r.text.empty()) // 识别置信度过低而丢弃文字的框
+            {
+                continue;
+            }
+            std::vector<int> b = Utility::xyxyxyxy2xyxy(r.box);
+            cv::Rect rect(b[0], b[1], b[2] - b[0] + 1, b[3] - b[1] + 1);
+            // 与上一识别帧中交并比最大、且尚未匹配的文字对应
+            int best = -1;
+            double best_iou = MATCH_IOU;
+            for (size_t k = 0; k < old_count; k++)
+            {
+                if (matched[k])
+                    continue;
+                double inter = (rect & tracks_[k].rect).area();
+                double iou = inter / (double(rect.area()) + tracks_[k].rect.area() - inter);
+                if (iou >= best_iou)
+                {
+                    best_iou = iou;
+                    best = int(k);
+                }
+            }
+            if (best < 0)
+            {
+                Track t;
+                t.id = next_id_++;
+                t.result = r;
+                t.rect = rect;
+                t.since_ms = time_ms;
+                tracks_.push_back(t);
+                emit_event("appear", t, time_ms);
+                continue;
+            }
+            Track &t = tracks_[best];
+            matched[best] = 1;
+            t.missing = 0;
+            t.rect = rect;
+            bool changed = t.result.text != r.text;
+            t.result = r; // 文字不变时只更新位置，不输出事件
+            if (changed)
+            {
+                emit_event("change", t, time_ms);
+            }
+        }
+        // 未匹配的旧文字：连续缺失 video_hold 帧后报告消失
+        std::vector<Track> kept;
+        for (size_t k = 0; k < tracks_.size(); k++)
+        {
+            if (k < old_count && !matched[k] && ++tracks_[k].missing >= FLAGS_video_hold)
+            {
+                emit_event("disappear", tracks_[k], time_ms);
+                continue;
+            }
+            kept.push_back(tracks_[k]);
+        }
+        tracks_.swap(kept);
+    }
+
+    void VideoOCR::emit_event(const char *event, const Track &track, long long time_ms)
+    {
+        std::string out;
+        JsonWriter j(out, FLAGS_ensure_ascii);
+        j.begin_object();
+        bool gone = std::string(event) == "disappear";
+        if (!gone)
+        {
+            j.key("box").value(track.result.box);
+        }
+        j.key("event").value(event).key("id").value(track.id);
+        if (gone)
+        {
+            j.key("since_ms").value(track.since_ms);
+        }
+        else if (track.result.score >= 0)
+        {
+            j.key("score").value(double(track.result.score));
+        }
+        j.key("text").value(track.result.text).key("time_ms").value(time_ms).end_object();
+        if (!j.ok())
+        {
+            OCR_LOG_WARN("Video event of text " << track.id << " dropped: invalid UTF-8");
+            return;
+        }
+        emit_(out);
+    }
+
+} // namespace PaddleOCR